@@ -30,6 +30,7 @@ limitations under the License. */
 
 DECLARE_bool(benchmark);
 DECLARE_bool(use_mkldnn);
+DECLARE_bool(enable_op_runtime_context_table);
 
 namespace paddle {
 namespace framework {
@@ -385,6 +386,9 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
   for (auto& op_desc : block.AllOps()) {
     ctx->ops_.push_back(OpRegistry::CreateOp(*op_desc));
   }
+  if (FLAGS_enable_op_runtime_context_table) {
+    ctx->runtime_ctx_table_.Build(ctx->ops_);
+  }
   ctx->PrepareUnusedVars(skip_ref_cnt_vars, force_disable_gc);
   return ctx;
 }
@@ -412,6 +416,9 @@ std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     for (auto& op_desc : block.AllOps()) {
       ctx->ops_.push_back(OpRegistry::CreateOp(*op_desc));
     }
+    if (FLAGS_enable_op_runtime_context_table) {
+      ctx->runtime_ctx_table_.Build(ctx->ops_);
+    }
     if (skip_ref_cnt_vars.empty()) {
       ctx->PrepareUnusedVars(std::vector<std::string>(), force_disable_gc);
     } else {
@@ -514,13 +521,28 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
     }
   }
 
+  // NOTE: the prepared context may be run by several threads at once, every
+  // thread keeps its own runtime contexts, which are bound again only when
+  // the local scope or its variables changed since the last run.
+  std::unique_ptr<OpRuntimeContexts> runtime_ctxs;
+  if (ctx->runtime_ctx_table_.IsBuilt()) {
+    runtime_ctxs = ctx->runtime_ctxs_cache_.Acquire(*local_scope);
+  }
+
   for (int64_t i = start_op_index; i < end_op_index; ++i) {
     auto& op = ctx->ops_[i];
-    op->Run(*local_scope, place_);
+    if (runtime_ctxs) {
+      runtime_ctxs->RunOp(i, *local_scope, place_);
+    } else {
+      op->Run(*local_scope, place_);
+    }
     if (gc) {
       DeleteUnusedTensors(*local_scope, op.get(), ctx->unused_vars_, gc.get());
     }
   }
+  if (runtime_ctxs) {
+    ctx->runtime_ctxs_cache_.Release(std::move(runtime_ctxs));
+  }
 
   auto callback = [scope, local_scope, keep_kids]() {
     if (local_scope != scope) {
@@ -23,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/executor_gc_helper.h"
 #include "paddle/fluid/framework/garbage_collector.h"
 #include "paddle/fluid/framework/op_info.h"
+#include "paddle/fluid/framework/op_runtime_context_table.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/tensor.h"
@@ -49,6 +50,12 @@ struct ExecutorPrepareContext {
 
   std::vector<std::unique_ptr<OperatorBase>> ops_;
 
+  // Built when prepared if FLAGS_enable_op_runtime_context_table is set, read
+  // only afterwards.
+  OpRuntimeContextTable runtime_ctx_table_;
+  // The contexts bound by the last run of each thread.
+  OpRuntimeContextsCache runtime_ctxs_cache_{runtime_ctx_table_};
+
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
   bool force_disable_gc_{false};
@@ -0,0 +1,406 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/cpu_int8_fc_conv_pass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/op_version_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_int8_gemm.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+namespace {
+
+// The var node of the argument of the op when it holds one var.
+Node* FindArgument(const VariableNameMap& arguments,
+                   const std::vector<Node*>& nodes,
+                   const std::string& argument) {
+  auto it = arguments.find(argument);
+  if (it == arguments.end() || it->second.size() != 1) return nullptr;
+  for (auto* node : nodes) {
+    if (node->IsVar() && node->Name() == it->second[0]) return node;
+  }
+  return nullptr;
+}
+
+Node* FindInput(Node* op, const std::string& argument) {
+  return FindArgument(op->Op()->Inputs(), op->inputs, argument);
+}
+
+Node* FindOutput(Node* op, const std::string& argument) {
+  return FindArgument(op->Op()->Outputs(), op->outputs, argument);
+}
+
+// The float tensor of a persistable weight node in the scope.
+const LoDTensor* FindWeight(Scope* scope, Node* node) {
+  if (node == nullptr || !node->Var() || !node->Var()->Persistable()) {
+    return nullptr;
+  }
+  auto* var = scope->FindVar(node->Name());
+  if (var == nullptr || !var->IsType<LoDTensor>()) return nullptr;
+  auto* tensor = &var->Get<LoDTensor>();
+  if (!tensor->IsInitialized() ||
+      framework::TransToProtoVarType(tensor->dtype()) !=
+          proto::VarType::FP32 ||
+      !platform::is_cpu_place(tensor->place())) {
+    return nullptr;
+  }
+  return tensor;
+}
+
+// The int8 values of the n channels of k elements of w, the element i of
+// the channel j is w[j * channel_stride + i * elem_stride]. The values are
+// written channel by channel, and the scale of the channel j to scales[j].
+// A channel keeps the scale of the op when its values are the int8 values
+// times the scale, the weights scaled after the quantization, e.g. by
+// conv_bn_fuse_pass, take the max abs values of their channels.
+int QuantizeChannels(const float* w, int64_t n, int64_t k,
+                     int64_t channel_stride, int64_t elem_stride,
+                     const std::vector<float>& op_scales,
+                     std::vector<float>* scales, std::vector<int8_t>* values) {
+  scales->resize(n);
+  values->resize(n * k);
+  int requantized = 0;
+  for (int64_t j = 0; j < n; ++j) {
+    const float* channel = w + j * channel_stride;
+    auto at = [&](int64_t i) { return channel[i * elem_stride]; };
+    float scale = op_scales.size() == 1 ? op_scales[0] : op_scales[j];
+    bool on_grid = scale > 0.0f;
+    for (int64_t i = 0; i < k && on_grid; ++i) {
+      float v = at(i) / scale;
+      on_grid = std::fabs(v) <= 127.5f && std::fabs(v - std::round(v)) < 1e-2f;
+    }
+    if (!on_grid) {
+      float max_abs = 0.0f;
+      for (int64_t i = 0; i < k; ++i) {
+        max_abs = std::max(max_abs, std::fabs(at(i)));
+      }
+      scale = max_abs / 127.0f;
+      ++requantized;
+    }
+    (*scales)[j] = scale;
+    for (int64_t i = 0; i < k; ++i) {
+      float v = scale > 0.0f ? std::round(at(i) / scale) : 0.0f;
+      (*values)[j * k + i] =
+          static_cast<int8_t>(std::min(std::max(v, -127.0f), 127.0f));
+    }
+  }
+  return requantized;
+}
+
+// Creates the persistable var of the tensor in the graph and the scope.
+Node* CreateParam(Graph* graph, Scope* scope, const std::string& name,
+                  const std::vector<int64_t>& shape,
+                  proto::VarType::Type dtype, LoDTensor** tensor) {
+  VarDesc desc(name);
+  desc.SetShape(shape);
+  desc.SetDataType(dtype);
+  desc.SetPersistable(true);
+  auto* node = graph->CreateVarNode(&desc);
+  *tensor = scope->Var(name)->GetMutable<LoDTensor>();
+  (*tensor)->Resize(phi::make_ddim(shape));
+  return node;
+}
+
+// Replaces the op node by the new op, and drops the float weight when no
+// other op reads it.
+void ReplaceOp(Graph* graph, Scope* scope, Node* op, Node* weight,
+               const std::unordered_set<const Node*>& extra_nodes) {
+  std::unordered_set<const Node*> nodes2rm(extra_nodes);
+  nodes2rm.insert(op);
+  GraphSafeRemoveNodes(graph, nodes2rm);
+  if (weight->outputs.empty()) {
+    std::string name = weight->Name();
+    GraphSafeRemoveNodes(graph, {weight});
+    scope->EraseVars({name});
+  }
+}
+
+bool IsInt8Quantized(const OpDesc& desc) {
+  return desc.GetAttrIfExists<bool>("enable_int8") &&
+         desc.HasAttr("weight_scale") &&
+         (!desc.HasAttr("bit_length") ||
+          BOOST_GET_CONST(int, desc.GetAttr("bit_length")) == 8);
+}
+
+}  // namespace
+
+bool CPUInt8FCConvPass::ConvertFC(Graph* graph, Scope* scope,
+                                  Node* op) const {
+  const OpDesc& desc = *op->Op();
+  const std::string& type = desc.Type();
+  if (!IsInt8Quantized(desc)) return false;
+  bool fc = type == "fc";
+  bool trans_y = false;
+  float alpha = 1.0f;
+  int in_num_col_dims = 1;
+  Node* x = FindInput(op, fc ? "Input" : "X");
+  Node* y = FindInput(op, fc ? "W" : "Y");
+  Node* out = FindOutput(op, "Out");
+  const LoDTensor* weight = FindWeight(scope, y);
+  if (x == nullptr || out == nullptr || weight == nullptr ||
+      weight->dims().size() != 2) {
+    return false;
+  }
+  if (fc) {
+    // fusion_int8_fc applies no activation other than relu
+    auto activation_type = desc.GetAttrIfExists<std::string>("activation_type");
+    if (desc.GetAttrIfExists<bool>("padding_weights") ||
+        (!activation_type.empty() && activation_type != "relu")) {
+      return false;
+    }
+    in_num_col_dims = BOOST_GET_CONST(int, desc.GetAttr("in_num_col_dims"));
+  } else if (type == "mul") {
+    if (BOOST_GET_CONST(int, desc.GetAttr("y_num_col_dims")) != 1) {
+      return false;
+    }
+    in_num_col_dims = BOOST_GET_CONST(int, desc.GetAttr("x_num_col_dims"));
+  } else {
+    // the matmul of the rows of X by the 2-D weight
+    bool matmul = type == "matmul";
+    if (desc.GetAttrIfExists<bool>(matmul ? "transpose_X" : "trans_x")) {
+      return false;
+    }
+    trans_y = desc.GetAttrIfExists<bool>(matmul ? "transpose_Y" : "trans_y");
+    if (matmul && desc.HasAttr("alpha")) {
+      alpha = BOOST_GET_CONST(float, desc.GetAttr("alpha"));
+    }
+    int x_rank = x->Var() ? static_cast<int>(x->Var()->GetShape().size()) : 0;
+    if (x_rank < 2) return false;
+    in_num_col_dims = x_rank - 1;
+  }
+  const std::string input_scale_name = fc ? "Input_scale" : "X_scale";
+  if (!desc.HasAttr(input_scale_name)) return false;
+  float input_scale = BOOST_GET_CONST(float, desc.GetAttr(input_scale_name));
+  auto op_scales =
+      BOOST_GET_CONST(std::vector<float>, desc.GetAttr("weight_scale"));
+
+  auto w_dims = weight->dims();
+  const int64_t k = trans_y ? w_dims[1] : w_dims[0];
+  const int64_t n = trans_y ? w_dims[0] : w_dims[1];
+  if (op_scales.size() != 1 && static_cast<int64_t>(op_scales.size()) != n) {
+    return false;
+  }
+  std::vector<float> scales;
+  std::vector<int8_t> values;
+  int requantized = QuantizeChannels(
+      weight->data<float>(), n, k, trans_y ? k : 1, trans_y ? 1 : n,
+      op_scales, &scales, &values);
+  for (auto& scale : scales) {
+    scale *= alpha;
+  }
+
+  LoDTensor *packed, *sum;
+  Node* packed_node = CreateParam(
+      graph, scope, patterns::PDNodeName(name_scope_, "int8_weight"),
+      {phi::funcs::CpuInt8PaddedK(k), phi::funcs::CpuInt8PaddedN(n)},
+      proto::VarType::INT8, &packed);
+  Node* sum_node =
+      CreateParam(graph, scope, patterns::PDNodeName(name_scope_, "weight_sum"),
+                  {n}, proto::VarType::INT32, &sum);
+  phi::funcs::CpuInt8PackWeight(
+      values.data(), k, n, true,
+      packed->mutable_data<int8_t>(platform::CPUPlace()),
+      sum->mutable_data<int32_t>(platform::CPUPlace()));
+
+  OpDesc new_desc(desc.Block());
+  new_desc.SetType("fusion_int8_fc");
+  new_desc.SetInput("Input", {x->Name()});
+  new_desc.SetInput("W", {packed_node->Name()});
+  new_desc.SetInput("WeightSum", {sum_node->Name()});
+  Node* bias = fc ? FindInput(op, "Bias") : nullptr;
+  if (bias) {
+    new_desc.SetInput("Bias", {bias->Name()});
+  }
+  new_desc.SetOutput("Out", {out->Name()});
+  new_desc.SetAttr("in_num_col_dims", in_num_col_dims);
+  new_desc.SetAttr("Input_scale", input_scale);
+  new_desc.SetAttr("weight_scale", scales);
+  new_desc.SetAttr("activation_type",
+                   fc ? desc.GetAttrIfExists<std::string>("activation_type")
+                      : std::string());
+  new_desc.Flush();
+  auto* new_op = graph->CreateOpNode(&new_desc);
+  IR_NODE_LINK_TO(x, new_op);
+  IR_NODE_LINK_TO(packed_node, new_op);
+  IR_NODE_LINK_TO(sum_node, new_op);
+  if (bias) {
+    IR_NODE_LINK_TO(bias, new_op);
+  }
+  IR_NODE_LINK_TO(new_op, out);
+  VLOG(4) << "Run " << type << " of " << out->Name() << " in int8, "
+          << requantized << " of its " << n << " channels are requantized.";
+  ReplaceOp(graph, scope, op, y, {});
+  return true;
+}
+
+bool CPUInt8FCConvPass::ConvertConv(Graph* graph, Scope* scope,
+                                    Node* op) const {
+  const OpDesc& desc = *op->Op();
+  if (!IsInt8Quantized(desc) || !desc.HasAttr("Input_scale")) return false;
+  auto data_format = desc.GetAttrIfExists<std::string>("data_format");
+  if (data_format != "NCHW" && data_format != "AnyLayout" &&
+      !data_format.empty()) {
+    return false;
+  }
+  for (auto* extra : {"Bias", "ResidualData"}) {
+    auto it = desc.Inputs().find(extra);
+    if (it != desc.Inputs().end() && !it->second.empty()) return false;
+  }
+  Node* x = FindInput(op, "Input");
+  Node* filter = FindInput(op, "Filter");
+  Node* out = FindOutput(op, "Output");
+  const LoDTensor* weight = FindWeight(scope, filter);
+  if (x == nullptr || out == nullptr || weight == nullptr ||
+      weight->dims().size() != 4) {
+    return false;
+  }
+  auto filter_shape = phi::vectorize<int>(weight->dims());
+  int groups = std::max(desc.GetAttrIfExists<int>("groups"), 1);
+  const int64_t oc = filter_shape[0];
+  const int64_t k = weight->numel() / oc;
+  auto op_scales =
+      BOOST_GET_CONST(std::vector<float>, desc.GetAttr("weight_scale"));
+  if (oc % groups != 0 ||
+      (op_scales.size() != 1 && static_cast<int64_t>(op_scales.size()) != oc)) {
+    return false;
+  }
+  const int64_t oc_per_group = oc / groups;
+
+  std::vector<float> scales;
+  std::vector<int8_t> values;
+  int requantized = QuantizeChannels(weight->data<float>(), oc, k, k, 1,
+                                     op_scales, &scales, &values);
+  LoDTensor *packed, *sum;
+  Node* packed_node = CreateParam(
+      graph, scope, patterns::PDNodeName(name_scope_, "int8_filter"),
+      {groups * phi::funcs::CpuInt8PaddedK(k),
+       phi::funcs::CpuInt8PaddedN(oc_per_group)},
+      proto::VarType::INT8, &packed);
+  Node* sum_node =
+      CreateParam(graph, scope, patterns::PDNodeName(name_scope_, "weight_sum"),
+                  {oc}, proto::VarType::INT32, &sum);
+  int8_t* packed_data = packed->mutable_data<int8_t>(platform::CPUPlace());
+  int32_t* sum_data = sum->mutable_data<int32_t>(platform::CPUPlace());
+  const int64_t group_size = phi::funcs::CpuInt8PackedSize(k, oc_per_group);
+  for (int g = 0; g < groups; ++g) {
+    phi::funcs::CpuInt8PackWeight(values.data() + g * oc_per_group * k, k,
+                                  oc_per_group, true,
+                                  packed_data + g * group_size,
+                                  sum_data + g * oc_per_group);
+  }
+
+  // the bias added by elementwise_add, e.g. the one of conv_bn_fuse_pass
+  Node* bias = nullptr;
+  std::unordered_set<const Node*> extra_nodes;
+  if (out->outputs.size() == 1 && out->outputs[0]->IsOp() &&
+      out->outputs[0]->Op()->Type() == "elementwise_add") {
+    Node* add = out->outputs[0];
+    Node* add_y = FindInput(add, "Y");
+    Node* add_out = FindOutput(add, "Out");
+    const LoDTensor* bias_tensor = FindWeight(scope, add_y);
+    if (FindInput(add, "X") == out && add_out != nullptr &&
+        bias_tensor != nullptr && bias_tensor->dims().size() == 1 &&
+        bias_tensor->numel() == oc &&
+        add->Op()->GetAttrIfExists<int>("axis") == 1) {
+      bias = add_y;
+      extra_nodes = {out, add};
+      out = add_out;
+    }
+  }
+
+  OpDesc new_desc(desc.Block());
+  new_desc.SetType("fusion_int8_conv2d");
+  new_desc.SetInput("Input", {x->Name()});
+  new_desc.SetInput("Filter", {packed_node->Name()});
+  new_desc.SetInput("WeightSum", {sum_node->Name()});
+  if (bias) {
+    new_desc.SetInput("Bias", {bias->Name()});
+  }
+  new_desc.SetOutput("Output", {out->Name()});
+  new_desc.SetAttr("filter_shape", filter_shape);
+  new_desc.SetAttr("strides", desc.GetAttr("strides"));
+  new_desc.SetAttr("paddings", desc.GetAttr("paddings"));
+  new_desc.SetAttr("dilations", desc.GetAttr("dilations"));
+  new_desc.SetAttr("groups", groups);
+  if (desc.HasAttr("padding_algorithm")) {
+    new_desc.SetAttr("padding_algorithm", desc.GetAttr("padding_algorithm"));
+  }
+  new_desc.SetAttr("Input_scale", desc.GetAttr("Input_scale"));
+  new_desc.SetAttr("weight_scale", scales);
+  new_desc.Flush();
+  auto* new_op = graph->CreateOpNode(&new_desc);
+  IR_NODE_LINK_TO(x, new_op);
+  IR_NODE_LINK_TO(packed_node, new_op);
+  IR_NODE_LINK_TO(sum_node, new_op);
+  if (bias) {
+    IR_NODE_LINK_TO(bias, new_op);
+  }
+  IR_NODE_LINK_TO(new_op, out);
+  VLOG(4) << "Run " << desc.Type() << " of " << out->Name() << " in int8, "
+          << requantized << " of its " << oc << " channels are requantized.";
+  ReplaceOp(graph, scope, op, filter, extra_nodes);
+  return true;
+}
+
+void CPUInt8FCConvPass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init(name_scope_, graph);
+  auto* scope = param_scope();
+
+  const std::unordered_set<std::string> types = {
+      "fc", "mul", "matmul", "matmul_v2", "conv2d", "depthwise_conv2d"};
+  // the ops are picked before any is converted, since a conversion removes
+  // the elementwise_add taken as the bias
+  std::vector<Node*> ops;
+  for (auto* node : TopologySortOperations(*graph)) {
+    if (node->Op() && types.count(node->Op()->Type())) {
+      ops.push_back(node);
+    }
+  }
+  int found_count = 0;
+  for (auto* op : ops) {
+    bool conv = op->Op()->Type().find("conv") != std::string::npos;
+    if (conv ? ConvertConv(graph, scope, op) : ConvertFC(graph, scope, op)) {
+      ++found_count;
+    }
+  }
+  AddStatis(found_count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(cpu_int8_fc_conv_pass, paddle::framework::ir::CPUInt8FCConvPass);
+REGISTER_PASS_CAPABILITY(cpu_int8_fc_conv_pass)
+    .AddCombination(
+        paddle::framework::compatible::OpVersionComparatorCombination()
+            .LE("fc", 0)
+            .EQ("mul", 0)
+            .LE("matmul", 1)
+            .EQ("matmul_v2", 0)
+            .LE("conv2d", 1)
+            .LE("depthwise_conv2d", 1)
+            .LE("elementwise_add", 1));
@@ -0,0 +1,53 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+class Graph;
+class Node;
+
+/*
+ * Runs the ops quantized by quant_conv2d_dequant_fuse_pass and
+ * delete_quant_dequant_op_pass with the int8 CPU kernels that do not need
+ * oneDNN. The fc ops with no activation or a relu, and the mul, matmul and
+ * matmul_v2 ops, whose weight is a 2-D persistable tensor become
+ * fusion_int8_fc. The NCHW conv2d and depthwise_conv2d ops become
+ * fusion_int8_conv2d, which takes the bias of a following elementwise_add.
+ * Their weights are quantized to int8 and packed in the scope.
+ */
+class CPUInt8FCConvPass : public FusePassBase {
+ public:
+  virtual ~CPUInt8FCConvPass() {}
+
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+
+ private:
+  bool ConvertFC(ir::Graph* graph, Scope* scope, Node* op) const;
+  bool ConvertConv(ir::Graph* graph, Scope* scope, Node* op) const;
+
+  const std::string name_scope_{"cpu_int8_fc_conv"};
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,386 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/cpu_int8_fc_conv_pass.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/phi/kernels/funcs/cpu_int8_gemm.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+void AddVar(ProgramDesc* prog, const std::string& name,
+            const std::vector<int64_t>& shape, bool persistable = false) {
+  auto* var = prog->MutableBlock(0)->Var(name);
+  var->SetType(proto::VarType::LOD_TENSOR);
+  var->SetDataType(proto::VarType::FP32);
+  var->SetShape(shape);
+  var->SetPersistable(persistable);
+}
+
+// Appends the op quantized by the quant/dequant passes, the weight of every
+// output channel is on the int8 grid of its weight_scale.
+OpDesc* AddQuantizedOp(ProgramDesc* prog, const std::string& type,
+                       const VariableNameMap& inputs,
+                       const VariableNameMap& outputs,
+                       const std::vector<float>& weight_scale) {
+  auto* op = prog->MutableBlock(0)->AppendOp();
+  op->SetType(type);
+  for (auto& item : inputs) {
+    op->SetInput(item.first, item.second);
+  }
+  for (auto& item : outputs) {
+    op->SetOutput(item.first, item.second);
+  }
+  bool named_input = type == "fc" || type.find("conv") != std::string::npos;
+  op->SetAttr("enable_int8", true);
+  op->SetAttr("bit_length", 8);
+  op->SetAttr(named_input ? "Input_scale" : "X_scale", 0.05f);
+  op->SetAttr("weight_scale", weight_scale);
+  op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+              static_cast<int>(OpRole::kForward));
+  return op;
+}
+
+std::vector<int8_t> Int8Values(int64_t size, int seed) {
+  std::vector<int8_t> values(size);
+  for (int64_t i = 0; i < size; ++i) {
+    values[i] = static_cast<int8_t>((i * 37 + seed) % 255 - 127);
+  }
+  return values;
+}
+
+void AddWeight(Scope* scope, const std::string& name,
+               const std::vector<int64_t>& shape,
+               const std::vector<float>& values) {
+  auto* tensor = scope->Var(name)->GetMutable<LoDTensor>();
+  tensor->Resize(phi::make_ddim(shape));
+  std::copy(values.begin(), values.end(),
+            tensor->mutable_data<float>(platform::CPUPlace()));
+}
+
+std::unique_ptr<Graph> ApplyPass(const ProgramDesc& prog, Scope* scope) {
+  std::unique_ptr<Graph> graph(new Graph(prog));
+  graph->SetNotOwned(kParamScopeAttr, scope);
+  auto pass = PassRegistry::Instance().Get("cpu_int8_fc_conv_pass");
+  graph.reset(pass->Apply(graph.release()));
+  return graph;
+}
+
+OpDesc* FindOnlyOp(const std::unique_ptr<Graph>& graph,
+                   const std::string& type) {
+  auto ops = GetOpNodes(graph, type);
+  PADDLE_ENFORCE_EQ(ops.size(), 1UL,
+                    platform::errors::NotFound(
+                        "The graph is expected to hold one %s op, but it "
+                        "holds %d.",
+                        type, ops.size()));
+  return ops[0]->Op();
+}
+
+// Checks that the input W of the op holds w packed in the scope.
+void ExpectPacked(const Scope& scope, const OpDesc& op,
+                  const std::string& argument, const int8_t* w, int64_t k,
+                  int64_t n, bool trans, int64_t offset = 0,
+                  int64_t channel_offset = 0) {
+  std::vector<int8_t> packed(phi::funcs::CpuInt8PackedSize(k, n));
+  std::vector<int32_t> sum(n);
+  phi::funcs::CpuInt8PackWeight(w, k, n, trans, packed.data(), sum.data());
+  auto& packed_tensor =
+      scope.FindVar(op.Input(argument)[0])->Get<LoDTensor>();
+  auto& sum_tensor = scope.FindVar(op.Input("WeightSum")[0])->Get<LoDTensor>();
+  for (size_t i = 0; i < packed.size(); ++i) {
+    ASSERT_EQ(packed_tensor.data<int8_t>()[offset + i], packed[i]);
+  }
+  for (int64_t j = 0; j < n; ++j) {
+    ASSERT_EQ(sum_tensor.data<int32_t>()[channel_offset + j], sum[j]);
+  }
+}
+
+TEST(CPUInt8FCConvPass, fc_with_relu) {
+  // (x, w, bias) fc(relu) -> out, w: 6 x 5 with a scale per column
+  const int64_t k = 6, n = 5;
+  ProgramDesc prog;
+  AddVar(&prog, "x", {-1, k});
+  AddVar(&prog, "w", {k, n}, true);
+  AddVar(&prog, "bias", {n}, true);
+  AddVar(&prog, "out", {-1, n});
+  std::vector<float> scales = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f};
+  auto* fc = AddQuantizedOp(
+      &prog, "fc", {{"Input", {"x"}}, {"W", {"w"}}, {"Bias", {"bias"}}},
+      {{"Out", {"out"}}}, scales);
+  fc->SetAttr("in_num_col_dims", 1);
+  fc->SetAttr("activation_type", std::string("relu"));
+
+  auto q = Int8Values(k * n, 3);
+  std::vector<float> w(k * n);
+  for (int64_t i = 0; i < k * n; ++i) {
+    w[i] = q[i] * scales[i % n];
+  }
+  Scope scope;
+  AddWeight(&scope, "w", {k, n}, w);
+  AddWeight(&scope, "bias", {n}, std::vector<float>(n, 1.0f));
+  auto graph = ApplyPass(prog, &scope);
+
+  EXPECT_EQ(GetNumOpNodes(graph, "fc"), 0);
+  auto* op = FindOnlyOp(graph, "fusion_int8_fc");
+  EXPECT_EQ(op->Input("Input"), std::vector<std::string>({"x"}));
+  EXPECT_EQ(op->Input("Bias"), std::vector<std::string>({"bias"}));
+  EXPECT_EQ(op->Output("Out"), std::vector<std::string>({"out"}));
+  EXPECT_EQ(BOOST_GET_CONST(std::string, op->GetAttr("activation_type")),
+            "relu");
+  // the weight on the grid keeps the scales of the op
+  auto op_scales =
+      BOOST_GET_CONST(std::vector<float>, op->GetAttr("weight_scale"));
+  EXPECT_EQ(op_scales, scales);
+  ExpectPacked(scope, *op, "W", q.data(), k, n, false);
+  // the float weight is read by no other op
+  EXPECT_EQ(scope.FindVar("w"), nullptr);
+}
+
+TEST(CPUInt8FCConvPass, fc_with_other_activation) {
+  const int64_t k = 4, n = 3;
+  ProgramDesc prog;
+  AddVar(&prog, "x", {-1, k});
+  AddVar(&prog, "w", {k, n}, true);
+  AddVar(&prog, "out", {-1, n});
+  auto* fc = AddQuantizedOp(&prog, "fc", {{"Input", {"x"}}, {"W", {"w"}}},
+                            {{"Out", {"out"}}}, {0.1f});
+  fc->SetAttr("in_num_col_dims", 1);
+  fc->SetAttr("activation_type", std::string("gelu"));
+
+  Scope scope;
+  AddWeight(&scope, "w", {k, n}, std::vector<float>(k * n, 0.1f));
+  auto graph = ApplyPass(prog, &scope);
+  EXPECT_EQ(GetNumOpNodes(graph, "fc"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "fusion_int8_fc"), 0);
+  EXPECT_NE(scope.FindVar("w"), nullptr);
+}
+
+TEST(CPUInt8FCConvPass, matmul_trans_y_and_alpha) {
+  // (x, y) matmul(transpose_Y, alpha) -> out, y: 5 x 8, the rows of y are
+  // the output channels
+  const int64_t k = 8, n = 5;
+  ProgramDesc prog;
+  AddVar(&prog, "x", {-1, 3, k});
+  AddVar(&prog, "y", {n, k}, true);
+  AddVar(&prog, "out", {-1, 3, n});
+  std::vector<float> scales = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f};
+  auto* matmul = AddQuantizedOp(&prog, "matmul", {{"X", {"x"}}, {"Y", {"y"}}},
+                                {{"Out", {"out"}}}, scales);
+  matmul->SetAttr("transpose_X", false);
+  matmul->SetAttr("transpose_Y", true);
+  matmul->SetAttr("alpha", 0.5f);
+
+  auto q = Int8Values(n * k, 11);
+  std::vector<float> y(n * k);
+  for (int64_t i = 0; i < n * k; ++i) {
+    y[i] = q[i] * scales[i / k];
+  }
+  Scope scope;
+  AddWeight(&scope, "y", {n, k}, y);
+  auto graph = ApplyPass(prog, &scope);
+
+  EXPECT_EQ(GetNumOpNodes(graph, "matmul"), 0);
+  auto* op = FindOnlyOp(graph, "fusion_int8_fc");
+  EXPECT_EQ(BOOST_GET_CONST(int, op->GetAttr("in_num_col_dims")), 2);
+  EXPECT_FLOAT_EQ(BOOST_GET_CONST(float, op->GetAttr("Input_scale")), 0.05f);
+  // alpha is folded into the scales
+  auto op_scales =
+      BOOST_GET_CONST(std::vector<float>, op->GetAttr("weight_scale"));
+  ASSERT_EQ(op_scales.size(), scales.size());
+  for (size_t j = 0; j < scales.size(); ++j) {
+    EXPECT_FLOAT_EQ(op_scales[j], scales[j] * 0.5f);
+  }
+  ExpectPacked(scope, *op, "W", q.data(), k, n, true);
+}
+
+TEST(CPUInt8FCConvPass, matmul_v2_trans_x) {
+  ProgramDesc prog;
+  AddVar(&prog, "x", {4, 6});
+  AddVar(&prog, "y", {4, 3}, true);
+  AddVar(&prog, "out", {6, 3});
+  auto* matmul =
+      AddQuantizedOp(&prog, "matmul_v2", {{"X", {"x"}}, {"Y", {"y"}}},
+                     {{"Out", {"out"}}}, {0.1f});
+  matmul->SetAttr("trans_x", true);
+  matmul->SetAttr("trans_y", false);
+
+  Scope scope;
+  AddWeight(&scope, "y", {4, 3}, std::vector<float>(12, 0.1f));
+  auto graph = ApplyPass(prog, &scope);
+  EXPECT_EQ(GetNumOpNodes(graph, "matmul_v2"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "fusion_int8_fc"), 0);
+}
+
+TEST(CPUInt8FCConvPass, mul_requantizes_rescaled_channels) {
+  // the channel 1 is scaled after the quantization and leaves the grid
+  const int64_t k = 7, n = 3;
+  ProgramDesc prog;
+  AddVar(&prog, "x", {-1, k});
+  AddVar(&prog, "w", {k, n}, true);
+  AddVar(&prog, "out", {-1, n});
+  auto* mul = AddQuantizedOp(&prog, "mul", {{"X", {"x"}}, {"Y", {"w"}}},
+                             {{"Out", {"out"}}}, {0.25f});
+  mul->SetAttr("x_num_col_dims", 1);
+  mul->SetAttr("y_num_col_dims", 1);
+
+  auto q = Int8Values(k * n, 5);
+  std::vector<float> w(k * n);
+  float max_abs = 0.0f;
+  for (int64_t i = 0; i < k * n; ++i) {
+    w[i] = q[i] * 0.25f * (i % n == 1 ? 0.37f : 1.0f);
+    if (i % n == 1) max_abs = std::max(max_abs, std::fabs(w[i]));
+  }
+  const float requantized = max_abs / 127.0f;
+  std::vector<int8_t> expected(q);
+  for (int64_t i = 1; i < k * n; i += n) {
+    expected[i] = static_cast<int8_t>(std::round(w[i] / requantized));
+  }
+  Scope scope;
+  AddWeight(&scope, "w", {k, n}, w);
+  auto graph = ApplyPass(prog, &scope);
+
+  auto* op = FindOnlyOp(graph, "fusion_int8_fc");
+  auto op_scales =
+      BOOST_GET_CONST(std::vector<float>, op->GetAttr("weight_scale"));
+  ASSERT_EQ(op_scales.size(), 3UL);
+  EXPECT_FLOAT_EQ(op_scales[0], 0.25f);
+  EXPECT_FLOAT_EQ(op_scales[1], requantized);
+  EXPECT_FLOAT_EQ(op_scales[2], 0.25f);
+  ExpectPacked(scope, *op, "W", expected.data(), k, n, false);
+}
+
+TEST(CPUInt8FCConvPass, conv2d_groups_paddings_dilations) {
+  // (x, filter) conv2d(groups = 2) -> y, y elementwise_add(bias) -> out
+  const int oc = 6, ic_per_group = 3, groups = 2, kh = 3, kw = 2;
+  const int64_t k = ic_per_group * kh * kw;
+  const int64_t oc_per_group = oc / groups;
+  ProgramDesc prog;
+  AddVar(&prog, "x", {-1, ic_per_group * groups, 9, 9});
+  AddVar(&prog, "filter", {oc, ic_per_group, kh, kw}, true);
+  AddVar(&prog, "y", {-1, oc, 4, 10});
+  AddVar(&prog, "bias", {oc}, true);
+  AddVar(&prog, "out", {-1, oc, 4, 10});
+  std::vector<float> scales = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f};
+  auto* conv = AddQuantizedOp(
+      &prog, "conv2d", {{"Input", {"x"}}, {"Filter", {"filter"}}},
+      {{"Output", {"y"}}}, scales);
+  conv->SetAttr("groups", groups);
+  conv->SetAttr("strides", std::vector<int>({2, 1}));
+  conv->SetAttr("paddings", std::vector<int>({1, 0, 2, 1}));
+  conv->SetAttr("dilations", std::vector<int>({1, 2}));
+  conv->SetAttr("padding_algorithm", std::string("EXPLICIT"));
+  conv->SetAttr("data_format", std::string("NCHW"));
+  auto* add = prog.MutableBlock(0)->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"y"});
+  add->SetInput("Y", {"bias"});
+  add->SetOutput("Out", {"out"});
+  add->SetAttr("axis", 1);
+
+  auto q = Int8Values(oc * k, 7);
+  std::vector<float> filter(oc * k);
+  for (int64_t i = 0; i < oc * k; ++i) {
+    filter[i] = q[i] * scales[i / k];
+  }
+  Scope scope;
+  AddWeight(&scope, "filter", {oc, ic_per_group, kh, kw}, filter);
+  AddWeight(&scope, "bias", {oc}, std::vector<float>(oc, 0.5f));
+  auto graph = ApplyPass(prog, &scope);
+
+  EXPECT_EQ(GetNumOpNodes(graph, "conv2d"), 0);
+  // the elementwise_add is taken as the bias
+  EXPECT_EQ(GetNumOpNodes(graph, "elementwise_add"), 0);
+  auto* op = FindOnlyOp(graph, "fusion_int8_conv2d");
+  EXPECT_EQ(op->Input("Bias"), std::vector<std::string>({"bias"}));
+  EXPECT_EQ(op->Output("Output"), std::vector<std::string>({"out"}));
+  EXPECT_EQ(BOOST_GET_CONST(std::vector<int>, op->GetAttr("filter_shape")),
+            std::vector<int>({oc, ic_per_group, kh, kw}));
+  EXPECT_EQ(BOOST_GET_CONST(int, op->GetAttr("groups")), groups);
+  EXPECT_EQ(BOOST_GET_CONST(std::vector<int>, op->GetAttr("strides")),
+            std::vector<int>({2, 1}));
+  EXPECT_EQ(BOOST_GET_CONST(std::vector<int>, op->GetAttr("paddings")),
+            std::vector<int>({1, 0, 2, 1}));
+  EXPECT_EQ(BOOST_GET_CONST(std::vector<int>, op->GetAttr("dilations")),
+            std::vector<int>({1, 2}));
+  EXPECT_EQ(BOOST_GET_CONST(std::vector<float>, op->GetAttr("weight_scale")),
+            scales);
+  // every group is packed on its own
+  const int64_t group_size = phi::funcs::CpuInt8PackedSize(k, oc_per_group);
+  for (int g = 0; g < groups; ++g) {
+    ExpectPacked(scope, *op, "Filter", q.data() + g * oc_per_group * k, k,
+                 oc_per_group, true, g * group_size, g * oc_per_group);
+  }
+}
+
+TEST(CPUInt8FCConvPass, depthwise_conv2d) {
+  const int channels = 4, kh = 3, kw = 3;
+  ProgramDesc prog;
+  AddVar(&prog, "x", {-1, channels, 8, 8});
+  AddVar(&prog, "filter", {channels, 1, kh, kw}, true);
+  AddVar(&prog, "y", {-1, channels, 8, 8});
+  AddVar(&prog, "bias", {channels}, true);
+  AddVar(&prog, "out", {-1, channels, 8, 8});
+  auto* conv = AddQuantizedOp(
+      &prog, "depthwise_conv2d", {{"Input", {"x"}}, {"Filter", {"filter"}}},
+      {{"Output", {"y"}}}, {0.125f});
+  conv->SetAttr("groups", channels);
+  conv->SetAttr("strides", std::vector<int>({1, 1}));
+  conv->SetAttr("paddings", std::vector<int>({1, 1}));
+  conv->SetAttr("dilations", std::vector<int>({1, 1}));
+  conv->SetAttr("data_format", std::string("AnyLayout"));
+  // the add over the last axis is no channel bias and stays
+  auto* add = prog.MutableBlock(0)->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"y"});
+  add->SetInput("Y", {"bias"});
+  add->SetOutput("Out", {"out"});
+  add->SetAttr("axis", -1);
+
+  auto q = Int8Values(channels * kh * kw, 13);
+  std::vector<float> filter(q.size());
+  for (size_t i = 0; i < q.size(); ++i) {
+    filter[i] = q[i] * 0.125f;
+  }
+  Scope scope;
+  AddWeight(&scope, "filter", {channels, 1, kh, kw}, filter);
+  AddWeight(&scope, "bias", {channels}, std::vector<float>(channels, 0.5f));
+  auto graph = ApplyPass(prog, &scope);
+
+  EXPECT_EQ(GetNumOpNodes(graph, "depthwise_conv2d"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "elementwise_add"), 1);
+  auto* op = FindOnlyOp(graph, "fusion_int8_conv2d");
+  EXPECT_TRUE(op->Input("Bias").empty());
+  EXPECT_EQ(op->Output("Output"), std::vector<std::string>({"y"}));
+  EXPECT_EQ(BOOST_GET_CONST(int, op->GetAttr("groups")), channels);
+  EXPECT_EQ(BOOST_GET_CONST(std::vector<float>, op->GetAttr("weight_scale")),
+            std::vector<float>(channels, 0.125f));
+  const int64_t k = kh * kw;
+  for (int g = 0; g < channels; ++g) {
+    ExpectPacked(scope, *op, "Filter", q.data() + g * k, k, 1, true,
+                 g * phi::funcs::CpuInt8PackedSize(k, 1), g);
+  }
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(cpu_int8_fc_conv_pass);
@@ -65,7 +65,7 @@ class OperationExpression {
   std::string GetRHSType() const { return rhs_type_; }
   std::string GetLHSType() const { return lhs_type_; }
   void SetAttr(AttributeMap attr) { attr_ = attr; }
-  AttributeMap GetAttr() { return attr_; }
+  AttributeMap GetAttr() const { return attr_; }
   // Check whether this operation type is supported in OperationMap.
   bool IsSupport() const;
 
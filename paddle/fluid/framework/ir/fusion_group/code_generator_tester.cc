@@ -17,6 +17,7 @@ limitations under the License. */
 #include <string>
 
 #include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_elementwise_kernel.h"
 #include "paddle/fluid/framework/ir/fusion_group/operation.h"
 #include "paddle/fluid/framework/ir/pass_tester_helper.h"
 #include "paddle/fluid/platform/device_code.h"
@@ -26,8 +27,6 @@ namespace phi {
 class DenseTensor;
 }  // namespace phi
 
-#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
-
 namespace paddle {
 namespace framework {
 namespace ir {
@@ -169,6 +168,7 @@ void SetupRandomCPUTensor(LoDTensor* tensor) {
 
 namespace fusion_group = paddle::framework::ir::fusion_group;
 
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 template <typename T>
 void TestMainImpl(std::string func_name, std::string code_str,
                   std::vector<paddle::framework::LoDTensor> cpu_tensors, int n,
@@ -369,6 +369,8 @@ TEST(code_generator, elementwise_grad) {
   }
 }
 
+#endif
+
 std::unique_ptr<paddle::framework::ir::Graph> BuildGraph(bool backward,
                                                          std::string dtype) {
   // inputs                     operator            output
@@ -467,6 +469,7 @@ std::unordered_set<paddle::framework::ir::Node*> DistilGradNodes(
   return grad_nodes;
 }
 
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 TEST(code_generator, subgraph) {
   for (std::string dtype : {"float", "__half"}) {
     std::unique_ptr<paddle::framework::ir::Graph> graph =
@@ -505,3 +508,147 @@ TEST(code_generator, subgraph_grad) {
   }
 }
 #endif
+
+// Runs the CPU kernel of the expressions on float tensors of n elements, the
+// inputs are set up randomly and the outputs are returned in cpu_tensors.
+void RunOnCPU(std::string func_name,
+              std::vector<fusion_group::OperationExpression> expressions,
+              std::vector<paddle::framework::LoDTensor>* cpu_tensors, int n,
+              std::vector<int> input_ids, std::vector<int> output_ids) {
+  auto kernel = fusion_group::CPUElementwiseKernel::Create(func_name,
+                                                           expressions);
+  ASSERT_NE(kernel, nullptr);
+
+  size_t num = n;
+  std::vector<float*> ptrs(cpu_tensors->size());
+  std::vector<void*> args;
+  args.push_back(&num);
+  for (auto id : input_ids) {
+    if (id >= 0) {
+      fusion_group::SetupRandomCPUTensor<float>(&(*cpu_tensors)[id]);
+      ptrs[id] = (*cpu_tensors)[id].data<float>();
+      args.push_back(&ptrs[id]);
+    }
+  }
+  for (auto id : output_ids) {
+    ptrs[id] = (*cpu_tensors)[id].data<float>();
+    args.push_back(&ptrs[id]);
+  }
+  paddle::platform::CPUDeviceContext dev_ctx;
+  kernel->Launch(dev_ctx, num, &args);
+}
+
+void TestCPUMain(std::string func_name,
+                 std::vector<fusion_group::OperationExpression> expressions,
+                 std::vector<int> input_ids, std::vector<int> output_ids) {
+  std::unordered_set<int> ids(input_ids.begin(), input_ids.end());
+  ids.insert(output_ids.begin(), output_ids.end());
+  ids.erase(-1);
+
+  // An odd size to check the last tile.
+  std::vector<paddle::framework::LoDTensor> cpu_tensors(ids.size());
+  auto dims = phi::make_ddim({257, 1023});
+  for (size_t i = 0; i < cpu_tensors.size(); ++i) {
+    cpu_tensors[i].mutable_data<float>(dims, paddle::platform::CPUPlace());
+  }
+  int n = cpu_tensors[0].numel();
+  RunOnCPU(func_name, expressions, &cpu_tensors, n, input_ids, output_ids);
+  for (int i = 0; i < n; i++) {
+    fusion_group::CheckOutput(expressions, cpu_tensors, input_ids, output_ids,
+                              i, 1E-5);
+  }
+}
+
+TEST(code_generator, cpu_elementwise) {
+  std::string dtype = "float";
+  fusion_group::OperationExpression exp1("elementwise_mul", {0, 1}, {2},
+                                         dtype, dtype);
+  fusion_group::OperationExpression exp2("elementwise_add", {2, 3}, {4},
+                                         dtype, dtype);
+  fusion_group::OperationExpression exp3("elementwise_sub", {4, 5}, {6},
+                                         dtype, dtype);
+  fusion_group::OperationExpression exp4("relu", {6}, {7}, dtype, dtype);
+  fusion_group::OperationExpression exp5("sigmoid", {7}, {8}, dtype, dtype);
+  std::vector<fusion_group::OperationExpression> expressions = {
+      exp1, exp2, exp3, exp4, exp5};
+
+  TestCPUMain("cpu_elementwise_kernel_0", expressions, {0, 1, 3, 5},
+              {2, 4, 6, 7, 8});
+}
+
+TEST(code_generator, cpu_elementwise_grad) {
+  std::string dtype = "float";
+  fusion_group::OperationExpression exp1("relu_grad", {-1, 3, 7}, {6}, dtype,
+                                         dtype);
+  fusion_group::OperationExpression exp2("elementwise_mul_grad", {0, 1, 2, 6},
+                                         {4, 5}, dtype, dtype);
+  std::vector<fusion_group::OperationExpression> expressions = {exp1, exp2};
+
+  TestCPUMain("cpu_elementwise_grad_kernel_0", expressions, {0, 1, 2, 3, 7},
+              {4, 5, 6});
+}
+
+TEST(code_generator, cpu_subgraph) {
+  std::unique_ptr<paddle::framework::ir::Graph> graph =
+      BuildGraph(false, "float");
+  fusion_group::SubGraph subgraph(0, "cpu_elementwise_kernel_1", true,
+                                  graph->Nodes());
+  fusion_group::OperationMap::Init();
+  fusion_group::CodeGenerator code_generator;
+  TestCPUMain(subgraph.GetFuncName(),
+              code_generator.ConvertToExpressions(&subgraph), {0, 1, 2, 3},
+              {4, 5, 6, 7, 8});
+}
+
+TEST(code_generator, cpu_unsupported_dtype) {
+  // float16 is not supported on CPU, such groups are not fused.
+  std::string dtype = "__half";
+  fusion_group::OperationExpression exp1("relu", {0}, {1}, dtype, dtype);
+  EXPECT_EQ(fusion_group::CPUElementwiseKernel::Create("cpu_half_kernel",
+                                                       {exp1}),
+            nullptr);
+}
+
+TEST(code_generator, cpu_mlp_activation) {
+  // The activation of a MLP layer: t3 = sigmoid(relu(t0 + t1) * t2), which
+  // is run by the fused kernel and by a loop for every operator.
+  std::string dtype = "float";
+  std::vector<fusion_group::OperationExpression> expressions = {
+      fusion_group::OperationExpression("elementwise_add", {0, 1}, {4}, dtype,
+                                        dtype, {4}),
+      fusion_group::OperationExpression("relu", {4}, {5}, dtype, dtype, {5}),
+      fusion_group::OperationExpression("elementwise_mul", {5, 2}, {6}, dtype,
+                                        dtype, {6}),
+      fusion_group::OperationExpression("sigmoid", {6}, {3}, dtype, dtype)};
+  auto kernel = fusion_group::CPUElementwiseKernel::Create(
+      "cpu_mlp_activation_kernel", expressions);
+  ASSERT_NE(kernel, nullptr);
+
+  const int n = 10007;
+  std::vector<paddle::framework::LoDTensor> cpu_tensors(7);
+  std::vector<float*> ptrs(cpu_tensors.size());
+  for (size_t i = 0; i < cpu_tensors.size(); ++i) {
+    cpu_tensors[i].mutable_data<float>(phi::make_ddim({n}),
+                                       paddle::platform::CPUPlace());
+    fusion_group::SetupRandomCPUTensor<float>(&cpu_tensors[i]);
+    ptrs[i] = cpu_tensors[i].data<float>();
+  }
+  // the intermediate outputs are not arguments of the fused kernel
+  size_t num = n;
+  std::vector<void*> args = {&num, &ptrs[0], &ptrs[1], &ptrs[2], &ptrs[3]};
+  paddle::platform::CPUDeviceContext dev_ctx;
+  kernel->Launch(dev_ctx, num, &args);
+
+  for (int i = 0; i < n; ++i) {
+    ptrs[4][i] = ptrs[0][i] + ptrs[1][i];
+  }
+  for (int i = 0; i < n; ++i) {
+    ptrs[5][i] = fusion_group::relu(ptrs[4][i]);
+  }
+  for (int i = 0; i < n; ++i) {
+    ptrs[6][i] = ptrs[5][i] * ptrs[2][i];
+  }
+  for (int i = 0; i < n; ++i) {
+    EXPECT_NEAR(ptrs[3][i], fusion_group::sigmoid(ptrs[6][i]), 1E-6);
+  }
+}
@@ -0,0 +1,508 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/ir/fusion_group/cpu_elementwise_kernel.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <unordered_set>
+
+#include "Eigen/Core"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+// the elements of a tile, the registers of a program are tiles
+constexpr int64_t kCPUKernelTile = 256;
+// the elements computed by one intra-op thread at least
+constexpr int64_t kCPUKernelGrainSize = 32768;
+
+static bool IsSupportedOnCPU(const OperationExpression& expression) {
+  static const std::unordered_set<std::string> op_types = {
+      "relu",
+      "relu_grad",
+      "sigmoid",
+      "sigmoid_grad",
+      "tanh",
+      "tanh_grad",
+      "sqrt",
+      "sqrt_grad",
+      "square",
+      "square_grad",
+      "assign",
+      "cast",
+      "scale",
+      "elementwise_add",
+      "elementwise_add_grad",
+      "elementwise_sub",
+      "elementwise_sub_grad",
+      "elementwise_mul",
+      "elementwise_mul_grad",
+      "elementwise_div",
+      "elementwise_div_grad",
+      "elementwise_min",
+      "elementwise_min_grad",
+      "elementwise_max",
+      "elementwise_max_grad",
+      "sum",
+      "fill_constant"};
+  auto is_supported_type = [](const std::string& type) {
+    return type == "float" || type == "double";
+  };
+  return op_types.count(expression.GetOpType()) &&
+         is_supported_type(expression.GetLHSType()) &&
+         (expression.GetInputIds().empty() ||
+          is_supported_type(expression.GetRHSType()));
+}
+
+template <typename T>
+static T GetAttrOr(const AttributeMap& attrs, const std::string& name,
+                   T default_value) {
+  auto iter = attrs.find(name);
+  return iter == attrs.end() ? default_value
+                             : BOOST_GET_CONST(T, iter->second);
+}
+
+std::unique_ptr<CPUElementwiseKernel> CPUElementwiseKernel::Create(
+    const std::string& name,
+    const std::vector<OperationExpression>& expressions) {
+  for (auto& expression : expressions) {
+    if (!IsSupportedOnCPU(expression)) {
+      VLOG(3) << "The fusion group " << name << " cannot run on CPU, "
+              << DebugString(expression) << " is not supported.";
+      return nullptr;
+    }
+  }
+  return std::unique_ptr<CPUElementwiseKernel>(
+      new CPUElementwiseKernel(name, expressions));
+}
+
+CPUElementwiseKernel::CPUElementwiseKernel(
+    const std::string& name,
+    const std::vector<OperationExpression>& expressions)
+    : name_(name) {
+  // The parameters are ordered as the generated code does: the inputs
+  // which are not outputs, then the outputs which are not intermediate.
+  std::set<int> input_ids, output_ids, intermediate_ids;
+  std::unordered_map<int, bool> is_double;
+  for (auto& expression : expressions) {
+    for (auto id : expression.GetInputIds()) {
+      if (id >= 0) {
+        input_ids.insert(id);
+        is_double[id] = expression.GetRHSType() == "double";
+      }
+    }
+    for (auto id : expression.GetOutputIds()) {
+      output_ids.insert(id);
+      is_double[id] = expression.GetLHSType() == "double";
+    }
+    for (auto id : expression.GetIntermediateOutputIds()) {
+      intermediate_ids.insert(id);
+    }
+  }
+  for (auto& item : is_double) {
+    use_double_ |= item.second;
+  }
+  for (auto id : input_ids) {
+    if (!output_ids.count(id)) {
+      input_params_[id] = params_.size();
+      params_.push_back({is_double[id], false});
+    }
+  }
+  std::vector<std::pair<int, int>> stored;  // (var, param)
+  for (auto id : output_ids) {
+    if (!intermediate_ids.count(id)) {
+      stored.emplace_back(id, params_.size());
+      params_.push_back({is_double[id], true});
+    }
+  }
+
+  for (auto& expression : expressions) {
+    const auto& ids = expression.GetOutputIds();
+    for (size_t i = 0; i < ids.size(); ++i) {
+      int reg = EmitOperation(expression, i);
+      // a float variable keeps the precision of float in a double program
+      if (use_double_ && expression.GetLHSType() == "float") {
+        reg = Emit(Op::kRoundToFloat, reg);
+      }
+      var_regs_[ids[i]] = reg;
+    }
+  }
+  for (auto& item : stored) {
+    stores_.emplace_back(var_regs_.at(item.first), item.second);
+  }
+  AssignSlots();
+}
+
+int CPUElementwiseKernel::NewRegister() {
+  is_result_.push_back(false);
+  return is_result_.size() - 1;
+}
+
+int CPUElementwiseKernel::Load(int param) {
+  auto iter = load_regs_.find(param);
+  if (iter != load_regs_.end()) {
+    return iter->second;
+  }
+  int reg = NewRegister();
+  load_regs_[param] = reg;
+  loads_.emplace_back(param, reg);
+  return reg;
+}
+
+int CPUElementwiseKernel::Constant(double value) {
+  auto iter = constant_regs_.find(value);
+  if (iter != constant_regs_.end()) {
+    return iter->second;
+  }
+  int reg = NewRegister();
+  constant_regs_[value] = reg;
+  constants_.emplace_back(reg, value);
+  return reg;
+}
+
+int CPUElementwiseKernel::Emit(Op op, int a, int b, int c) {
+  int out = NewRegister();
+  is_result_[out] = true;
+  instructions_.push_back({op, out, {a, b, c}});
+  return out;
+}
+
+// The instructions of the i-th output of the expression, following the
+// definitions of the operations in OperationMap.
+int CPUElementwiseKernel::EmitOperation(const OperationExpression& expression,
+                                        size_t i) {
+  const std::string op_type = expression.GetOpType();
+  const std::vector<int> input_ids = expression.GetInputIds();
+  auto in = [&](size_t index) {
+    PADDLE_ENFORCE_LT(index, input_ids.size(),
+                      platform::errors::InvalidArgument(
+                          "Only %d inputs are provided, but need %d for "
+                          "operation < %s >.",
+                          input_ids.size(), index + 1, op_type));
+    int id = input_ids[index];
+    PADDLE_ENFORCE_GE(id, 0, platform::errors::InvalidArgument(
+                                 "Expected %d-th input id > 0 for operation "
+                                 "< %s >. Received %d.",
+                                 index, op_type, id));
+    auto iter = var_regs_.find(id);
+    return iter != var_regs_.end() ? iter->second
+                                   : Load(input_params_.at(id));
+  };
+  auto one = [&] { return Constant(1.0); };
+  auto zero = [&] { return Constant(0.0); };
+
+  // forward: x, y, out; backward: x, y, out, dout
+  if (op_type == "relu") {
+    return Emit(Op::kMax, in(0), zero());
+  } else if (op_type == "relu_grad") {
+    return Emit(Op::kSelect, Emit(Op::kGT, in(1), zero()), in(2), zero());
+  } else if (op_type == "sigmoid") {
+    return Emit(Op::kDiv, one(),
+                Emit(Op::kAdd, one(), Emit(Op::kExp, Emit(Op::kNeg, in(0)))));
+  } else if (op_type == "sigmoid_grad") {
+    return Emit(Op::kMul, Emit(Op::kMul, in(2), in(1)),
+                Emit(Op::kSub, one(), in(1)));
+  } else if (op_type == "tanh") {
+    int e = Emit(Op::kExp, Emit(Op::kMul, Constant(-2.0), in(0)));
+    return Emit(Op::kSub,
+                Emit(Op::kDiv, Constant(2.0), Emit(Op::kAdd, one(), e)), one());
+  } else if (op_type == "tanh_grad") {
+    return Emit(Op::kMul, in(2),
+                Emit(Op::kSub, one(), Emit(Op::kMul, in(1), in(1))));
+  } else if (op_type == "sqrt") {
+    return Emit(Op::kSqrt, in(0));
+  } else if (op_type == "sqrt_grad") {
+    return Emit(Op::kDiv, Emit(Op::kMul, in(2), Constant(0.5)), in(1));
+  } else if (op_type == "square") {
+    return Emit(Op::kMul, in(0), in(0));
+  } else if (op_type == "square_grad") {
+    return Emit(Op::kMul, Emit(Op::kMul, in(2), Constant(2.0)), in(0));
+  } else if (op_type == "assign" || op_type == "cast") {
+    return in(0);
+  } else if (op_type == "scale") {
+    const AttributeMap attrs = expression.GetAttr();
+    int scale = Constant(GetAttrOr<float>(attrs, "scale", 1.0f));
+    int bias = Constant(GetAttrOr<float>(attrs, "bias", 0.0f));
+    if (GetAttrOr<bool>(attrs, "bias_after_scale", true)) {
+      return Emit(Op::kAdd, Emit(Op::kMul, scale, in(0)), bias);
+    }
+    return Emit(Op::kMul, scale, Emit(Op::kAdd, in(0), bias));
+  } else if (op_type == "elementwise_add") {
+    return Emit(Op::kAdd, in(0), in(1));
+  } else if (op_type == "elementwise_add_grad") {
+    return in(3);
+  } else if (op_type == "elementwise_sub") {
+    return Emit(Op::kSub, in(0), in(1));
+  } else if (op_type == "elementwise_sub_grad") {
+    return i == 0 ? in(3) : Emit(Op::kNeg, in(3));
+  } else if (op_type == "elementwise_mul") {
+    return Emit(Op::kMul, in(0), in(1));
+  } else if (op_type == "elementwise_mul_grad") {
+    return Emit(Op::kMul, in(3), i == 0 ? in(1) : in(0));
+  } else if (op_type == "elementwise_div") {
+    return Emit(Op::kDiv, in(0), in(1));
+  } else if (op_type == "elementwise_div_grad") {
+    if (i == 0) {
+      return Emit(Op::kDiv, in(3), in(1));
+    }
+    return Emit(Op::kDiv, Emit(Op::kMul, Emit(Op::kNeg, in(3)), in(2)), in(1));
+  } else if (op_type == "elementwise_min") {
+    return Emit(Op::kSelect, Emit(Op::kLT, in(0), in(1)), in(0), in(1));
+  } else if (op_type == "elementwise_min_grad") {
+    Op mask = i == 0 ? Op::kLT : Op::kGE;
+    return Emit(Op::kMul, in(3), Emit(mask, in(0), in(1)));
+  } else if (op_type == "elementwise_max") {
+    return Emit(Op::kSelect, Emit(Op::kGT, in(0), in(1)), in(0), in(1));
+  } else if (op_type == "elementwise_max_grad") {
+    Op mask = i == 0 ? Op::kGT : Op::kLE;
+    return Emit(Op::kMul, in(3), Emit(mask, in(0), in(1)));
+  } else if (op_type == "sum") {
+    int reg = in(0);
+    for (size_t k = 1; k < input_ids.size(); ++k) {
+      reg = Emit(Op::kAdd, reg, in(k));
+    }
+    return reg;
+  } else if (op_type == "fill_constant") {
+    const AttributeMap attrs = expression.GetAttr();
+    std::string str_value = GetAttrOr<std::string>(attrs, "str_value", "");
+    return Constant(str_value.empty()
+                        ? GetAttrOr<float>(attrs, "value", 0.0f)
+                        : std::strtod(str_value.c_str(), nullptr));
+  }
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Operation %s is not supported on CPU.", op_type));
+}
+
+void CPUElementwiseKernel::AssignSlots() {
+  slots_.assign(is_result_.size(), -1);
+  for (auto& load : loads_) {
+    if (params_[load.first].is_double != use_double_) {
+      slots_[load.second] = num_slots_++;
+    }
+  }
+  for (auto& constant : constants_) {
+    slots_[constant.first] = num_slots_++;
+  }
+  // the results are freed after their last use, the stored ones never
+  const int kNeverFreed = instructions_.size();
+  std::vector<int> last_use(is_result_.size(), -1);
+  for (size_t i = 0; i < instructions_.size(); ++i) {
+    for (int in : instructions_[i].in) {
+      if (in >= 0) {
+        last_use[in] = i;
+      }
+    }
+  }
+  for (auto& store : stores_) {
+    last_use[store.first] = kNeverFreed;
+  }
+  std::vector<int> free_slots;
+  for (size_t i = 0; i < instructions_.size(); ++i) {
+    auto& instruction = instructions_[i];
+    for (int in : instruction.in) {
+      // an operand used twice is freed once
+      if (in >= 0 && is_result_[in] && last_use[in] == static_cast<int>(i)) {
+        free_slots.push_back(slots_[in]);
+        last_use[in] = -1;
+      }
+    }
+    if (free_slots.empty()) {
+      slots_[instruction.out] = num_slots_++;
+    } else {
+      slots_[instruction.out] = free_slots.back();
+      free_slots.pop_back();
+    }
+    if (last_use[instruction.out] < 0) {
+      free_slots.push_back(slots_[instruction.out]);
+    }
+  }
+}
+
+template <typename T, typename Fn>
+static void CPUKernelLoop(const T* a, const T* b, T* out, int64_t n, Fn fn) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = fn(a[i], b[i]);
+  }
+}
+
+template <typename Src, typename Dst>
+static void ConvertTile(const Src* src, Dst* dst, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<Dst>(src[i]);
+  }
+}
+
+template <typename T>
+void CPUElementwiseKernel::RunTiles(const std::vector<void*>& params,
+                                    int64_t n, int64_t begin,
+                                    int64_t end) const {
+  using Array = Eigen::Array<T, Eigen::Dynamic, 1>;
+  std::vector<T> buffers(num_slots_ * kCPUKernelTile);
+  std::vector<const T*> regs(slots_.size());
+  auto buffer = [&](int reg) {
+    return buffers.data() + slots_[reg] * kCPUKernelTile;
+  };
+  for (auto& constant : constants_) {
+    T* data = buffer(constant.first);
+    std::fill(data, data + kCPUKernelTile, static_cast<T>(constant.second));
+    regs[constant.first] = data;
+  }
+  const T one = static_cast<T>(1);
+  const T zero = static_cast<T>(0);
+  for (int64_t tile = begin; tile < end; ++tile) {
+    const int64_t offset = tile * kCPUKernelTile;
+    const int64_t len = std::min(kCPUKernelTile, n - offset);
+    for (auto& load : loads_) {
+      const void* src = params[load.first];
+      if (slots_[load.second] < 0) {
+        regs[load.second] = static_cast<const T*>(src) + offset;
+        continue;
+      }
+      if (params_[load.first].is_double) {
+        ConvertTile(static_cast<const double*>(src) + offset,
+                    buffer(load.second), len);
+      } else {
+        ConvertTile(static_cast<const float*>(src) + offset,
+                    buffer(load.second), len);
+      }
+      regs[load.second] = buffer(load.second);
+    }
+    // the arithmetic is done by Eigen, the comparisons and the selects are
+    // loops the compiler vectorizes with masks
+    for (auto& instruction : instructions_) {
+      T* out = buffer(instruction.out);
+      const T* x = regs[instruction.in[0]];
+      const T* y = instruction.in[1] >= 0 ? regs[instruction.in[1]] : nullptr;
+      Eigen::Map<Array> o(out, len);
+      Eigen::Map<const Array> a(x, len);
+      auto b = [&] { return Eigen::Map<const Array>(y, len); };
+      switch (instruction.op) {
+        case Op::kNeg:
+          o = -a;
+          break;
+        case Op::kAdd:
+          o = a + b();
+          break;
+        case Op::kSub:
+          o = a - b();
+          break;
+        case Op::kMul:
+          o = a * b();
+          break;
+        case Op::kDiv:
+          o = a / b();
+          break;
+        case Op::kLT:
+          CPUKernelLoop(x, y, out, len,
+                        [=](T u, T v) { return u < v ? one : zero; });
+          break;
+        case Op::kGT:
+          CPUKernelLoop(x, y, out, len,
+                        [=](T u, T v) { return u > v ? one : zero; });
+          break;
+        case Op::kLE:
+          CPUKernelLoop(x, y, out, len,
+                        [=](T u, T v) { return u <= v ? one : zero; });
+          break;
+        case Op::kGE:
+          CPUKernelLoop(x, y, out, len,
+                        [=](T u, T v) { return u >= v ? one : zero; });
+          break;
+        case Op::kSelect: {
+          const T* z = regs[instruction.in[2]];
+          for (int64_t i = 0; i < len; ++i) {
+            out[i] = x[i] != zero ? y[i] : z[i];
+          }
+          break;
+        }
+        case Op::kExp:
+          o = a.exp();
+          break;
+        case Op::kSqrt:
+          o = a.sqrt();
+          break;
+        case Op::kMax:
+          CPUKernelLoop(x, y, out, len, [](T u, T v) { return u > v ? u : v; });
+          break;
+        case Op::kRoundToFloat:
+          o = a.template cast<float>().template cast<T>();
+          break;
+      }
+      regs[instruction.out] = out;
+    }
+    for (auto& store : stores_) {
+      void* dst = params[store.second];
+      if (params_[store.second].is_double) {
+        ConvertTile(regs[store.first], static_cast<double*>(dst) + offset,
+                    len);
+      } else {
+        ConvertTile(regs[store.first], static_cast<float*>(dst) + offset, len);
+      }
+    }
+  }
+}
+
+void CPUElementwiseKernel::Launch(const platform::CPUDeviceContext& ctx,
+                                  const size_t n,
+                                  std::vector<void*>* args) const {
+  PADDLE_ENFORCE_EQ(
+      args->size(), params_.size() + 1,
+      platform::errors::InvalidArgument(
+          "The CPU kernel < %s > expects %d arguments, but received %d.",
+          name_, params_.size() + 1, args->size()));
+  std::vector<void*> params(params_.size());
+  for (size_t i = 0; i < params.size(); ++i) {
+    params[i] = *static_cast<void**>((*args)[i + 1]);
+  }
+  const int64_t num_tiles = (n + kCPUKernelTile - 1) / kCPUKernelTile;
+  ctx.ParallelFor(0, num_tiles, kCPUKernelGrainSize / kCPUKernelTile,
+                  [&](int64_t begin, int64_t end) {
+                    if (use_double_) {
+                      RunTiles<double>(params, n, begin, end);
+                    } else {
+                      RunTiles<float>(params, n, begin, end);
+                    }
+                  });
+}
+
+void CPUElementwiseKernelPool::Set(
+    std::unique_ptr<CPUElementwiseKernel>&& kernel) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string name = kernel->GetName();
+  PADDLE_ENFORCE_EQ(kernels_.count(name), 0UL,
+                    platform::errors::AlreadyExists(
+                        "The CPU kernel of fusion group %s already exists.",
+                        name));
+  kernels_.emplace(name, std::move(kernel));
+}
+
+const CPUElementwiseKernel* CPUElementwiseKernelPool::Get(
+    const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = kernels_.find(name);
+  PADDLE_ENFORCE_NE(iter, kernels_.end(),
+                    platform::errors::NotFound(
+                        "The CPU kernel of fusion group %s does not exist.",
+                        name));
+  return iter->second.get();
+}
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,157 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/ir/fusion_group/code_generator_helper.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+// Runs an elementwise fusion group on CPU. The expressions of the group are
+// translated into a program of vectorized operations, one to a few for
+// every operation, instead of generating and compiling code. Launch runs
+// the program on tiles of the elements split among the intra-op threads of
+// the context, so every input and output is touched once and the
+// intermediate values stay in the cache.
+class CPUElementwiseKernel {
+ public:
+  // Returns nullptr if the group cannot run on CPU, such as a group of
+  // float16 variables, and the group stays unfused.
+  static std::unique_ptr<CPUElementwiseKernel> Create(
+      const std::string& name,
+      const std::vector<OperationExpression>& expressions);
+
+  const std::string& GetName() const { return name_; }
+
+  // The arguments are those of the generated CUDA kernel: args[0] points to
+  // the number of elements, the others to the data of the inputs and the
+  // outputs ordered by their ids.
+  void Launch(const platform::CPUDeviceContext& ctx, const size_t n,
+              std::vector<void*>* args) const;
+
+ private:
+  enum class Op {
+    kNeg,
+    kAdd,
+    kSub,
+    kMul,
+    kDiv,
+    kLT,
+    kGT,
+    kLE,
+    kGE,
+    kSelect,
+    kExp,
+    kSqrt,
+    kMax,
+    kRoundToFloat
+  };
+
+  struct Instruction {
+    Op op;
+    int out;
+    int in[3];
+  };
+
+  struct Param {
+    bool is_double;
+    bool is_output;
+  };
+
+  CPUElementwiseKernel(const std::string& name,
+                       const std::vector<OperationExpression>& expressions);
+
+  int NewRegister();
+  int Load(int param);
+  int Constant(double value);
+  int Emit(Op op, int a, int b = -1, int c = -1);
+  int EmitOperation(const OperationExpression& expression, size_t i);
+  void AssignSlots();
+
+  // Runs the tiles [begin, end) of the n elements.
+  template <typename T>
+  void RunTiles(const std::vector<void*>& params, int64_t n, int64_t begin,
+                int64_t end) const;
+
+  std::string name_;
+  bool use_double_{false};
+  std::vector<Param> params_;
+  std::vector<std::pair<int, int>> loads_;         // (param, register)
+  std::vector<std::pair<int, double>> constants_;  // (register, value)
+  std::vector<Instruction> instructions_;
+  std::vector<std::pair<int, int>> stores_;  // (register, param)
+  // The tile buffer of every register. The results reuse the buffers of
+  // the registers used for the last time, and the inputs of the compute
+  // type are read in place (-1).
+  std::vector<int> slots_;
+  int num_slots_{0};
+
+  // The registers of the variables, the parameters of the inputs and the
+  // constants while the program is built.
+  std::unordered_map<int, int> var_regs_;
+  std::unordered_map<int, int> input_params_;
+  std::unordered_map<int, int> load_regs_;
+  std::unordered_map<double, int> constant_regs_;
+  std::vector<bool> is_result_;
+};
+
+// The CPU kernels of the fusion groups by name, as platform::DeviceCodePool
+// holds the CUDA ones.
+class CPUElementwiseKernelPool {
+ public:
+  static CPUElementwiseKernelPool& Instance() {
+    static CPUElementwiseKernelPool pool;
+    return pool;
+  }
+
+  // The kernel name must not be used by another kernel of the pool.
+  void Set(std::unique_ptr<CPUElementwiseKernel>&& kernel);
+
+  const CPUElementwiseKernel* Get(const std::string& name) const;
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return kernels_.size();
+  }
+
+  // A new index for the name of a kernel, never returned twice even when
+  // several passes run at once.
+  int NewIndex() { return next_index_.fetch_add(1); }
+
+ private:
+  CPUElementwiseKernelPool() = default;
+
+  std::atomic<int> next_index_{0};
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::unique_ptr<CPUElementwiseKernel>>
+      kernels_;
+  DISABLE_COPY_AND_ASSIGN(CPUElementwiseKernelPool);
+};
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
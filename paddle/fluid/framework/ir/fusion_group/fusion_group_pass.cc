@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/ir/fusion_group/fusion_group_pass.h"
 #include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_elementwise_kernel.h"
 #include "paddle/fluid/framework/ir/fusion_group/elementwise_group_detector.h"
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
 #include "paddle/fluid/framework/ir/pass_tester_helper.h"
@@ -33,27 +34,35 @@ class Node;
 
 void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
   FusePassBase::Init("fusion_group_pass", graph);
+  // TODO(liuyiqun): open this check.
+  // if (Get<bool>("use_gpu") && !platform::CUDADeviceCode::IsAvailable()) {
+  //   LOG(WARNING)
+  //       << "Disable fusion_group because CUDA Driver or NVRTC is not
+  //       avaiable.";
+  //   return 0;
+  // }
+
+  // Without GPU, the groups run as fusion_group::CPUElementwiseKernel.
+  fusion_group::OperationMap::Init();
+  int num_elementwise_groups = DetectFusionGroup(graph, 0);
+  AddStatis(num_elementwise_groups);
+  LOG(INFO) << "Detect " << num_elementwise_groups
+            << " elementwise fusion groups.";
+}
+
+platform::Place FusionGroupPass::GetPlace() const {
+  // TODO(liuyiqun): supported different places
   if (Get<bool>("use_gpu")) {
-    // TODO(liuyiqun): open this check.
-    // if (!platform::CUDADeviceCode::IsAvailable()) {
-    //   LOG(WARNING)
-    //       << "Disable fusion_group because CUDA Driver or NVRTC is not
-    //       avaiable.";
-    //   return 0;
-    // }
-
-    fusion_group::OperationMap::Init();
-    int num_elementwise_groups = DetectFusionGroup(graph, 0);
-    AddStatis(num_elementwise_groups);
-    LOG(INFO) << "Detect " << num_elementwise_groups
-              << " elementwise fusion groups.";
+    return platform::CUDAPlace(0);
   }
+  return platform::CPUPlace();
 }
 
 int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  int index = platform::DeviceCodePool::Init({place}).size(place);
+  platform::Place place = GetPlace();
+  int index = is_gpu_place(place)
+                  ? platform::DeviceCodePool::Init({place}).size(place)
+                  : 0;
 
   std::vector<std::vector<Node*>> subgraphs =
       fusion_group::ElementwiseGroupDetector()(graph);
@@ -68,7 +77,13 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
     VLOG(3) << "subgraph: {\n" << DebugString(subgraph.SortedNodes()) << "}\n";
 
     if (subgraph.IsValid(min_subgraph_size)) {
-      subgraph.SetFuncName("fused_elementwise_" + std::to_string(index++));
+      // The passes of several programs may build CPU kernels at once, so
+      // their names come from the counter of the pool.
+      int func_index =
+          is_gpu_place(place)
+              ? index++
+              : fusion_group::CPUElementwiseKernelPool::Instance().NewIndex();
+      subgraph.SetFuncName("fused_elementwise_" + std::to_string(func_index));
       if (GenerateCode(&subgraph)) {
         InsertFusionGroupOp(graph, &subgraph);
         num_subgraphs++;
@@ -79,12 +94,23 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
 }
 
 bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
+  platform::Place place = GetPlace();
   fusion_group::CodeGenerator code_generator;
+  if (is_cpu_place(place)) {
+    // The CPU kernel is built from the expressions, no code is generated.
+    auto kernel = fusion_group::CPUElementwiseKernel::Create(
+        subgraph->GetFuncName(), code_generator.ConvertToExpressions(subgraph));
+    if (kernel == nullptr) {
+      return false;
+    }
+    fusion_group::CPUElementwiseKernelPool::Instance().Set(std::move(kernel));
+    return true;
+  }
+
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(4) << code_str;
 
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
   std::unique_ptr<platform::CUDADeviceCode> device_code(
       new platform::CUDADeviceCode(place, subgraph->GetFuncName(), code_str));
   bool is_compiled = device_code->Compile();
@@ -93,6 +119,9 @@ bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
     pool.Set(std::move(device_code));
   }
   return is_compiled;
+#else
+  return false;
+#endif
 }
 
 static int ExtractOpRole(fusion_group::SubGraph* subgraph) {
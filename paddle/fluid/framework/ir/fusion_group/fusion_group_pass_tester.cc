@@ -135,7 +135,11 @@ std::unique_ptr<Graph> BuildElementwiseTreeGraph(bool backward = false) {
 int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
   // VisualizeGraph(&graph, prefix + ".dot");
   auto pass = PassRegistry::Instance().Get("fusion_group_pass");
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   pass->Set("use_gpu", new bool(true));
+#else
+  pass->Set("use_gpu", new bool(false));
+#endif
   VLOG(3) << DebugString(graph);
 
   graph.reset(pass->Apply(graph.release()));
@@ -279,6 +279,25 @@ void Graph::ResolveHazard(
   }
 }
 
+void Graph::RefreshOpTypeIndex() {
+  if (FLAGS_convert_all_blocks) {
+    if (IsMainGraph()) {
+      GetSubGraph(0)->RefreshOpTypeIndex();
+      return;
+    }
+  }
+  std::vector<ir::Node *> retyped;
+  for (auto &item : indexed_op_types_) {
+    if (item.first->Op()->Type() != item.second) {
+      retyped.push_back(item.first);
+    }
+  }
+  for (auto *node : retyped) {
+    UnindexOpNode(node);
+    IndexOpNode(node);
+  }
+}
+
 std::shared_ptr<Graph> Graph::Clone() {
   PADDLE_ENFORCE_EQ(
       this->IsMainGraph(), true,
@@ -18,6 +18,7 @@ limitations under the License. */
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -297,6 +298,8 @@ class Graph {
     }
     nodes_.clear();
     node_set_.clear();
+    op_type_index_.clear();
+    indexed_op_types_.clear();
     return ret;
   }
 
@@ -313,6 +316,7 @@ class Graph {
     ret.reset(nodes_.at(node).release());
     nodes_.erase(node);
     node_set_.erase(node);
+    UnindexOpNode(node);
     return ret;
   }
 
@@ -356,9 +360,28 @@ class Graph {
                           "The node to be added already exists."));
     nodes_[node].reset(node);
     node_set_.insert(node);
+    IndexOpNode(node);
     return node;
   }
 
+  // The op nodes of the type. The index is kept as the nodes are added and
+  // removed, so all the passes on the graph share it.
+  const std::unordered_set<ir::Node *> &OpNodesOfType(
+      const std::string &type) const {
+    if (FLAGS_convert_all_blocks) {
+      if (IsMainGraph()) {
+        return GetSubGraph(0)->OpNodesOfType(type);
+      }
+    }
+    static const std::unordered_set<ir::Node *> empty;
+    auto iter = op_type_index_.find(type);
+    return iter == op_type_index_.end() ? empty : iter->second;
+  }
+
+  // Moves the op nodes whose OpDesc type is changed in place to their new
+  // type in the index.
+  void RefreshOpTypeIndex();
+
   void ResolveHazard(
       const std::map<std::string, std::vector<ir::Node *>> &var_nodes);
 
@@ -424,6 +447,26 @@ class Graph {
 
   std::unique_ptr<Graph> CloneSubGraph(const size_t idx);
 
+  void IndexOpNode(ir::Node *node) {
+    if (node->IsOp() && node->Op()) {
+      op_type_index_[node->Op()->Type()].insert(node);
+      indexed_op_types_[node] = node->Op()->Type();
+    }
+  }
+
+  void UnindexOpNode(ir::Node *node) {
+    auto iter = indexed_op_types_.find(node);
+    if (iter == indexed_op_types_.end()) {
+      return;
+    }
+    auto bucket = op_type_index_.find(iter->second);
+    bucket->second.erase(node);
+    if (bucket->second.empty()) {
+      op_type_index_.erase(bucket);
+    }
+    indexed_op_types_.erase(iter);
+  }
+
   // NOTE: program_ shouldn't be exposed to user.
   const ProgramDesc program_;
   // NOTE: main_graph_ doesn't hold any node. It's used as a container of
@@ -435,6 +478,10 @@ class Graph {
   std::map<std::string, std::function<void(void)>> attr_dels_;
   std::map<ir::Node *, std::unique_ptr<ir::Node>> nodes_;
   std::unordered_set<ir::Node *> node_set_;
+  // The op nodes by their types, and the type each op node is indexed by.
+  std::unordered_map<std::string, std::unordered_set<ir::Node *>>
+      op_type_index_;
+  std::unordered_map<ir::Node *, std::string> indexed_op_types_;
   size_t num_node_created_{0};  // help to generate a unique node id.
   // NOTE(Aurelius84): Whether is constructed with partial ProgramDesc.
   // In case of @to_static, whole trainning program is splited into two
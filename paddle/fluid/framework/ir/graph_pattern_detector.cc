@@ -77,6 +77,8 @@ void PDPattern::AddEdge(PDNode *a, PDNode *b) {
 
 void GraphPatternDetector::operator()(Graph *graph,
                                       GraphPatternDetector::handle_t handler) {
+  // The passes may change the types of the ops in place.
+  graph->RefreshOpTypeIndex();
   if (!MarkPDNodesInGraph(*graph)) {
     return;
   }
@@ -100,11 +102,30 @@ bool GraphPatternDetector::MarkPDNodesInGraph(const ir::Graph &graph) {
   VLOG(3) << "mark pdnodes in graph";
   if (graph.Nodes().empty()) return false;
 
-  for (auto &node : GraphTraits::DFS(graph)) {
-    for (const auto &pdnode : pattern_.nodes()) {
-      if (pdnode->Tell(&node)) {
-        VLOG(4) << "Node " << node.Name() << " marked as " << pdnode->name();
-        pdnodes2nodes_[pdnode.get()].insert(&node);
+  // The PDNodes asserting an op type only tell the nodes found by the op type
+  // index, the others tell all the nodes.
+  std::vector<PDNode *> unanchored;
+  std::vector<Node *> candidates;
+  for (const auto &pdnode : pattern_.nodes()) {
+    if (!CollectAnchoredNodes(graph, *pdnode, &candidates)) {
+      unanchored.push_back(pdnode.get());
+      continue;
+    }
+    for (auto *node : candidates) {
+      if (pdnode->Tell(node)) {
+        VLOG(4) << "Node " << node->Name() << " marked as " << pdnode->name();
+        pdnodes2nodes_[pdnode.get()].insert(node);
+      }
+    }
+  }
+  if (!unanchored.empty()) {
+    for (auto *node : graph.Nodes()) {
+      for (auto *pdnode : unanchored) {
+        if (pdnode->Tell(node)) {
+          VLOG(4) << "Node " << node->Name() << " marked as "
+                  << pdnode->name();
+          pdnodes2nodes_[pdnode].insert(node);
+        }
       }
     }
   }
@@ -120,6 +141,49 @@ bool GraphPatternDetector::MarkPDNodesInGraph(const ir::Graph &graph) {
   return !pdnodes2nodes_.empty();
 }
 
+bool GraphPatternDetector::CollectAnchoredNodes(
+    const ir::Graph &graph, const PDNode &pdnode,
+    std::vector<Node *> *nodes) const {
+  const auto &anchors = pdnode.op_type_anchors();
+  if (anchors.empty()) return false;
+  // Every anchor holds all the matched nodes, the one with the fewest ops is
+  // used.
+  const PDNode::OpTypeAnchor *best = nullptr;
+  size_t best_size = 0;
+  for (const auto &anchor : anchors) {
+    size_t size = 0;
+    for (const auto &type : anchor.op_types) {
+      size += graph.OpNodesOfType(type).size();
+    }
+    if (!best || size < best_size) {
+      best = &anchor;
+      best_size = size;
+    }
+  }
+
+  nodes->clear();
+  std::unordered_set<Node *> visited;
+  auto collect = [&](Node *node) {
+    if (visited.insert(node).second) nodes->push_back(node);
+  };
+  for (const auto &type : best->op_types) {
+    for (auto *op : graph.OpNodesOfType(type)) {
+      switch (best->kind) {
+        case PDNode::OpTypeAnchor::Kind::kOp:
+          collect(op);
+          break;
+        case PDNode::OpTypeAnchor::Kind::kInputOf:
+          for (auto *var : op->inputs) collect(var);
+          break;
+        case PDNode::OpTypeAnchor::Kind::kOutputOf:
+          for (auto *var : op->outputs) collect(var);
+          break;
+      }
+    }
+  }
+  return true;
+}
+
 // The intermediate Nodes can only link to the nodes inside the pattern, or this
 // subgraph will be dropped.
 void GraphPatternDetector::ValidateByNodeRole(
@@ -188,6 +252,24 @@ bool IsNodesLink(Node *a, Node *b) {
   return false;
 }
 
+// A link between the nodes of an edge of the pattern, for a hit group.
+struct EdgeLink {
+  Node *source;
+  Node *target;
+  size_t group;
+
+  bool operator<(const EdgeLink &other) const {
+    std::less<Node *> less;
+    if (source != other.source) return less(source, other.source);
+    if (target != other.target) return less(target, other.target);
+    return group < other.group;
+  }
+  bool operator==(const EdgeLink &other) const {
+    return source == other.source && target == other.target &&
+           group == other.group;
+  }
+};
+
 std::vector<GraphPatternDetector::subgraph_t>
 GraphPatternDetector::DetectPatterns() {
   // Init empty subgraphs.
@@ -218,23 +300,59 @@ GraphPatternDetector::DetectPatterns() {
     cur_groups.clear();
     if (pre_groups.empty()) break;
     // source -> target
-    for (Node *source : pdnodes2nodes_[edge.first]) {
-      for (Node *target : pdnodes2nodes_[edge.second]) {
-        VLOG(8) << "check " << source->id() << " -- " << target->id();
-        // TODO(Superjomn) add some prune strategies.
-        for (const auto &group : pre_groups) {
-          if (IsNodesLink(source, target)) {
-            HitGroup new_group = group;
-            bool flag = new_group.Match(source, edge.first) &&
-                        new_group.Match(target, edge.second);
-            if (flag) {
-              new_group.Register(source, edge.first);
-              new_group.Register(target, edge.second);
-              cur_groups.push_back(new_group);
-              // TODO(Superjomn) need to unique
+    const auto &sources = pdnodes2nodes_[edge.first];
+    const auto &targets = pdnodes2nodes_[edge.second];
+    // Only the links next to a node the group already holds can match it, so
+    // the links are found from the edges of that node. They are sorted by the
+    // source and target node pointers, so the groups are extended in that
+    // order rather than in the order the groups were found.
+    std::vector<EdgeLink> links;
+    std::vector<std::pair<Node *, Node *>> all_links;
+    bool all_links_found = false;
+    for (size_t i = 0; i < pre_groups.size(); ++i) {
+      const auto &roles = pre_groups[i].roles;
+      auto source_role = roles.find(edge.first);
+      auto target_role = roles.find(edge.second);
+      if (source_role != roles.end()) {
+        Node *source = source_role->second;
+        if (!sources.count(source)) continue;
+        for (Node *target : source->outputs) {
+          if (targets.count(target)) links.push_back({source, target, i});
+        }
+      } else if (target_role != roles.end()) {
+        Node *target = target_role->second;
+        if (!targets.count(target)) continue;
+        for (Node *source : target->inputs) {
+          if (sources.count(source) && IsNodesLink(source, target)) {
+            links.push_back({source, target, i});
+          }
+        }
+      } else {
+        if (!all_links_found) {
+          for (Node *source : sources) {
+            for (Node *target : source->outputs) {
+              if (targets.count(target)) all_links.emplace_back(source, target);
             }
           }
+          all_links_found = true;
         }
+        for (auto &link : all_links) {
+          links.push_back({link.first, link.second, i});
+        }
+      }
+    }
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+    for (const auto &link : links) {
+      VLOG(8) << "check " << link.source->id() << " -- " << link.target->id();
+      HitGroup new_group = pre_groups[link.group];
+      bool flag = new_group.Match(link.source, edge.first) &&
+                  new_group.Match(link.target, edge.second);
+      if (flag) {
+        new_group.Register(link.source, edge.first);
+        new_group.Register(link.target, edge.second);
+        cur_groups.push_back(new_group);
+        // TODO(Superjomn) need to unique
       }
     }
     VLOG(3) << "step " << step << " get records: " << cur_groups.size();
@@ -402,6 +520,7 @@ PDNode *PDNode::assert_is_op() {
 }
 
 PDNode *PDNode::assert_is_op(const std::string &op_type) {
+  AddAnchor(OpTypeAnchor::Kind::kOp, op_type);
   asserts_.emplace_back([op_type](Node *x) {
     return x && x->IsOp() && x->Op()->Type() == op_type;
   });
@@ -455,6 +574,7 @@ PDNode *PDNode::assert_is_op_nth_input(const std::string &op_type,
 PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
                                         const std::string &argument, int nth) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kOutputOf, op_type);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op->IsOp() && op->Op()->Type() == op_type &&
@@ -468,6 +588,7 @@ PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
 
 PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kInputOf, op_type);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type &&
@@ -482,6 +603,7 @@ PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
 
 PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kOutputOf, op_type);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type &&
@@ -496,6 +618,7 @@ PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
 
 PDNode *PDNode::assert_is_op_output(const std::string &op_type) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kOutputOf, op_type);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type) {
@@ -516,6 +639,7 @@ PDNode *PDNode::assert_is_op_output(const std::string &op_type,
 
 PDNode *PDNode::assert_is_op_input(const std::string &op_type) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kInputOf, op_type);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type) {
@@ -572,6 +696,7 @@ PDNode *PDNode::assert_more(PDNode::teller_t &&teller) {
 }
 
 PDNode *PDNode::assert_is_ops(const std::unordered_set<std::string> &op_types) {
+  AddAnchor(OpTypeAnchor::Kind::kOp, op_types);
   asserts_.emplace_back([op_types](Node *x) {
     return x && x->IsOp() && op_types.count(x->Op()->Type());
   });
@@ -598,6 +723,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
     const std::unordered_set<std::string> &op_types,
     const std::string &argument, int nth) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op->IsOp() && op_types.count(op->Op()->Type()) &&
@@ -611,6 +737,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
 PDNode *PDNode::assert_is_ops_output(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type())) {
@@ -633,6 +760,7 @@ PDNode *PDNode::assert_is_ops_output(
 PDNode *PDNode::assert_is_ops_input(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kInputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type())) {
@@ -655,6 +783,7 @@ PDNode *PDNode::assert_is_ops_input(
 PDNode *PDNode::assert_is_only_input_of_ops(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kInputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type()) &&
@@ -670,6 +799,7 @@ PDNode *PDNode::assert_is_only_input_of_ops(
 PDNode *PDNode::assert_is_only_output_of_ops(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  AddAnchor(OpTypeAnchor::Kind::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type()) &&
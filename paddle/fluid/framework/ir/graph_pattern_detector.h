@@ -162,7 +162,31 @@ struct PDNode {
     return this;
   }
 
+  // An op type condition of the asserts: the node is an op of the types, or
+  // an input or an output of an op of the types. The nodes matching the
+  // PDNode are among the ones found from the op type index of the graph by
+  // any of its anchors.
+  struct OpTypeAnchor {
+    enum class Kind { kOp, kInputOf, kOutputOf };
+    Kind kind;
+    std::vector<std::string> op_types;
+  };
+  // The anchors of the asserts, empty if the teller decides alone.
+  const std::vector<OpTypeAnchor>& op_type_anchors() const {
+    static const std::vector<OpTypeAnchor> empty;
+    return teller_ ? empty : anchors_;
+  }
+
  private:
+  void AddAnchor(OpTypeAnchor::Kind kind, const std::string& op_type) {
+    anchors_.push_back(OpTypeAnchor{kind, {op_type}});
+  }
+  void AddAnchor(OpTypeAnchor::Kind kind,
+                 const std::unordered_set<std::string>& op_types) {
+    anchors_.push_back(OpTypeAnchor{
+        kind, std::vector<std::string>(op_types.begin(), op_types.end())});
+  }
+
   PDNode(PDPattern* pattern, const std::string& name = "",
          Type type = Type::kVar)
       : pattern_(pattern), name_(name), type_(type) {}
@@ -184,6 +208,7 @@ struct PDNode {
   // Will removed latter.
   teller_t teller_;
   std::vector<teller_t> asserts_;
+  std::vector<OpTypeAnchor> anchors_;
   PDPattern* pattern_;
   std::string name_;
   Type type_;
@@ -292,6 +317,11 @@ class GraphPatternDetector {
   // Mark the nodes that fits the pattern.
   bool MarkPDNodesInGraph(const ir::Graph& graph);
 
+  // Collect the nodes that may match the PDNode by the anchor with the fewest
+  // ops, it returns false if the PDNode has no anchor.
+  bool CollectAnchoredNodes(const ir::Graph& graph, const PDNode& pdnode,
+                            std::vector<Node*>* nodes) const;
+
   // Detect all the pattern and output the hit records.
   std::vector<subgraph_t> DetectPatterns();
 
@@ -14,7 +14,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
 
 namespace paddle {
 namespace framework {
@@ -203,6 +206,147 @@ TEST(GraphPatternDetector, IntermediateCheck) {
   ASSERT_EQ(count, 1);
 }
 
+TEST(GraphPatternDetector, OpTypeIndex) {
+  ProgramDesc program;
+  Graph graph(program);
+  OpDesc desc;
+  desc.SetType("relu");
+  auto* relu = graph.CreateOpNode(&desc);
+  auto* other = graph.CreateOpNode(&desc);
+  graph.CreateEmptyNode("op", Node::Type::kOperation);
+  ASSERT_EQ(graph.OpNodesOfType("relu").size(), 2UL);
+  ASSERT_TRUE(graph.OpNodesOfType("scale").empty());
+
+  // the ops retyped in place are moved when the index is refreshed
+  relu->Op()->SetType("scale");
+  graph.RefreshOpTypeIndex();
+  ASSERT_EQ(graph.OpNodesOfType("relu").size(), 1UL);
+  ASSERT_EQ(graph.OpNodesOfType("scale").count(relu), 1UL);
+
+  graph.RemoveNode(other);
+  ASSERT_TRUE(graph.OpNodesOfType("relu").empty());
+  ASSERT_EQ(graph.OpNodesOfType("scale").size(), 1UL);
+}
+
+TEST(GraphPatternDetector, DetectRetypedOps) {
+  ProgramDesc program;
+  Graph graph(program);
+  // x -> relu -> y -> relu -> z
+  VarDesc x_desc("x"), y_desc("y"), z_desc("z");
+  auto* x = graph.CreateVarNode(&x_desc);
+  auto* y = graph.CreateVarNode(&y_desc);
+  auto* z = graph.CreateVarNode(&z_desc);
+  OpDesc desc;
+  desc.SetType("relu");
+  auto* relu1 = graph.CreateOpNode(&desc);
+  auto* relu2 = graph.CreateOpNode(&desc);
+  IR_NODE_LINK_TO(x, relu1);
+  IR_NODE_LINK_TO(relu1, y);
+  IR_NODE_LINK_TO(y, relu2);
+  IR_NODE_LINK_TO(relu2, z);
+
+  GraphPatternDetector detector;
+  auto* input = detector.mutable_pattern()
+                    ->NewNode("input")
+                    ->assert_is_op_input("scale")
+                    ->AsInput();
+  auto* op = detector.mutable_pattern()->NewNode("op")->assert_is_op("scale");
+  auto* output = detector.mutable_pattern()
+                     ->NewNode("output")
+                     ->assert_is_op_output("scale")
+                     ->AsOutput();
+  op->LinksFrom({input}).LinksTo({output});
+
+  std::vector<Node*> found;
+  auto handler = [&](const GraphPatternDetector::subgraph_t& subgraph,
+                     Graph* g) { found.push_back(subgraph.at(op)); };
+  detector(&graph, handler);
+  ASSERT_TRUE(found.empty());
+
+  relu2->Op()->SetType("scale");
+  detector(&graph, handler);
+  ASSERT_EQ(found.size(), 1UL);
+  ASSERT_EQ(found[0], relu2);
+}
+
+// The mul -> elementwise_add -> relu groups found by a detector. The
+// indexed pattern asserts the op types, the other one checks them in
+// assert_more, which the detector cannot index, so it tells every node.
+static std::vector<std::vector<Node*>> DetectMulAddRelu(Graph* graph,
+                                                        bool indexed) {
+  GraphPatternDetector detector;
+  auto* pattern = detector.mutable_pattern();
+  auto has_op = [](const std::vector<Node*>& ops, const std::string& type) {
+    for (auto* op : ops) {
+      if (op->IsOp() && op->Op() && op->Op()->Type() == type) return true;
+    }
+    return false;
+  };
+  auto op = [&](const std::string& type) -> PDNode* {
+    if (indexed) return pattern->NewNode(type)->assert_is_op(type);
+    return pattern->NewNode(type)->assert_is_op()->assert_more(
+        [type](Node* x) { return x->Op()->Type() == type; });
+  };
+  auto var = [&](const std::string& name, const std::string& output_of,
+                 const std::string& input_of) -> PDNode* {
+    auto* node = pattern->NewNode(name)->assert_is_var();
+    if (indexed) {
+      if (!output_of.empty()) node->assert_is_op_output(output_of);
+      node->assert_is_op_input(input_of);
+    } else {
+      node->assert_more([=](Node* x) {
+        return (output_of.empty() || has_op(x->inputs, output_of)) &&
+               has_op(x->outputs, input_of);
+      });
+    }
+    return node;
+  };
+  auto* x = var("x", "", "mul");
+  auto* mul = op("mul");
+  auto* mul_out = var("mul_out", "mul", "elementwise_add");
+  auto* add = op("elementwise_add");
+  auto* add_out = var("add_out", "elementwise_add", "relu");
+  auto* relu = op("relu");
+  mul->LinksFrom({x}).LinksTo({mul_out});
+  add->LinksFrom({mul_out}).LinksTo({add_out});
+  relu->LinksFrom({add_out});
+
+  std::vector<std::vector<Node*>> groups;
+  using subgraph_t = GraphPatternDetector::subgraph_t;
+  auto handler = [&](const subgraph_t& subgraph, Graph* g) {
+    groups.push_back({subgraph.at(x), subgraph.at(mul), subgraph.at(mul_out),
+                      subgraph.at(add), subgraph.at(add_out),
+                      subgraph.at(relu)});
+  };
+  detector(graph, handler);
+  std::sort(groups.begin(), groups.end());
+  return groups;
+}
+
+TEST(GraphPatternDetector, OpTypeIndexMatchesUnindexed) {
+  Layers layers;
+  auto* x = layers.data("x", {-1, 16});
+  auto block = [&](VarDesc* in, int i) {
+    auto suffix = std::to_string(i);
+    auto* w = layers.data("w" + suffix, {16, 16}, true);
+    auto* bias = layers.data("b" + suffix, {16}, true);
+    return layers.elementwise_add(layers.mul(in, w), bias, nullptr, 1);
+  };
+  // three groups share x, one follows another group, and one ends in a
+  // softmax instead of a relu
+  auto* out0 = layers.relu(block(x, 0));
+  layers.relu(block(x, 1));
+  layers.relu(block(x, 2));
+  layers.relu(block(out0, 3));
+  layers.softmax(block(x, 4), 1);
+  Graph graph(layers.main_program());
+
+  auto indexed = DetectMulAddRelu(&graph, true);
+  auto unindexed = DetectMulAddRelu(&graph, false);
+  ASSERT_EQ(indexed.size(), 4UL);
+  ASSERT_EQ(indexed, unindexed);
+}
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
@@ -24,6 +24,8 @@
 #include "paddle/fluid/operators/tensorrt/tensorrt_engine_op.h"
 #endif
 
+DECLARE_bool(enable_op_runtime_context_table);
+
 namespace paddle {
 namespace framework {
 void NaiveExecutor::Prepare(Scope *scope, const ProgramDesc &program_desc,
@@ -44,11 +46,27 @@ void NaiveExecutor::Run() {
   platform::RegisterModelLayout(ops_, place_);
 #endif
   platform::ScopedFlushDenormal flush;
-  for (auto &op : ops_) {
+  if (FLAGS_enable_op_runtime_context_table) {
+    if (!runtime_ctxs_) {
+      runtime_ctx_table_.Build(ops_);
+      runtime_ctxs_.reset(new OpRuntimeContexts(runtime_ctx_table_));
+    }
+    // NOTE: the variables of the scope may be erased and created again
+    // between two runs, bind again when they changed.
+    if (!runtime_ctxs_->IsBoundTo(*scope_)) {
+      runtime_ctxs_->Bind(*scope_);
+    }
+  }
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto &op = ops_[i];
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
     op->SetIsCalledByExecutor(false);
-    op->Run(*scope_, place_);
+    if (FLAGS_enable_op_runtime_context_table) {
+      runtime_ctxs_->RunOp(i, *scope_, place_);
+    } else {
+      op->Run(*scope_, place_);
+    }
   }
 }
 
@@ -105,6 +123,8 @@ void NaiveExecutor::CreateOps(const ProgramDesc &desc, int block_id,
     }
     ops_.emplace_back(OpRegistry::CreateOp(*op_desc));
   }
+  runtime_ctxs_.reset();
+  runtime_ctx_table_ = OpRuntimeContextTable();
 }
 
 LoDTensor *NaiveExecutor::FindTensor(const std::string &name) {
@@ -126,6 +146,8 @@ void NaiveExecutor::CleanFeedFetchOps() {
     }
   }
   ops_.swap(ops);
+  runtime_ctxs_.reset();
+  runtime_ctx_table_ = OpRuntimeContextTable();
 }
 
 NaiveExecutor::~NaiveExecutor() {
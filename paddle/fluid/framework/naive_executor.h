@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 
+#include "paddle/fluid/framework/op_runtime_context_table.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
@@ -76,6 +77,10 @@ class NaiveExecutor {
   const platform::Place place_;
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
+  // Built at the first Run, the contexts are bound to scope_ again when its
+  // variables changed since the last Run.
+  OpRuntimeContextTable runtime_ctx_table_;
+  std::unique_ptr<OpRuntimeContexts> runtime_ctxs_;
   Scope* scope_;
 };
 
@@ -0,0 +1,171 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/cpu_graph_replay.h"
+
+#include <unordered_map>
+
+#include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
+#include "paddle/fluid/platform/profiler/event_tracing.h"
+
+namespace paddle {
+namespace framework {
+
+// The phi kernel context reads attributes like ShapeTensor from the values
+// of input variables when it is built, which can not be recorded.
+static bool HasAttributeFromInput(const OperatorWithKernel& op) {
+  auto* signature = op.PhiKernelSignature();
+  if (signature == nullptr) {
+    return true;
+  }
+  for (auto& attr_name : std::get<1>(signature->args)) {
+    if (op.Attrs().find(attr_name) == op.Attrs().end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool AllInputsAreTensors(const RuntimeContext& runtime_ctx) {
+  for (auto& var_item : runtime_ctx.inputs) {
+    for (auto* var : var_item.second) {
+      if (var != nullptr && !var->IsType<LoDTensor>() &&
+          !var->IsType<phi::SelectedRows>()) {
+        return false;
+      }
+    }
+  }
+  for (auto& var_item : runtime_ctx.outputs) {
+    for (auto* var : var_item.second) {
+      if (var != nullptr && !var->IsType<LoDTensor>() &&
+          !var->IsType<phi::SelectedRows>()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+CpuGraphReplayPlan::CpuGraphReplayPlan(const std::vector<Instruction>& instrs,
+                                       const VariableScope& var_scope,
+                                       bool use_inplace) {
+  steps_.resize(instrs.size());
+  std::unordered_map<size_t, size_t> last_reader;
+  for (size_t i = 0; i < instrs.size(); ++i) {
+    auto& instr = instrs[i];
+    auto& step = steps_[i];
+    step.instr = &instr;
+
+    auto* op_with_kernel =
+        dynamic_cast<const OperatorWithKernel*>(instr.OpBase());
+    auto& runtime_ctx = *instr.InnerRuntimeContext();
+    if (op_with_kernel != nullptr && AllInputsAreTensors(runtime_ctx)) {
+      if (instr.PhiKernel() && instr.PhiKernel()->IsValid() &&
+          !HasAttributeFromInput(*op_with_kernel)) {
+        step.type = StepType::kPhiKernel;
+        step.kernel_ctx.reset(new phi::KernelContext());
+        op_with_kernel->BuildPhiKernelContext(
+            runtime_ctx,
+            const_cast<platform::DeviceContext*>(&instr.DeviceContext()),
+            step.kernel_ctx.get());
+      } else if (instr.KernelFunc()) {
+        step.type = StepType::kFluidKernel;
+      }
+    }
+
+    if (step.type != StepType::kInterpret) {
+      for (auto& var_item : runtime_ctx.inputs) {
+        for (auto* var : var_item.second) {
+          if (var != nullptr && var->IsType<LoDTensor>()) {
+            auto& tensor = var->Get<LoDTensor>();
+            step.input_dims.emplace_back(&tensor, tensor.dims());
+            step.input_lods.emplace_back(&tensor, tensor.lod());
+          }
+        }
+      }
+      if (use_inplace) {
+        step.inplace = instr.InplaceInfo();
+      }
+    }
+
+    for (auto var_id : instr.GCCheckVars()) {
+      last_reader[var_id] = i;
+    }
+  }
+
+  for (auto& item : last_reader) {
+    auto* var_desc = var_scope.VarDesc(item.first);
+    // persistable var will be ignore while GC
+    if (var_desc && var_desc->Persistable()) {
+      continue;
+    }
+    steps_[item.second].garbage.push_back(var_scope.Var(item.first));
+  }
+  VLOG(4) << "Capture cpu graph replay plan of " << steps_.size()
+          << " instructions";
+}
+
+bool CpuGraphReplayPlan::InputShapesChanged(const Step& step) const {
+  for (auto& item : step.input_dims) {
+    if (item.first->dims() != item.second) {
+      return true;
+    }
+  }
+  for (auto& item : step.input_lods) {
+    if (item.first->lod() != item.second) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CpuGraphReplayPlan::Replay(size_t i) {
+  auto& step = steps_[i];
+  if (step.type == StepType::kInterpret) {
+    return false;
+  }
+  if (UNLIKELY(stale_ || InputShapesChanged(step))) {
+    VLOG(4) << "Input shapes of " << step.instr->OpBase()->Type()
+            << " changed, the replay plan is stale";
+    stale_ = true;
+    return false;
+  }
+
+  auto& instr = *step.instr;
+  platform::RecordEvent instruction_event(
+      instr.OpBase()->Type(), platform::TracerEventType::Operator, 1);
+  if (step.type == StepType::kFluidKernel) {
+    // NOTE: the infer shape of fluid operators may read ShapeTensor and the
+    // like from input values, so it is kept for them.
+    auto* op_with_kernel =
+        static_cast<const OperatorWithKernel*>(instr.OpBase());
+    op_with_kernel->Info().infer_shape_(instr.InnerInferShapeContext().get());
+  }
+  for (auto& pair : step.inplace) {
+    const auto& in = details::GetTensorFromVar(pair.first);
+    auto* out = details::GetMutableTensorFromVar(pair.second);
+    if (in.dims() == out->dims()) {
+      out->ShareBufferWith(in);
+    }
+  }
+  if (step.type == StepType::kPhiKernel) {
+    (*instr.PhiKernel())(step.kernel_ctx.get());
+  } else {
+    instr.KernelFunc()(*instr.InnerExecutionContext());
+  }
+  return true;
+}
+
+}  // namespace framework
+}  // namespace paddle
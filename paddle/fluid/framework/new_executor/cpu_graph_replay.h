@@ -0,0 +1,85 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/new_executor_defs.h"
+#include "paddle/phi/core/kernel_context.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * A flat launch plan recorded from one executed step of InterpreterCore on
+ * CPU, the host counterpart of capturing a CUDA Graph. For every instruction
+ * it keeps the resolved kernel, a phi::KernelContext whose argument pointers
+ * are bound to the variables of the step, the input shapes seen at capture
+ * and the variables to release once the instruction is done. Replaying the
+ * plan launches the kernels in program order on the calling thread, skipping
+ * the dependency counting, the kernel context building and, for phi kernels,
+ * the shape inference.
+ *
+ * The plan becomes stale once any recorded input shape changes, the caller
+ * should then run the rest of the step by the interpreter and capture again.
+ * Not thread-safe.
+ */
+class CpuGraphReplayPlan {
+ public:
+  CpuGraphReplayPlan(const std::vector<Instruction>& instrs,
+                     const VariableScope& var_scope, bool use_inplace);
+
+  size_t Size() const { return steps_.size(); }
+
+  // Launch the recorded kernel of the i-th instruction. Returns false if the
+  // instruction can not be replayed, or its input shapes changed since the
+  // capture, and must be run by the interpreter instead.
+  bool Replay(size_t i);
+
+  // The variables whose last reader is the i-th instruction.
+  const std::vector<Variable*>& GarbageAfter(size_t i) const {
+    return steps_[i].garbage;
+  }
+
+  bool IsStale() const { return stale_; }
+
+ private:
+  enum class StepType {
+    kPhiKernel,    // replay the phi kernel with the recorded context
+    kFluidKernel,  // infer shape, then replay the fluid kernel
+    kInterpret,    // run by the interpreter every time
+  };
+
+  struct Step {
+    StepType type{StepType::kInterpret};
+    const Instruction* instr{nullptr};  // not owned
+    std::unique_ptr<phi::KernelContext> kernel_ctx;
+    // the LoDTensor inputs and their dims and lod at capture
+    std::vector<std::pair<const LoDTensor*, phi::DDim>> input_dims;
+    std::vector<std::pair<const LoDTensor*, LoD>> input_lods;
+    std::vector<std::pair<Variable*, Variable*>> inplace;
+    std::vector<Variable*> garbage;
+  };
+
+  bool InputShapesChanged(const Step& step) const;
+
+  std::vector<Step> steps_;
+  bool stale_{false};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,113 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/cpu_graph_replay.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/standalone_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+USE_OP_ITSELF(scale);
+USE_OP(fetch_v2);
+
+PD_DECLARE_KERNEL(scale, CPU, ALL_LAYOUT);
+
+DECLARE_bool(new_executor_use_cpu_graph_replay);
+
+namespace paddle {
+namespace framework {
+
+// x -> scale -> y_0 -> scale -> y_1 -> scale -> y_2
+static ProgramDesc BuildProgram() {
+  const float scales[][2] = {{2.f, 1.f}, {0.5f, -1.f}, {3.f, 0.f}};
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  std::string x = "x";
+  for (int i = 0; i < 3; ++i) {
+    std::string y = "y_" + std::to_string(i);
+    for (auto& name : {x, y}) {
+      auto* var = block->Var(name);
+      var->SetType(proto::VarType::LOD_TENSOR);
+      var->SetDataType(proto::VarType::FP32);
+    }
+    auto* op = block->AppendOp();
+    op->SetType("scale");
+    op->SetInput("X", {x});
+    op->SetOutput("Out", {y});
+    op->SetAttr("scale", scales[i][0]);
+    op->SetAttr("bias", scales[i][1]);
+    op->CheckAttrs();
+    x = y;
+  }
+  return program;
+}
+
+static LoDTensor MakeInput(int64_t numel, float value) {
+  LoDTensor x;
+  x.Resize({numel});
+  auto* data = x.mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < numel; ++i) {
+    data[i] = value + i;
+  }
+  return x;
+}
+
+TEST(CpuGraphReplay, SameOutputsAsInterpreter) {
+  platform::CPUPlace place;
+  ProgramDesc startup_prog;
+  auto main_prog = BuildProgram();
+  const std::vector<std::string> feed_names = {"x"};
+  const std::vector<std::string> fetch_names = {"y_2"};
+
+  Scope scope;
+  StandaloneExecutor exec(place, startup_prog, main_prog, &scope);
+  Scope replay_scope;
+  FLAGS_new_executor_use_cpu_graph_replay = true;
+  StandaloneExecutor replay_exec(place, startup_prog, main_prog,
+                                 &replay_scope);
+
+  // build, capture, replay, then a new shape invalidates the plan and the
+  // next steps capture and replay again
+  for (int64_t numel : {4, 4, 4, 8, 8, 8, 3, 4, 4}) {
+    for (float value : {0.f, 2.f}) {
+      auto input = MakeInput(numel, value);
+      FLAGS_new_executor_use_cpu_graph_replay = false;
+      auto fetch_list = exec.Run(feed_names, {input}, fetch_names);
+      FLAGS_new_executor_use_cpu_graph_replay = true;
+      auto replay_fetch_list =
+          replay_exec.Run(feed_names, {input}, fetch_names);
+
+      ASSERT_EQ(fetch_list.size(), 1UL);
+      ASSERT_EQ(replay_fetch_list.size(), 1UL);
+      auto& out = BOOST_GET_CONST(LoDTensor, fetch_list[0]);
+      auto& replay_out = BOOST_GET_CONST(LoDTensor, replay_fetch_list[0]);
+      // a stale plan would keep the outputs of the shape it captured
+      ASSERT_EQ(out.dims(), phi::make_ddim({numel}));
+      ASSERT_EQ(replay_out.dims(), out.dims());
+      for (int64_t i = 0; i < numel; ++i) {
+        // ((x * 2 + 1) * 0.5 - 1) * 3
+        ASSERT_FLOAT_EQ(out.data<float>()[i], (value + i - 0.5f) * 3.f);
+        ASSERT_FLOAT_EQ(replay_out.data<float>()[i], out.data<float>()[i]);
+      }
+    }
+  }
+  FLAGS_new_executor_use_cpu_graph_replay = false;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -20,6 +20,7 @@
 #include "paddle/fluid/framework/new_executor/garbage_collector/fast_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/interpretercore_util.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/var_type.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 
@@ -28,6 +29,10 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_inplace, true,
 PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope, true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_use_cpu_graph_replay, false,
+    "Capture the kernel launches of a step into a flat plan and replay it in "
+    "the following steps until the shapes change, only for CPUPlace");
 
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
@@ -46,6 +51,23 @@ bool IsInterpretercoreFastGCEnabled() {
   return FLAGS_fast_eager_deletion_mode && FLAGS_use_stream_safe_cuda_allocator;
 }
 
+// Release the memory held by an intermediate variable synchronously, for
+// the runs that are not scheduled by the async work queue. The variable
+// itself and the meta of its tensor are kept.
+static void ClearRunVariable(Variable* var) {
+  if (var == nullptr) {
+    return;
+  }
+  if (var->IsType<LoDTensor>()) {
+    var->GetMutable<LoDTensor>()->MoveMemoryHolder();
+  } else if (var->IsType<phi::SelectedRows>()) {
+    var->GetMutable<phi::SelectedRows>()->mutable_value()->MoveMemoryHolder();
+    var->GetMutable<phi::SelectedRows>()->mutable_rows()->clear();
+  } else if (var->IsType<LoDTensorArray>()) {
+    var->GetMutable<LoDTensorArray>()->clear();
+  }
+}
+
 InterpreterCore::InterpreterCore(const platform::Place& place,
                                  const BlockDesc& block,
                                  VariableScope* global_scope)
@@ -107,7 +129,12 @@ paddle::framework::FetchList InterpreterCore::Run(
   Prepare(feed_names, feed_tensors, is_build);
 
   if (is_build) {
-    ExecuteInstructionList(vec_instruction_);
+    if (FLAGS_new_executor_use_cpu_graph_replay &&
+        platform::is_cpu_place(place_)) {
+      ExecuteWithReplayPlan();
+    } else {
+      ExecuteInstructionList(vec_instruction_);
+    }
   }
 
   if (create_local_scope_) {
@@ -144,6 +171,9 @@ paddle::framework::FetchList InterpreterCore::Run(
     // convert vec func_list to graph
     Convert(&op_func_nodes);
 
+  } else if (FLAGS_new_executor_use_cpu_graph_replay &&
+             platform::is_cpu_place(place_)) {
+    ExecuteWithReplayPlan();
   } else {
     ExecuteInstructionList(vec_instruction_);
   }
@@ -157,6 +187,36 @@ paddle::framework::FetchList InterpreterCore::Run(
   return std::move(*fetch_var->GetMutable<framework::FetchList>());
 }
 
+paddle::framework::FetchList InterpreterCore::ReentrantRun(
+    const std::vector<std::string>& feed_names,
+    const std::vector<framework::LoDTensor>& feed_tensors) {
+  {
+    std::lock_guard<std::mutex> guard(build_mutex_);
+    if (!is_build_) {
+      // NOTE: the first run builds the instruction list and runs the program
+      // on the shared local scope, the concurrent callers wait here.
+      return Run(feed_names, feed_tensors);
+    }
+  }
+  PADDLE_ENFORCE_EQ(feed_names.size(), feed_tensors.size(),
+                    platform::errors::PreconditionNotMet(
+                        "Required feed_names.size() == feed_tensors.size(), "
+                        "but received %d != %d",
+                        feed_names.size(), feed_tensors.size()));
+
+  auto run_ctx = AcquireRunContext();
+  paddle::framework::FetchList fetch_list;
+  try {
+    fetch_list = ExecuteInstructionListReentrant(feed_names, feed_tensors,
+                                                 run_ctx.get());
+  } catch (...) {
+    ReleaseRunContext(std::move(run_ctx));
+    throw;
+  }
+  ReleaseRunContext(std::move(run_ctx));
+  return fetch_list;
+}
+
 // At the end of each step, the holder of Tensor in LoDTensorArray is null.
 // Clear these Tensors and leave LoDTensorArray empty, otherwise an exception
 // will occur in the next step
@@ -379,13 +439,29 @@ void InterpreterCore::BuildSkipShareLoDInfo() {
   }
 }
 
-void InterpreterCore::RunInstruction(const Instruction& instr_node) {
+void InterpreterCore::RunInstruction(const Instruction& instr_node,
+                                     InterpreterRunContext* run_ctx) {
   auto* op = instr_node.OpBase();
   auto place = instr_node.DeviceContext().GetPlace();
   VLOG(4) << "Start run " << place << " " << op->DebugStringEx(global_scope_);
   Scope* local_scope = create_local_scope_
                            ? global_scope_->GetMutableLocalScope()
                            : global_scope_->GetMutableScope();
+  RuntimeContext* runtime_ctx = instr_node.InnerRuntimeContext().get();
+  InterpretercoreInferShapeContext* infershape_ctx =
+      instr_node.InnerInferShapeContext().get();
+  ExecutionContext* execution_ctx = instr_node.InnerExecutionContext().get();
+  const std::vector<std::pair<Variable*, Variable*>>* inplace_info =
+      &instr_node.InplaceInfo();
+  if (run_ctx != nullptr) {
+    // reentrant run, bind the instruction to the variables of this run
+    size_t instr_id = instr_node.Id();
+    local_scope = run_ctx->scope;
+    runtime_ctx = run_ctx->runtime_ctxs[instr_id].get();
+    infershape_ctx = run_ctx->infershape_ctxs[instr_id].get();
+    execution_ctx = run_ctx->execution_ctxs[instr_id].get();
+    inplace_info = &run_ctx->inplace_infos[instr_id];
+  }
   auto op_with_kernel = dynamic_cast<const framework::OperatorWithKernel*>(op);
   {
     platform::RecordEvent infershape_event(
@@ -393,14 +469,13 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
         platform::EventRole::kInnerOp);
     // If it is OperatorBase, InferShape do nothing.
     if (op_with_kernel != nullptr)
-      op_with_kernel->Info().infer_shape_(
-          instr_node.InnerInferShapeContext().get());
+      op_with_kernel->Info().infer_shape_(infershape_ctx);
   }
 
   if (op_with_kernel != nullptr &&
       FLAGS_new_executor_use_inplace) {  // TODO(xiongkun03) Does operator
                                          // base support inplace ?
-    for (auto& pair : instr_node.InplaceInfo()) {
+    for (auto& pair : *inplace_info) {
       const auto& in = paddle::framework::details::GetTensorFromVar(pair.first);
       auto* out =
           paddle::framework::details::GetMutableTensorFromVar(pair.second);
@@ -419,18 +494,17 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
       // fit for phi
       if (instr_node.PhiKernel() && instr_node.PhiKernel()->IsValid()) {
         VLOG(4) << "Run phi kernel: " << op->Type();
-        VLOG(4) << instr_node.InnerRuntimeContext().get() << " "
-                << &instr_node.DeviceContext();
-        phi::KernelContext pt_kernel_context;
+        VLOG(4) << runtime_ctx << " " << &instr_node.DeviceContext();
+        phi::ScopedKernelContext pt_kernel_context;
         op_with_kernel->BuildPhiKernelContext(
-            *instr_node.InnerRuntimeContext().get(),
+            *runtime_ctx,
             const_cast<platform::DeviceContext*>(&instr_node.DeviceContext()),
-            &pt_kernel_context);
+            pt_kernel_context.get());
 
-        (*instr_node.PhiKernel())(&pt_kernel_context);
+        (*instr_node.PhiKernel())(pt_kernel_context.get());
 
       } else {
-        instr_node.KernelFunc()(*instr_node.InnerExecutionContext().get());
+        instr_node.KernelFunc()(*execution_ctx);
       }
     }
   }
@@ -450,9 +524,13 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
   // for debug nan/inf
   if (FLAGS_check_nan_inf) {
     VLOG(4) << "Check nan/inf";
-    framework::details::CheckOpHasNanOrInf(
-        *op, *global_scope_,
-        place);  // TODO(xiongkun03) change it to inner scope.
+    if (run_ctx != nullptr) {
+      framework::details::CheckOpHasNanOrInf(*op, *run_ctx->scope, place);
+    } else {
+      framework::details::CheckOpHasNanOrInf(
+          *op, *global_scope_,
+          place);  // TODO(xiongkun03) change it to inner scope.
+    }
   }
 }
 
@@ -489,6 +567,44 @@ void InterpreterCore::ExecuteInstructionList(
   }
 }
 
+// Run one step by replaying the plan captured from a previous step, the
+// first step and the step after the plan became stale are interpreted and
+// captured.
+void InterpreterCore::ExecuteWithReplayPlan() {
+  if (replay_plan_ == nullptr) {
+    ExecuteInstructionList(vec_instruction_);
+    replay_plan_.reset(new CpuGraphReplayPlan(
+        vec_instruction_, *global_scope_, FLAGS_new_executor_use_inplace));
+    return;
+  }
+
+  for (size_t i = 0; i < vec_instruction_.size(); ++i) {
+    auto& instr_node = vec_instruction_[i];
+    auto* op = instr_node.OpBase();
+    try {
+      if (!replay_plan_->Replay(i)) {
+        platform::RecordEvent instruction_event(
+            op->Type(), platform::TracerEventType::Operator, 1);
+        RunInstruction(instr_node);
+      }
+    } catch (platform::EnforceNotMet& ex) {
+      replay_plan_.reset();
+      framework::InsertCallStackInfo(op->Type(), op->Attrs(), &ex);
+      throw;
+    } catch (...) {
+      replay_plan_.reset();
+      throw;
+    }
+    for (auto* var : replay_plan_->GarbageAfter(i)) {
+      ClearRunVariable(var);
+    }
+  }
+
+  if (replay_plan_->IsStale()) {
+    replay_plan_.reset();
+  }
+}
+
 void InterpreterCore::RunNextInstructions(
     const Instruction& instr, std::queue<size_t>* reserved_next_ops) {
   auto& next_instr = instr.NextInstructions();
@@ -740,6 +856,212 @@ void InterpreterCore::CheckGC(const Instruction& instr) {
   }
 }
 
+// Persistable variables (the weights) are shared by all the reentrant runs,
+// except the fetch holder which collects the results of one run.
+bool InterpreterCore::IsSharedAcrossRuns(size_t var_id) const {
+  auto* var_desc = global_scope_->VarDesc(var_id);
+  return var_desc != nullptr && var_desc->Persistable() &&
+         var_desc->Name() != interpreter::kFetchVarName;
+}
+
+std::unique_ptr<InterpreterRunContext> InterpreterCore::BuildRunContext() {
+  auto run_ctx = std::make_unique<InterpreterRunContext>();
+  Scope* root_scope = global_scope_->GetMutableScope();
+  // NOTE: the run scope has no VariableScopeListener, the variables created
+  // by one run must not leak into the shared VariableScope.
+  run_ctx->scope = &root_scope->NewScope();
+
+  auto var_nums = global_scope_->VarSize();
+  std::vector<std::string> var_names(var_nums);
+  auto CollectNames = [&](const Scope* scope) {
+    for (auto& name : scope->LocalVarNames()) {
+      int id = global_scope_->GetIdByName(name);
+      if (id > kEmptyVarIndex &&
+          global_scope_->Var(id) == scope->FindLocalVar(name)) {
+        var_names[id] = name;
+      }
+    }
+  };
+  CollectNames(root_scope);
+  if (local_scope_ != nullptr) {
+    CollectNames(local_scope_);
+  }
+
+  std::unordered_map<const Variable*, Variable*> var_map;
+  run_ctx->vars.resize(var_nums, nullptr);
+  for (size_t id = kEmptyVarIndex + 1; id < var_nums; ++id) {
+    auto* var = global_scope_->Var(id);
+    if (var == nullptr || IsSharedAcrossRuns(id)) {
+      run_ctx->vars[id] = var;
+      continue;
+    }
+    auto* run_var = var_names[id].empty()
+                        ? run_ctx->scope->Var(nullptr)
+                        : run_ctx->scope->Var(var_names[id]);
+    auto* var_desc = global_scope_->VarDesc(id);
+    if (var_desc != nullptr) {
+      InitializeVariable(run_var, var_desc->GetType());
+    } else if (var->IsInitialized()) {
+      InitializeVariable(run_var, ToVarType(var->Type()));
+    }
+    run_ctx->vars[id] = run_var;
+    var_map[var] = run_var;
+  }
+
+  auto op_nums = vec_instruction_.size();
+  run_ctx->runtime_ctxs.reserve(op_nums);
+  run_ctx->infershape_ctxs.reserve(op_nums);
+  run_ctx->execution_ctxs.reserve(op_nums);
+  run_ctx->inplace_infos.resize(op_nums);
+  auto BuildValueMap = [&](const std::map<std::string, std::vector<int>>& ids) {
+    VariableValueMap value_map;
+    for (auto& var_name_item : ids) {
+      std::vector<Variable*> vars;
+      vars.reserve(var_name_item.second.size());
+      for (auto id : var_name_item.second) {
+        vars.emplace_back(run_ctx->vars.at(id));
+      }
+      value_map.emplace(var_name_item.first, std::move(vars));
+    }
+    return value_map;
+  };
+  for (size_t i = 0; i < op_nums; ++i) {
+    auto& instr = vec_instruction_[i];
+    auto* runtime_ctx = new RuntimeContext(BuildValueMap(instr.Inputs()),
+                                           BuildValueMap(instr.Outputs()));
+    run_ctx->runtime_ctxs.emplace_back(runtime_ctx);
+    run_ctx->infershape_ctxs.emplace_back(
+        new InterpretercoreInferShapeContext(*instr.OpBase(), *runtime_ctx));
+    run_ctx->infershape_ctxs.back()->SetSkipLoD(
+        instr.InnerInferShapeContext()->CanSkipLoD());
+    run_ctx->execution_ctxs.emplace_back(new ExecutionContext(
+        *instr.OpBase(), *run_ctx->scope, instr.DeviceContext(),
+        *runtime_ctx));
+    for (auto& pair : instr.InplaceInfo()) {
+      auto in_iter = var_map.find(pair.first);
+      auto out_iter = var_map.find(pair.second);
+      if (in_iter != var_map.end() && out_iter != var_map.end()) {
+        run_ctx->inplace_infos[i].emplace_back(in_iter->second,
+                                               out_iter->second);
+      }
+    }
+  }
+  VLOG(4) << "Build run context " << run_ctx.get() << " with scope "
+          << run_ctx->scope;
+  return run_ctx;
+}
+
+std::unique_ptr<InterpreterRunContext> InterpreterCore::AcquireRunContext() {
+  std::lock_guard<std::mutex> guard(run_ctx_mutex_);
+  if (idle_run_ctxs_.empty()) {
+    // NOTE: Scope::NewScope is not thread-safe when PADDLE_ON_INFERENCE,
+    // so the run contexts are built under the lock.
+    return BuildRunContext();
+  }
+  auto run_ctx = std::move(idle_run_ctxs_.back());
+  idle_run_ctxs_.pop_back();
+  return run_ctx;
+}
+
+void InterpreterCore::ReleaseRunContext(
+    std::unique_ptr<InterpreterRunContext> run_ctx) {
+  std::lock_guard<std::mutex> guard(run_ctx_mutex_);
+  idle_run_ctxs_.emplace_back(std::move(run_ctx));
+}
+
+paddle::framework::FetchList InterpreterCore::ExecuteInstructionListReentrant(
+    const std::vector<std::string>& feed_names,
+    const std::vector<framework::LoDTensor>& feed_tensors,
+    InterpreterRunContext* run_ctx) {
+  for (size_t i = 0; i < feed_names.size(); ++i) {
+    int var_id = global_scope_->GetIdByName(feed_names[i]);
+    PADDLE_ENFORCE_GT(var_id, kEmptyVarIndex,
+                      platform::errors::NotFound(
+                          "Variable %s should not be nullptr.", feed_names[i]));
+    PADDLE_ENFORCE_EQ(
+        IsSharedAcrossRuns(var_id), false,
+        platform::errors::PreconditionNotMet(
+            "The feed variable %s is persistable, which is shared by all the "
+            "runs and can not be fed in ReentrantRun.",
+            feed_names[i]));
+    auto feed_tensor =
+        run_ctx->vars[var_id]->GetMutable<framework::LoDTensor>();
+    feed_tensor->ShareDataWith(feed_tensors[i]);
+    feed_tensor->set_lod(feed_tensors[i].lod());
+  }
+
+  auto& vec_meta_info = global_scope_->VecMetaInfo();
+  run_ctx->var_ref_count.resize(vec_meta_info.size());
+  for (size_t i = 0; i < vec_meta_info.size(); ++i) {
+    run_ctx->var_ref_count[i] = vec_meta_info[i].var_ref_count_;
+  }
+
+  // NOTE: the instructions are in program order, which is a valid
+  // topological order, so no dependency counting is needed for a run that
+  // executes on the calling thread. The intermediate variables on host are
+  // released as soon as their last reader finishes, those on device are
+  // released after the run since the streams are shared by the runs.
+  bool eager_gc = platform::is_cpu_place(place_);
+  for (auto& instr_node : vec_instruction_) {
+    auto* op = instr_node.OpBase();
+    platform::RecordEvent instruction_event(
+        op->Type(), platform::TracerEventType::Operator, 1);
+    interpreter::WaitEvent(instr_node, place_);
+    try {
+      RunInstruction(instr_node, run_ctx);
+    } catch (platform::EnforceNotMet& ex) {
+      framework::InsertCallStackInfo(op->Type(), op->Attrs(), &ex);
+      throw;
+    }
+    interpreter::RecordEvent(instr_node, place_);
+    if (eager_gc) {
+      CheckGCReentrant(instr_node, run_ctx);
+    }
+  }
+
+  if (!eager_gc) {
+    std::unordered_set<const platform::DeviceContext*> dev_ctxs;
+    for (auto& instr_node : vec_instruction_) {
+      if (dev_ctxs.insert(&instr_node.DeviceContext()).second) {
+        instr_node.DeviceContext().Wait();
+      }
+    }
+  }
+
+  auto fetch_var_id = global_scope_->GetIdByName(interpreter::kFetchVarName);
+  paddle::framework::FetchList fetch_list;
+  if (fetch_var_id > kEmptyVarIndex) {
+    fetch_list = std::move(
+        *run_ctx->vars[fetch_var_id]->GetMutable<framework::FetchList>());
+  }
+
+  if (!eager_gc) {
+    for (size_t id = kEmptyVarIndex + 1; id < run_ctx->vars.size(); ++id) {
+      if (!IsSharedAcrossRuns(id) && run_ctx->vars[id] != nullptr) {
+        ClearRunVariable(run_ctx->vars[id]);
+      }
+    }
+  }
+  return fetch_list;
+}
+
+void InterpreterCore::CheckGCReentrant(const Instruction& instr,
+                                       InterpreterRunContext* run_ctx) {
+  auto& var_scope = *global_scope_;
+  for (auto var_id : instr.GCCheckVars()) {
+    bool is_ready = --run_ctx->var_ref_count[var_id] == 0;
+    // ignore all persistable var while GC
+    if (var_scope.VarDesc(var_id) && var_scope.VarDesc(var_id)->Persistable()) {
+      continue;
+    }
+    if (is_ready) {
+      VLOG(6) << "Delete variable with name : "
+              << var_scope.GetNameById(var_id);
+      ClearRunVariable(run_ctx->vars[var_id]);
+    }
+  }
+}
+
 void InterpreterCore::Prepare(
     const std::vector<std::string>& feed_names,
     const std::vector<framework::LoDTensor>& feed_tensors, bool prepare_feed) {
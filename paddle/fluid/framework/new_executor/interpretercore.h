@@ -14,12 +14,15 @@
 #pragma once
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "paddle/fluid/framework/details/exception_holder.h"
+#include "paddle/fluid/framework/new_executor/cpu_graph_replay.h"
 #include "paddle/fluid/framework/new_executor/event_manager.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/interpretercore_util.h"
@@ -36,6 +39,24 @@ namespace paddle {
 namespace framework {
 using AtomicVectorSizeT = std::vector<std::unique_ptr<std::atomic<size_t>>>;
 
+// The per-run state of InterpreterCore::ReentrantRun. The instruction list,
+// the kernels and the persistable variables are shared by all the runs of an
+// InterpreterCore, while the non-persistable variables, the contexts bound to
+// them and the gc reference counts are private to one run. Run contexts are
+// pooled and reused, so they are only built up to the peak concurrency.
+struct InterpreterRunContext {
+  Scope* scope{nullptr};  // not owned, a kid of the global scope
+  // indexed by var id, persistable vars point to the shared variables
+  std::vector<Variable*> vars;
+  // indexed by instruction id
+  std::vector<std::unique_ptr<RuntimeContext>> runtime_ctxs;
+  std::vector<std::unique_ptr<InterpretercoreInferShapeContext>>
+      infershape_ctxs;
+  std::vector<std::unique_ptr<ExecutionContext>> execution_ctxs;
+  std::vector<std::vector<std::pair<Variable*, Variable*>>> inplace_infos;
+  std::vector<size_t> var_ref_count;
+};
+
 class InterpreterCore {
  public:
   InterpreterCore(const platform::Place& place, const BlockDesc& block,
@@ -49,6 +70,16 @@ class InterpreterCore {
 
   paddle::framework::FetchList Run(const std::vector<std::string>& feed_names);
 
+  // Thread-safe variant of Run(feed_names, feed_tensors): N threads may call
+  // it on the same InterpreterCore at the same time. Each call executes the
+  // instruction list in order on the calling thread, against its own
+  // InterpreterRunContext, so the program and the weights are shared but the
+  // intermediate variables are not. The first call builds the instruction
+  // list, the others wait for it. Do not mix with Run() concurrently.
+  paddle::framework::FetchList ReentrantRun(
+      const std::vector<std::string>& feed_names,
+      const std::vector<framework::LoDTensor>& feed_tensors);
+
   interpreter::CostInfo DryRun(
       const std::vector<std::string>& feed_names,
       const std::vector<framework::LoDTensor>& feed_tensors);
@@ -64,10 +95,13 @@ class InterpreterCore {
 
   bool BuildInplaceCheckVarIsOnlyInput(size_t var_index);
 
-  void RunInstruction(const Instruction& instr_node);
+  void RunInstruction(const Instruction& instr_node,
+                      InterpreterRunContext* run_ctx = nullptr);
 
   void ExecuteInstructionList(const std::vector<Instruction>& vec_instr);
 
+  void ExecuteWithReplayPlan();
+
   void Prepare(const std::vector<std::string>& feed_names,
                const std::vector<framework::LoDTensor>& feed_tensors,
                bool prepare_feed);
@@ -78,6 +112,22 @@ class InterpreterCore {
 
   void CheckGC(const Instruction& instr);
 
+  bool IsSharedAcrossRuns(size_t var_id) const;
+
+  std::unique_ptr<InterpreterRunContext> BuildRunContext();
+
+  std::unique_ptr<InterpreterRunContext> AcquireRunContext();
+
+  void ReleaseRunContext(std::unique_ptr<InterpreterRunContext> run_ctx);
+
+  paddle::framework::FetchList ExecuteInstructionListReentrant(
+      const std::vector<std::string>& feed_names,
+      const std::vector<framework::LoDTensor>& feed_tensors,
+      InterpreterRunContext* run_ctx);
+
+  void CheckGCReentrant(const Instruction& instr,
+                        InterpreterRunContext* run_ctx);
+
   void RunInstructionAsync(size_t instr_id);
   void RunNextInstructions(const Instruction& instr_id,
                            std::queue<size_t>* reserved_next_ops);
@@ -119,6 +169,14 @@ class InterpreterCore {
   std::vector<paddle::platform::DeviceEvent> gc_event_;
   bool create_local_scope_{true};
   Scope* local_scope_{nullptr};  // not owned
+
+  // for FLAGS_new_executor_use_cpu_graph_replay
+  std::unique_ptr<CpuGraphReplayPlan> replay_plan_;
+
+  // for ReentrantRun
+  std::mutex build_mutex_;
+  std::mutex run_ctx_mutex_;
+  std::vector<std::unique_ptr<InterpreterRunContext>> idle_run_ctxs_;
 };
 }  // namespace framework
 }  // namespace paddle
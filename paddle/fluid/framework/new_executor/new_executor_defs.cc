@@ -391,6 +391,10 @@ void InterpretercoreInferShapeContext::SetSkipLoD(bool skip) {
   can_skip_lod_ = skip;
 }
 
+bool InterpretercoreInferShapeContext::CanSkipLoD() const {
+  return can_skip_lod_;
+}
+
 DDim InterpretercoreInferShapeContext::GetDim(Variable* var) const {
   PADDLE_ENFORCE_NOT_NULL(
       var, platform::errors::InvalidArgument("Input variable is nullptr."));
@@ -112,6 +112,8 @@ class InterpretercoreInferShapeContext : public InferShapeContext {
 
   void SetSkipLoD(bool skip);
 
+  bool CanSkipLoD() const;
+
  protected:
   DDim GetDim(Variable* var) const;
 
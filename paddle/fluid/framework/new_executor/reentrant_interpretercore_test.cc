@@ -0,0 +1,214 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/standalone_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+USE_OP_ITSELF(matmul_v2);
+USE_OP_ITSELF(scale);
+USE_OP_ITSELF(relu);
+USE_OP(fetch_v2);
+
+PD_DECLARE_KERNEL(matmul, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(scale, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(relu, CPU, ALL_LAYOUT);
+
+namespace paddle {
+namespace framework {
+
+static constexpr int64_t kBatchSize = 8;
+static constexpr int64_t kHiddenSize = 64;
+static constexpr int kNumLayers = 6;
+static constexpr int kNumInputs = 4;
+static constexpr float kScale = 0.5f;
+static constexpr float kBias = 0.1f;
+
+static VarDesc* AddTensorVar(BlockDesc* block, const std::string& name,
+                             const std::vector<int64_t>& shape) {
+  auto* var = block->Var(name);
+  var->SetType(proto::VarType::LOD_TENSOR);
+  var->SetDataType(proto::VarType::FP32);
+  var->SetShape(shape);
+  return var;
+}
+
+// x -> [matmul_v2 -> scale -> relu] * kNumLayers -> fetch
+static ProgramDesc BuildMlpProgram() {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  AddTensorVar(block, "x", {kBatchSize, kHiddenSize});
+
+  std::string input = "x";
+  for (int i = 0; i < kNumLayers; ++i) {
+    auto idx = std::to_string(i);
+    AddTensorVar(block, "w_" + idx, {kHiddenSize, kHiddenSize})
+        ->SetPersistable(true);
+    AddTensorVar(block, "mm_" + idx, {kBatchSize, kHiddenSize});
+    AddTensorVar(block, "scale_" + idx, {kBatchSize, kHiddenSize});
+    AddTensorVar(block, "relu_" + idx, {kBatchSize, kHiddenSize});
+
+    auto* matmul = block->AppendOp();
+    matmul->SetType("matmul_v2");
+    matmul->SetInput("X", {input});
+    matmul->SetInput("Y", {"w_" + idx});
+    matmul->SetOutput("Out", {"mm_" + idx});
+    matmul->CheckAttrs();
+
+    auto* scale = block->AppendOp();
+    scale->SetType("scale");
+    scale->SetInput("X", {"mm_" + idx});
+    scale->SetOutput("Out", {"scale_" + idx});
+    scale->SetAttr("scale", kScale);
+    scale->SetAttr("bias", kBias);
+    scale->CheckAttrs();
+
+    auto* relu = block->AppendOp();
+    relu->SetType("relu");
+    relu->SetInput("X", {"scale_" + idx});
+    relu->SetOutput("Out", {"relu_" + idx});
+    relu->CheckAttrs();
+
+    input = "relu_" + idx;
+  }
+  return program;
+}
+
+static float WeightValue(int layer, int64_t i) {
+  return static_cast<float>((i * 7 + layer) % 13 - 6) * 0.02f;
+}
+
+static float InputValue(int input_id, int64_t i) {
+  return static_cast<float>((i * 3 + input_id) % 11 - 5) * 0.1f;
+}
+
+static void InitWeights(Scope* scope) {
+  for (int l = 0; l < kNumLayers; ++l) {
+    auto* w = scope->Var("w_" + std::to_string(l))->GetMutable<LoDTensor>();
+    w->Resize({kHiddenSize, kHiddenSize});
+    auto* data = w->mutable_data<float>(platform::CPUPlace());
+    for (int64_t i = 0; i < w->numel(); ++i) {
+      data[i] = WeightValue(l, i);
+    }
+  }
+}
+
+static LoDTensor MakeInput(int input_id) {
+  LoDTensor x;
+  x.Resize({kBatchSize, kHiddenSize});
+  auto* data = x.mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    data[i] = InputValue(input_id, i);
+  }
+  return x;
+}
+
+static std::vector<float> ComputeReference(int input_id) {
+  std::vector<float> h(kBatchSize * kHiddenSize);
+  for (size_t i = 0; i < h.size(); ++i) {
+    h[i] = InputValue(input_id, i);
+  }
+  std::vector<float> out(h.size());
+  for (int l = 0; l < kNumLayers; ++l) {
+    for (int64_t m = 0; m < kBatchSize; ++m) {
+      for (int64_t n = 0; n < kHiddenSize; ++n) {
+        float sum = 0.f;
+        for (int64_t k = 0; k < kHiddenSize; ++k) {
+          sum += h[m * kHiddenSize + k] * WeightValue(l, k * kHiddenSize + n);
+        }
+        out[m * kHiddenSize + n] = std::max(sum * kScale + kBias, 0.f);
+      }
+    }
+    h.swap(out);
+  }
+  return h;
+}
+
+static void ExpectNear(const FetchList& fetch_list,
+                       const std::vector<float>& expected) {
+  ASSERT_EQ(fetch_list.size(), 1UL);
+  auto& out = BOOST_GET_CONST(LoDTensor, fetch_list[0]);
+  ASSERT_EQ(out.numel(), static_cast<int64_t>(expected.size()));
+  auto* data = out.data<float>();
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_NEAR(data[i], expected[i], 1e-4);
+  }
+}
+
+TEST(InterpreterCore, reentrant_run) {
+  platform::CPUPlace place;
+  Scope scope;
+  InitWeights(&scope);
+  ProgramDesc startup_prog;
+  auto main_prog = BuildMlpProgram();
+  StandaloneExecutor exec(place, startup_prog, main_prog, &scope);
+
+  const std::vector<std::string> feed_names = {"x"};
+  const std::vector<std::string> fetch_names = {
+      "relu_" + std::to_string(kNumLayers - 1)};
+  std::vector<LoDTensor> inputs;
+  std::vector<std::vector<float>> expected;
+  for (int i = 0; i < kNumInputs; ++i) {
+    inputs.emplace_back(MakeInput(i));
+    expected.emplace_back(ComputeReference(i));
+  }
+
+  // the first run builds the instruction list
+  ExpectNear(exec.ReentrantRun(feed_names, {inputs[0]}, fetch_names),
+             expected[0]);
+
+  // the concurrent requests share one program and the weights, every caller
+  // gets the output of its own input
+  constexpr int kNumCallers = 4;
+  constexpr int kRequestsPerCaller = 16;
+  // not vector<bool>, whose elements share words between the callers
+  std::vector<std::vector<int>> matched(
+      kNumCallers, std::vector<int>(kRequestsPerCaller, 0));
+  std::vector<std::thread> callers;
+  for (int t = 0; t < kNumCallers; ++t) {
+    callers.emplace_back([&, t] {
+      for (int r = 0; r < kRequestsPerCaller; ++r) {
+        int input_id = (t + r) % kNumInputs;
+        auto fetch_list =
+            exec.ReentrantRun(feed_names, {inputs[input_id]}, fetch_names);
+        auto& out = BOOST_GET_CONST(LoDTensor, fetch_list.at(0));
+        auto* data = out.data<float>();
+        bool equal = out.numel() ==
+                     static_cast<int64_t>(expected[input_id].size());
+        for (size_t i = 0; equal && i < expected[input_id].size(); ++i) {
+          equal = std::abs(data[i] - expected[input_id][i]) <= 1e-4;
+        }
+        matched[t][r] = equal;
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  for (int t = 0; t < kNumCallers; ++t) {
+    for (int r = 0; r < kRequestsPerCaller; ++r) {
+      EXPECT_EQ(matched[t][r], 1) << "caller " << t << ", request " << r;
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -72,6 +72,18 @@ paddle::framework::FetchList StandaloneExecutor::Run(
   return core->Run(feed_names);
 }
 
+paddle::framework::FetchList StandaloneExecutor::ReentrantRun(
+    const std::vector<std::string>& feed_names,
+    const std::vector<framework::LoDTensor>& feed_tensors,
+    const std::vector<std::string>& fetch_names) {
+  std::shared_ptr<InterpreterCore> core = nullptr;
+  {
+    std::lock_guard<std::mutex> guard(interpretercores_mutex_);
+    core = GetInterpreterCore(feed_names, fetch_names, true);
+  }
+  return core->ReentrantRun(feed_names, feed_tensors);
+}
+
 framework::interpreter::CostInfo StandaloneExecutor::DryRun(
     const std::vector<std::string>& feed_names,
     const std::vector<framework::LoDTensor>& feed_tensors) {
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -51,6 +52,14 @@ class StandaloneExecutor : public ExecutorBase {
   paddle::framework::FetchList Run(const std::vector<std::string>& feed_names,
                                    const std::vector<std::string>& fetch_names);
 
+  // Thread-safe variant of Run(feed_names, feed_tensors, fetch_names), the
+  // cached InterpreterCore and the weights are shared by all the callers,
+  // see InterpreterCore::ReentrantRun.
+  paddle::framework::FetchList ReentrantRun(
+      const std::vector<std::string>& feed_names,
+      const std::vector<framework::LoDTensor>& feed_tensors,
+      const std::vector<std::string>& fetch_names);
+
   framework::interpreter::CostInfo DryRun(
       const std::vector<std::string>& feed_names,
       const std::vector<framework::LoDTensor>& feed_tensors);
@@ -70,6 +79,7 @@ class StandaloneExecutor : public ExecutorBase {
 
   std::unordered_map<std::string, std::shared_ptr<InterpreterCore>>
       interpretercores_;
+  std::mutex interpretercores_mutex_;  // for ReentrantRun
 };
 
 }  // namespace framework
@@ -0,0 +1,203 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/op_runtime_context_table.h"
+
+#include "paddle/fluid/platform/flags.h"
+
+PADDLE_DEFINE_EXPORTED_bool(
+    enable_op_runtime_context_table, false,
+    "Resolve the variables of operators to integer slots once in "
+    "NaiveExecutor and Executor, instead of looking them up in the scope by "
+    "name every time an operator runs.");
+
+namespace paddle {
+namespace framework {
+
+void OpRuntimeContextTable::Build(
+    const std::vector<std::unique_ptr<OperatorBase>>& ops) {
+  name2slot_.clear();
+  slot_names_.clear();
+  op_slots_.clear();
+  op_slots_.resize(ops.size());
+
+  for (size_t i = 0; i < ops.size(); ++i) {
+    auto& op_slots = op_slots_[i];
+    op_slots.op = ops[i].get();
+    AddSlots(op_slots.op->Inputs(), &op_slots.input_slots);
+    AddSlots(op_slots.op->Outputs(), &op_slots.output_slots);
+  }
+
+  is_built_ = true;
+  VLOG(4) << "Build runtime context table of " << op_slots_.size()
+          << " ops with " << slot_names_.size() << " slots";
+}
+
+int OpRuntimeContextTable::AddSlot(const std::string& name) {
+  auto iter = name2slot_.find(name);
+  if (iter != name2slot_.end()) {
+    return iter->second;
+  }
+  int slot = static_cast<int>(slot_names_.size());
+  name2slot_.emplace(name, slot);
+  slot_names_.emplace_back(name);
+  return slot;
+}
+
+void OpRuntimeContextTable::AddSlots(const VariableNameMap& names,
+                                     std::vector<int>* slots) {
+  for (auto& var_name_item : names) {
+    for (auto& var_name : var_name_item.second) {
+      // keep nullptr for the empty variable, as Scope::FindVar does.
+      slots->push_back(var_name == kEmptyVarName ? -1 : AddSlot(var_name));
+    }
+  }
+}
+
+int OpRuntimeContextTable::Slot(const std::string& name) const {
+  auto iter = name2slot_.find(name);
+  return iter == name2slot_.end() ? -1 : iter->second;
+}
+
+OpRuntimeContexts::OpRuntimeContexts(const OpRuntimeContextTable& table)
+    : table_(table) {
+  PADDLE_ENFORCE_EQ(table.IsBuilt(), true,
+                    platform::errors::PreconditionNotMet(
+                        "The runtime context table should be built before "
+                        "creating the contexts of its operators."));
+  vars_.resize(table.SlotSize(), nullptr);
+  op_ctxs_.resize(table.OpSize());
+  for (size_t i = 0; i < op_ctxs_.size(); ++i) {
+    auto& op_slots = table.op_slots_[i];
+    auto& op_ctx = op_ctxs_[i];
+    VariableValueMap ins;
+    for (auto& var_name_item : op_slots.op->Inputs()) {
+      ins[var_name_item.first].resize(var_name_item.second.size(), nullptr);
+    }
+    VariableValueMap outs;
+    for (auto& var_name_item : op_slots.op->Outputs()) {
+      outs[var_name_item.first].resize(var_name_item.second.size(), nullptr);
+    }
+    // NOTE: the bindings point into the vectors of the context, which are
+    // never resized after this point.
+    op_ctx.ctx.reset(new RuntimeContext(ins, outs));
+    AddBindings(op_slots.op->Inputs(), op_slots.input_slots,
+                &op_ctx.ctx->inputs, &op_ctx);
+    AddBindings(op_slots.op->Outputs(), op_slots.output_slots,
+                &op_ctx.ctx->outputs, &op_ctx);
+  }
+}
+
+void OpRuntimeContexts::AddBindings(const VariableNameMap& names,
+                                    const std::vector<int>& slots,
+                                    VariableValueMap* values,
+                                    OpContext* op_ctx) {
+  auto slot = slots.begin();
+  for (auto& var_name_item : names) {
+    auto& vars = values->at(var_name_item.first);
+    for (size_t i = 0; i < var_name_item.second.size(); ++i, ++slot) {
+      if (*slot >= 0) {
+        op_ctx->bindings.emplace_back(&vars[i], *slot);
+      }
+    }
+  }
+}
+
+void OpRuntimeContexts::Bind(const Scope& scope) {
+  // NOTE: record the generations before looking up, a change during binding
+  // makes the next IsBoundTo fail.
+  bound_generations_.clear();
+  for (auto* s = &scope; s != nullptr; s = s->parent()) {
+    bound_generations_.push_back(s->Generation());
+  }
+  for (size_t slot = 0; slot < vars_.size(); ++slot) {
+    vars_[slot] = scope.FindVar(table_.slot_names_[slot]);
+  }
+  for (auto& op_ctx : op_ctxs_) {
+    op_ctx.resolved = true;
+    for (auto& binding : op_ctx.bindings) {
+      *binding.first = vars_[binding.second];
+      if (*binding.first == nullptr) {
+        op_ctx.resolved = false;
+      }
+    }
+  }
+  bound_scope_ = &scope;
+}
+
+bool OpRuntimeContexts::IsBoundTo(const Scope& scope) const {
+  if (&scope != bound_scope_) {
+    return false;
+  }
+  size_t depth = 0;
+  for (auto* s = &scope; s != nullptr; s = s->parent(), ++depth) {
+    if (depth >= bound_generations_.size() ||
+        s->Generation() != bound_generations_[depth]) {
+      return false;
+    }
+  }
+  return depth == bound_generations_.size();
+}
+
+void OpRuntimeContexts::Restore(OpContext* op_ctx) {
+  for (auto& binding : op_ctx->bindings) {
+    *binding.first = vars_[binding.second];
+  }
+}
+
+void OpRuntimeContexts::RunOp(size_t op_idx, const Scope& scope,
+                              const platform::Place& place) {
+  auto* op = table_.op_slots_.at(op_idx).op;
+  auto& op_ctx = op_ctxs_.at(op_idx);
+  if (!op_ctx.resolved || &scope != bound_scope_) {
+    op->Run(scope, place);
+    return;
+  }
+  try {
+    op->Run(scope, place, op_ctx.ctx.get());
+  } catch (...) {
+    Restore(&op_ctx);
+    throw;
+  }
+  Restore(&op_ctx);
+}
+
+std::unique_ptr<OpRuntimeContexts> OpRuntimeContextsCache::Acquire(
+    const Scope& scope) {
+  std::unique_ptr<OpRuntimeContexts> runtime_ctxs;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto iter = idle_ctxs_.find(std::this_thread::get_id());
+    if (iter != idle_ctxs_.end()) {
+      runtime_ctxs = std::move(iter->second);
+    }
+  }
+  if (runtime_ctxs == nullptr) {
+    runtime_ctxs.reset(new OpRuntimeContexts(table_));
+  }
+  if (!runtime_ctxs->IsBoundTo(scope)) {
+    VLOG(4) << "Bind runtime contexts to scope " << &scope;
+    runtime_ctxs->Bind(scope);
+  }
+  return runtime_ctxs;
+}
+
+void OpRuntimeContextsCache::Release(
+    std::unique_ptr<OpRuntimeContexts> runtime_ctxs) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  idle_ctxs_[std::this_thread::get_id()] = std::move(runtime_ctxs);
+}
+
+}  // namespace framework
+}  // namespace paddle
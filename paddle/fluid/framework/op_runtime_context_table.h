@@ -0,0 +1,154 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * Resolves the input and output names of a list of operators to dense
+ * integer slots once. The table is not changed after Build, the runs of the
+ * operators share it and bind their own OpRuntimeContexts to their scopes.
+ */
+class OpRuntimeContextTable {
+ public:
+  // Assign the slots of ops, the ops are not owned and must outlive the
+  // table.
+  void Build(const std::vector<std::unique_ptr<OperatorBase>>& ops);
+
+  bool IsBuilt() const { return is_built_; }
+
+  size_t OpSize() const { return op_slots_.size(); }
+
+  size_t SlotSize() const { return slot_names_.size(); }
+
+  int Slot(const std::string& name) const;
+
+ private:
+  friend class OpRuntimeContexts;
+
+  struct OpSlots {
+    OperatorBase* op{nullptr};  // not owned
+    // the slots of op->Inputs() and op->Outputs() in their order, -1 for the
+    // empty variable
+    std::vector<int> input_slots;
+    std::vector<int> output_slots;
+  };
+
+  int AddSlot(const std::string& name);
+
+  void AddSlots(const VariableNameMap& names, std::vector<int>* slots);
+
+  bool is_built_{false};
+  std::unordered_map<std::string, int> name2slot_;
+  std::vector<std::string> slot_names_;
+  std::vector<OpSlots> op_slots_;
+};
+
+/*
+ * One RuntimeContext per operator of a built OpRuntimeContextTable, whose
+ * Variable pointers are filled from a flat array indexed by slot. Running an
+ * operator with its prepared RuntimeContext needs no name hashing nor scope
+ * walk, binding the contexts to a scope costs one FindVar per slot.
+ *
+ * The Variable pointers are only valid while the variables of the bound
+ * scope and its ancestors do not change, check IsBoundTo before every run
+ * and bind the contexts again if needed. Not thread-safe, every run owns its
+ * contexts.
+ */
+class OpRuntimeContexts {
+ public:
+  // The table must be built and outlive the contexts.
+  explicit OpRuntimeContexts(const OpRuntimeContextTable& table);
+
+  // Resolve every slot in scope and fill the prepared contexts.
+  void Bind(const Scope& scope);
+
+  const Scope* BoundScope() const { return bound_scope_; }
+
+  // Whether the contexts are bound to scope and no variable of scope or its
+  // ancestors has changed since.
+  bool IsBoundTo(const Scope& scope) const;
+
+  // Run the op_idx-th operator with its prepared context. Falls back to the
+  // name lookup of OperatorBase::Run when some variables of the operator
+  // were not found when binding.
+  void RunOp(size_t op_idx, const Scope& scope, const platform::Place& place);
+
+  Variable* Var(int slot) const { return vars_.at(slot); }
+
+ private:
+  struct OpContext {
+    std::unique_ptr<RuntimeContext> ctx;
+    // the address of each Variable pointer in ctx and its slot
+    std::vector<std::pair<Variable**, int>> bindings;
+    bool resolved{false};
+  };
+
+  void AddBindings(const VariableNameMap& names,
+                   const std::vector<int>& slots, VariableValueMap* values,
+                   OpContext* op_ctx);
+
+  // Operators that transform data put the transferred variables into the
+  // context, restore the bound ones after running.
+  void Restore(OpContext* op_ctx);
+
+  const OpRuntimeContextTable& table_;
+  const Scope* bound_scope_{nullptr};
+  // the generations of the bound scope and its ancestors when binding
+  std::vector<uint64_t> bound_generations_;
+  std::vector<Variable*> vars_;
+  std::vector<OpContext> op_ctxs_;
+};
+
+/*
+ * Keeps the bound OpRuntimeContexts of each thread running the operators of
+ * one table, so that a prepared program run again on the same scope is not
+ * bound again. A run acquires the contexts of its thread and releases them
+ * when it is finished; a nested run on the same thread gets new contexts.
+ */
+class OpRuntimeContextsCache {
+ public:
+  // The table must outlive the cache.
+  explicit OpRuntimeContextsCache(const OpRuntimeContextTable& table)
+      : table_(table) {}
+
+  // Return the contexts of the calling thread bound to scope, they are only
+  // bound again when scope or its variables changed since the last run.
+  std::unique_ptr<OpRuntimeContexts> Acquire(const Scope& scope);
+
+  void Release(std::unique_ptr<OpRuntimeContexts> runtime_ctxs);
+
+ private:
+  const OpRuntimeContextTable& table_;
+  std::mutex mutex_;
+  std::unordered_map<std::thread::id, std::unique_ptr<OpRuntimeContexts>>
+      idle_ctxs_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,238 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/op_runtime_context_table.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+USE_OP_ITSELF(scale);
+PD_DECLARE_KERNEL(scale, CPU, ALL_LAYOUT);
+
+DECLARE_bool(enable_op_runtime_context_table);
+
+namespace paddle {
+namespace framework {
+
+static constexpr int kNumOps = 16;
+
+static std::string VarName(int i) { return "x_" + std::to_string(i); }
+
+// x_0 -> scale -> x_1 -> ... -> scale -> x_kNumOps
+static ProgramDesc BuildScaleChain() {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  for (int i = 0; i <= kNumOps; ++i) {
+    auto* var = block->Var(VarName(i));
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetDataType(proto::VarType::FP32);
+  }
+  for (int i = 0; i < kNumOps; ++i) {
+    auto* op = block->AppendOp();
+    op->SetType("scale");
+    op->SetInput("X", {VarName(i)});
+    op->SetOutput("Out", {VarName(i + 1)});
+    op->SetAttr("scale", 1.0f);
+    op->SetAttr("bias", 1.0f);
+    op->CheckAttrs();
+  }
+  return program;
+}
+
+static std::vector<std::unique_ptr<OperatorBase>> CreateOps(
+    const ProgramDesc& program) {
+  std::vector<std::unique_ptr<OperatorBase>> ops;
+  for (auto* op_desc : program.Block(0).AllOps()) {
+    ops.emplace_back(OpRegistry::CreateOp(*op_desc));
+  }
+  return ops;
+}
+
+static void CreateVars(Scope* scope, float x_0) {
+  for (int i = 0; i <= kNumOps; ++i) {
+    scope->Var(VarName(i))->GetMutable<LoDTensor>();
+  }
+  auto* x = scope->FindVar(VarName(0))->GetMutable<LoDTensor>();
+  x->Resize({1});
+  x->mutable_data<float>(platform::CPUPlace())[0] = x_0;
+}
+
+static float Output(const Scope& scope) {
+  return scope.FindVar(VarName(kNumOps))->Get<LoDTensor>().data<float>()[0];
+}
+
+TEST(OpRuntimeContextTable, Slots) {
+  auto program = BuildScaleChain();
+  auto ops = CreateOps(program);
+  Scope scope;
+  CreateVars(&scope, 0.f);
+
+  OpRuntimeContextTable table;
+  table.Build(ops);
+  // every variable gets one slot, though the inner ones are used twice
+  EXPECT_EQ(table.OpSize(), static_cast<size_t>(kNumOps));
+  EXPECT_EQ(table.SlotSize(), static_cast<size_t>(kNumOps + 1));
+  EXPECT_EQ(table.Slot("not_exist"), -1);
+
+  OpRuntimeContexts ctxs(table);
+  ctxs.Bind(scope);
+  EXPECT_EQ(ctxs.BoundScope(), &scope);
+  for (int i = 0; i <= kNumOps; ++i) {
+    EXPECT_EQ(ctxs.Var(table.Slot(VarName(i))), scope.FindVar(VarName(i)));
+  }
+}
+
+TEST(OpRuntimeContextTable, ContextsOfOneTable) {
+  platform::CPUPlace place;
+  auto program = BuildScaleChain();
+  auto ops = CreateOps(program);
+  OpRuntimeContextTable table;
+  table.Build(ops);
+
+  // two runs share the table, each binds its contexts to its own scope
+  Scope scopes[2];
+  std::unique_ptr<OpRuntimeContexts> ctxs[2];
+  for (int r = 0; r < 2; ++r) {
+    CreateVars(&scopes[r], 10.f * r);
+    ctxs[r].reset(new OpRuntimeContexts(table));
+    ctxs[r]->Bind(scopes[r]);
+  }
+  for (int i = 0; i < kNumOps; ++i) {
+    for (int r = 0; r < 2; ++r) {
+      ctxs[r]->RunOp(i, scopes[r], place);
+    }
+  }
+  for (int r = 0; r < 2; ++r) {
+    EXPECT_EQ(ctxs[r]->Var(table.Slot(VarName(kNumOps))),
+              scopes[r].FindVar(VarName(kNumOps)));
+    // every scale adds one
+    EXPECT_FLOAT_EQ(Output(scopes[r]), 10.f * r + kNumOps);
+  }
+}
+
+TEST(OpRuntimeContextTable, IsBoundTo) {
+  auto program = BuildScaleChain();
+  auto ops = CreateOps(program);
+  OpRuntimeContextTable table;
+  table.Build(ops);
+
+  Scope scope;
+  auto* local_scope = &scope.NewScope();
+  CreateVars(local_scope, 0.f);
+  OpRuntimeContexts ctxs(table);
+  EXPECT_FALSE(ctxs.IsBoundTo(*local_scope));
+  ctxs.Bind(*local_scope);
+  EXPECT_TRUE(ctxs.IsBoundTo(*local_scope));
+  EXPECT_FALSE(ctxs.IsBoundTo(scope));
+
+  // writing the tensors does not change the variables
+  CreateVars(local_scope, 1.f);
+  EXPECT_TRUE(ctxs.IsBoundTo(*local_scope));
+
+  local_scope->Var("y");
+  EXPECT_FALSE(ctxs.IsBoundTo(*local_scope));
+  ctxs.Bind(*local_scope);
+  EXPECT_TRUE(ctxs.IsBoundTo(*local_scope));
+
+  // the variables of the ancestors are found by the scope too
+  scope.Var(VarName(0));
+  EXPECT_FALSE(ctxs.IsBoundTo(*local_scope));
+}
+
+TEST(OpRuntimeContextTable, ContextsCache) {
+  auto program = BuildScaleChain();
+  auto ops = CreateOps(program);
+  OpRuntimeContextTable table;
+  table.Build(ops);
+  OpRuntimeContextsCache cache(table);
+
+  Scope scope;
+  CreateVars(&scope, 0.f);
+  auto ctxs = cache.Acquire(scope);
+  auto* ctxs_ptr = ctxs.get();
+  EXPECT_TRUE(ctxs->IsBoundTo(scope));
+  // a nested run on the same thread gets its own contexts
+  auto nested_ctxs = cache.Acquire(scope);
+  EXPECT_NE(nested_ctxs.get(), ctxs_ptr);
+  nested_ctxs.reset();
+  cache.Release(std::move(ctxs));
+
+  // the next run of the thread reuses the bound contexts
+  ctxs = cache.Acquire(scope);
+  EXPECT_EQ(ctxs.get(), ctxs_ptr);
+  EXPECT_TRUE(ctxs->IsBoundTo(scope));
+  cache.Release(std::move(ctxs));
+
+  // another thread binds its own contexts
+  OpRuntimeContexts* other_ctxs_ptr = nullptr;
+  std::thread other([&] {
+    auto other_ctxs = cache.Acquire(scope);
+    other_ctxs_ptr = other_ctxs.get();
+    EXPECT_TRUE(other_ctxs->IsBoundTo(scope));
+    cache.Release(std::move(other_ctxs));
+  });
+  other.join();
+  EXPECT_NE(other_ctxs_ptr, ctxs_ptr);
+
+  // the contexts are bound again to a new scope
+  Scope new_scope;
+  CreateVars(&new_scope, 0.f);
+  ctxs = cache.Acquire(new_scope);
+  EXPECT_EQ(ctxs.get(), ctxs_ptr);
+  EXPECT_TRUE(ctxs->IsBoundTo(new_scope));
+  EXPECT_EQ(ctxs->Var(table.Slot(VarName(0))), new_scope.FindVar(VarName(0)));
+  cache.Release(std::move(ctxs));
+}
+
+TEST(OpRuntimeContextTable, NaiveExecutorRebind) {
+  platform::CPUPlace place;
+  auto program = BuildScaleChain();
+  Scope scope;
+
+  for (bool use_table : {false, true}) {
+    FLAGS_enable_op_runtime_context_table = use_table;
+    NaiveExecutor exe(place);
+    auto* exe_scope = &scope.NewScope();
+    exe.CreateVariables(program, 0, false, exe_scope);
+    exe.Prepare(exe_scope, program, 0, false);
+    auto* x = exe.FindTensor(VarName(0));
+    x->Resize({1});
+    x->mutable_data<float>(place)[0] = 0.f;
+    exe.Run();
+    EXPECT_FLOAT_EQ(Output(*exe_scope), static_cast<float>(kNumOps));
+
+    // the variables erased and created again between two runs are bound
+    // again, the ops write the new ones
+    std::vector<std::string> names = {VarName(kNumOps / 2), VarName(kNumOps)};
+    exe_scope->EraseVars(names);
+    for (auto& name : names) {
+      exe_scope->Var(name)->GetMutable<LoDTensor>();
+    }
+    exe.FindTensor(VarName(0))->data<float>()[0] = 1.f;
+    exe.Run();
+    EXPECT_FLOAT_EQ(Output(*exe_scope), static_cast<float>(kNumOps + 1));
+  }
+  FLAGS_enable_op_runtime_context_table = false;
+}
+
+}  // namespace framework
+}  // namespace paddle
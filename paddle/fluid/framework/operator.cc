@@ -205,6 +205,11 @@ RuntimeContext::RuntimeContext(const VariableNameMap& innames,
 }
 
 void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
+  Run(scope, place, nullptr);
+}
+
+void OperatorBase::Run(const Scope& scope, const platform::Place& place,
+                       RuntimeContext* runtime_ctx) {
   try {
     VLOG(4) << place << " " << DebugStringEx(&scope);
     if (platform::is_gpu_place(place)) {
@@ -268,7 +273,11 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
       platform::RecordEvent op_name_record_event(
           op_name, platform::TracerEventType::Operator, 10,
           platform::EventRole::kUniqueOp);
-      RunImpl(scope, place);
+      if (runtime_ctx == nullptr) {
+        RunImpl(scope, place);
+      } else {
+        RunImplWithRuntimeContext(scope, place, runtime_ctx);
+      }
     }
 
     VLOG(3) << GetExecutionPlace(place) << " " << DebugStringEx(&scope);
@@ -1171,6 +1180,15 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   }
 }
 
+void OperatorWithKernel::RunImplWithRuntimeContext(
+    const Scope& scope, const platform::Place& place,
+    RuntimeContext* runtime_ctx) const {
+  if (!all_kernels_must_compute_runtime_shape_ &&
+      HasAttr(kAllKernelsMustComputeRuntimeShape))
+    all_kernels_must_compute_runtime_shape_ = true;
+  RunImpl(scope, place, runtime_ctx);
+}
+
 void OperatorWithKernel::RunImpl(const Scope& scope,
                                  const platform::Place& place,
                                  RuntimeContext* runtime_ctx) const {
@@ -1308,13 +1326,13 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
                                        platform::TracerEventType::OperatorInner,
                                        1, platform::EventRole::kInnerOp);
     if (run_phi_kernel_) {
-      phi::KernelContext pt_kernel_context;
+      phi::ScopedKernelContext pt_kernel_context;
       // Do data transform before building KernelContext
       // TODO(zhiqiu): support TransferInplaceVarsBack
       PreparePhiData(exec_scope, *pt_kernel_, *pt_kernel_signature_,
                      runtime_ctx);
-      BuildPhiKernelContext(*runtime_ctx, dev_ctx, &pt_kernel_context);
-      (*pt_kernel_)(&pt_kernel_context);
+      BuildPhiKernelContext(*runtime_ctx, dev_ctx, pt_kernel_context.get());
+      (*pt_kernel_)(pt_kernel_context.get());
     } else {
       (*kernel_func_)(
           ExecutionContext(*this, exec_scope, *dev_ctx, *runtime_ctx));
@@ -158,6 +158,13 @@ class OperatorBase {
   //  The implementation should be written at RunImpl
   void Run(const Scope& scope, const platform::Place& place);
 
+  /// Same as Run(scope, place), but the input and output variables are taken
+  /// from runtime_ctx, which is prepared by the executor, instead of being
+  /// looked up in the scope by name. Operators without kernel still use the
+  /// scope.
+  void Run(const Scope& scope, const platform::Place& place,
+           RuntimeContext* runtime_ctx);
+
   // FIXME(typhoonzero): this is only used for recv_op to stop event_loop.
   virtual void Stop() {}
 
@@ -251,6 +258,11 @@ class OperatorBase {
   void CheckAllInputOutputSet() const;
   virtual void RunImpl(const Scope& scope,
                        const platform::Place& place) const = 0;
+  virtual void RunImplWithRuntimeContext(const Scope& scope,
+                                         const platform::Place& place,
+                                         RuntimeContext* runtime_ctx) const {
+    RunImpl(scope, place);
+  }
 };
 
 class ExecutionContext {
@@ -649,6 +661,9 @@ class OperatorWithKernel : public OperatorBase {
   void RunImpl(const Scope& scope, const platform::Place& place) const final;
   void RunImpl(const Scope& scope, const platform::Place& place,
                RuntimeContext* runtime_ctx) const;
+  void RunImplWithRuntimeContext(const Scope& scope,
+                                 const platform::Place& place,
+                                 RuntimeContext* runtime_ctx) const final;
 
   /**
    * Transfer data from scope to a transferred scope. If there is no data need
@@ -189,6 +189,7 @@ void Scope::EraseVars(const std::vector<std::string>& var_names) {
         ++it;
       }
     }
+    NextGeneration();
   }
   for (auto l : listeners_) {
     for (auto& var_name : var_names) {
@@ -225,6 +226,7 @@ Variable* Scope::VarInternal(const std::string& name) {
   if (v != nullptr) return v;
   v = new Variable();
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  NextGeneration();
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -260,6 +262,7 @@ void Scope::RenameInternal(const std::string& origin_name,
           "The variable with name %s already exists in the scope.", new_name));
   vars_[new_name].reset(origin_it->second.release());
   vars_.erase(origin_it);
+  NextGeneration();
 }
 
 Variable* Scope::FindVarInternal(const std::string& name) const {
@@ -278,6 +281,15 @@ Variable* Scope::FindVarLocally(const std::string& name) const {
   return nullptr;
 }
 
+void Scope::NextGeneration() const {
+  generation_.store(NewGeneration(), std::memory_order_release);
+}
+
+uint64_t Scope::NewGeneration() {
+  static std::atomic<uint64_t> generation{0};
+  return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
 void Scope::AddListener(const std::shared_ptr<ScopeListener>& listener) {
   auto it = std::find(listeners_.begin(), listeners_.end(), listener);
   if (it == listeners_.end()) {
@@ -298,6 +310,7 @@ void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
       vars_.erase(iter++);
     }
   }
+  NextGeneration();
 }
 
 std::string GenScopeTreeDebugInfo(Scope* root) {
@@ -18,6 +18,7 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -147,6 +148,13 @@ class Scope : public ScopeBase {
   // Rename variable to a new name and return the new name
   std::string Rename(const std::string& origin_name) const;
 
+  /// Changes whenever a variable is created in, erased from or renamed in
+  /// this scope. Generations are unique among all scopes, so a scope and its
+  /// generation never match a deleted scope at the same address.
+  uint64_t Generation() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+
   void AddListener(const std::shared_ptr<ScopeListener>& listener);
 
   void DelListener(const std::shared_ptr<ScopeListener>& listener);
@@ -184,10 +192,16 @@ class Scope : public ScopeBase {
   // Called by FindVarInternal and Var.
   Variable* FindVarLocally(const std::string& name) const;
 
+  // Called when the variables of the scope change.
+  void NextGeneration() const;
+
+  static uint64_t NewGeneration();
+
   // Scope in `kids_` are owned by this class.
   mutable std::list<Scope*> kids_;
   const Scope* parent_{nullptr};
   std::list<std::shared_ptr<ScopeListener>> listeners_;
+  mutable std::atomic<uint64_t> generation_{NewGeneration()};
 
   DISABLE_COPY_AND_ASSIGN(Scope);
 
@@ -77,3 +77,31 @@ TEST(Scope, GetAllNames) {
 
   EXPECT_STREQ("a", str.c_str());
 }
+
+TEST(Scope, Generation) {
+  Scope s;
+  Scope& ss = s.NewScope();
+  EXPECT_NE(s.Generation(), ss.Generation());
+
+  auto generation = s.Generation();
+  s.Var("a");
+  EXPECT_NE(generation, s.Generation());
+
+  // looking up or getting an existing variable changes nothing
+  generation = s.Generation();
+  s.FindVar("a");
+  s.Var("a");
+  EXPECT_EQ(generation, s.Generation());
+
+  s.Rename("a", "b");
+  EXPECT_NE(generation, s.Generation());
+
+  generation = s.Generation();
+  s.EraseVars({"b"});
+  EXPECT_NE(generation, s.Generation());
+
+  // the variables of the kids are not the variables of the scope
+  generation = s.Generation();
+  ss.Var("c");
+  EXPECT_EQ(generation, s.Generation());
+}
@@ -425,12 +425,12 @@ static void PreparedOpRunPtImpl(
 
     PreparePhiData<VarType>(pt_kernel, pt_kernel_signature, ins);
 
-    phi::KernelContext pt_kernel_context;
+    phi::ScopedKernelContext pt_kernel_context;
     BuildDygraphPhiKernelContext<VarType>(pt_kernel_signature, pt_kernel, ins,
                                           outs, attrs, default_attrs, dev_ctx,
-                                          &pt_kernel_context);
+                                          pt_kernel_context.get());
 
-    pt_kernel(&pt_kernel_context);
+    pt_kernel(pt_kernel_context.get());
   }
 
   if (FLAGS_benchmark) {
@@ -60,6 +60,9 @@ struct Argument {
   using unique_ptr_t = std::unique_ptr<void, std::function<void(void*)>>;
   using fusion_statis_t = std::unordered_map<std::string, int>;
   using input_shape_t = std::map<std::string, std::vector<int>>;
+  // The offset and the size in bytes of the vars in the memory arena.
+  using memory_offset_plan_t =
+      std::unordered_map<std::string, std::pair<size_t, size_t>>;
 
   bool Has(const std::string& key) const { return valid_fields_.count(key); }
   // If we set the model using config.SetModelBuffer,
@@ -265,6 +268,14 @@ struct Argument {
   // optimization relays on the sort algorithm.
   DECL_ARGUMENT_FIELD(memory_optim_sort_kind, MemoryOptimSortKind, int);
 
+  // Pack the vars into a memory arena by their lifecycles instead of renaming
+  // them, the max shapes in the shape range info bound their sizes.
+  DECL_ARGUMENT_FIELD(memory_optim_offset_plan, MemoryOptimOffsetPlan, bool);
+  DECL_ARGUMENT_FIELD(memory_optim_shape_range_info_path,
+                      MemoryOptimShapeRangeInfoPath, std::string);
+  DECL_ARGUMENT_FIELD(memory_offset_plan, MemoryOffsetPlan,
+                      memory_offset_plan_t);
+
   // The program transformed by IR analysis phase.
   DECL_ARGUMENT_UNIQUE_FIELD(ir_analyzed_program, IrAnalyzedProgram,
                              framework::proto::ProgramDesc);
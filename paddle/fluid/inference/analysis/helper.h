@@ -236,6 +236,16 @@ static std::string GetTrtCalibTableData(const std::string &model_opt_cache_dir,
   return "";
 }
 
+static std::string GetOptimizedProgramCachePath(const std::string &model_root,
+                                                const std::string &key) {
+  return model_root + "/optimized_program_" + key;
+}
+
+static std::string GetOptimizedParamsCachePath(const std::string &model_root,
+                                               const std::string &key) {
+  return model_root + "/optimized_params_" + key;
+}
+
 static std::string GetTrtEngineSerializedPath(const std::string &model_root,
                                               const std::string &engine_key) {
   return model_root + "/trt_serialized_" + engine_key;
@@ -14,11 +14,14 @@
 
 #include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
 
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <utility>
 
 #include "glog/logging.h"
 #include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/inference/utils/io_utils.h"
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
@@ -90,7 +93,8 @@ void MemoryOptimizePass::CollectLifeCycle(
 }
 
 void MemoryOptimizePass::CollectVarMemorySize(
-    Graph* graph, space_table_t* space_table) const {
+    Graph* graph, space_table_t* space_table,
+    const std::map<std::string, std::vector<int32_t>>* max_shapes) const {
   const int fake_batch_size = 1;
 
   auto valid_var = [&](framework::ir::Node* node) -> bool {
@@ -149,12 +153,21 @@ void MemoryOptimizePass::CollectVarMemorySize(
       // Parameters will not be reused.
       if (node->Var()->Persistable()) continue;
       auto shape = node->Var()->GetShape();
+      if (max_shapes) {
+        auto bound = max_shapes->find(node->Var()->Name());
+        if (bound != max_shapes->end()) {
+          shape.assign(bound->second.begin(), bound->second.end());
+        } else if (std::any_of(shape.begin(), shape.end(),
+                               [](int64_t v) { return v < 0; })) {
+          continue;
+        }
+      }
       for (auto& v : shape) {
         if (v < 0) v = fake_batch_size;
       }
 
-      int size = std::accumulate(shape.begin(), shape.end(), 1,
-                                 std::multiplies<int>());
+      int64_t size = std::accumulate(shape.begin(), shape.end(), int64_t{1},
+                                     std::multiplies<int64_t>());
       (*space_table)[node->Var()->Name()] =
           size * paddle::framework::SizeOfType(node->Var()->GetDataType());
     }
@@ -218,6 +231,70 @@ void MakeSimpleReusePlan(
   }
 }
 
+// Place every var in the smallest gap of the arena left by the vars placed
+// before it with overlapping lifetimes, or after all of them. The larger vars
+// are placed first. It returns the size of the arena.
+size_t MakeOffsetReusePlan(
+    const std::unordered_map<std::string, std::pair<int, int>>& lifecycles,
+    const std::unordered_map<std::string, size_t>& space_table,
+    Argument::memory_offset_plan_t* plan) {
+  // The offsets are aligned as the allocators do.
+  constexpr size_t kAlignment = 64;
+  struct Block {
+    std::string name;
+    size_t size;
+    std::pair<int, int> lifetime;
+    size_t offset;
+  };
+  std::vector<Block> blocks;
+  for (auto& data : lifecycles) {
+    if (!space_table.count(data.first)) continue;
+    size_t size = space_table.at(data.first);
+    if (size == 0) continue;
+    size = (size + kAlignment - 1) / kAlignment * kAlignment;
+    blocks.push_back(Block{data.first, size, data.second, 0});
+  }
+  std::sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) {
+    return a.size != b.size ? a.size > b.size : a.name < b.name;
+  });
+
+  auto overlap = [](std::pair<int, int> a, std::pair<int, int> b) -> bool {
+    return b.second >= a.first && a.second >= b.first;
+  };
+  size_t arena_size = 0;
+  std::vector<const Block*> live;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    auto& block = blocks[i];
+    live.clear();
+    for (size_t j = 0; j < i; j++) {
+      if (overlap(block.lifetime, blocks[j].lifetime)) {
+        live.push_back(&blocks[j]);
+      }
+    }
+    std::sort(live.begin(), live.end(), [](const Block* a, const Block* b) {
+      return a->offset < b->offset;
+    });
+    // Take the smallest gap that fits, or the end of the live blocks.
+    size_t best_offset = 0, best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    for (auto* other : live) {
+      if (other->offset >= end) {
+        size_t gap = other->offset - end;
+        if (gap >= block.size && gap < best_gap) {
+          best_offset = end;
+          best_gap = gap;
+        }
+      }
+      end = std::max(end, other->offset + other->size);
+    }
+    block.offset =
+        best_gap == std::numeric_limits<size_t>::max() ? end : best_offset;
+    arena_size = std::max(arena_size, block.offset + block.size);
+    (*plan)[block.name] = std::make_pair(block.offset, block.size);
+  }
+  return arena_size;
+}
+
 // NOTE The optimized opdesc doesn't match ir::Graph.
 void UpdateOpDescsByReuse(
     Graph* graph,
@@ -290,6 +367,58 @@ void UpdateOpDescsByReuse(
   }
 }
 
+void MemoryOptimizePass::MakeOffsetPlan(Graph* graph, Argument* argument,
+                                        int sort_kind) const {
+  std::map<std::string, std::vector<int32_t>> min_shapes, max_shapes,
+      opt_shapes;
+  if (argument->memory_optim_shape_range_info_path_valid() &&
+      !argument->memory_optim_shape_range_info_path().empty()) {
+    DeserializeShapeRangeInfo(argument->memory_optim_shape_range_info_path(),
+                              &min_shapes, &max_shapes, &opt_shapes);
+  }
+
+  std::unordered_map<std::string, lifecycle_t> lifecycles;
+  space_table_t space_table;
+  CollectLifeCycle(graph, &lifecycles, sort_kind);
+  CollectVarMemorySize(graph, &space_table, &max_shapes);
+
+  // The vars fed or fetched by the users are kept out of the arena, they are
+  // written before the run or read after it.
+  for (auto* node : graph->Nodes()) {
+    if (!node->IsVar()) continue;
+    bool fed = node->inputs.empty();
+    for (auto* op : node->inputs) {
+      fed |= op->IsOp() && op->Name() == "feed";
+    }
+    if (fed || node->outputs.empty()) {
+      space_table.erase(node->Name());
+    }
+  }
+
+  Argument::memory_offset_plan_t plan;
+  size_t arena_size = MakeOffsetReusePlan(lifecycles, space_table, &plan);
+
+  // The peaks of the same vars without reuse and with the renaming plan.
+  size_t total_size = 0, cluster_total_size = 0;
+  for (auto& item : plan) {
+    total_size += space_table.at(item.first);
+  }
+  std::unordered_map<std::string, std::string> node2cluster;
+  std::unordered_map<std::string, int> cluster_size;
+  MakeSimpleReusePlan(lifecycles, space_table, &node2cluster, &cluster_size);
+  for (auto& cluster : cluster_size) {
+    cluster_total_size += cluster.second;
+  }
+  LOG(INFO) << "Memory offset plan packs " << plan.size() << " vars of "
+            << total_size << " bytes into an arena of " << arena_size
+            << " bytes, the renaming plan takes " << cluster_total_size
+            << " bytes";
+
+  argument->SetMemoryOffsetPlan(plan);
+  // The program must run in the order the lifecycles are collected in.
+  argument->SetMemoryOptimSortKind(sort_kind);
+}
+
 std::string MemoryOptimizePass::repr() const { return "memory optimize pass"; }
 
 void MemoryOptimizePass::RunImpl(Argument* argument) {
@@ -310,6 +439,12 @@ void MemoryOptimizePass::RunImpl(Argument* argument) {
   auto graph = argument->main_graph_ptr();
 
   int sort_kind = 0;
+  if (argument->memory_optim_offset_plan_valid() &&
+      argument->memory_optim_offset_plan()) {
+    MakeOffsetPlan(graph, argument, sort_kind);
+    return;
+  }
+
   std::unordered_map<std::string, lifecycle_t> lifecycles;
   space_table_t space_table;
   std::unordered_map<std::string, std::string> node2cluster;
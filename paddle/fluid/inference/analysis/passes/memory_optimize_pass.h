@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #pragma once
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -44,6 +45,9 @@ namespace analysis {
 * name of var and the value in the table represents the current name of var.
 * 3. Perform reuse plan: Replace all var's name in the model according to the
 * mapping table.
+* With the offset plan, the vars are not renamed. Each one is given an offset
+* in a memory arena that doesn't overlap the vars living at the same time, and
+* the predictor binds the vars to the arena before every run.
 */
 class MemoryOptimizePass : public AnalysisPass {
  public:
@@ -61,8 +65,15 @@ class MemoryOptimizePass : public AnalysisPass {
       std::unordered_map<std::string, lifecycle_t> *lifecycles,
       int sort_kind) const;
 
-  void CollectVarMemorySize(framework::ir::Graph *graph,
-                            space_table_t *space_table) const;
+  // If max_shapes is given, the sizes are the bounds of the vars from their
+  // max shapes or static shapes, the vars without a bound are skipped.
+  void CollectVarMemorySize(
+      framework::ir::Graph *graph, space_table_t *space_table,
+      const std::map<std::string, std::vector<int32_t>> *max_shapes =
+          nullptr) const;
+
+  void MakeOffsetPlan(framework::ir::Graph *graph, Argument *argument,
+                      int sort_kind) const;
 
  public:
   std::string repr() const override;
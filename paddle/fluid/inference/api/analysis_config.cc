@@ -204,6 +204,9 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
                                   // params_file_ fields.
 
   CP_MEMBER(opt_cache_dir_);
+  CP_MEMBER(optimized_program_cache_);
+  CP_MEMBER(weight_sharing_);
+  CP_MEMBER(weight_sharing_dir_);
   CP_MEMBER(prog_file_);
   CP_MEMBER(params_file_);
 
@@ -215,6 +218,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(memory_pool_init_size_mb_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(memory_offset_plan_);
+  CP_MEMBER(memory_offset_plan_shape_range_info_path_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -243,6 +248,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   // Bfloat16 related.
   CP_MEMBER(use_mkldnn_bfloat16_);
   CP_MEMBER(bfloat16_enabled_op_types_);
+  CP_MEMBER(use_cpu_int8_);
   // Quantization related.
   CP_MEMBER(use_mkldnn_quantizer_);
   CP_MEMBER(mkldnn_quantizer_config_);
@@ -418,6 +424,12 @@ void AnalysisConfig::EnableMkldnnBfloat16() {
   Update();
 }
 
+void AnalysisConfig::EnableCpuInt8() {
+  use_cpu_int8_ = true;
+
+  Update();
+}
+
 MkldnnQuantizerConfig *AnalysisConfig::mkldnn_quantizer_config() const {
   PADDLE_ENFORCE_NOT_NULL(mkldnn_quantizer_config_,
                           platform::errors::PreconditionNotMet(
@@ -601,6 +613,19 @@ void AnalysisConfig::Update() {
 #endif
   }
 
+  if (use_cpu_int8_) {
+    if (!enable_ir_optim_) {
+      LOG(ERROR) << "EnableCpuInt8() only works when IR optimization "
+                    "is enabled.";
+    }
+    if (use_mkldnn_) {
+      LOG(ERROR) << "EnableCpuInt8() does not work with MKLDNN, the "
+                    "quantized ops will run with the MKLDNN kernels.";
+    } else {
+      pass_builder()->EnableCpuInt8();
+    }
+  }
+
 #ifdef PADDLE_WITH_MKLDNN
   // Do not optimize when mkldnn is on
   if (enable_memory_optim_ && !use_mkldnn_) {
@@ -689,6 +714,9 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << memory_offset_plan_;
+  ss << memory_offset_plan_shape_range_info_path_;
+  ss << optimized_program_cache_;
 
   ss << use_mkldnn_;
   ss << mkldnn_cache_capacity_;
@@ -699,6 +727,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << use_mkldnn_bfloat16_;
   for (auto &item : bfloat16_enabled_op_types_) ss << item;
   ss << ";";
+  ss << use_cpu_int8_;
   ss << model_from_memory_;
 
   ss << with_profile_;
@@ -775,6 +804,13 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableMemoryOffsetPlan(
+    const std::string &shape_range_info_path) {
+  memory_offset_plan_ = true;
+  memory_offset_plan_shape_range_info_path_ = shape_range_info_path;
+  EnableMemoryOptim();
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
@@ -854,6 +890,7 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow({"enable_mkldnn", use_mkldnn_ ? "true" : "false"});
   os.InsertRow(
       {"mkldnn_cache_capacity", std::to_string(mkldnn_cache_capacity_)});
+  os.InsertRow({"enable_cpu_int8", use_cpu_int8_ ? "true" : "false"});
   os.InsetDivider();
 
   // gpu info
@@ -943,6 +980,16 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow({"ir_optim", enable_ir_optim_ ? "true" : "false"});
   os.InsertRow({"ir_debug", ir_debug_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  if (enable_memory_optim_) {
+    os.InsertRow(
+        {"memory_offset_plan", memory_offset_plan_ ? "true" : "false"});
+  }
+  os.InsertRow({"optimized_program_cache",
+                optimized_program_cache_ ? "true" : "false"});
+  os.InsertRow({"weight_sharing", weight_sharing_ ? "true" : "false"});
+  if (weight_sharing_ && !weight_sharing_dir_.empty()) {
+    os.InsertRow({"weight_sharing_dir", weight_sharing_dir_});
+  }
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
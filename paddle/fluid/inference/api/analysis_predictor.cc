@@ -17,9 +17,12 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <memory>
+#include <random>
 #include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -39,9 +42,12 @@
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
+#include "paddle/fluid/inference/io.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
 #include "paddle/fluid/inference/utils/singleton.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/memory/memcpy.h"
+#include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/device_context.h"
@@ -208,6 +214,7 @@ bool AnalysisPredictor::Init(
   if (!PrepareExecutor()) {
     return true;
   }
+  PrepareMemoryArena();
 
   return true;
 }
@@ -241,12 +248,36 @@ bool AnalysisPredictor::PrepareProgram(
     // If config_.ir_optim() is False, parameters is loaded in LoadParameters(),
     // still need to create other persistable variables.
     // So in both case, create persistable variables at first.
-    executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
-
-    // if enable_ir_optim_ is false,
-    // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc) will
-    // not be executed.
-    OptimizeInferenceProgram();
+    // The optimized program and parameters of the same model and config are
+    // taken from the other predictors or loaded from the cache without
+    // running the analysis passes.
+    std::string program_key = config_.optimized_program_cache_enabled() ||
+                                      config_.weight_sharing_enabled()
+                                  ? OptimizedProgramKey()
+                                  : "";
+    std::string cache_key =
+        config_.optimized_program_cache_enabled() ? program_key : "";
+    std::string weight_key =
+        config_.weight_sharing_enabled() ? program_key : "";
+    std::string cache_dir = OptimizedProgramCacheDir(
+        config_.opt_cache_dir_, config_.model_dir(), config_.prog_file());
+    if (weight_key.empty() || !AttachSharedWeights(weight_key)) {
+      if (cache_key.empty() ||
+          !LoadOptimizedProgramCache(cache_dir, cache_key)) {
+        executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+
+        // if enable_ir_optim_ is false,
+        // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc)
+        // will not be executed.
+        OptimizeInferenceProgram();
+        if (!cache_key.empty()) {
+          SaveOptimizedProgramCache(cache_dir, cache_key);
+        }
+      }
+      if (!weight_key.empty()) {
+        PublishSharedWeights(weight_key);
+      }
+    }
   } else {
     // If the program is passed from external, no need to optimize it, this
     // logic is used in the clone scenario.
@@ -373,6 +404,51 @@ static void DisablePrepareDataOpt(
   }
 }
 
+namespace {
+// A slot of the memory arena, it keeps the arena alive.
+class MemoryArenaSlot : public phi::Allocation {
+ public:
+  MemoryArenaSlot(const std::shared_ptr<phi::Allocation> &arena, size_t offset,
+                  size_t size)
+      : phi::Allocation(static_cast<uint8_t *>(arena->ptr()) + offset, size,
+                        arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<phi::Allocation> arena_;
+};
+}  // namespace
+
+void AnalysisPredictor::PrepareMemoryArena() {
+  if (memory_offset_plan_.empty()) return;
+  size_t arena_size = 0;
+  for (auto &item : memory_offset_plan_) {
+    arena_size = std::max(arena_size, item.second.first + item.second.second);
+  }
+  memory_arena_ = memory::AllocShared(place_, arena_size);
+  for (auto &item : memory_offset_plan_) {
+    auto *var = sub_scope_->FindLocalVar(item.first);
+    if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+    arena_slots_.emplace_back(
+        var->GetMutable<framework::LoDTensor>(),
+        std::make_shared<MemoryArenaSlot>(memory_arena_, item.second.first,
+                                          item.second.second));
+  }
+  VLOG(3) << "Bind " << arena_slots_.size() << " tensors to a memory arena of "
+          << arena_size << " bytes";
+}
+
+void AnalysisPredictor::BindMemoryArena() {
+  // The kernels allocate a tensor again if it outgrows its slot or share
+  // another buffer, it is bound to its slot again for the next run.
+  for (auto &slot : arena_slots_) {
+    if (slot.first->Holder() != slot.second) {
+      slot.first->clear();
+      slot.first->ResetHolder(slot.second);
+    }
+  }
+}
+
 bool AnalysisPredictor::PrepareExecutor() {
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE) && \
     !defined(PADDLE_WITH_ASCEND_CL)
@@ -693,6 +769,7 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
 
   // Run the inference program
   // if share variables, we need not create variables
+  BindMemoryArena();
   executor_->Run();
 
   // get fetch variable
@@ -824,6 +901,9 @@ void AnalysisPredictor::PrepareArgument() {
   argument_.SetGPUDeviceId(config_.gpu_device_id());
   argument_.SetEnableAnalysisOptim(config_.enable_ir_optim_);
   argument_.SetEnableMemoryOptim(config_.enable_memory_optim());
+  argument_.SetMemoryOptimOffsetPlan(config_.memory_offset_plan_enabled());
+  argument_.SetMemoryOptimShapeRangeInfoPath(
+      config_.memory_offset_plan_shape_range_info_path_);
   argument_.SetModelFromMemory(config_.model_from_memory_);
   // Analyze inference_program
   argument_.SetPredictorID(predictor_id_);
@@ -993,6 +1073,9 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
 #endif
         delete prog;
       });
+  if (argument_.memory_offset_plan_valid()) {
+    memory_offset_plan_ = argument_.memory_offset_plan();
+  }
   // The config and argument take a lot of storage,
   // when the predictor settings are complete, we release these stores.
   argument_.PartiallyRelease();
@@ -1000,6 +1083,210 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
   LOG(INFO) << "======= optimize end =======";
 }
 
+// The size and the modification time of a file, empty if it is not found.
+static std::string FileStamp(const std::string &filename) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) {
+    return "";
+  }
+  return std::to_string(st.st_size) + ":" + std::to_string(st.st_mtime);
+}
+
+// The optimization cache directory, or the one beside the model.
+static std::string OptimizedProgramCacheDir(const std::string &opt_cache_dir,
+                                            const std::string &model_dir,
+                                            const std::string &prog_file) {
+  if (!opt_cache_dir.empty()) {
+    return opt_cache_dir;
+  }
+  return (model_dir.empty() ? inference::analysis::GetDirRoot(prog_file)
+                            : model_dir) +
+         "/_opt_cache/";
+}
+
+std::string AnalysisPredictor::OptimizedProgramKey() {
+  // the passes of the subgraph engines and the devices keep states out of
+  // the program and the scope
+  if (!config_.ir_optim() || config_.model_from_memory() ||
+      !platform::is_cpu_place(place_) || config_.tensorrt_engine_enabled() ||
+      config_.lite_engine_enabled() || config_.use_dlnne_ ||
+      config_.mkldnn_quantizer_enabled() ||
+      config_.memory_offset_plan_enabled()) {
+    return "";
+  }
+  std::stringstream ss;
+  ss << paddle::get_version() << ";";
+  ss << config_.SerializeInfoCache() << ";";
+  for (auto &pass : config_.pass_builder()->AllPasses()) ss << pass << ",";
+  ss << ";";
+  for (auto &pass : config_.pass_builder()->AnalysisPasses()) ss << pass << ",";
+  ss << ";";
+  // the fuse passes of mkldnn depend on the instruction sets
+  for (auto isa : {platform::avx2, platform::avx512f,
+                   platform::avx512_core_vnni, platform::avx512_bf16}) {
+    ss << platform::MayIUse(isa);
+  }
+  ss << ";";
+  ss << inference_program_->Proto()->SerializeAsString() << ";";
+  // the parameters are not read, their files are known by the size and the
+  // modification time
+  if (!config_.params_file().empty()) {
+    ss << FileStamp(config_.params_file());
+  } else {
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (IsPersistable(var)) {
+        ss << var->Name() << ":"
+           << FileStamp(config_.model_dir() + "/" + var->Name()) << ",";
+      }
+    }
+  }
+  return std::to_string(std::hash<std::string>()(ss.str()));
+}
+
+bool AnalysisPredictor::LoadOptimizedProgramCache(const std::string &cache_dir,
+                                                  const std::string &key) {
+  std::string program_path =
+      inference::analysis::GetOptimizedProgramCachePath(cache_dir, key);
+  std::string params_path =
+      inference::analysis::GetOptimizedParamsCachePath(cache_dir, key);
+  if (!inference::analysis::FileExists(program_path) ||
+      !inference::IsMappedParamsFile(params_path)) {
+    VLOG(3) << "No optimized program cache " << program_path;
+    return false;
+  }
+  std::ifstream fin(program_path, std::ios::in | std::ios::binary);
+  std::stringstream content;
+  content << fin.rdbuf();
+  framework::proto::ProgramDesc proto;
+  if (!proto.ParseFromString(content.str())) {
+    LOG(WARNING) << "Failed to parse the optimized program cache "
+                 << program_path;
+    return false;
+  }
+  auto program = std::make_shared<framework::ProgramDesc>(proto);
+  std::vector<std::string> params;
+  for (auto *var : program->Block(0).AllVars()) {
+    if (IsPersistable(var)) {
+      params.push_back(var->Name());
+    }
+  }
+  try {
+    executor_->CreateVariables(*program, 0, true, sub_scope_);
+    inference::LoadMappedParams(scope_.get(), params, params_path, place_);
+  } catch (platform::EnforceNotMet &error) {
+    LOG(WARNING) << "Failed to load the optimized params cache "
+                 << params_path << ", " << error.what();
+    return false;
+  }
+  inference_program_ = program;
+  LOG(INFO) << "Load the optimized program from " << program_path;
+  return true;
+}
+
+void AnalysisPredictor::SaveOptimizedProgramCache(const std::string &cache_dir,
+                                                  const std::string &key) {
+  std::vector<std::string> params;
+  for (auto *var : inference_program_->Block(0).AllVars()) {
+    if (!var->Persistable() ||
+        var->GetType() == framework::proto::VarType::FEED_MINIBATCH ||
+        var->GetType() == framework::proto::VarType::FETCH_LIST) {
+      continue;
+    }
+    auto *variable = scope_->FindVar(var->Name());
+    if (!IsPersistable(var) || variable == nullptr ||
+        !variable->IsType<framework::LoDTensor>() ||
+        !variable->Get<framework::LoDTensor>().IsInitialized()) {
+      LOG(WARNING) << "The optimized program is not cached, the persistable "
+                      "variable "
+                   << var->Name() << " is not a loaded LoDTensor.";
+      return;
+    }
+    params.push_back(var->Name());
+  }
+
+  if (!inference::analysis::PathExists(cache_dir) &&
+      MKDIR(cache_dir.c_str()) == -1) {
+    LOG(WARNING) << "Can not create the optimization cache directory "
+                 << cache_dir;
+    return;
+  }
+  std::string program_path =
+      inference::analysis::GetOptimizedProgramCachePath(cache_dir, key);
+  std::string params_path =
+      inference::analysis::GetOptimizedParamsCachePath(cache_dir, key);
+  // The files are written aside and renamed, the predictors of the other
+  // processes never read a partial file.
+  std::string suffix = ".tmp" + std::to_string(std::random_device()());
+  bool saved = true;
+  try {
+    inference::SaveMappedParams(*scope_, params, params_path + suffix);
+    std::ofstream fout(program_path + suffix,
+                       std::ios::out | std::ios::binary);
+    fout << inference_program_->Proto()->SerializeAsString();
+    fout.close();
+    saved = fout.good();
+  } catch (platform::EnforceNotMet &error) {
+    LOG(WARNING) << error.what();
+    saved = false;
+  }
+  if (!saved ||
+      std::rename((params_path + suffix).c_str(), params_path.c_str()) != 0 ||
+      std::rename((program_path + suffix).c_str(), program_path.c_str()) !=
+          0) {
+    LOG(WARNING) << "Failed to save the optimized program cache "
+                 << program_path;
+    std::remove((params_path + suffix).c_str());
+    std::remove((program_path + suffix).c_str());
+    return;
+  }
+  LOG(INFO) << "Save the optimized program to " << program_path;
+}
+
+bool AnalysisPredictor::AttachSharedWeights(const std::string &key) {
+  auto &store = details::WeightStore::Instance();
+  auto weights = store.Find(key);
+  if (!weights) {
+    // the weights saved by a predictor of another process
+    if (config_.weight_sharing_dir().empty() ||
+        !LoadOptimizedProgramCache(config_.weight_sharing_dir(), key)) {
+      return false;
+    }
+    weights = store.Publish(key, inference_program_, scope_.get());
+  }
+  inference_program_ = weights->program();
+  executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+  weights->AttachTo(scope_.get(), place_);
+  weight_set_ = weights;
+  VLOG(3) << "Attach " << weights->memory_size() << " bytes of shared weights";
+  return true;
+}
+
+void AnalysisPredictor::PublishSharedWeights(const std::string &key) {
+  const std::string &shm_dir = config_.weight_sharing_dir();
+  if (!shm_dir.empty()) {
+    // The weights are saved to the shared directory and mapped back, so the
+    // predictors of all the processes map the same pages.
+    if (!inference::IsMappedParamsFile(
+            inference::analysis::GetOptimizedParamsCachePath(shm_dir, key))) {
+      SaveOptimizedProgramCache(shm_dir, key);
+    }
+    if (!LoadOptimizedProgramCache(shm_dir, key)) {
+      LOG(WARNING) << "The weights are only shared in the process, they can "
+                      "not be saved to "
+                   << shm_dir;
+    }
+  }
+  auto weights = details::WeightStore::Instance().Publish(
+      key, inference_program_, scope_.get());
+  if (weights->program() != inference_program_) {
+    // another predictor published the weights first
+    inference_program_ = weights->program();
+    executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+    weights->AttachTo(scope_.get(), place_);
+  }
+  weight_set_ = weights;
+}
+
 template <>
 std::unique_ptr<PaddlePredictor> CreatePaddlePredictor<
     AnalysisConfig, PaddleEngineKind::kAnalysis>(const AnalysisConfig &config) {
@@ -1311,6 +1598,7 @@ bool AnalysisPredictor::ZeroCopyRun() {
     MkldnnPreSet(shape_vector);
   }
 #endif
+  BindMemoryArena();
   executor_->Run();
 
   if (config_.shape_range_info_collected()) {
@@ -1507,6 +1795,16 @@ bool AnalysisPredictor::LoadParameters() {
     }
   }
 
+  if (!config_.params_file().empty() && !config_.model_from_memory() &&
+      inference::IsMappedParamsFile(config_.params_file())) {
+    // the tensors on CPU are backed by the mapping of the file
+    inference::LoadMappedParams(scope_.get(), params, config_.params_file(),
+                                place_);
+    VLOG(3) << "map " << params.size() << " vars of "
+            << config_.params_file();
+    return true;
+  }
+
   if (!config_.params_file().empty()) {
     // sort paramlist to have consistent ordering
     std::sort(params.begin(), params.end());
@@ -1638,6 +1936,8 @@ AnalysisPredictor::~AnalysisPredictor() {
 std::unique_ptr<PaddlePredictor> AnalysisPredictor::Clone() {
   std::lock_guard<std::mutex> lk(clone_mutex_);
   auto *x = new AnalysisPredictor(config_);
+  x->memory_offset_plan_ = memory_offset_plan_;
+  x->weight_set_ = weight_set_;
   x->Init(scope_, inference_program_);
   x->executor_->ResetTrtOps(++AnalysisPredictor::clone_num_);
   return std::unique_ptr<PaddlePredictor>(x);
@@ -27,6 +27,7 @@
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/api_impl.h"
 #include "paddle/fluid/inference/api/details/reset_tensor_array.h"
+#include "paddle/fluid/inference/api/details/weight_store.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/platform/device/gpu/gpu_types.h"
@@ -204,6 +205,45 @@ class AnalysisPredictor : public PaddlePredictor {
   /// to get the optimized model program
   ///
   void OptimizeInferenceProgram();
+  ///
+  /// \brief The key of the optimized program, the hash of the model, the
+  /// config, the passes and the library version
+  ///
+  /// \return The key, empty if the optimized program can not be reused
+  ///
+  std::string OptimizedProgramKey();
+  ///
+  /// \brief Load the optimized program and its parameters from the cache
+  ///
+  /// \param[in] cache_dir the directory of the cache
+  /// \param[in] key the key of the cache
+  /// \return Whether the cache is found and loaded
+  ///
+  bool LoadOptimizedProgramCache(const std::string &cache_dir,
+                                 const std::string &key);
+  ///
+  /// \brief Save the optimized program and its parameters to the cache
+  ///
+  /// \param[in] cache_dir the directory of the cache
+  /// \param[in] key the key of the cache
+  ///
+  void SaveOptimizedProgramCache(const std::string &cache_dir,
+                                 const std::string &key);
+  ///
+  /// \brief Take the optimized program and the weights shared by the other
+  /// predictors in the process or in the shared directory
+  ///
+  /// \param[in] key the key of the optimized program
+  /// \return Whether the shared weights are found
+  ///
+  bool AttachSharedWeights(const std::string &key);
+  ///
+  /// \brief Share the optimized program and the weights of the predictor
+  /// with the predictors created later
+  ///
+  /// \param[in] key the key of the optimized program
+  ///
+  void PublishSharedWeights(const std::string &key);
 
   ///
   /// \brief Clear the intermediate tensors of the predictor
@@ -296,6 +336,16 @@ class AnalysisPredictor : public PaddlePredictor {
   /// \return Whether the function executed successfully
   ///
   bool PrepareExecutor();
+  ///
+  /// \brief Allocate the memory arena of the memory offset plan, and find
+  /// the tensors placed in it.
+  ///
+  void PrepareMemoryArena();
+  ///
+  /// \brief Bind the tensors of the memory offset plan to their slots in the
+  /// arena, it is called before every run.
+  ///
+  void BindMemoryArena();
 
   ///
   /// \brief Load model program.
@@ -389,6 +439,7 @@ class AnalysisPredictor : public PaddlePredictor {
   FRIEND_TEST(AnalysisPredictor, analysis_off);
   FRIEND_TEST(AnalysisPredictor, analysis_on);
   FRIEND_TEST(AnalysisPredictor, with_gpu);
+  FRIEND_TEST(AnalysisPredictor, memory_offset_plan);
 #endif
 
  private:
@@ -488,6 +539,18 @@ class AnalysisPredictor : public PaddlePredictor {
   std::map<std::string, std::vector<std::vector<int32_t>>> shape_info_;
   static int clone_num_;
 
+  // The offsets of the temporary tensors in the memory arena, every clone
+  // has its own arena.
+  Argument::memory_offset_plan_t memory_offset_plan_;
+  std::shared_ptr<phi::Allocation> memory_arena_;
+  std::vector<
+      std::pair<framework::LoDTensor *, std::shared_ptr<phi::Allocation>>>
+      arena_slots_;
+
+  // The weights shared with the other predictors of the same model and
+  // config, the clones hold them too.
+  std::shared_ptr<const details::WeightSet> weight_set_;
+
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE) && \
     !defined(PADDLE_WITH_ASCEND_CL)
   // fleet executor related
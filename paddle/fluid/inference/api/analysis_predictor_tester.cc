@@ -16,14 +16,24 @@
 #if defined(PADDLE_WITH_CUDA)
 #include <cuda_runtime.h>
 #endif
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <thread>  // NOLINT
 #include "paddle/fluid/framework/ir/pass.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/inference/io.h"
 #include "paddle/fluid/inference/tests/api/tester_helper.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
 #include "paddle/fluid/platform/cpu_info.h"
@@ -122,6 +132,290 @@ TEST(AnalysisPredictor, analysis_on) {
   inference::CompareTensor(outputs.front(), naive_outputs.front());
 }
 
+#ifndef _WIN32
+// the sorted names of the files in the directory
+static std::vector<std::string> ListFiles(const std::string& dirname) {
+  std::vector<std::string> files;
+  DIR* dir = opendir(dirname.c_str());
+  if (dir == nullptr) {
+    return files;
+  }
+  while (auto* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      files.push_back(name);
+    }
+  }
+  closedir(dir);
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// a new empty directory in /tmp
+static std::string MakeTempDir(const std::string& prefix) {
+  std::string dirname = "/tmp/" + prefix + "_XXXXXX";
+  PADDLE_ENFORCE_NOT_NULL(
+      mkdtemp(&dirname[0]),
+      platform::errors::Unavailable("Failed to create the directory %s.",
+                                    dirname));
+  return dirname;
+}
+
+static void RemoveDir(const std::string& dirname) {
+  for (auto& name : ListFiles(dirname)) {
+    std::remove((dirname + "/" + name).c_str());
+  }
+  rmdir(dirname.c_str());
+}
+
+TEST(AnalysisPredictor, mapped_params) {
+  // the persistables of the model saved to a mapped params file
+  std::string mapped_dir = MakeTempDir("mapped_params");
+  std::string mapped_file = mapped_dir + "/mapped_params";
+  {
+    platform::CPUPlace place;
+    framework::Executor executor(place);
+    framework::Scope scope;
+    auto program = inference::Load(&executor, &scope, FLAGS_dirname);
+    std::vector<std::string> vars;
+    for (auto* var : program->Block(0).AllVars()) {
+      if (var->Persistable() && var->Name() != "feed" &&
+          var->Name() != "fetch") {
+        vars.push_back(var->Name());
+      }
+    }
+    inference::SaveMappedParams(scope, vars, mapped_file);
+  }
+  ASSERT_TRUE(inference::IsMappedParamsFile(mapped_file));
+  ASSERT_FALSE(inference::IsMappedParamsFile(FLAGS_dirname + "/__model__"));
+
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  AnalysisConfig mapped_config;
+  mapped_config.SetModel(FLAGS_dirname + "/__model__", mapped_file);
+  mapped_config.DisableGpu();
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> outputs, mapped_outputs;
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  auto mapped_predictor = CreatePaddlePredictor<AnalysisConfig>(mapped_config);
+  ASSERT_TRUE(mapped_predictor->Run(inputs, &mapped_outputs));
+  ASSERT_EQ(mapped_outputs.size(), 1UL);
+  inference::CompareTensor(outputs.front(), mapped_outputs.front());
+  // the clone maps the same file
+  auto clone = mapped_predictor->Clone();
+  mapped_outputs.clear();
+  ASSERT_TRUE(clone->Run(inputs, &mapped_outputs));
+  inference::CompareTensor(outputs.front(), mapped_outputs.front());
+  RemoveDir(mapped_dir);
+}
+
+TEST(AnalysisPredictor, optimized_program_cache) {
+  std::string cache_dir = FLAGS_dirname + "/optimized_program_cache";
+  for (auto& name : ListFiles(cache_dir)) {
+    std::remove((cache_dir + "/" + name).c_str());
+  }
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.EnableMemoryOptim();
+  config.SetOptimCacheDir(cache_dir);
+  config.EnableOptimizedProgramCache();
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  // the first predictor optimizes the program and saves it
+  std::vector<PaddleTensor> outputs;
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  auto files = ListFiles(cache_dir);
+  ASSERT_EQ(files.size(), 2UL);
+  ASSERT_EQ(files[0].find("optimized_params_"), 0UL);
+  ASSERT_EQ(files[1].find("optimized_program_"), 0UL);
+  ASSERT_TRUE(inference::IsMappedParamsFile(cache_dir + "/" + files[0]));
+
+  // the second one loads it
+  std::vector<PaddleTensor> cached_outputs;
+  AnalysisConfig cached_config(config);
+  auto cached_predictor = CreatePaddlePredictor<AnalysisConfig>(cached_config);
+  ASSERT_TRUE(cached_predictor->Run(inputs, &cached_outputs));
+  ASSERT_EQ(ListFiles(cache_dir), files);
+  ASSERT_EQ(cached_predictor->GetSerializedProgram(),
+            predictor->GetSerializedProgram());
+  ASSERT_EQ(cached_outputs.size(), 1UL);
+  inference::CompareTensor(outputs.front(), cached_outputs.front());
+
+  // the other configs are cached apart
+  AnalysisConfig other_config(config);
+  other_config.EnableMemoryOptim(false);
+  auto other_predictor = CreatePaddlePredictor<AnalysisConfig>(other_config);
+  ASSERT_EQ(ListFiles(cache_dir).size(), 4UL);
+}
+
+// the names of the persistable tensors of the predictor
+static std::vector<std::string> WeightNames(AnalysisPredictor* predictor) {
+  std::vector<std::string> names;
+  for (auto* var : predictor->program().Block(0).AllVars()) {
+    if (var->Persistable() &&
+        var->GetType() == framework::proto::VarType::LOD_TENSOR) {
+      names.push_back(var->Name());
+    }
+  }
+  return names;
+}
+
+static const void* WeightData(AnalysisPredictor* predictor,
+                              const std::string& name) {
+  return predictor->scope()->FindVar(name)->Get<framework::LoDTensor>().data();
+}
+
+TEST(AnalysisPredictor, weight_sharing) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  AnalysisConfig shared_config(config);
+  shared_config.EnableWeightSharing();
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> outputs;
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+
+  // the predictors created later take the weights of the first one
+  auto first = CreatePaddlePredictor<AnalysisConfig>(shared_config);
+  auto second = CreatePaddlePredictor<AnalysisConfig>(shared_config);
+  auto* first_predictor = static_cast<AnalysisPredictor*>(first.get());
+  auto* second_predictor = static_cast<AnalysisPredictor*>(second.get());
+  ASSERT_EQ(first_predictor->GetSerializedProgram(),
+            second_predictor->GetSerializedProgram());
+  auto names = WeightNames(second_predictor);
+  ASSERT_FALSE(names.empty());
+  for (auto& name : names) {
+    ASSERT_EQ(WeightData(first_predictor, name),
+              WeightData(second_predictor, name));
+  }
+  for (auto* shared : {first.get(), second.get()}) {
+    std::vector<PaddleTensor> shared_outputs;
+    ASSERT_TRUE(shared->Run(inputs, &shared_outputs));
+    ASSERT_EQ(shared_outputs.size(), 1UL);
+    inference::CompareTensor(outputs.front(), shared_outputs.front());
+  }
+
+  // a written weight is copied first, the other predictor keeps its data
+  auto* scope = first_predictor->scope();
+  auto float_weight =
+      std::find_if(names.begin(), names.end(), [&](auto& var_name) {
+        return scope->FindVar(var_name)->Get<framework::LoDTensor>().dtype() ==
+               phi::DataType::FLOAT32;
+      });
+  ASSERT_NE(float_weight, names.end());
+  auto name = *float_weight;
+  auto& first_weight = scope->FindVar(name)->Get<framework::LoDTensor>();
+  auto* first_data = first_weight.data<float>();
+  std::vector<float> expected(first_data, first_data + first_weight.numel());
+  auto weight = second->GetInputTensor(name);
+  auto* written = weight->mutable_data<float>(PaddlePlace::kCPU);
+  ASSERT_NE(written, first_data);
+  std::fill(written, written + first_weight.numel(), 0.0f);
+  ASSERT_TRUE(std::equal(expected.begin(), expected.end(), first_data));
+}
+
+// whether the file is mapped in the process
+static bool IsFileMapped(const std::string& filename) {
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  while (std::getline(maps, line)) {
+    if (line.find(filename) != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+TEST(AnalysisPredictor, weight_sharing_across_processes) {
+  std::string shm_dir = MakeTempDir("weight_sharing");
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.EnableWeightSharing(shm_dir);
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> outputs;
+  std::string program;
+  {
+    auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    program = predictor->GetSerializedProgram();
+  }
+  auto files = ListFiles(shm_dir);
+  ASSERT_EQ(files.size(), 2UL);
+  const std::string params_file = shm_dir + "/" + files[0];
+  ASSERT_TRUE(inference::IsMappedParamsFile(params_file));
+  ASSERT_EQ(outputs.size(), 1UL);
+
+  // The predictor of the parent is destroyed before the fork, so the child
+  // has no weights in its store and maps the ones of the shm dir. The exit
+  // code of the child tells the failed check.
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    std::vector<PaddleTensor> shared_outputs;
+    if (!predictor->Run(inputs, &shared_outputs) ||
+        shared_outputs.size() != 1UL) {
+      _exit(1);
+    }
+    if (predictor->GetSerializedProgram() != program ||
+        ListFiles(shm_dir) != files) {
+      _exit(2);
+    }
+    if (!IsFileMapped(params_file)) {
+      _exit(3);
+    }
+    const auto& expected = outputs.front().data;
+    const auto& actual = shared_outputs.front().data;
+    if (actual.length() != expected.length()) {
+      _exit(4);
+    }
+    const float* expected_data = static_cast<const float*>(expected.data());
+    const float* actual_data = static_cast<const float*>(actual.data());
+    for (size_t i = 0; i < expected.length() / sizeof(float); ++i) {
+      if (std::abs(actual_data[i] - expected_data[i]) > 1e-5) {
+        _exit(4);
+      }
+    }
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+  RemoveDir(shm_dir);
+}
+#endif
+
 TEST(AnalysisPredictor, ZeroCopy) {
   AnalysisConfig config;
   config.SetModel(FLAGS_dirname);
@@ -210,6 +504,88 @@ TEST(AnalysisPredictor, CollectShapeRangeInfo) {
   // ASSERT_EQ(min_shape.size(), 14u);
 }
 
+// Runs the word2vec model of the batch, returns the output.
+static std::vector<float> RunWord2vec(PaddlePredictor* predictor, int batch) {
+  for (auto name : {"firstw", "secondw", "thirdw", "forthw"}) {
+    auto input = predictor->GetInputTensor(name);
+    input->Reshape({batch, 1});
+    auto* data = input->mutable_data<int64_t>(PaddlePlace::kCPU);
+    for (int i = 0; i < batch; i++) {
+      data[i] = (i * 7 + name[0]) % 1000;
+    }
+  }
+  EXPECT_TRUE(predictor->ZeroCopyRun());
+  auto out = predictor->GetOutputTensor("fc_1.tmp_2");
+  PaddlePlace place;
+  int size = 0;
+  auto* data = out->data<float>(&place, &size);
+  return std::vector<float>(data, data + size);
+}
+
+TEST(AnalysisPredictor, memory_offset_plan) {
+  std::string shape_range_path = FLAGS_dirname + "/offset_plan_shape.pbtxt";
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+  config.DisableGpu();
+
+  std::vector<std::vector<float>> expected;
+  {
+    AnalysisConfig collect_config(config);
+    collect_config.CollectShapeRangeInfo(shape_range_path);
+    auto predictor = CreatePaddlePredictor<AnalysisConfig>(collect_config);
+    for (int batch : {1, 8}) {
+      expected.push_back(RunWord2vec(predictor.get(), batch));
+    }
+  }
+
+  config.EnableMemoryOffsetPlan(shape_range_path);
+  ASSERT_TRUE(config.memory_offset_plan_enabled());
+  ASSERT_TRUE(config.enable_memory_optim());
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+
+  // the plan packs the tensors whose lifetimes do not overlap in the same
+  // bytes, so the arena is smaller than the sum of the tensors
+  auto* analysis_predictor = static_cast<AnalysisPredictor*>(predictor.get());
+  const auto& plan = analysis_predictor->memory_offset_plan_;
+  ASSERT_FALSE(plan.empty());
+  size_t arena_size = 0, total_size = 0;
+  for (auto& item : plan) {
+    arena_size = std::max(arena_size, item.second.first + item.second.second);
+    total_size += item.second.second;
+  }
+  ASSERT_LT(arena_size, total_size);
+  ASSERT_TRUE(analysis_predictor->memory_arena_);
+  ASSERT_GE(analysis_predictor->memory_arena_->size(), arena_size);
+
+  // the intermediate tensors of a batch within the bounds live in the arena
+  ASSERT_EQ(RunWord2vec(predictor.get(), 8), expected[1]);
+  auto* arena_begin =
+      static_cast<uint8_t*>(analysis_predictor->memory_arena_->ptr());
+  auto* arena_end = arena_begin + arena_size;
+  int num_in_arena = 0;
+  for (auto& item : plan) {
+    auto* var = analysis_predictor->sub_scope_->FindLocalVar(item.first);
+    if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+    auto& tensor = var->Get<framework::LoDTensor>();
+    if (!tensor.initialized()) continue;
+    auto* data = static_cast<const uint8_t*>(tensor.data());
+    if (data >= arena_begin && data < arena_end) {
+      ++num_in_arena;
+    }
+  }
+  ASSERT_GT(num_in_arena, 0);
+
+  auto clone = predictor->Clone();
+  // the batches out of the bounds are allocated out of the arena
+  for (int round = 0; round < 3; ++round) {
+    ASSERT_EQ(RunWord2vec(predictor.get(), 8), expected[1]);
+    ASSERT_EQ(RunWord2vec(clone.get(), 1), expected[0]);
+    RunWord2vec(predictor.get(), 16);
+    ASSERT_EQ(RunWord2vec(predictor.get(), 1), expected[0]);
+  }
+}
+
 TEST(AnalysisPredictor, Clone) {
   AnalysisConfig config;
   config.SetModel(FLAGS_dirname);
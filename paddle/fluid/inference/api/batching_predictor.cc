@@ -0,0 +1,420 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle_infer {
+namespace services {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Calls fn with a null pointer of the C++ type of dtype.
+template <typename Fn>
+void VisitDataType(DataType dtype, Fn&& fn) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      fn(static_cast<float*>(nullptr));
+      break;
+    case DataType::INT64:
+      fn(static_cast<int64_t*>(nullptr));
+      break;
+    case DataType::INT32:
+      fn(static_cast<int32_t*>(nullptr));
+      break;
+    case DataType::UINT8:
+      fn(static_cast<uint8_t*>(nullptr));
+      break;
+    case DataType::INT8:
+      fn(static_cast<int8_t*>(nullptr));
+      break;
+    case DataType::FLOAT16:
+      fn(static_cast<paddle::platform::float16*>(nullptr));
+      break;
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "BatchingPredictor does not support the data type %d.",
+          static_cast<int>(dtype)));
+  }
+}
+
+size_t SizeOfDataType(DataType dtype) {
+  size_t size = 0;
+  VisitDataType(dtype, [&size](auto* type) { size = sizeof(*type); });
+  return size;
+}
+
+// the elements of the dims from begin
+int64_t Numel(const std::vector<int>& shape, size_t begin = 0) {
+  int64_t numel = 1;
+  for (size_t i = begin; i < shape.size(); ++i) {
+    numel *= shape[i];
+  }
+  return numel;
+}
+
+struct Request {
+  // in the order of the input names
+  std::vector<paddle::PaddleTensor> inputs;
+  // the shapes of the inputs after padding
+  std::vector<std::vector<int>> shapes;
+  int rows{0};
+  // the dim 1 of the first padded input before and after padding, or -1
+  int length{-1};
+  int padded_length{-1};
+  // the requests of the same key are batched together
+  std::string key;
+  Clock::time_point arrival;
+  std::promise<std::vector<paddle::PaddleTensor>> promise;
+};
+
+using Batch = std::vector<std::unique_ptr<Request>>;
+
+}  // namespace
+
+class BatchingPredictor::Impl {
+ public:
+  Impl(const Config& config, const BatchingOptions& options);
+  ~Impl();
+
+  std::future<std::vector<paddle::PaddleTensor>> Submit(
+      std::vector<paddle::PaddleTensor> inputs);
+
+ private:
+  void Work(Predictor* predictor);
+  // Waits for the next batch, which is empty if the threads are stopped.
+  Batch NextBatch();
+  void RunBatch(Predictor* predictor, const Batch& batch);
+  // Runs the requests as one batch and sets their outputs, throws if the
+  // batch fails.
+  void RunRequests(Predictor* predictor,
+                   const std::vector<Request*>& batch);
+
+  BatchingOptions options_;
+  PredictorPool pool_;
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Request>> queue_;
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+};
+
+BatchingPredictor::Impl::Impl(const Config& config,
+                              const BatchingOptions& options)
+    : options_(options), pool_(config, options.num_predictors) {
+  PADDLE_ENFORCE_GE(options.max_batch_size, 1,
+                    paddle::platform::errors::InvalidArgument(
+                        "The max_batch_size of BatchingPredictor should be "
+                        "greater than 0, but it's (%d).",
+                        options.max_batch_size));
+  for (auto& buckets : options_.pad_buckets) {
+    std::sort(buckets.second.begin(), buckets.second.end());
+  }
+  input_names_ = pool_.Retrive(0)->GetInputNames();
+  output_names_ = pool_.Retrive(0)->GetOutputNames();
+  for (size_t i = 0; i < options.num_predictors; ++i) {
+    threads_.emplace_back(&Impl::Work, this, pool_.Retrive(i));
+  }
+}
+
+BatchingPredictor::Impl::~Impl() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+std::future<std::vector<paddle::PaddleTensor>> BatchingPredictor::Impl::Submit(
+    std::vector<paddle::PaddleTensor> inputs) {
+  PADDLE_ENFORCE_EQ(inputs.size(), input_names_.size(),
+                    paddle::platform::errors::InvalidArgument(
+                        "The model has (%d) inputs, but the request has (%d).",
+                        input_names_.size(), inputs.size()));
+  std::unique_ptr<Request> request(new Request);
+  request->inputs.resize(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    size_t idx = i;
+    if (!inputs[i].name.empty()) {
+      auto iter = std::find(input_names_.begin(), input_names_.end(),
+                            inputs[i].name);
+      PADDLE_ENFORCE_EQ(iter != input_names_.end(), true,
+                        paddle::platform::errors::NotFound(
+                            "The model has no input named %s.",
+                            inputs[i].name));
+      idx = iter - input_names_.begin();
+    }
+    request->inputs[idx] = std::move(inputs[i]);
+  }
+
+  std::string& key = request->key;
+  for (size_t i = 0; i < request->inputs.size(); ++i) {
+    auto& input = request->inputs[i];
+    PADDLE_ENFORCE_EQ(
+        input.shape.empty() || input.shape[0] < 1, false,
+        paddle::platform::errors::InvalidArgument(
+            "The input %s of a request should have rows in the dim 0.",
+            input_names_[i]));
+    PADDLE_ENFORCE_EQ(
+        input.lod.empty(), true,
+        paddle::platform::errors::Unimplemented(
+            "BatchingPredictor does not batch the LoD input %s.",
+            input_names_[i]));
+    PADDLE_ENFORCE_EQ(
+        input.data.length(),
+        Numel(input.shape) * SizeOfDataType(input.dtype),
+        paddle::platform::errors::InvalidArgument(
+            "The data of the input %s does not match its shape.",
+            input_names_[i]));
+    PADDLE_ENFORCE_EQ(
+        i == 0 || input.shape[0] == request->rows, true,
+        paddle::platform::errors::InvalidArgument(
+            "The inputs of a request should have the same rows."));
+    request->rows = input.shape[0];
+
+    std::vector<int> shape = input.shape;
+    auto buckets = options_.pad_buckets.find(input_names_[i]);
+    if (buckets != options_.pad_buckets.end() && shape.size() >= 2) {
+      auto bucket = std::lower_bound(buckets->second.begin(),
+                                     buckets->second.end(), shape[1]);
+      if (bucket != buckets->second.end()) {
+        if (request->length < 0) {
+          request->length = shape[1];
+          request->padded_length = *bucket;
+        }
+        shape[1] = *bucket;
+      }
+    }
+    key += std::to_string(static_cast<int>(input.dtype));
+    for (size_t d = 1; d < shape.size(); ++d) {
+      key += "," + std::to_string(shape[d]);
+    }
+    key += ";";
+    request->shapes.push_back(std::move(shape));
+  }
+
+  auto future = request->promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    request->arrival = Clock::now();
+    queue_.push_back(std::move(request));
+  }
+  // the threads collecting a batch of another key should not take it
+  cv_.notify_all();
+  return future;
+}
+
+void BatchingPredictor::Impl::Work(Predictor* predictor) {
+  while (true) {
+    Batch batch = NextBatch();
+    if (batch.empty()) {
+      return;
+    }
+    RunBatch(predictor, batch);
+  }
+}
+
+Batch BatchingPredictor::Impl::NextBatch() {
+  Batch batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+  if (queue_.empty()) {
+    return batch;
+  }
+  batch.push_back(std::move(queue_.front()));
+  queue_.pop_front();
+  const std::string key = batch[0]->key;
+  int rows = batch[0]->rows;
+  const auto deadline =
+      batch[0]->arrival + std::chrono::microseconds(options_.max_delay_us);
+  while (true) {
+    // the requests of the key join in the order they arrive
+    for (auto iter = queue_.begin();
+         iter != queue_.end() && rows < options_.max_batch_size;) {
+      if ((*iter)->key == key &&
+          rows + (*iter)->rows <= options_.max_batch_size) {
+        rows += (*iter)->rows;
+        batch.push_back(std::move(*iter));
+        iter = queue_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    if (rows >= options_.max_batch_size || stop_ ||
+        Clock::now() >= deadline) {
+      return batch;
+    }
+    cv_.wait_until(lock, deadline);
+  }
+}
+
+void BatchingPredictor::Impl::RunBatch(Predictor* predictor,
+                                       const Batch& batch) {
+  std::vector<Request*> requests;
+  for (auto& request : batch) {
+    requests.push_back(request.get());
+  }
+  try {
+    RunRequests(predictor, requests);
+    return;
+  } catch (...) {
+    if (batch.size() == 1) {
+      batch[0]->promise.set_exception(std::current_exception());
+      return;
+    }
+  }
+  // Submit only checks the shapes, a request of bad data such as an id out
+  // of range fails the whole batch. The requests run again one by one so
+  // that only the bad ones fail.
+  VLOG(3) << "A batch of " << batch.size()
+          << " requests failed, run them one by one";
+  for (auto* request : requests) {
+    try {
+      RunRequests(predictor, {request});
+    } catch (...) {
+      request->promise.set_exception(std::current_exception());
+    }
+  }
+}
+
+void BatchingPredictor::Impl::RunRequests(
+    Predictor* predictor, const std::vector<Request*>& batch) {
+  int rows = 0;
+  for (auto* request : batch) {
+    rows += request->rows;
+  }
+  std::vector<char> buffer;
+  for (size_t i = 0; i < input_names_.size(); ++i) {
+    std::vector<int> shape = batch[0]->shapes[i];
+    shape[0] = rows;
+    const size_t type_size = SizeOfDataType(batch[0]->inputs[i].dtype);
+    // the padded requests are copied in blocks of the dims after the dim 1
+    const size_t block = Numel(shape, 2) * type_size;
+    const size_t row_bytes = Numel(shape, 1) * type_size;
+    buffer.assign(rows * row_bytes, 0);
+    char* dst = buffer.data();
+    for (auto& request : batch) {
+      const auto& input = request->inputs[i];
+      const char* src = static_cast<const char*>(input.data.data());
+      if (input.shape == request->shapes[i]) {
+        std::memcpy(dst, src, input.data.length());
+      } else {
+        const size_t src_row_bytes = input.shape[1] * block;
+        for (int r = 0; r < request->rows; ++r) {
+          std::memcpy(dst + r * row_bytes, src + r * src_row_bytes,
+                      src_row_bytes);
+        }
+      }
+      dst += request->rows * row_bytes;
+    }
+    auto tensor = predictor->GetInputHandle(input_names_[i]);
+    tensor->Reshape(shape);
+    VisitDataType(batch[0]->inputs[i].dtype, [&](auto* type) {
+      using T = std::remove_pointer_t<decltype(type)>;
+      tensor->CopyFromCpu(reinterpret_cast<const T*>(buffer.data()));
+    });
+  }
+
+  PADDLE_ENFORCE_EQ(predictor->Run(), true,
+                    paddle::platform::errors::Fatal(
+                        "Failed to run a batch of %d rows.", rows));
+  VLOG(3) << "Run a batch of " << batch.size() << " requests, " << rows
+          << " rows";
+
+  std::vector<std::vector<paddle::PaddleTensor>> outputs(batch.size());
+  for (auto& name : output_names_) {
+    auto tensor = predictor->GetOutputHandle(name);
+    std::vector<int> shape = tensor->shape();
+    DataType dtype = tensor->type();
+    PADDLE_ENFORCE_EQ(
+        !shape.empty() && shape[0] == rows, true,
+        paddle::platform::errors::InvalidArgument(
+            "The dim 0 of the output %s should be the %d rows of the batch.",
+            name, rows));
+    const size_t type_size = SizeOfDataType(dtype);
+    buffer.resize(Numel(shape) * type_size);
+    VisitDataType(dtype, [&](auto* type) {
+      using T = std::remove_pointer_t<decltype(type)>;
+      tensor->CopyToCpu(reinterpret_cast<T*>(buffer.data()));
+    });
+    const size_t row_bytes = Numel(shape, 1) * type_size;
+    const char* src = buffer.data();
+    for (size_t b = 0; b < batch.size(); ++b) {
+      auto& request = batch[b];
+      paddle::PaddleTensor out;
+      out.name = name;
+      out.dtype = dtype;
+      out.shape = shape;
+      out.shape[0] = request->rows;
+      bool cut = shape.size() >= 2 && request->length >= 0 &&
+                 shape[1] == request->padded_length;
+      if (cut) {
+        out.shape[1] = request->length;
+      }
+      out.data.Resize(Numel(out.shape) * type_size);
+      char* dst = static_cast<char*>(out.data.data());
+      if (cut) {
+        const size_t dst_row_bytes = Numel(out.shape, 1) * type_size;
+        for (int r = 0; r < request->rows; ++r) {
+          std::memcpy(dst + r * dst_row_bytes, src + r * row_bytes,
+                      dst_row_bytes);
+        }
+      } else {
+        std::memcpy(dst, src, request->rows * row_bytes);
+      }
+      src += request->rows * row_bytes;
+      outputs[b].push_back(std::move(out));
+    }
+  }
+  for (size_t b = 0; b < batch.size(); ++b) {
+    batch[b]->promise.set_value(std::move(outputs[b]));
+  }
+}
+
+BatchingPredictor::BatchingPredictor(const Config& config,
+                                     const BatchingOptions& options)
+    : impl_(new Impl(config, options)) {}
+
+BatchingPredictor::~BatchingPredictor() = default;
+
+std::future<std::vector<paddle::PaddleTensor>> BatchingPredictor::Submit(
+    std::vector<paddle::PaddleTensor> inputs) {
+  return impl_->Submit(std::move(inputs));
+}
+
+}  // namespace services
+}  // namespace paddle_infer
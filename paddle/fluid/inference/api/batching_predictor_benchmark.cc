@@ -0,0 +1,137 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput and p99 latency of BatchingPredictor on the word2vec model, at
+// several request rates, with and without batching.
+// To use this tool, run command:
+//     ./batching_predictor_benchmark --dirname=<word2vec model dir>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <future>              // NOLINT
+#include <mutex>               // NOLINT
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "Directory of the word2vec model.");
+DEFINE_int32(num_requests, 2000, "Requests submitted at each rate.");
+
+namespace paddle_infer {
+namespace services {
+
+using Clock = std::chrono::steady_clock;
+
+// the four words of the word2vec model, rows requests of random ids
+static std::vector<paddle::PaddleTensor> MakeRequest(int rows,
+                                                     std::mt19937* rng) {
+  std::vector<paddle::PaddleTensor> inputs(4);
+  for (auto& input : inputs) {
+    input.shape = {rows, 1};
+    input.dtype = DataType::INT64;
+    input.data.Resize(rows * sizeof(int64_t));
+    auto* data = static_cast<int64_t*>(input.data.data());
+    for (int i = 0; i < rows; ++i) {
+      data[i] = (*rng)() % 1000;
+    }
+  }
+  return inputs;
+}
+
+// Submits the requests of one row at a fixed rate, returns the throughput
+// and the p99 latency in ms.
+static void RunAtRate(BatchingPredictor* batching, double rate, int num,
+                      double* throughput, double* p99) {
+  std::mt19937 rng(2022);
+  std::vector<std::vector<paddle::PaddleTensor>> requests;
+  for (int i = 0; i < num; ++i) {
+    requests.push_back(MakeRequest(1, &rng));
+  }
+  std::vector<Clock::time_point> submitted(num), done(num);
+  std::vector<std::future<std::vector<paddle::PaddleTensor>>> futures(num);
+  std::vector<bool> ready(num, false);
+  std::mutex mutex;
+  std::condition_variable cv;
+  // the results are collected while the requests are submitted
+  std::thread collector([&] {
+    for (int i = 0; i < num; ++i) {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return ready[i]; });
+      lock.unlock();
+      futures[i].get();
+      done[i] = Clock::now();
+    }
+  });
+  auto start = Clock::now();
+  auto interval = std::chrono::duration<double>(1.0 / rate);
+  for (int i = 0; i < num; ++i) {
+    std::this_thread::sleep_until(
+        start + std::chrono::duration_cast<Clock::duration>(interval * i));
+    submitted[i] = Clock::now();
+    auto future = batching->Submit(std::move(requests[i]));
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      futures[i] = std::move(future);
+      ready[i] = true;
+    }
+    cv.notify_one();
+  }
+  collector.join();
+  std::vector<double> latency(num);
+  for (int i = 0; i < num; ++i) {
+    latency[i] =
+        std::chrono::duration<double, std::milli>(done[i] - submitted[i])
+            .count();
+  }
+  std::sort(latency.begin(), latency.end());
+  *p99 = latency[num * 99 / 100];
+  *throughput =
+      num / std::chrono::duration<double>(
+                *std::max_element(done.begin(), done.end()) - start)
+                .count();
+}
+
+static void BenchmarkRequestRates() {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  config.SetCpuMathLibraryNumThreads(1);
+  for (double rate : {500.0, 2000.0, 8000.0, 32000.0}) {
+    for (int max_batch_size : {1, 32}) {
+      BatchingOptions options;
+      options.max_batch_size = max_batch_size;
+      options.max_delay_us = 1000;
+      BatchingPredictor batching(config, options);
+      double throughput = 0, p99 = 0;
+      RunAtRate(&batching, rate, FLAGS_num_requests, &throughput, &p99);
+      LOG(INFO) << "rate " << rate << " req/s, max batch " << max_batch_size
+                << ": throughput " << throughput << " req/s, p99 latency "
+                << p99 << " ms";
+    }
+  }
+}
+
+}  // namespace services
+}  // namespace paddle_infer
+
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_logtostderr = true;
+  paddle_infer::services::BenchmarkRequestRates();
+  return 0;
+}
@@ -0,0 +1,269 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <future>  // NOLINT
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "dirname to tests.");
+
+namespace paddle_infer {
+namespace services {
+
+// the four words of the word2vec model, rows requests of random ids
+static std::vector<paddle::PaddleTensor> MakeRequest(int rows,
+                                                     std::mt19937* rng) {
+  std::vector<paddle::PaddleTensor> inputs(4);
+  for (auto& input : inputs) {
+    input.shape = {rows, 1};
+    input.dtype = DataType::INT64;
+    input.data.Resize(rows * sizeof(int64_t));
+    auto* data = static_cast<int64_t*>(input.data.data());
+    for (int i = 0; i < rows; ++i) {
+      data[i] = (*rng)() % 1000;
+    }
+  }
+  return inputs;
+}
+
+static std::vector<float> RunAlone(
+    Predictor* predictor, const std::vector<paddle::PaddleTensor>& inputs) {
+  auto names = predictor->GetInputNames();
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto tensor = predictor->GetInputHandle(names[i]);
+    tensor->Reshape(inputs[i].shape);
+    tensor->CopyFromCpu(static_cast<const int64_t*>(inputs[i].data.data()));
+  }
+  EXPECT_TRUE(predictor->Run());
+  auto out = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  auto shape = out->shape();
+  std::vector<float> data(std::accumulate(shape.begin(), shape.end(), 1,
+                                          std::multiplies<int>()));
+  out->CopyToCpu(data.data());
+  return data;
+}
+
+TEST(BatchingPredictor, same_as_running_alone) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  Predictor predictor(config);
+
+  std::mt19937 rng(2022);
+  std::vector<std::vector<paddle::PaddleTensor>> requests;
+  std::vector<std::vector<float>> expected;
+  for (int i = 0; i < 64; ++i) {
+    requests.push_back(MakeRequest(1 + i % 3, &rng));
+    expected.push_back(RunAlone(&predictor, requests.back()));
+  }
+
+  BatchingOptions options;
+  options.num_predictors = 2;
+  options.max_batch_size = 8;
+  options.max_delay_us = 2000;
+  BatchingPredictor batching(config, options);
+  // the requests are submitted by a few threads at the same time
+  std::vector<std::future<std::vector<paddle::PaddleTensor>>> futures(
+      requests.size());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t i = t; i < requests.size(); i += 4) {
+        auto inputs = requests[i];
+        futures[i] = batching.Submit(std::move(inputs));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto outputs = futures[i].get();
+    ASSERT_EQ(outputs.size(), 1UL);
+    ASSERT_EQ(outputs[0].shape[0], requests[i][0].shape[0]);
+    ASSERT_EQ(outputs[0].data.length(), expected[i].size() * sizeof(float));
+    const float* data = static_cast<const float*>(outputs[0].data.data());
+    for (size_t j = 0; j < expected[i].size(); ++j) {
+      EXPECT_NEAR(data[j], expected[i][j], 1e-5) << "request " << i;
+    }
+  }
+
+  // a bad request fails alone
+  auto bad = MakeRequest(1, &rng);
+  bad[0].shape = {2, 1};
+  EXPECT_ANY_THROW(batching.Submit(std::move(bad)));
+}
+
+TEST(BatchingPredictor, bad_request_fails_alone) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  Predictor predictor(config);
+
+  std::mt19937 rng(2022);
+  std::vector<std::vector<paddle::PaddleTensor>> requests;
+  std::vector<std::vector<float>> expected;
+  for (int i = 0; i < 4; ++i) {
+    requests.push_back(MakeRequest(2, &rng));
+    expected.push_back(RunAlone(&predictor, requests.back()));
+  }
+  // the shape is right, but the word id is out of the dictionary
+  auto bad = MakeRequest(2, &rng);
+  static_cast<int64_t*>(bad[1].data.data())[1] = -1;
+  requests.insert(requests.begin() + 2, std::move(bad));
+
+  BatchingOptions options;
+  options.max_batch_size = 16;
+  // long enough for the requests to be in one batch
+  options.max_delay_us = 200000;
+  BatchingPredictor batching(config, options);
+  std::vector<std::future<std::vector<paddle::PaddleTensor>>> futures;
+  for (auto& request : requests) {
+    futures.push_back(batching.Submit(request));
+  }
+  EXPECT_ANY_THROW(futures[2].get());
+  futures.erase(futures.begin() + 2);
+  for (size_t i = 0; i < futures.size(); ++i) {
+    auto outputs = futures[i].get();
+    ASSERT_EQ(outputs.size(), 1UL);
+    ASSERT_EQ(outputs[0].data.length(), expected[i].size() * sizeof(float));
+    const float* data = static_cast<const float*>(outputs[0].data.data());
+    for (size_t j = 0; j < expected[i].size(); ++j) {
+      EXPECT_NEAR(data[j], expected[i][j], 1e-5) << "request " << i;
+    }
+  }
+}
+
+// Saves a model of one scale op to a new directory in /tmp. Its output has
+// the [rows, length] shape of its input x, and every output element only
+// depends on the input element at the same position, so the padded
+// positions do not change the others.
+static std::string SaveScaleModel() {
+  namespace fw = paddle::framework;
+  fw::ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  auto* feed = block->Var("feed");
+  feed->SetType(fw::proto::VarType::FEED_MINIBATCH);
+  feed->SetPersistable(true);
+  auto* fetch = block->Var("fetch");
+  fetch->SetType(fw::proto::VarType::FETCH_LIST);
+  fetch->SetPersistable(true);
+  for (auto name : {"x", "out"}) {
+    auto* var = block->Var(name);
+    var->SetType(fw::proto::VarType::LOD_TENSOR);
+    var->SetDataType(fw::proto::VarType::FP32);
+    var->SetShape({-1, -1});
+  }
+  auto* feed_op = block->AppendOp();
+  feed_op->SetType("feed");
+  feed_op->SetInput("X", {"feed"});
+  feed_op->SetOutput("Out", {"x"});
+  feed_op->SetAttr("col", 0);
+  auto* scale_op = block->AppendOp();
+  scale_op->SetType("scale");
+  scale_op->SetInput("X", {"x"});
+  scale_op->SetOutput("Out", {"out"});
+  scale_op->SetAttr("scale", 2.f);
+  scale_op->SetAttr("bias", 1.f);
+  scale_op->SetAttr("bias_after_scale", true);
+  auto* fetch_op = block->AppendOp();
+  fetch_op->SetType("fetch");
+  fetch_op->SetInput("X", {"out"});
+  fetch_op->SetOutput("Out", {"fetch"});
+  fetch_op->SetAttr("col", 0);
+
+  std::string dirname = "/tmp/batching_predictor_XXXXXX";
+  EXPECT_NE(mkdtemp(&dirname[0]), nullptr);
+  std::ofstream fout(dirname + "/__model__", std::ios::binary);
+  fout << program.Proto()->SerializeAsString();
+  return dirname;
+}
+
+static paddle::PaddleTensor MakeSequence(int rows, int length,
+                                         std::mt19937* rng) {
+  paddle::PaddleTensor input;
+  input.name = "x";
+  input.shape = {rows, length};
+  input.dtype = DataType::FLOAT32;
+  input.data.Resize(rows * length * sizeof(float));
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  auto* data = static_cast<float*>(input.data.data());
+  for (int i = 0; i < rows * length; ++i) {
+    data[i] = dist(*rng);
+  }
+  return input;
+}
+
+TEST(BatchingPredictor, pad_buckets) {
+  std::string dirname = SaveScaleModel();
+  Config config;
+  config.SetModel(dirname);
+  config.SwitchIrOptim(false);
+  Predictor predictor(config);
+
+  // the lengths 1 and 3 are padded to 4, 5 to 8 and batched with the length
+  // 8, 13 is longer than the buckets and runs unpadded
+  std::mt19937 rng(2022);
+  std::vector<paddle::PaddleTensor> requests;
+  std::vector<std::vector<float>> expected;
+  for (int length : {3, 5, 8, 3, 13, 1}) {
+    requests.push_back(MakeSequence(1 + length % 2, length, &rng));
+    auto input = predictor.GetInputHandle("x");
+    input->Reshape(requests.back().shape);
+    input->CopyFromCpu(static_cast<const float*>(requests.back().data.data()));
+    ASSERT_TRUE(predictor.Run());
+    auto out = predictor.GetOutputHandle(predictor.GetOutputNames()[0]);
+    ASSERT_EQ(out->shape(), requests.back().shape);
+    expected.emplace_back(requests.back().data.length() / sizeof(float));
+    out->CopyToCpu(expected.back().data());
+  }
+
+  BatchingOptions options;
+  options.max_batch_size = 16;
+  // long enough for the requests of a bucket to be in one batch
+  options.max_delay_us = 200000;
+  options.pad_buckets["x"] = {8, 4};
+  BatchingPredictor batching(config, options);
+  std::vector<std::future<std::vector<paddle::PaddleTensor>>> futures;
+  for (auto& request : requests) {
+    futures.push_back(batching.Submit({request}));
+  }
+  for (size_t i = 0; i < futures.size(); ++i) {
+    auto outputs = futures[i].get();
+    ASSERT_EQ(outputs.size(), 1UL);
+    // the padded positions are cut from the output
+    ASSERT_EQ(outputs[0].shape, requests[i].shape) << "request " << i;
+    ASSERT_EQ(outputs[0].data.length(), expected[i].size() * sizeof(float));
+    const float* data = static_cast<const float*>(outputs[0].data.data());
+    for (size_t j = 0; j < expected[i].size(); ++j) {
+      EXPECT_NEAR(data[j], expected[i][j], 1e-6) << "request " << i;
+    }
+  }
+
+  std::remove((dirname + "/__model__").c_str());
+  rmdir(dirname.c_str());
+}
+
+}  // namespace services
+}  // namespace paddle_infer
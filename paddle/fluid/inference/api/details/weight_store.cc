@@ -0,0 +1,136 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/weight_store.h"
+
+#include <glog/logging.h>
+
+#include "paddle/fluid/framework/block_desc.h"
+#include "paddle/fluid/framework/op_desc.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/phi/common/data_type.h"
+
+namespace paddle {
+namespace details {
+
+bool IsSharedWeight(const framework::LoDTensor &tensor) {
+  return tensor.IsInitialized() &&
+         dynamic_cast<const SharedWeightAllocation *>(tensor.Holder().get()) !=
+             nullptr;
+}
+
+void DetachSharedWeight(framework::LoDTensor *tensor) {
+  if (!IsSharedWeight(*tensor)) {
+    return;
+  }
+  size_t bytes = tensor->numel() * experimental::SizeOf(tensor->dtype()) +
+                 tensor->offset();
+  if (bytes > tensor->Holder()->size()) {
+    // the tensor is reshaped larger, mutable_data allocates it again
+    tensor->clear();
+    return;
+  }
+  framework::LoDTensor copy;
+  framework::TensorCopySync(*tensor, tensor->place(), &copy);
+  auto lod = tensor->lod();
+  tensor->ShareDataWith(copy);
+  tensor->set_lod(lod);
+  VLOG(3) << "Copy " << bytes << " bytes of a shared weight to write it";
+}
+
+WeightSet::WeightSet(const std::shared_ptr<framework::ProgramDesc> &program,
+                     framework::Scope *scope)
+    : program_(program) {
+  for (size_t i = 0; i < program->Size(); ++i) {
+    for (auto *op : program->Block(i).AllOps()) {
+      for (auto &name : op->OutputArgumentNames()) {
+        written_.insert(name);
+      }
+    }
+  }
+  for (auto *var : program->Block(0).AllVars()) {
+    if (!var->Persistable() ||
+        var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+      continue;
+    }
+    auto *variable = scope->FindVar(var->Name());
+    if (variable == nullptr || !variable->IsType<framework::LoDTensor>() ||
+        !variable->Get<framework::LoDTensor>().IsInitialized()) {
+      continue;
+    }
+    auto *tensor = variable->GetMutable<framework::LoDTensor>();
+    auto &shared = tensors_[var->Name()];
+    if (written_.count(var->Name())) {
+      // the ops of the scope's predictor write it, the set keeps a copy
+      framework::TensorCopySync(*tensor, tensor->place(), &shared);
+    } else {
+      if (!IsSharedWeight(*tensor)) {
+        tensor->ResetHolder(
+            std::make_shared<SharedWeightAllocation>(tensor->Holder()));
+      }
+      shared.ShareDataWith(*tensor);
+    }
+    shared.set_lod(tensor->lod());
+    memory_size_ += shared.memory_size();
+  }
+}
+
+void WeightSet::AttachTo(framework::Scope *scope,
+                         const platform::Place &place) const {
+  for (auto &item : tensors_) {
+    auto *tensor = scope->Var(item.first)->GetMutable<framework::LoDTensor>();
+    if (written_.count(item.first) || item.second.place() != place) {
+      framework::TensorCopySync(item.second, place, tensor);
+    } else {
+      tensor->ShareDataWith(item.second);
+    }
+    tensor->set_lod(item.second.lod());
+  }
+}
+
+WeightStore &WeightStore::Instance() {
+  static WeightStore store;
+  return store;
+}
+
+std::shared_ptr<const WeightSet> WeightStore::Find(const std::string &key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = sets_.find(key);
+  return iter == sets_.end() ? nullptr : iter->second.lock();
+}
+
+std::shared_ptr<const WeightSet> WeightStore::Publish(
+    const std::string &key,
+    const std::shared_ptr<framework::ProgramDesc> &program,
+    framework::Scope *scope) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (auto weights = sets_[key].lock()) {
+    return weights;
+  }
+  // drop the keys of the sets no predictor holds anymore
+  for (auto iter = sets_.begin(); iter != sets_.end();) {
+    if (iter->first != key && iter->second.expired()) {
+      iter = sets_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  auto weights = std::make_shared<const WeightSet>(program, scope);
+  sets_[key] = weights;
+  VLOG(3) << "Share " << weights->memory_size() << " bytes of weights";
+  return weights;
+}
+
+}  // namespace details
+}  // namespace paddle
@@ -0,0 +1,102 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace details {
+
+// The holder of a tensor shared through a WeightSet. It points to the memory
+// of the wrapped allocation, which is freed with the last sharing tensor.
+class SharedWeightAllocation : public memory::allocation::Allocation {
+ public:
+  explicit SharedWeightAllocation(std::shared_ptr<phi::Allocation> base)
+      : Allocation(base->ptr(), base->size(), base->place()),
+        base_(std::move(base)) {}
+
+ private:
+  std::shared_ptr<phi::Allocation> base_;
+};
+
+// Whether the data of the tensor is shared with the other predictors.
+bool IsSharedWeight(const framework::LoDTensor &tensor);
+
+// Copy-on-write of a shared weight: the tensor gets its own copy of the data
+// before it is written, the other predictors keep the shared one. It does
+// nothing to the tensors that are not shared.
+void DetachSharedWeight(framework::LoDTensor *tensor);
+
+// The optimized program of a model and its persistable tensors, shared by
+// all the predictors created with the same model and config. The tensors are
+// never written through the set, the predictors that write them have their
+// own copies.
+class WeightSet {
+ public:
+  WeightSet(const std::shared_ptr<framework::ProgramDesc> &program,
+            framework::Scope *scope);
+
+  const std::shared_ptr<framework::ProgramDesc> &program() const {
+    return program_;
+  }
+
+  // Shares the tensors with the variables of the same names in the scope,
+  // the variables written by the ops of the program get copies.
+  void AttachTo(framework::Scope *scope, const platform::Place &place) const;
+
+  // The bytes of the shared tensors.
+  size_t memory_size() const { return memory_size_; }
+
+ private:
+  std::shared_ptr<framework::ProgramDesc> program_;
+  std::unordered_map<std::string, framework::LoDTensor> tensors_;
+  std::unordered_set<std::string> written_;
+  size_t memory_size_{0};
+};
+
+// The WeightSets of the process by the keys of the optimized programs. A set
+// lives as long as a predictor holds it.
+class WeightStore {
+ public:
+  static WeightStore &Instance();
+
+  // The live set of the key, nullptr if there is none.
+  std::shared_ptr<const WeightSet> Find(const std::string &key);
+
+  // Shares the persistable tensors of the scope under the key. If a set of
+  // the key was published first, it is returned instead.
+  std::shared_ptr<const WeightSet> Publish(
+      const std::string &key,
+      const std::shared_ptr<framework::ProgramDesc> &program,
+      framework::Scope *scope);
+
+ private:
+  WeightStore() = default;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<const WeightSet>> sets_;
+};
+
+}  // namespace details
+}  // namespace paddle
@@ -16,6 +16,7 @@
 #include "paddle/fluid/framework/data_layout_transform.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/inference/api/details/weight_store.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/paddle_tensor.h"
 #include "paddle/fluid/memory/memcpy.h"
@@ -78,6 +79,8 @@ T *Tensor::mutable_data(PlaceType place) {
           "You should call Tensor::Reshape(const std::vector<int> "
           "&shape)"
           "function before retrieving mutable_data from input tensor."));
+  // the weights shared with the other predictors are copied to be written
+  paddle::details::DetachSharedWeight(tensor);
   switch (static_cast<int>(place)) {
     case static_cast<int>(PlaceType::kCPU): {
       return tensor->mutable_data<T>(paddle::platform::CPUPlace());
@@ -152,6 +155,7 @@ void Tensor::CopyFromCpu(const T *data) {
                         "std::vector<int> &shape)"
                         "function before copying data from cpu."));
   size_t ele_size = tensor->numel() * sizeof(T);
+  paddle::details::DetachSharedWeight(tensor);
 
   if (place_ == PlaceType::kCPU) {
     auto *t_data = tensor->mutable_data<T>(paddle::platform::CPUPlace());
@@ -207,6 +207,54 @@ struct PD_INFER_DECL AnalysisConfig {
     opt_cache_dir_ = opt_cache_dir;
   }
   ///
+  /// \brief Cache the optimized program and its parameters in the
+  /// optimization cache directory, the later predictors of the same model,
+  /// config and library load them instead of running the analysis passes. It
+  /// is only used by the predictors on CPU without a subgraph engine.
+  ///
+  /// \param x Whether to cache the optimized program.
+  ///
+  void EnableOptimizedProgramCache(bool x = true) {
+    optimized_program_cache_ = x;
+  }
+  ///
+  /// \brief A boolean state telling whether the optimized program is cached.
+  ///
+  /// \return bool Whether the optimized program is cached.
+  ///
+  bool optimized_program_cache_enabled() const {
+    return optimized_program_cache_;
+  }
+  ///
+  /// \brief Share the optimized program and the parameters among the
+  /// predictors of the same model and config. The predictors created later
+  /// take the parameters of the first one instead of loading and optimizing
+  /// their own, and copy a parameter only if they write it. If shm_dir is
+  /// set, e.g. a directory in /dev/shm, the parameters are also saved there
+  /// and mapped by the predictors of the other processes. It is only used by
+  /// the predictors on CPU without a subgraph engine.
+  ///
+  /// \param shm_dir The directory of the parameters shared across processes.
+  ///
+  void EnableWeightSharing(const std::string& shm_dir = "") {
+    weight_sharing_ = true;
+    weight_sharing_dir_ = shm_dir;
+  }
+  ///
+  /// \brief A boolean state telling whether the parameters are shared among
+  /// the predictors.
+  ///
+  /// \return bool Whether the parameters are shared.
+  ///
+  bool weight_sharing_enabled() const { return weight_sharing_; }
+  ///
+  /// \brief Get the directory of the parameters shared across processes.
+  ///
+  /// \return const std::string& The directory, empty if the parameters are
+  /// only shared in the process.
+  ///
+  const std::string& weight_sharing_dir() const { return weight_sharing_dir_; }
+  ///
   /// \brief Get the model directory path.
   ///
   /// \return const std::string& The model directory path.
@@ -720,6 +768,20 @@ struct PD_INFER_DECL AnalysisConfig {
     bfloat16_enabled_op_types_ = op_list;
   }
 
+  ///
+  /// \brief Turn on the int8 CPU kernels for the quantized models, which
+  /// run the quantized fc, matmul and conv2d ops in int8 without MKLDNN.
+  ///
+  ///
+  void EnableCpuInt8();
+
+  ///
+  /// \brief A boolean state telling whether to use the int8 CPU kernels.
+  ///
+  /// \return bool Whether to use the int8 CPU kernels.
+  ///
+  bool cpu_int8_enabled() const { return use_cpu_int8_; }
+
   ///
   /// \brief A boolean state telling whether the thread local CUDA stream is
   /// enabled.
@@ -775,6 +837,23 @@ struct PD_INFER_DECL AnalysisConfig {
   /// \return bool Whether the memory optimization is activated.
   ///
   bool enable_memory_optim() const;
+  ///
+  /// \brief Turn on the memory optimize that packs the temporary tensors into
+  /// one memory arena by their lifetimes. The tensors are bound to their
+  /// offsets in the arena before every run instead of being allocated.
+  ///
+  /// \param shape_range_info_path The shape range info file collected by
+  /// CollectShapeRangeInfo, its max shapes bound the tensors of dynamic
+  /// shapes. Without it only the tensors of static shapes are packed.
+  ///
+  void EnableMemoryOffsetPlan(const std::string& shape_range_info_path = "");
+  ///
+  /// \brief A boolean state telling whether the tensors are packed into a
+  /// memory arena.
+  ///
+  /// \return bool Whether the memory offset plan is activated.
+  ///
+  bool memory_offset_plan_enabled() const { return memory_offset_plan_; }
 
   ///
   /// \brief Turn on profiling report.
@@ -917,6 +996,8 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool memory_offset_plan_{false};
+  std::string memory_offset_plan_shape_range_info_path_;
 
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
@@ -966,6 +1047,9 @@ struct PD_INFER_DECL AnalysisConfig {
   bool use_mkldnn_bfloat16_{false};
   std::unordered_set<std::string> bfloat16_enabled_op_types_;
 
+  // int8 cpu related.
+  bool use_cpu_int8_{false};
+
   // ipu related.
   bool use_ipu_{false};
   int ipu_device_num_{1};
@@ -984,6 +1068,9 @@ struct PD_INFER_DECL AnalysisConfig {
   // So we release the memory when the predictor is set up.
   mutable bool is_valid_{true};
   std::string opt_cache_dir_;
+  bool optimized_program_cache_{false};
+  bool weight_sharing_{false};
+  std::string weight_sharing_dir_;
   friend class paddle_infer::experimental::InternalUtils;
 
   // fleet exe related
@@ -22,6 +22,7 @@ limitations under the License. */
 #pragma once
 
 #include <cassert>
+#include <future>  // NOLINT
 #include <map>
 #include <memory>
 #include <string>
@@ -199,6 +200,68 @@ class PD_INFER_DECL PredictorPool {
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
 };
+
+///
+/// \brief The options of BatchingPredictor.
+///
+struct PD_INFER_DECL BatchingOptions {
+  /// The number of predictors, each one runs the batches on its own thread.
+  size_t num_predictors{1};
+  /// The most rows (the dim 0 of the inputs) in a batch.
+  int max_batch_size{32};
+  /// How long the first request of a batch waits for the others, in us.
+  int max_delay_us{1000};
+  /// The lengths the dim 1 of an input is padded to with zeros, by the input
+  /// name. The requests padded to the same length are batched together, the
+  /// ones longer than the largest bucket are not padded.
+  std::map<std::string, std::vector<int>> pad_buckets;
+};
+
+///
+/// \class BatchingPredictor
+///
+/// \brief BatchingPredictor runs the requests submitted by many threads in
+/// batches. The requests whose inputs have the same data types and the same
+/// dims except the dim 0 are concatenated along the dim 0, up to
+/// max_batch_size rows or until the first one has waited max_delay_us. Every
+/// batch is run once and the rows of its outputs are split back to the
+/// requests. The dim 1 of an output that equals the padded length of the
+/// first padded input is cut back to the length of the request.
+///
+/// Usage:
+///
+/// \code{.cpp}
+/// BatchingPredictor batching(config, options);
+/// auto outputs = batching.Submit(std::move(inputs)).get();
+/// \endcode
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  explicit BatchingPredictor(
+      const Config& config, const BatchingOptions& options = BatchingOptions());
+
+  /// \brief Run the queued requests and stop the threads.
+  ~BatchingPredictor();
+
+  ///
+  /// \brief Queue one request, thread safe.
+  ///
+  /// \param[in] inputs The CPU tensors of the request, a tensor feeds the
+  /// input of its name, or the input of its position if the name is empty.
+  /// \return The outputs of the request, in the order of the output names.
+  /// A request that fails to run, such as one with an id out of range, sets
+  /// the exception of its own future, the others of its batch still run.
+  ///
+  std::future<std::vector<paddle::PaddleTensor>> Submit(
+      std::vector<paddle::PaddleTensor> inputs);
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
 }  // namespace services
 
 }  // namespace paddle_infer
@@ -20,6 +20,7 @@
 #include <miopen/miopen.h>
 #endif
 #include <glog/logging.h>
+#include <algorithm>
 #include <sstream>
 
 namespace paddle {
@@ -184,6 +185,10 @@ void GpuPassStrategy::EnableMkldnnBfloat16() {
   LOG(ERROR) << "GPU not support MKL-DNN bfloat16";
 }
 
+void GpuPassStrategy::EnableCpuInt8() {
+  LOG(ERROR) << "GPU not support the CPU int8 kernels";
+}
+
 CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
   // NOTE the large fusions should be located in the front, so that they will
   // not be damaged by smaller ones.
@@ -302,6 +307,24 @@ void CpuPassStrategy::EnableMkldnnBfloat16() {
 #endif
 }
 
+void CpuPassStrategy::EnableCpuInt8() {
+  if (!use_cpu_int8_) {
+    // the scales of the fake quant ops go to the quantized ops first
+    passes_.insert(passes_.begin(), {"quant_conv2d_dequant_fuse_pass",  //
+                                     "delete_quant_dequant_op_pass"});
+    // the quantized fc and conv2d run in int8 after the fc and conv bn
+    // fusions
+    auto bn_fuse = std::find(passes_.begin(), passes_.end(),
+                             "conv_eltwiseadd_bn_fuse_pass");
+    if (bn_fuse != passes_.end()) {
+      passes_.insert(bn_fuse + 1, "cpu_int8_fc_conv_pass");
+    } else {
+      passes_.push_back("cpu_int8_fc_conv_pass");
+    }
+  }
+  use_cpu_int8_ = true;
+}
+
 IpuPassStrategy::IpuPassStrategy() : PassStrategy({}) {
   passes_.assign({"inference_process_pass"});
 }
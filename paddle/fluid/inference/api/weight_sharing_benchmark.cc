@@ -0,0 +1,73 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The resident memory each predictor replica adds, with and without weight
+// sharing.
+// To use this tool, run command:
+//     ./weight_sharing_benchmark --dirname=<model dir> [--num_replicas=8]
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <unistd.h>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(dirname, "", "Directory of the model.");
+DEFINE_int32(num_replicas, 8, "Predictors created with each config.");
+
+namespace paddle {
+
+// the resident memory of the process in bytes
+static int64_t ResidentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  int64_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+static void BenchmarkReplicaMemory() {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  AnalysisConfig shared_config(config);
+  shared_config.EnableWeightSharing();
+  // the first predictor optimizes the program, so the replicas below only
+  // count their own memory
+  auto first = CreatePaddlePredictor<AnalysisConfig>(shared_config);
+  for (auto* replica_config : {&config, &shared_config}) {
+    std::vector<std::unique_ptr<PaddlePredictor>> replicas;
+    int64_t before = ResidentBytes();
+    for (int i = 0; i < FLAGS_num_replicas; ++i) {
+      replicas.push_back(
+          CreatePaddlePredictor<AnalysisConfig>(*replica_config));
+    }
+    LOG(INFO) << "resident memory per replica "
+              << (replica_config->weight_sharing_enabled() ? "with"
+                                                           : "without")
+              << " weight sharing: "
+              << (ResidentBytes() - before) / FLAGS_num_replicas << " bytes";
+  }
+}
+
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_logtostderr = true;
+  paddle::BenchmarkReplicaMemory();
+  return 0;
+}
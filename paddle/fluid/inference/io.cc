@@ -15,13 +15,21 @@ limitations under the License. */
 #include "paddle/fluid/inference/io.h"
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <sstream>
+#include <unordered_map>
 #include <vector>
 
 #include "paddle/fluid/framework/block_desc.h"
+#include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/version.h"
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/pybind/pybind.h"
@@ -114,6 +122,13 @@ void LoadPersistables(framework::Executor* executor, framework::Scope* scope,
     }
   }
 
+  if (!param_filename.empty() && !model_from_memory &&
+      IsMappedParamsFile(param_filename)) {
+    LoadMappedParams(scope, paramlist, param_filename, executor->GetPlace());
+    delete load_program;
+    return;
+  }
+
   if (!param_filename.empty()) {
     // sort paramlist to have consistent ordering
     std::sort(paramlist.begin(), paramlist.end());
@@ -201,5 +216,253 @@ void SaveVars(const framework::Scope& scope,
   exe.Run(prog, const_cast<framework::Scope*>(&scope), 0, true, true);
 }
 
+// =========================================================
+//       Item        |        Type       |      Bytes
+// ---------------------------------------------------------
+//       Magic       |        char       |        8
+//      Version      |      uint32_t     |        4
+//    Size of Vars   |      uint32_t     |        4
+//   Bytes of Index  |      uint64_t     |        8
+// ---------------------------------------------------------
+//   Bytes of `Name` |      uint64_t     |        8
+//        Name       |        char       |  Bytes of `Name`
+//       Dtype       |       int32_t     |        4
+//   Dims of `Shape` |      uint64_t     |        8
+//       Shape       |       int64_t     |    Dims * 8
+//      LoD Level    |      uint64_t     |        8
+//  Size of `LoD[0]` |      uint64_t     |        8
+//       LoD[0]      |      uint64_t     | Size of `LoD[0]` * 8
+//        ...        |         ...       |       ...
+//  Offset of `Data` |      uint64_t     |        8
+//  Bytes of `Data`  |      uint64_t     |        8
+// ---------------------------------------------------------
+//        ...        |  (Size of Vars entries of the index)
+// ---------------------------------------------------------
+//        Data       |        Dtype      |  Bytes of `Data`
+//        ...        |         ...       |       ...
+// =========================================================
+// The data section starts at the first aligned offset after the index, the
+// offsets of the data are from its start and aligned as well.
+static constexpr char kMappedParamsMagic[8] = {'P', 'D', 'M', 'A',
+                                               'P', 'P', 'E', 'D'};
+static constexpr uint32_t kCurMappedParamsVersion = 0;
+static constexpr uint64_t kMappedParamsHeaderBytes = 24;
+static constexpr uint64_t kMappedParamsAlignment = 64;
+
+static uint64_t AlignMappedParams(uint64_t offset) {
+  return (offset + kMappedParamsAlignment - 1) / kMappedParamsAlignment *
+         kMappedParamsAlignment;
+}
+
+template <typename T>
+static void WriteValue(std::ostream* os, T value) {
+  os->write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads a value at *pos of the mapped data and moves *pos past it.
+template <typename T>
+static T ReadValue(const char* data, uint64_t size, uint64_t* pos) {
+  PADDLE_ENFORCE_LE(*pos + sizeof(T), size,
+                    platform::errors::InvalidArgument(
+                        "The mapped params file is truncated."));
+  T value;
+  std::memcpy(&value, data + *pos, sizeof(T));
+  *pos += sizeof(T);
+  return value;
+}
+
+bool IsMappedParamsFile(const std::string& filename) {
+  std::ifstream fin(filename, std::ios::in | std::ios::binary);
+  char magic[sizeof(kMappedParamsMagic)];
+  return fin.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, kMappedParamsMagic, sizeof(magic)) == 0;
+}
+
+void SaveMappedParams(const framework::Scope& scope,
+                      const std::vector<std::string>& vars,
+                      const std::string& filename) {
+  std::vector<framework::LoDTensor> tensors(vars.size());
+  std::ostringstream index;
+  uint64_t data_bytes = 0;
+  for (size_t i = 0; i < vars.size(); ++i) {
+    auto* var = scope.FindVar(vars[i]);
+    PADDLE_ENFORCE_NOT_NULL(
+        var, platform::errors::NotFound("Variable %s is not in the scope.",
+                                        vars[i]));
+    PADDLE_ENFORCE_EQ(var->IsType<framework::LoDTensor>(), true,
+                      platform::errors::Unimplemented(
+                          "The mapped params file only holds LoDTensors, but "
+                          "the variable %s is not a LoDTensor.",
+                          vars[i]));
+    auto& tensor = var->Get<framework::LoDTensor>();
+    if (platform::is_cpu_place(tensor.place())) {
+      tensors[i].ShareDataWith(tensor);
+      tensors[i].set_lod(tensor.lod());
+    } else {
+      framework::TensorCopySync(tensor, platform::CPUPlace(), &tensors[i]);
+      tensors[i].set_lod(tensor.lod());
+    }
+
+    WriteValue<uint64_t>(&index, vars[i].size());
+    index.write(vars[i].data(), vars[i].size());
+    WriteValue<int32_t>(&index, framework::TransToProtoVarType(tensor.dtype()));
+    auto dims = phi::vectorize(tensor.dims());
+    WriteValue<uint64_t>(&index, dims.size());
+    for (auto dim : dims) {
+      WriteValue<int64_t>(&index, dim);
+    }
+    WriteValue<uint64_t>(&index, tensor.lod().size());
+    for (auto& level : tensor.lod()) {
+      WriteValue<uint64_t>(&index, level.size());
+      for (auto offset : level) {
+        WriteValue<uint64_t>(&index, offset);
+      }
+    }
+    uint64_t bytes = tensor.numel() * experimental::SizeOf(tensor.dtype());
+    WriteValue<uint64_t>(&index, data_bytes);
+    WriteValue<uint64_t>(&index, bytes);
+    data_bytes = AlignMappedParams(data_bytes + bytes);
+  }
+
+  std::ofstream fout(filename, std::ios::out | std::ios::binary);
+  PADDLE_ENFORCE_EQ(
+      fout.is_open(), true,
+      platform::errors::Unavailable("Failed to open file %s.", filename));
+  std::string index_str = index.str();
+  fout.write(kMappedParamsMagic, sizeof(kMappedParamsMagic));
+  WriteValue<uint32_t>(&fout, kCurMappedParamsVersion);
+  WriteValue<uint32_t>(&fout, vars.size());
+  WriteValue<uint64_t>(&fout, index_str.size());
+  fout.write(index_str.data(), index_str.size());
+  uint64_t written = kMappedParamsHeaderBytes + index_str.size();
+  std::string padding(kMappedParamsAlignment, '\0');
+  for (auto& tensor : tensors) {
+    fout.write(padding.data(), AlignMappedParams(written) - written);
+    written = AlignMappedParams(written);
+    uint64_t bytes = tensor.numel() * experimental::SizeOf(tensor.dtype());
+    if (bytes > 0) {
+      fout.write(static_cast<const char*>(tensor.data()), bytes);
+    }
+    written += bytes;
+  }
+  PADDLE_ENFORCE_EQ(
+      fout.good(), true,
+      platform::errors::Unavailable("Failed to write file %s.", filename));
+}
+
+void LoadMappedParams(framework::Scope* scope,
+                      const std::vector<std::string>& vars,
+                      const std::string& filename,
+                      const platform::Place& place) {
+#ifdef _WIN32
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Loading the mapped params file %s is not supported on Windows.",
+      filename));
+#else
+  auto file = std::make_shared<memory::allocation::MappedFile>(filename);
+  const char* data = file->data();
+  const uint64_t size = file->size();
+  uint64_t pos = sizeof(kMappedParamsMagic);
+  PADDLE_ENFORCE_EQ(
+      size >= pos && std::memcmp(data, kMappedParamsMagic, pos) == 0, true,
+      platform::errors::InvalidArgument(
+          "The file %s is not a mapped params file.", filename));
+  auto version = ReadValue<uint32_t>(data, size, &pos);
+  PADDLE_ENFORCE_LE(version, kCurMappedParamsVersion,
+                    platform::errors::Unavailable(
+                        "The version %d of the mapped params file %s is not "
+                        "supported.",
+                        version, filename));
+  auto num_vars = ReadValue<uint32_t>(data, size, &pos);
+  auto index_bytes = ReadValue<uint64_t>(data, size, &pos);
+  const uint64_t data_begin = AlignMappedParams(pos + index_bytes);
+
+  struct Entry {
+    framework::proto::VarType::Type dtype;
+    std::vector<int64_t> dims;
+    framework::LoD lod;
+    uint64_t offset;
+    uint64_t bytes;
+  };
+  std::unordered_map<std::string, Entry> entries;
+  for (uint32_t i = 0; i < num_vars; ++i) {
+    auto name_bytes = ReadValue<uint64_t>(data, size, &pos);
+    PADDLE_ENFORCE_LE(pos + name_bytes, size,
+                      platform::errors::InvalidArgument(
+                          "The mapped params file %s is truncated.", filename));
+    std::string name(data + pos, name_bytes);
+    pos += name_bytes;
+    Entry& entry = entries[name];
+    entry.dtype = static_cast<framework::proto::VarType::Type>(
+        ReadValue<int32_t>(data, size, &pos));
+    entry.dims.resize(ReadValue<uint64_t>(data, size, &pos));
+    for (auto& dim : entry.dims) {
+      dim = ReadValue<int64_t>(data, size, &pos);
+    }
+    entry.lod.resize(ReadValue<uint64_t>(data, size, &pos));
+    for (auto& level : entry.lod) {
+      level.resize(ReadValue<uint64_t>(data, size, &pos));
+      for (size_t j = 0; j < level.size(); ++j) {
+        level[j] = ReadValue<uint64_t>(data, size, &pos);
+      }
+    }
+    entry.offset = data_begin + ReadValue<uint64_t>(data, size, &pos);
+    entry.bytes = ReadValue<uint64_t>(data, size, &pos);
+    PADDLE_ENFORCE_LE(entry.offset + entry.bytes, size,
+                      platform::errors::InvalidArgument(
+                          "The data of variable %s is out of the mapped "
+                          "params file %s.",
+                          name, filename));
+  }
+
+  for (auto& name : vars) {
+    auto iter = entries.find(name);
+    PADDLE_ENFORCE_EQ(iter != entries.end(), true,
+                      platform::errors::NotFound(
+                          "Variable %s is not in the mapped params file %s.",
+                          name, filename));
+    const Entry& entry = iter->second;
+    auto dtype = framework::TransToPhiDataType(entry.dtype);
+    auto dims = phi::make_ddim(entry.dims);
+    PADDLE_ENFORCE_EQ(
+        entry.bytes, phi::product(dims) * experimental::SizeOf(dtype),
+        platform::errors::InvalidArgument(
+            "The data of variable %s does not match its shape.", name));
+    auto holder = std::make_shared<memory::allocation::MmapAllocation>(
+        file, entry.offset, entry.bytes);
+    auto* tensor = scope->Var(name)->GetMutable<framework::LoDTensor>();
+    if (platform::is_cpu_place(place)) {
+      tensor->Resize(dims);
+      tensor->set_offset(0);
+      tensor->ResetHolderWithType(holder, dtype);
+    } else {
+      framework::LoDTensor mapped;
+      mapped.Resize(dims);
+      mapped.ResetHolderWithType(holder, dtype);
+      framework::TensorCopySync(mapped, place, tensor);
+    }
+    tensor->set_lod(entry.lod);
+  }
+  VLOG(3) << "Map " << vars.size() << " variables of " << filename;
+#endif
+}
+
+void SaveMappedParamsOfModel(const std::string& prog_filename,
+                             const std::string& param_filename,
+                             const std::string& mapped_filename) {
+  platform::CPUPlace place;
+  framework::Executor executor(place);
+  framework::Scope scope;
+  auto program = Load(&executor, &scope, prog_filename, param_filename);
+  std::vector<std::string> vars;
+  for (auto* var : program->Block(0).AllVars()) {
+    if (IsPersistable(var)) {
+      vars.push_back(var->Name());
+    }
+  }
+  std::sort(vars.begin(), vars.end());
+  SaveMappedParams(scope, vars, mapped_filename);
+}
+
 }  // namespace inference
 }  // namespace paddle
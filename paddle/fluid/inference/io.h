@@ -51,5 +51,27 @@ void SaveVars(const framework::Scope& scope,
               const std::vector<std::string>& vars, const std::string& dirname,
               bool predicate = true);
 
+// The mapped params file holds the LoDTensors of the persistable variables
+// with their payloads aligned in the file, the loaded tensors are backed by a
+// mapping of the file rather than copied out of it.
+bool IsMappedParamsFile(const std::string& filename);
+
+void SaveMappedParams(const framework::Scope& scope,
+                      const std::vector<std::string>& vars,
+                      const std::string& filename);
+
+// Loads the variables into the scope, the tensors are copied to the place if
+// it is not CPUPlace.
+void LoadMappedParams(framework::Scope* scope,
+                      const std::vector<std::string>& vars,
+                      const std::string& filename,
+                      const platform::Place& place);
+
+// Saves the persistable variables of a model with combined params to a mapped
+// params file.
+void SaveMappedParamsOfModel(const std::string& prog_filename,
+                             const std::string& param_filename,
+                             const std::string& mapped_filename);
+
 }  // namespace inference
 }  // namespace paddle
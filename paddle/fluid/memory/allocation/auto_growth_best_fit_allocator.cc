@@ -34,10 +34,36 @@ PADDLE_DEFINE_EXPORTED_READONLY_bool(
     "chunk would be freed when out of memory occurs. This flag "
     "only works when FLAGS_allocator_strategy=auto_growth.");
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace paddle {
 namespace memory {
 namespace allocation {
 
+// Index of the lowest set bit, x must not be 0.
+static inline size_t FindFirstSet(uint64_t x) {
+#ifdef _MSC_VER
+  unsigned long index;  // NOLINT
+  _BitScanForward64(&index, x);
+  return static_cast<size_t>(index);
+#else
+  return static_cast<size_t>(__builtin_ctzll(x));
+#endif
+}
+
+// Index of the highest set bit, x must not be 0.
+static inline size_t FindLastSet(uint64_t x) {
+#ifdef _MSC_VER
+  unsigned long index;  // NOLINT
+  _BitScanReverse64(&index, x);
+  return static_cast<size_t>(index);
+#else
+  return static_cast<size_t>(63 - __builtin_clzll(x));
+#endif
+}
+
 AutoGrowthBestFitAllocator::AutoGrowthBestFitAllocator(
     const std::shared_ptr<Allocator> &underlying_allocator, size_t alignment,
     size_t chunk_size, bool allow_free_idle_chunk)
@@ -46,6 +72,124 @@ AutoGrowthBestFitAllocator::AutoGrowthBestFitAllocator(
       chunk_size_(std::max(AlignedSize(chunk_size, alignment), alignment)),
       allow_free_idle_chunk_(allow_free_idle_chunk) {}
 
+AutoGrowthBestFitAllocator::~AutoGrowthBestFitAllocator() {
+  for (auto &chunk : chunks_) {
+    for (auto *block = chunk.head_; block != nullptr;) {
+      auto *next = block->next_phys_;
+      delete block;
+      block = next;
+    }
+  }
+  while (spare_blocks_ != nullptr) {
+    auto *next = spare_blocks_->next_free_;
+    delete spare_blocks_;
+    spare_blocks_ = next;
+  }
+}
+
+void AutoGrowthBestFitAllocator::MappingInsert(size_t size, size_t *fl,
+                                               size_t *sl) {
+  if (size < kSLCount) {
+    *fl = 0;
+    *sl = size;
+  } else {
+    size_t msb = FindLastSet(size);
+    *fl = msb - kSLBits + 1;
+    *sl = (size >> (msb - kSLBits)) ^ kSLCount;
+  }
+}
+
+void AutoGrowthBestFitAllocator::MappingSearch(size_t size, size_t *fl,
+                                               size_t *sl) {
+  if (size >= kSLCount) {
+    size_t round = (static_cast<size_t>(1) << (FindLastSet(size) - kSLBits));
+    size += round - 1;
+  }
+  MappingInsert(size, fl, sl);
+}
+
+void AutoGrowthBestFitAllocator::InsertFreeBlock(Block *block) {
+  size_t fl, sl;
+  MappingInsert(block->size_, &fl, &sl);
+  auto *head = free_blocks_[fl][sl];
+  block->prev_free_ = nullptr;
+  block->next_free_ = head;
+  if (head != nullptr) {
+    head->prev_free_ = block;
+  }
+  free_blocks_[fl][sl] = block;
+  fl_bitmap_ |= (static_cast<uint64_t>(1) << fl);
+  sl_bitmap_[fl] |= (1U << sl);
+}
+
+void AutoGrowthBestFitAllocator::RemoveFreeBlock(Block *block) {
+  size_t fl, sl;
+  MappingInsert(block->size_, &fl, &sl);
+  if (block->prev_free_ != nullptr) {
+    block->prev_free_->next_free_ = block->next_free_;
+  } else {
+    free_blocks_[fl][sl] = block->next_free_;
+  }
+  if (block->next_free_ != nullptr) {
+    block->next_free_->prev_free_ = block->prev_free_;
+  }
+  block->prev_free_ = nullptr;
+  block->next_free_ = nullptr;
+  if (free_blocks_[fl][sl] == nullptr) {
+    sl_bitmap_[fl] &= ~(1U << sl);
+    if (sl_bitmap_[fl] == 0) {
+      fl_bitmap_ &= ~(static_cast<uint64_t>(1) << fl);
+    }
+  }
+}
+
+AutoGrowthBestFitAllocator::Block *AutoGrowthBestFitAllocator::FindFreeBlock(
+    size_t size) {
+  // The blocks in the bin of size may be smaller than size, but checking the
+  // head of that bin first keeps exact-size reuse without any scanning.
+  size_t fl, sl;
+  MappingInsert(size, &fl, &sl);
+  auto *block = free_blocks_[fl][sl];
+  if (block != nullptr && block->size_ >= size) {
+    return block;
+  }
+
+  MappingSearch(size, &fl, &sl);
+  if (fl >= kFLCount) {
+    return nullptr;
+  }
+  uint32_t sl_map = sl_bitmap_[fl] & (~0U << sl);
+  if (sl_map == 0) {
+    if (fl + 1 >= kFLCount) {
+      return nullptr;
+    }
+    uint64_t fl_map = fl_bitmap_ & (~static_cast<uint64_t>(0) << (fl + 1));
+    if (fl_map == 0) {
+      return nullptr;
+    }
+    fl = FindFirstSet(fl_map);
+    sl_map = sl_bitmap_[fl];
+  }
+  sl = FindFirstSet(sl_map);
+  return free_blocks_[fl][sl];
+}
+
+AutoGrowthBestFitAllocator::Block *
+AutoGrowthBestFitAllocator::NewBlockHeader() {
+  if (spare_blocks_ == nullptr) {
+    return new Block();
+  }
+  auto *block = spare_blocks_;
+  spare_blocks_ = block->next_free_;
+  *block = Block();
+  return block;
+}
+
+void AutoGrowthBestFitAllocator::DeleteBlockHeader(Block *block) {
+  block->next_free_ = spare_blocks_;
+  spare_blocks_ = block;
+}
+
 phi::Allocation *AutoGrowthBestFitAllocator::AllocateImpl(
     size_t unaligned_size) {
   platform::RecordEvent("AutoGrowthBestFitAllocator::Allocate",
@@ -54,27 +198,11 @@ phi::Allocation *AutoGrowthBestFitAllocator::AllocateImpl(
   VLOG(10) << "Allocate " << unaligned_size << " bytes, aligned to " << size;
 
   std::lock_guard<SpinLock> guard(spinlock_);
-  auto iter = free_blocks_.lower_bound(std::make_pair(size, nullptr));
-  BlockIt block_it;
-  if (iter != free_blocks_.end()) {
-    block_it = iter->second;
-    free_blocks_.erase(iter);
-    auto *chunk = block_it->chunk_;
-    size_t remaining_size = block_it->size_ - size;
+  auto *block = FindFreeBlock(size);
+  if (block != nullptr) {
+    RemoveFreeBlock(block);
     VLOG(10) << "Allocate " << size << " bytes from chunk size "
-             << block_it->size_ << ", remaining " << remaining_size;
-    if (remaining_size == 0) {
-      block_it->is_free_ = false;
-    } else {
-      auto remaining_free_block = chunk->blocks_.insert(
-          block_it, Block(block_it->ptr_, remaining_size, true, chunk));
-      free_blocks_.emplace(std::make_pair(remaining_size, block_it->ptr_),
-                           remaining_free_block);
-      block_it->ptr_ =
-          reinterpret_cast<uint8_t *>(block_it->ptr_) + remaining_size;
-      block_it->size_ = size;
-      block_it->is_free_ = false;
-    }
+             << block->size_ << ", remaining " << block->size_ - size;
   } else {
     if (FLAGS_free_when_no_cache_hit) {
       FreeIdleChunks();
@@ -93,21 +221,36 @@ phi::Allocation *AutoGrowthBestFitAllocator::AllocateImpl(
 
     auto *chunk = &(*chunks_.rbegin());
     realloc_size = chunk->allocation_->size();
-    uint8_t *p = reinterpret_cast<uint8_t *>(chunk->allocation_->ptr());
-    auto &blocks = chunk->blocks_;
+    block = NewBlockHeader();
+    block->ptr_ = chunk->allocation_->ptr();
+    block->size_ = realloc_size;
+    block->chunk_ = chunk;
+    chunk->head_ = block;
+    VLOG(2) << "Not found and reallocate " << realloc_size << "("
+            << block->ptr_ << "), and remaining " << realloc_size - size;
+  }
 
-    size_t remaining_size = realloc_size - size;
-    if (remaining_size > 0) {
-      blocks.emplace_back(p, remaining_size, true, chunk);
-      free_blocks_.emplace(std::make_pair(remaining_size, p), --(blocks.end()));
+  // Split the tail of the block into a new free block.
+  size_t remaining_size = block->size_ - size;
+  if (remaining_size > 0) {
+    auto *remaining_block = NewBlockHeader();
+    remaining_block->ptr_ = reinterpret_cast<uint8_t *>(block->ptr_) + size;
+    remaining_block->size_ = remaining_size;
+    remaining_block->is_free_ = true;
+    remaining_block->chunk_ = block->chunk_;
+    remaining_block->prev_phys_ = block;
+    remaining_block->next_phys_ = block->next_phys_;
+    if (block->next_phys_ != nullptr) {
+      block->next_phys_->prev_phys_ = remaining_block;
     }
-    blocks.emplace_back(p + remaining_size, size, false, chunk);
-    block_it = --(blocks.end());
-    VLOG(2) << "Not found and reallocate " << realloc_size << "("
-            << static_cast<void *>(p) << "), and remaining " << remaining_size;
+    block->next_phys_ = remaining_block;
+    block->size_ = size;
+    InsertFreeBlock(remaining_block);
   }
-  VLOG(10) << "Alloc " << block_it->size_ << " bytes, ptr = " << block_it->ptr_;
-  return new BlockAllocation(block_it);
+  block->is_free_ = false;
+
+  VLOG(10) << "Alloc " << block->size_ << " bytes, ptr = " << block->ptr_;
+  return new BlockAllocation(block);
 }
 
 void AutoGrowthBestFitAllocator::FreeImpl(phi::Allocation *allocation) {
@@ -116,34 +259,34 @@ void AutoGrowthBestFitAllocator::FreeImpl(phi::Allocation *allocation) {
   VLOG(10) << "Free " << allocation->size()
            << " bytes, ptr = " << allocation->ptr();
   std::lock_guard<SpinLock> guard(spinlock_);
-  auto block_it = static_cast<BlockAllocation *>(allocation)->block_it_;
-  auto &blocks = block_it->chunk_->blocks_;
+  auto *block = static_cast<BlockAllocation *>(allocation)->block_;
 
-  block_it->is_free_ = true;
+  block->is_free_ = true;
 
-  if (block_it != blocks.begin()) {
-    auto prev_it = block_it;
-    --prev_it;
-
-    if (prev_it->is_free_) {
-      free_blocks_.erase(std::make_pair(prev_it->size_, prev_it->ptr_));
-      prev_it->size_ += block_it->size_;
-      blocks.erase(block_it);
-      block_it = prev_it;
+  auto *prev = block->prev_phys_;
+  if (prev != nullptr && prev->is_free_) {
+    RemoveFreeBlock(prev);
+    prev->size_ += block->size_;
+    prev->next_phys_ = block->next_phys_;
+    if (block->next_phys_ != nullptr) {
+      block->next_phys_->prev_phys_ = prev;
     }
+    DeleteBlockHeader(block);
+    block = prev;
   }
 
-  auto next_it = block_it;
-  ++next_it;
-
-  if (next_it != blocks.end() && next_it->is_free_) {
-    free_blocks_.erase(std::make_pair(next_it->size_, next_it->ptr_));
-    block_it->size_ += next_it->size_;
-    blocks.erase(next_it);
+  auto *next = block->next_phys_;
+  if (next != nullptr && next->is_free_) {
+    RemoveFreeBlock(next);
+    block->size_ += next->size_;
+    block->next_phys_ = next->next_phys_;
+    if (next->next_phys_ != nullptr) {
+      next->next_phys_->prev_phys_ = block;
+    }
+    DeleteBlockHeader(next);
   }
 
-  free_blocks_.emplace(std::make_pair(block_it->size_, block_it->ptr_),
-                       block_it);
+  InsertFreeBlock(block);
 
   delete allocation;
 
@@ -158,12 +301,12 @@ uint64_t AutoGrowthBestFitAllocator::FreeIdleChunks() {
   }
   uint64_t bytes = 0;
   for (auto chunk_it = chunks_.begin(); chunk_it != chunks_.end();) {
-    auto &blocks = chunk_it->blocks_;
-    if (blocks.size() == 1 && blocks.begin()->is_free_) {
-      auto &block = *blocks.begin();
-      VLOG(2) << "Free chunk with size " << block.size_;
-      bytes += block.size_;
-      free_blocks_.erase(std::make_pair(block.size_, block.ptr_));
+    auto *block = chunk_it->head_;
+    if (block->is_free_ && block->next_phys_ == nullptr) {
+      VLOG(2) << "Free chunk with size " << block->size_;
+      bytes += block->size_;
+      RemoveFreeBlock(block);
+      DeleteBlockHeader(block);
       chunk_it = chunks_.erase(chunk_it);
     } else {
       ++chunk_it;
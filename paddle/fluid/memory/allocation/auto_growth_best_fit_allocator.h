@@ -14,8 +14,9 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <list>
-#include <map>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <utility>
@@ -27,12 +28,26 @@ namespace paddle {
 namespace memory {
 namespace allocation {
 
+// AutoGrowthBestFitAllocator grows its pool by requesting chunks from the
+// underlying allocator and serves requests by splitting the free blocks of
+// these chunks.
+//
+// Free blocks are indexed by a two-level segregated-fit table (TLSF): the
+// first level is the power-of-two size class, the second level divides each
+// class into kSLCount linear subdivisions. A bitmap per level marks which
+// bins are non-empty, so finding a suitable free block, inserting/removing a
+// free block and coalescing a freed block with its physical neighbours are
+// all O(1). Block headers are intrusive (linked with their physical
+// neighbours and with the other blocks of the same bin) and kept in host
+// memory, since the managed memory may not be host-accessible.
 class AutoGrowthBestFitAllocator : public Allocator {
  public:
   AutoGrowthBestFitAllocator(
       const std::shared_ptr<Allocator> &underlying_allocator, size_t alignment,
       size_t chunk_size = 0, bool allow_free_idle_chunk = true);
 
+  ~AutoGrowthBestFitAllocator();
+
   bool IsAllocThreadSafe() const override { return true; }
 
  protected:
@@ -42,25 +57,31 @@ class AutoGrowthBestFitAllocator : public Allocator {
 
   // Release the memory block which is not used in pool.
   uint64_t ReleaseImpl(const platform::Place &place) override {
+    std::lock_guard<SpinLock> guard(spinlock_);
     return FreeIdleChunks();
   }
 
  private:
-  uint64_t FreeIdleChunks();
-
-  template <typename T>
-  using List = std::list<T>;
+  static constexpr size_t kSLBits = 4;
+  static constexpr size_t kSLCount = static_cast<size_t>(1) << kSLBits;
+  static constexpr size_t kFLCount = sizeof(size_t) * 8 - kSLBits + 1;
 
   struct Chunk;
 
   struct Block {
-    Block(void *ptr, size_t size, bool is_free, Chunk *chunk)
-        : ptr_(ptr), size_(size), is_free_(is_free), chunk_(chunk) {}
-
-    void *ptr_;
-    size_t size_;
-    bool is_free_;
-    Chunk *chunk_;  // which chunk it is from
+    void *ptr_{nullptr};
+    size_t size_{0};
+    bool is_free_{false};
+    Chunk *chunk_{nullptr};  // which chunk it is from
+
+    // Physical neighbours inside the same chunk.
+    Block *prev_phys_{nullptr};
+    Block *next_phys_{nullptr};
+
+    // Neighbours inside the same free bin, only valid when is_free_ is true.
+    // next_free_ also links the unused headers in the header pool.
+    Block *prev_free_{nullptr};
+    Block *next_free_{nullptr};
   };
 
   struct Chunk {
@@ -68,27 +89,45 @@ class AutoGrowthBestFitAllocator : public Allocator {
         : allocation_(std::move(allocation)) {}
 
     DecoratedAllocationPtr allocation_;
-    List<Block> blocks_;
+    Block *head_{nullptr};  // the block starting at the chunk base
   };
 
   struct BlockAllocation : public Allocation {
-    explicit BlockAllocation(const List<Block>::iterator &it)
-        : Allocation(it->ptr_, it->chunk_->allocation_->base_ptr(), it->size_,
-                     it->chunk_->allocation_->place()),
-          block_it_(it) {}
+    explicit BlockAllocation(Block *block)
+        : Allocation(block->ptr_, block->chunk_->allocation_->base_ptr(),
+                     block->size_, block->chunk_->allocation_->place()),
+          block_(block) {}
 
-    List<Block>::iterator block_it_;
+    Block *block_;
   };
 
-  using BlockIt = List<Block>::iterator;
+  uint64_t FreeIdleChunks();
+
+  // Map size to the bin it is stored in.
+  static void MappingInsert(size_t size, size_t *fl, size_t *sl);
+  // Map size to the first bin whose blocks are all large enough for size.
+  static void MappingSearch(size_t size, size_t *fl, size_t *sl);
+
+  void InsertFreeBlock(Block *block);
+  void RemoveFreeBlock(Block *block);
+  Block *FindFreeBlock(size_t size);
+
+  Block *NewBlockHeader();
+  void DeleteBlockHeader(Block *block);
 
   std::shared_ptr<Allocator> underlying_allocator_;
-  std::map<std::pair<size_t, void *>, BlockIt> free_blocks_;
   std::list<Chunk> chunks_;
   size_t alignment_;
   size_t chunk_size_;
   bool allow_free_idle_chunk_;
 
+  uint64_t fl_bitmap_{0};
+  std::array<uint32_t, kFLCount> sl_bitmap_{};
+  std::array<std::array<Block *, kSLCount>, kFLCount> free_blocks_{};
+
+  // Unused block headers, linked by next_free_.
+  Block *spare_blocks_{nullptr};
+
   SpinLock spinlock_;
 };
 
@@ -0,0 +1,162 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Allocate/free latency and fragmentation of AutoGrowthBestFitAllocator,
+// compared with BestFitAllocator whose free blocks are indexed by std::map
+// (the index AutoGrowthBestFitAllocator used before the segregated-fit
+// table). Neither allocator touches the memory it manages, so both run on
+// fake addresses and the benchmark only measures the bookkeeping.
+// To use this tool, run command: ./auto_growth_best_fit_allocator_benchmark
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/best_fit_allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// Hands out increasing fake addresses and records the reserved bytes.
+class FakeAddressAllocator : public Allocator {
+ public:
+  size_t ReservedSize() const { return reserved_size_; }
+  size_t PeakReservedSize() const { return peak_reserved_size_; }
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override {
+    reserved_size_ += size;
+    peak_reserved_size_ = std::max(peak_reserved_size_, reserved_size_);
+    auto *ptr = reinterpret_cast<void *>(next_addr_);
+    next_addr_ += size;
+    return new Allocation(ptr, size, platform::CPUPlace());
+  }
+
+  void FreeImpl(phi::Allocation *allocation) override {
+    reserved_size_ -= allocation->size();
+    delete allocation;
+  }
+
+ private:
+  uintptr_t next_addr_{4096};
+  size_t reserved_size_{0};
+  size_t peak_reserved_size_{0};
+};
+
+class StubAllocation : public Allocation {
+ public:
+  explicit StubAllocation(size_t size)
+      : Allocation(0, size, platform::CPUPlace()) {}
+};
+
+struct Request {
+  bool is_alloc;
+  size_t size;   // valid when is_alloc
+  size_t index;  // slot to fill or to free
+};
+
+// A trace mixing many small activations with occasional large buffers and
+// random lifetimes, similar to what an executor produces in one step.
+static std::vector<Request> MakeTrace(size_t num_requests, size_t max_live) {
+  std::mt19937 gen(2022);
+  std::uniform_int_distribution<size_t> small_dist(1, 64 << 10);
+  std::uniform_int_distribution<size_t> large_dist(1 << 20, 16 << 20);
+  std::vector<Request> trace;
+  std::vector<size_t> live;
+  for (size_t i = 0; i < num_requests; ++i) {
+    if (live.size() < max_live && (live.empty() || gen() % 2 == 0)) {
+      size_t size = (gen() % 16 == 0) ? large_dist(gen) : small_dist(gen);
+      trace.push_back({true, size, i});
+      live.push_back(i);
+    } else {
+      size_t pos = gen() % live.size();
+      trace.push_back({false, 0, live[pos]});
+      live[pos] = live.back();
+      live.pop_back();
+    }
+  }
+  return trace;
+}
+
+struct BenchmarkResult {
+  double ns_per_op;
+  size_t peak_requested;
+};
+
+static BenchmarkResult RunTrace(Allocator *allocator,
+                                const std::vector<Request> &trace,
+                                size_t alignment) {
+  std::vector<AllocationPtr> slots(trace.size());
+  size_t requested = 0, peak_requested = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto &req : trace) {
+    if (req.is_alloc) {
+      slots[req.index] = allocator->Allocate(req.size);
+      requested += AlignedSize(req.size, alignment);
+      peak_requested = std::max(peak_requested, requested);
+    } else {
+      requested -= AlignedSize(slots[req.index]->size(), alignment);
+      slots[req.index].reset();
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  slots.clear();
+  double ns =
+      std::chrono::duration<double, std::nano>(end - start).count() /
+      trace.size();
+  return {ns, peak_requested};
+}
+
+static void BenchmarkLatencyAndFragmentation() {
+  constexpr size_t kAlignment = 256;
+  constexpr size_t kChunkSize = 64 << 20;
+  auto trace = MakeTrace(1000000, 2000);
+
+  auto fake_allocator = std::make_shared<FakeAddressAllocator>();
+  AutoGrowthBestFitAllocator ag_allocator(fake_allocator, kAlignment,
+                                          kChunkSize);
+  auto ag_result = RunTrace(&ag_allocator, trace, kAlignment);
+  double ag_fragmentation =
+      static_cast<double>(fake_allocator->PeakReservedSize()) /
+      ag_result.peak_requested;
+
+  StubAllocation stub(64ULL * 1024 * 1024 * 1024);
+  BestFitAllocator bf_allocator(&stub);
+  auto bf_result = RunTrace(&bf_allocator, trace, 1);
+
+  LOG(INFO) << "AutoGrowthBestFitAllocator: " << ag_result.ns_per_op
+            << " ns/op, peak reserved / peak requested = " << ag_fragmentation;
+  LOG(INFO) << "BestFitAllocator(std::map index): " << bf_result.ns_per_op
+            << " ns/op";
+
+  ag_allocator.Release(platform::CPUPlace());
+  CHECK_EQ(fake_allocator->ReservedSize(), 0UL);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_logtostderr = true;
+  paddle::memory::allocation::BenchmarkLatencyAndFragmentation();
+  return 0;
+}
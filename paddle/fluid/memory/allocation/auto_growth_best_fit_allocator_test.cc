@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cstdlib>
+#include <vector>
 
 #include "paddle/fluid/memory/allocation/aligned_allocator.h"
 #include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
@@ -171,6 +172,130 @@ TEST(test_auto_growth_allocator, test_free_when_no_cache_hit) {
   TestFreeWhenNoCacheHit(true);
 }
 
+static std::shared_ptr<AutoGrowthBestFitAllocator> NewRecordedAGAllocator(
+    const std::shared_ptr<RecordedAllocator> &recorded_allocator,
+    size_t chunk_size) {
+  FLAGS_free_idle_chunk = false;
+  FLAGS_free_when_no_cache_hit = false;
+  return std::make_shared<AutoGrowthBestFitAllocator>(recorded_allocator, 256,
+                                                      chunk_size);
+}
+
+static uint8_t *Ptr(const AllocationPtr &allocation) {
+  return reinterpret_cast<uint8_t *>(allocation->ptr());
+}
+
+TEST(test_auto_growth_allocator, test_split_and_coalesce) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto ag_allocator = NewRecordedAGAllocator(recorded_allocator, 1 << 16);
+
+  // All three blocks are split from the head of the same chunk.
+  auto a = ag_allocator->Allocate(1000);
+  auto b = ag_allocator->Allocate(2000);
+  auto c = ag_allocator->Allocate(256);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 1UL << 16);
+  ASSERT_EQ(a->size(), 1024UL);
+  ASSERT_EQ(b->size(), 2048UL);
+  ASSERT_EQ(Ptr(b), Ptr(a) + 1024);
+  ASSERT_EQ(Ptr(c), Ptr(a) + 3072);
+  uint8_t *base = Ptr(a);
+
+  // The freed block is reused in place.
+  b.reset();
+  b = ag_allocator->Allocate(2048);
+  ASSERT_EQ(Ptr(b), base + 1024);
+
+  // Freeing two neighbours coalesces them into one block.
+  a.reset();
+  b.reset();
+  auto ab = ag_allocator->Allocate(3072);
+  ASSERT_EQ(Ptr(ab), base);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 1UL << 16);
+
+  // Freeing everything coalesces the whole chunk, so it can be released.
+  ab.reset();
+  c.reset();
+  ASSERT_EQ(ag_allocator->Release(platform::CPUPlace()), 1UL << 16);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0UL);
+}
+
+TEST(test_auto_growth_allocator, test_search_across_size_classes) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto ag_allocator = NewRecordedAGAllocator(recorded_allocator, 1 << 20);
+
+  // The separators keep the freed blocks from coalescing.
+  auto small = ag_allocator->Allocate(1024);
+  auto sep0 = ag_allocator->Allocate(256);
+  auto large = ag_allocator->Allocate(1 << 16);
+  auto sep1 = ag_allocator->Allocate(256);
+  uint8_t *small_ptr = Ptr(small);
+  uint8_t *large_ptr = Ptr(large);
+  small.reset();
+  large.reset();
+
+  // No free block in the size class of 2048, the smallest block of a larger
+  // class is taken instead of the tail of the chunk.
+  auto mid = ag_allocator->Allocate(2048);
+  ASSERT_EQ(Ptr(mid), large_ptr);
+  // An exact fit is taken from its own bin.
+  small = ag_allocator->Allocate(1024);
+  ASSERT_EQ(Ptr(small), small_ptr);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 1UL << 20);
+}
+
+TEST(test_auto_growth_allocator, test_alignment) {
+  FLAGS_free_idle_chunk = false;
+  FLAGS_free_when_no_cache_hit = false;
+  size_t alignment = 256;
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto underlying_allocator =
+      std::make_shared<AlignedAllocator>(recorded_allocator, alignment);
+  auto ag_allocator = std::make_shared<AutoGrowthBestFitAllocator>(
+      underlying_allocator, alignment, 1 << 20);
+
+  std::vector<AllocationPtr> allocations;
+  for (size_t size : {1, 255, 256, 257, 1000, 4097, 100000}) {
+    allocations.emplace_back(ag_allocator->Allocate(size));
+    auto &allocation = allocations.back();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(allocation->ptr()) % alignment, 0UL);
+    ASSERT_EQ(allocation->size(), AlignedSize(size, alignment));
+  }
+}
+
+TEST(test_auto_growth_allocator, test_release_only_free_chunks) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto ag_allocator = NewRecordedAGAllocator(recorded_allocator, 4096);
+
+  auto a = ag_allocator->Allocate(4096);  // fills a chunk
+  auto b = ag_allocator->Allocate(8192);  // a chunk larger than chunk_size
+  auto c = ag_allocator->Allocate(256);   // a partially used chunk
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 16384UL);
+
+  b.reset();
+  ASSERT_EQ(ag_allocator->Release(platform::CPUPlace()), 8192UL);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 8192UL);
+
+  // The chunk of c has a free tail but is still in use.
+  ASSERT_EQ(ag_allocator->Release(platform::CPUPlace()), 0UL);
+  c.reset();
+  ASSERT_EQ(ag_allocator->Release(platform::CPUPlace()), 4096UL);
+  a.reset();
+  ASSERT_EQ(ag_allocator->Release(platform::CPUPlace()), 4096UL);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 0UL);
+}
+
+TEST(test_auto_growth_allocator, test_not_allow_free_idle_chunk) {
+  FLAGS_free_idle_chunk = false;
+  FLAGS_free_when_no_cache_hit = false;
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto ag_allocator = std::make_shared<AutoGrowthBestFitAllocator>(
+      recorded_allocator, 256, 4096, /*allow_free_idle_chunk=*/false);
+
+  ag_allocator->Allocate(4096).reset();
+  ASSERT_EQ(ag_allocator->Release(platform::CPUPlace()), 0UL);
+  ASSERT_EQ(recorded_allocator->AllocatedSize(), 4096UL);
+}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
@@ -19,6 +19,8 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <random>
 #include <string>
 
@@ -250,6 +252,38 @@ std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
   return std::make_shared<MemoryMapReaderAllocation>(ptr, size, ipc_name);
 }
 
+MappedFile::MappedFile(const std::string &filename) : filename_(filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(
+      fd, -1,
+      platform::errors::Unavailable("Failed to open the file %s to map.",
+                                    filename));
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    close(fd);
+    PADDLE_THROW(platform::errors::Unavailable("Failed to get the size of %s.",
+                                               filename));
+  }
+  size_ = file_stat.st_size;
+  if (size_ == 0) {
+    close(fd);
+    PADDLE_THROW(
+        platform::errors::InvalidArgument("The file %s is empty.", filename));
+  }
+  ptr_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(
+      ptr_, MAP_FAILED,
+      platform::errors::Unavailable("Failed to map the file %s.", filename));
+  VLOG(3) << "Map " << size_ << " bytes of " << filename;
+}
+
+MappedFile::~MappedFile() {
+  if (munmap(ptr_, size_) == -1) {
+    LOG(WARNING) << "Failed to unmap the file " << filename_;
+  }
+}
+
 MemoryMapFdSet &MemoryMapFdSet::Instance() {  // NOLINT
   static MemoryMapFdSet set;
   return set;
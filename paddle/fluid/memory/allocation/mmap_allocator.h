@@ -131,6 +131,39 @@ std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
 std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
     const std::string &ipc_name, size_t size);
 
+// A private mapping of a whole file. Its pages are shared with the page cache
+// and the other processes mapping the file until they are written, the
+// written pages are copied and never reach the file.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &filename);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  char *data() const { return static_cast<char *>(ptr_); }
+  size_t size() const { return size_; }
+  const std::string &filename() const { return filename_; }
+
+ private:
+  std::string filename_;
+  void *ptr_ = nullptr;
+  size_t size_ = 0;
+};
+
+// A region of a MappedFile, the file stays mapped while any region is used.
+class MmapAllocation : public Allocation {
+ public:
+  MmapAllocation(std::shared_ptr<MappedFile> file, size_t offset, size_t size)
+      : Allocation(file->data() + offset, size, platform::CPUPlace()),
+        file_(std::move(file)) {}
+
+  const std::shared_ptr<MappedFile> &file() const { return file_; }
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+};
+
 class MemoryMapFdSet {
  public:
   static MemoryMapFdSet &Instance();  // NOLINT
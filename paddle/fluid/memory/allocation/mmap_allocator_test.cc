@@ -16,6 +16,10 @@
 
 #include "paddle/fluid/memory/allocation/mmap_allocator.h"
 
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace paddle {
@@ -45,6 +49,39 @@ TEST(MemoryMapAllocation, test_allocation_base) {
   }
 }
 
+TEST(MappedFile, test_copy_on_write) {
+  std::string filename = "mapped_file_test.bin";
+  std::vector<int32_t> values(1024);
+  for (int32_t i = 0; i < 1024; ++i) {
+    values[i] = i;
+  }
+  {
+    std::ofstream fout(filename, std::ios::binary);
+    fout.write(reinterpret_cast<const char *>(values.data()),
+               values.size() * sizeof(int32_t));
+  }
+
+  auto file = std::make_shared<MappedFile>(filename);
+  ASSERT_EQ(file->size(), values.size() * sizeof(int32_t));
+  // the allocation of the second half keeps the file mapped
+  auto allocation = std::make_shared<MmapAllocation>(
+      file, 512 * sizeof(int32_t), 512 * sizeof(int32_t));
+  file.reset();
+  auto *ptr = static_cast<int32_t *>(allocation->ptr());
+  for (int32_t i = 0; i < 512; ++i) {
+    ASSERT_EQ(ptr[i], 512 + i);
+  }
+  // the written pages are private
+  ptr[0] = -1;
+  std::vector<int32_t> loaded(1024);
+  std::ifstream fin(filename, std::ios::binary);
+  fin.read(reinterpret_cast<char *>(loaded.data()),
+           loaded.size() * sizeof(int32_t));
+  ASSERT_EQ(loaded, values);
+  allocation.reset();
+  std::remove(filename.c_str());
+}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
@@ -0,0 +1,90 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/platform/profiler/event_tracing.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// StatAllocator counts the allocated bytes of the underlying allocator and
+// emits a memory event for every allocation and free, so that the profiler
+// can attribute memory to the innermost running operator and draw a memory
+// timeline.
+class StatAllocator : public Allocator {
+ public:
+  explicit StatAllocator(std::shared_ptr<Allocator> underlying_allocator)
+      : underlying_allocator_(std::move(underlying_allocator)) {}
+
+  bool IsAllocThreadSafe() const override {
+    return underlying_allocator_->IsAllocThreadSafe();
+  }
+
+  uint64_t AllocatedSize() const {
+    return allocated_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t PeakAllocatedSize() const {
+    return peak_allocated_.load(std::memory_order_relaxed);
+  }
+
+ protected:
+  void FreeImpl(phi::Allocation* allocation) override {
+    uint64_t size = allocation->size();
+    uint64_t allocated =
+        allocated_.fetch_sub(size, std::memory_order_relaxed) - size;
+    platform::RecordMemEvent(allocation->ptr(), allocation->place(), size,
+                             allocated, PeakAllocatedSize(),
+                             platform::TracerMemEventType::Free);
+    underlying_allocator_->Free(allocation);
+  }
+
+  phi::Allocation* AllocateImpl(size_t size) override {
+    phi::Allocation* allocation =
+        underlying_allocator_->Allocate(size).release();
+    uint64_t real_size = allocation->size();
+    uint64_t allocated =
+        allocated_.fetch_add(real_size, std::memory_order_relaxed) +
+        real_size;
+    uint64_t peak = peak_allocated_.load(std::memory_order_relaxed);
+    while (allocated > peak &&
+           !peak_allocated_.compare_exchange_weak(peak, allocated,
+                                                  std::memory_order_relaxed)) {
+    }
+    platform::RecordMemEvent(allocation->ptr(), allocation->place(),
+                             real_size, allocated, PeakAllocatedSize(),
+                             platform::TracerMemEventType::Allocate);
+    return allocation;
+  }
+
+  uint64_t ReleaseImpl(const platform::Place& place) override {
+    return underlying_allocator_->Release(place);
+  }
+
+ private:
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::atomic<uint64_t> allocated_{0};
+  std::atomic<uint64_t> peak_allocated_{0};
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
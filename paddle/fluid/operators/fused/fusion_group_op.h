@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <string>
 #include <vector>
+#include "paddle/fluid/framework/ir/fusion_group/cpu_elementwise_kernel.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_code.h"
 
@@ -36,6 +37,24 @@ static void MutableMultiTypeData(
   }
 }
 
+static void LaunchFusionGroup(const platform::CPUDeviceContext& dev_ctx,
+                              const std::string& func_name, size_t n,
+                              std::vector<void*>* args) {
+  framework::ir::fusion_group::CPUElementwiseKernelPool::Instance()
+      .Get(func_name)
+      ->Launch(dev_ctx, n, args);
+}
+
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+static void LaunchFusionGroup(const platform::CUDADeviceContext& dev_ctx,
+                              const std::string& func_name, size_t n,
+                              std::vector<void*>* args) {
+  platform::DeviceCode* dev_code =
+      platform::DeviceCodePool::Instance().Get(dev_ctx.GetPlace(), func_name);
+  dev_code->Launch(n, args);
+}
+#endif
+
 template <typename DeviceContext, typename T>
 class FusionGroupKernel : public framework::OpKernel<T> {
  public:
@@ -54,8 +73,6 @@ class FusionGroupKernel : public framework::OpKernel<T> {
     MutableMultiTypeData(&outs, outs_dtype, place);
 
     std::string func_name = ctx.Attr<std::string>("func_name");
-    platform::DeviceCode* dev_code =
-        platform::DeviceCodePool::Instance().Get(place, func_name);
     VLOG(3) << "func_name: " << func_name;
 
     if (type == 0) {
@@ -83,7 +100,8 @@ class FusionGroupKernel : public framework::OpKernel<T> {
         }
         args.push_back(&ptrs[num_ins + j]);
       }
-      dev_code->Launch(n, &args);
+      LaunchFusionGroup(ctx.template device_context<DeviceContext>(),
+                        func_name, n, &args);
     }
   }
 };
@@ -0,0 +1,305 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fusion_int8_conv2d_op.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "paddle/fluid/operators/conv_op.h"
+#include "paddle/phi/kernels/funcs/cpu_int8_gemm.h"
+
+namespace paddle {
+namespace operators {
+
+// Updates the paddings to the 4 sides and the dilations of the input of
+// data_dims, as conv2d does.
+static void Int8ConvPaddings(const std::vector<int>& filter_shape,
+                             const std::vector<int>& strides,
+                             const std::string& padding_algorithm,
+                             const framework::DDim& data_dims,
+                             std::vector<int>* paddings,
+                             std::vector<int>* dilations) {
+  UpdatePaddingAndDilation(paddings, dilations, padding_algorithm, data_dims,
+                           strides,
+                           std::vector<int>{filter_shape[2], filter_shape[3]});
+}
+
+void FusionInt8Conv2DOp::InferShape(framework::InferShapeContext* ctx) const {
+  OP_INOUT_CHECK(ctx->HasInput("Input"), "Input", "Input",
+                 "FusionInt8Conv2D");
+  OP_INOUT_CHECK(ctx->HasInput("Filter"), "Input", "Filter",
+                 "FusionInt8Conv2D");
+  OP_INOUT_CHECK(ctx->HasInput("WeightSum"), "Input", "WeightSum",
+                 "FusionInt8Conv2D");
+  OP_INOUT_CHECK(ctx->HasOutput("Output"), "Output", "Output",
+                 "FusionInt8Conv2D");
+
+  auto in_dims = ctx->GetInputDim("Input");
+  auto& filter_shape = ctx->Attrs().Get<std::vector<int>>("filter_shape");
+  auto& strides = ctx->Attrs().Get<std::vector<int>>("strides");
+  int groups = ctx->Attrs().Get<int>("groups");
+  PADDLE_ENFORCE_EQ(
+      in_dims.size(), 4,
+      platform::errors::InvalidArgument(
+          "The Input of fusion_int8_conv2d is expected to be a 4-D tensor "
+          "in NCHW, but received Input's shape is %s.",
+          in_dims));
+  PADDLE_ENFORCE_EQ(
+      filter_shape.size(), 4UL,
+      platform::errors::InvalidArgument(
+          "The attribute filter_shape of fusion_int8_conv2d is expected to "
+          "hold 4 dimensions, but received %d.",
+          filter_shape.size()));
+  PADDLE_ENFORCE_EQ(
+      groups > 0 && filter_shape[0] % groups == 0, true,
+      platform::errors::InvalidArgument(
+          "The output channels %d of fusion_int8_conv2d are expected to be "
+          "divided by the groups %d.",
+          filter_shape[0], groups));
+  if (in_dims[1] > 0) {
+    PADDLE_ENFORCE_EQ(
+        in_dims[1], filter_shape[1] * groups,
+        platform::errors::InvalidArgument(
+            "The input channels of fusion_int8_conv2d are expected to be "
+            "filter_shape[1] * groups = %d, but received Input's shape is "
+            "%s.",
+            filter_shape[1] * groups, in_dims));
+  }
+  const int64_t oc = filter_shape[0];
+  const int64_t oc_per_group = oc / groups;
+  const int64_t k = static_cast<int64_t>(filter_shape[1]) * filter_shape[2] *
+                    filter_shape[3];
+  PADDLE_ENFORCE_EQ(
+      ctx->GetInputDim("Filter"),
+      phi::make_ddim({groups * phi::funcs::CpuInt8PaddedK(k),
+                      phi::funcs::CpuInt8PaddedN(oc_per_group)}),
+      platform::errors::InvalidArgument(
+          "The Filter of fusion_int8_conv2d is expected to hold the %d "
+          "packed groups of filter_shape, but received Filter's shape is %s.",
+          groups, ctx->GetInputDim("Filter")));
+  PADDLE_ENFORCE_EQ(
+      ctx->GetInputDim("WeightSum"), phi::make_ddim({oc}),
+      platform::errors::InvalidArgument(
+          "The WeightSum of fusion_int8_conv2d is expected to be [%d], but "
+          "received %s.",
+          oc, ctx->GetInputDim("WeightSum")));
+  PADDLE_ENFORCE_EQ(
+      ctx->Attrs().Get<std::vector<float>>("weight_scale").size(),
+      static_cast<size_t>(oc),
+      platform::errors::InvalidArgument(
+          "The size of the attribute weight_scale of fusion_int8_conv2d is "
+          "expected to be the output channels %d.",
+          oc));
+  if (ctx->HasInput("Bias")) {
+    PADDLE_ENFORCE_EQ(
+        phi::product(ctx->GetInputDim("Bias")), oc,
+        platform::errors::InvalidArgument(
+            "The size of input Bias of fusion_int8_conv2d is expected to be "
+            "the output channels %d, but received Bias's shape is %s.",
+            oc, ctx->GetInputDim("Bias")));
+  }
+
+  auto paddings = ctx->Attrs().Get<std::vector<int>>("paddings");
+  auto dilations = ctx->Attrs().Get<std::vector<int>>("dilations");
+  auto data_dims = phi::slice_ddim(in_dims, 2, 4);
+  Int8ConvPaddings(filter_shape, strides,
+                   ctx->Attrs().Get<std::string>("padding_algorithm"),
+                   data_dims, &paddings, &dilations);
+  std::vector<int64_t> output_shape({in_dims[0], oc});
+  for (int i = 0; i < 2; ++i) {
+    if (!ctx->IsRuntime() && data_dims[i] <= 0) {
+      output_shape.push_back(-1);
+    } else {
+      output_shape.push_back(ConvOutputSize(
+          data_dims[i], filter_shape[i + 2], dilations[i], paddings[2 * i],
+          paddings[2 * i + 1], strides[i]));
+    }
+  }
+  ctx->SetOutputDim("Output", phi::make_ddim(output_shape));
+}
+
+framework::OpKernelType FusionInt8Conv2DOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return framework::OpKernelType(
+      OperatorWithKernel::IndicateVarDataType(ctx, "Input"), ctx.GetPlace());
+}
+
+void FusionInt8Conv2DOpMaker::Make() {
+  AddInput("Input", "(Tensor) The float input of the conv2d op in NCHW.");
+  AddInput("Filter",
+           "(Tensor) The int8 filters of the groups, every group is the "
+           "matrix of (C / groups * KH * KW, M / groups) packed by "
+           "CpuInt8PackWeight.");
+  AddInput("WeightSum", "(Tensor) The int32 sums of the M filters.");
+  AddInput("Bias", "(Tensor, optional) The float bias of shape (M).")
+      .AsDispensable();
+  AddOutput("Output", "(Tensor) The float output of the op in NCHW.");
+  AddAttr<std::vector<int>>(
+      "filter_shape",
+      "(vector<int>) The shape (M, C / groups, KH, KW) of the filters.");
+  AddAttr<std::vector<int>>("strides", "(vector<int> default:{1, 1}).")
+      .SetDefault({1, 1});
+  AddAttr<std::vector<int>>("paddings", "(vector<int> default:{0, 0}).")
+      .SetDefault({0, 0});
+  AddAttr<std::string>("padding_algorithm",
+                       "(string, default \"EXPLICIT\") \"EXPLICIT\", "
+                       "\"SAME\" or \"VALID\".")
+      .SetDefault("EXPLICIT");
+  AddAttr<std::vector<int>>("dilations", "(vector<int> default:{1, 1}).")
+      .SetDefault({1, 1});
+  AddAttr<int>("groups", "(int default:1).").SetDefault(1);
+  AddAttr<float>("Input_scale",
+                 "(float) The scale of the input, the int8 input is "
+                 "round(Input / Input_scale) clipped to [-127, 127].");
+  AddAttr<std::vector<float>>(
+      "weight_scale", "(vector<float>) The scales of the M filters.");
+  AddComment(R"DOC(
+  Fusion Int8 Conv2D Operator.
+
+  The conv2d op of the quantized models on CPU without oneDNN. The input is
+  quantized to int8 with Input_scale and unfolded to the rows of the output
+  pixels, multiplied by the int8 filters into int32, and the output channel
+  j is dequantized with Input_scale * weight_scale[j] before the bias.
+)DOC");
+}
+
+template <typename T>
+class FusionInt8Conv2DKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto* input = ctx.Input<Tensor>("Input");
+    auto* filter = ctx.Input<Tensor>("Filter");
+    auto* weight_sum = ctx.Input<Tensor>("WeightSum");
+    auto* bias = ctx.Input<Tensor>("Bias");
+    auto* output = ctx.Output<Tensor>("Output");
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    auto place = ctx.GetPlace();
+
+    auto filter_shape = ctx.Attr<std::vector<int>>("filter_shape");
+    auto strides = ctx.Attr<std::vector<int>>("strides");
+    const int groups = ctx.Attr<int>("groups");
+    auto paddings = ctx.Attr<std::vector<int>>("paddings");
+    auto dilations = ctx.Attr<std::vector<int>>("dilations");
+    Int8ConvPaddings(filter_shape, strides,
+                     ctx.Attr<std::string>("padding_algorithm"),
+                     phi::slice_ddim(input->dims(), 2, 4), &paddings,
+                     &dilations);
+
+    const int64_t batch = input->dims()[0];
+    const int64_t channels = input->dims()[1];
+    const int64_t height = input->dims()[2];
+    const int64_t width = input->dims()[3];
+    const int64_t out_h = output->dims()[2];
+    const int64_t out_w = output->dims()[3];
+    const int64_t pixels = out_h * out_w;
+    const int64_t oc = filter_shape[0];
+    const int64_t ic_per_group = filter_shape[1];
+    const int64_t kh = filter_shape[2];
+    const int64_t kw = filter_shape[3];
+    const int64_t oc_per_group = oc / groups;
+    const int64_t k = ic_per_group * kh * kw;
+    const int64_t padded_k = phi::funcs::CpuInt8PaddedK(k);
+    const int64_t group_size = phi::funcs::CpuInt8PackedSize(k, oc_per_group);
+
+    const float input_scale = ctx.Attr<float>("Input_scale");
+    auto weight_scale = ctx.Attr<std::vector<float>>("weight_scale");
+    std::vector<float> scale(oc);
+    for (int64_t j = 0; j < oc; ++j) {
+      scale[j] = input_scale * weight_scale[j];
+    }
+
+    Tensor quantized, cols, acc;
+    quantized.Resize({channels * height * width});
+    cols.Resize({pixels, padded_k});
+    acc.Resize({pixels, oc_per_group});
+    uint8_t* image = quantized.mutable_data<uint8_t>(place);
+    uint8_t* col_data = cols.mutable_data<uint8_t>(place);
+    int32_t* c = acc.mutable_data<int32_t>(place);
+    const int8_t* w = filter->data<int8_t>();
+    const int32_t* sum = weight_sum->data<int32_t>();
+    const T* bias_data = bias ? bias->data<T>() : nullptr;
+    T* out = output->mutable_data<T>(place);
+    // the padding of the input is the int8 zero
+    const uint8_t zero = static_cast<uint8_t>(phi::funcs::kCpuInt8Shift);
+    const int64_t grain = std::max<int64_t>(1, 4096 / padded_k);
+
+    for (int64_t b = 0; b < batch; ++b) {
+      const T* x = input->data<T>() + b * channels * height * width;
+      dev_ctx.ParallelFor(
+          0, channels, 1, [&](int64_t begin, int64_t end) {
+            phi::funcs::CpuInt8Quantize(x + begin * height * width,
+                                        (end - begin) * height * width,
+                                        input_scale,
+                                        image + begin * height * width);
+          });
+      for (int g = 0; g < groups; ++g) {
+        const uint8_t* group_image = image + g * ic_per_group * height * width;
+        // the row of an output pixel holds its inputs in the order of the
+        // filter, (channel, kh, kw)
+        dev_ctx.ParallelFor(0, pixels, grain, [&](int64_t begin, int64_t end) {
+          for (int64_t p = begin; p < end; ++p) {
+            const int64_t oh = p / out_w;
+            const int64_t ow = p % out_w;
+            uint8_t* row = col_data + p * padded_k;
+            for (int64_t ci = 0; ci < ic_per_group; ++ci) {
+              const uint8_t* plane = group_image + ci * height * width;
+              for (int64_t i = 0; i < kh; ++i) {
+                const int64_t ih = oh * strides[0] - paddings[0] +
+                                   i * dilations[0];
+                for (int64_t j = 0; j < kw; ++j) {
+                  const int64_t iw = ow * strides[1] - paddings[2] +
+                                     j * dilations[1];
+                  *row++ = (ih >= 0 && ih < height && iw >= 0 && iw < width)
+                               ? plane[ih * width + iw]
+                               : zero;
+                }
+              }
+            }
+            std::fill(row, col_data + (p + 1) * padded_k, zero);
+          }
+        });
+        phi::funcs::CpuInt8Gemm(dev_ctx, col_data, padded_k,
+                                w + g * group_size, pixels, oc_per_group, k,
+                                c, oc_per_group);
+        T* group_out = out + (b * oc + g * oc_per_group) * pixels;
+        dev_ctx.ParallelFor(
+            0, oc_per_group, 1, [&](int64_t begin, int64_t end) {
+              for (int64_t j = begin; j < end; ++j) {
+                const int64_t channel = g * oc_per_group + j;
+                const int32_t compensation =
+                    phi::funcs::kCpuInt8Shift * sum[channel];
+                const T channel_bias = bias_data ? bias_data[channel] : 0;
+                T* plane = group_out + j * pixels;
+                for (int64_t p = 0; p < pixels; ++p) {
+                  plane[p] = static_cast<T>(c[p * oc_per_group + j] -
+                                            compensation) *
+                                 scale[channel] +
+                             channel_bias;
+                }
+              }
+            });
+      }
+    }
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(fusion_int8_conv2d, ops::FusionInt8Conv2DOp,
+                  ops::FusionInt8Conv2DOpMaker);
+
+REGISTER_OP_CPU_KERNEL(fusion_int8_conv2d,
+                       ops::FusionInt8Conv2DKernel<float>);
@@ -0,0 +1,199 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fusion_int8_fc_op.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "paddle/phi/kernels/funcs/cpu_int8_gemm.h"
+
+namespace paddle {
+namespace operators {
+
+void FusionInt8FCOp::InferShape(framework::InferShapeContext* ctx) const {
+  OP_INOUT_CHECK(ctx->HasInput("Input"), "Input", "Input", "FusionInt8FC");
+  OP_INOUT_CHECK(ctx->HasInput("W"), "Input", "W", "FusionInt8FC");
+  OP_INOUT_CHECK(ctx->HasInput("WeightSum"), "Input", "WeightSum",
+                 "FusionInt8FC");
+  OP_INOUT_CHECK(ctx->HasOutput("Out"), "Output", "Out", "FusionInt8FC");
+
+  auto in_dims = ctx->GetInputDim("Input");
+  auto w_dims = ctx->GetInputDim("W");
+  auto sum_dims = ctx->GetInputDim("WeightSum");
+  int in_num_col_dims = ctx->Attrs().Get<int>("in_num_col_dims");
+  PADDLE_ENFORCE_LT(
+      in_num_col_dims, in_dims.size(),
+      platform::errors::InvalidArgument(
+          "The attribute in_num_col_dims of fusion_int8_fc is expected to be "
+          "less than the number of Input's dimensions. But received "
+          "in_num_col_dims is %d, Input's shape is %s.",
+          in_num_col_dims, in_dims));
+  PADDLE_ENFORCE_EQ(
+      sum_dims.size(), 1,
+      platform::errors::InvalidArgument(
+          "The input WeightSum of fusion_int8_fc is expected to be a 1-D "
+          "tensor, but received WeightSum's shape is %s.",
+          sum_dims));
+  int64_t n = sum_dims[0];
+  auto& weight_scale = ctx->Attrs().Get<std::vector<float>>("weight_scale");
+  PADDLE_ENFORCE_EQ(
+      static_cast<int64_t>(weight_scale.size()), n,
+      platform::errors::InvalidArgument(
+          "The size of the attribute weight_scale of fusion_int8_fc is "
+          "expected to be the width of W %d, but received %d.",
+          n, weight_scale.size()));
+  if (ctx->HasInput("Bias")) {
+    auto bias_dims = ctx->GetInputDim("Bias");
+    PADDLE_ENFORCE_EQ(
+        phi::product(bias_dims), n,
+        platform::errors::InvalidArgument(
+            "The size of input Bias of fusion_int8_fc is expected to be the "
+            "width of W %d, but received Bias's shape is %s.",
+            n, bias_dims));
+  }
+  auto& activation_type = ctx->Attrs().Get<std::string>("activation_type");
+  PADDLE_ENFORCE_EQ(
+      activation_type.empty() || activation_type == "relu", true,
+      platform::errors::InvalidArgument(
+          "The attribute activation_type of fusion_int8_fc is expected to be "
+          "empty or \"relu\", but received %s.",
+          activation_type));
+
+  int64_t k = phi::product(phi::slice_ddim(in_dims, in_num_col_dims,
+                                           in_dims.size()));
+  if (k > 0) {
+    PADDLE_ENFORCE_EQ(
+        w_dims, phi::make_ddim({phi::funcs::CpuInt8PaddedK(k),
+                                phi::funcs::CpuInt8PaddedN(n)}),
+        platform::errors::InvalidArgument(
+            "The packed W of fusion_int8_fc is expected to be [%d, %d] for "
+            "the %d input columns and the %d output columns, but received "
+            "W's shape is %s.",
+            phi::funcs::CpuInt8PaddedK(k), phi::funcs::CpuInt8PaddedN(n), k,
+            n, w_dims));
+  }
+
+  std::vector<int64_t> output_dims;
+  for (int i = 0; i < in_num_col_dims; ++i) {
+    output_dims.push_back(in_dims[i]);
+  }
+  output_dims.push_back(n);
+  ctx->SetOutputDim("Out", phi::make_ddim(output_dims));
+  ctx->ShareLoD("Input", "Out");
+}
+
+framework::OpKernelType FusionInt8FCOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return framework::OpKernelType(
+      OperatorWithKernel::IndicateVarDataType(ctx, "Input"), ctx.GetPlace());
+}
+
+void FusionInt8FCOpMaker::Make() {
+  AddInput("Input", "(LoDTensor) The float input of the fully connected op.");
+  AddInput("W",
+           "(Tensor) The int8 weight of shape (I, O) packed by "
+           "CpuInt8PackWeight, its shape is (I, O) padded to the blocks "
+           "of the packing.");
+  AddInput("WeightSum", "(Tensor) The int32 sums of the O columns of W.");
+  AddInput("Bias", "(Tensor, optional) The float bias of shape (O).")
+      .AsDispensable();
+  AddOutput("Out", "(LoDTensor) The float output of the op.");
+  AddAttr<int>("in_num_col_dims",
+               "(int, default 1), The dimensions of Input flattened to the "
+               "rows of the input matrix, the others to its columns.")
+      .SetDefault(1);
+  AddAttr<float>("Input_scale",
+                 "(float) The scale of the input, the int8 input is "
+                 "round(Input / Input_scale) clipped to [-127, 127].");
+  AddAttr<std::vector<float>>(
+      "weight_scale",
+      "(vector<float>) The scales of the O output channels of W.");
+  AddAttr<std::string>("activation_type",
+                       "(string, default \"\") Activation type, empty or "
+                       "\"relu\".")
+      .SetDefault("");
+  AddComment(R"DOC(
+  Fusion Int8 FC Operator.
+
+  The fully connected op of the quantized models on CPU without oneDNN. The
+  input is quantized to int8 with Input_scale, multiplied by the int8 weight
+  into int32, and the output channel j is dequantized with
+  Input_scale * weight_scale[j] before the bias and the activation.
+)DOC");
+}
+
+template <typename T>
+class FusionInt8FCKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto* input = ctx.Input<LoDTensor>("Input");
+    auto* w = ctx.Input<Tensor>("W");
+    auto* weight_sum = ctx.Input<Tensor>("WeightSum");
+    auto* bias = ctx.Input<Tensor>("Bias");
+    auto* out = ctx.Output<LoDTensor>("Out");
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    auto place = ctx.GetPlace();
+
+    auto in_mat_dims =
+        phi::flatten_to_2d(input->dims(), ctx.Attr<int>("in_num_col_dims"));
+    const int64_t m = in_mat_dims[0];
+    const int64_t k = in_mat_dims[1];
+    const int64_t n = weight_sum->numel();
+    const int64_t padded_k = phi::funcs::CpuInt8PaddedK(k);
+    const float input_scale = ctx.Attr<float>("Input_scale");
+    auto weight_scale = ctx.Attr<std::vector<float>>("weight_scale");
+    std::vector<float> scale(n);
+    for (int64_t j = 0; j < n; ++j) {
+      scale[j] = input_scale * weight_scale[j];
+    }
+    bool relu = ctx.Attr<std::string>("activation_type") == "relu";
+
+    Tensor quantized, acc;
+    quantized.Resize({m, padded_k});
+    acc.Resize({m, n});
+    uint8_t* a = quantized.mutable_data<uint8_t>(place);
+    int32_t* c = acc.mutable_data<int32_t>(place);
+    const T* x = input->data<T>();
+    T* y = out->mutable_data<T>(place);
+    const int32_t* sum = weight_sum->data<int32_t>();
+    const T* bias_data = bias ? bias->data<T>() : nullptr;
+
+    const int64_t grain = std::max<int64_t>(1, 4096 / std::max<int64_t>(k, 1));
+    dev_ctx.ParallelFor(0, m, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        uint8_t* row = a + i * padded_k;
+        phi::funcs::CpuInt8Quantize(x + i * k, k, input_scale, row);
+        std::fill(row + k, row + padded_k,
+                  static_cast<uint8_t>(phi::funcs::kCpuInt8Shift));
+      }
+    });
+    phi::funcs::CpuInt8Gemm(dev_ctx, a, padded_k, w->data<int8_t>(), m, n, k,
+                            c, n);
+    dev_ctx.ParallelFor(0, m, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        phi::funcs::CpuInt8DequantizeRow(c + i * n, sum, scale.data(),
+                                         bias_data, n, relu, y + i * n);
+      }
+    });
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(fusion_int8_fc, ops::FusionInt8FCOp,
+                  ops::FusionInt8FCOpMaker);
+
+REGISTER_OP_CPU_KERNEL(fusion_int8_fc, ops::FusionInt8FCKernel<float>);
@@ -0,0 +1,255 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_int8_gemm.h"
+
+USE_CPU_ONLY_OP(fusion_int8_fc);
+USE_CPU_ONLY_OP(fusion_int8_conv2d);
+USE_CPU_ONLY_OP(fc);
+USE_OP_ITSELF(conv2d);
+USE_OP_ITSELF(depthwise_conv2d);
+PD_DECLARE_KERNEL(conv2d, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(depthwise_conv2d, CPU, ALL_LAYOUT);
+
+namespace paddle {
+namespace operators {
+
+// The scales are powers of 2, so the float ops compute the values on the
+// int8 grids exactly and the int8 ops must give the same outputs.
+constexpr float kInputScale = 1.0f / 64;
+
+std::vector<int8_t> RandomInt8(int64_t size, std::mt19937* rng) {
+  std::uniform_int_distribution<int> dist(-127, 127);
+  std::vector<int8_t> values(size);
+  for (auto& v : values) {
+    v = static_cast<int8_t>(dist(*rng));
+  }
+  return values;
+}
+
+// the scale of the output channel j
+float WeightScale(int64_t j) { return 1.0f / (128 >> (j % 3)); }
+
+template <typename T>
+void SetTensor(framework::Scope* scope, const std::string& name,
+               const std::vector<int64_t>& shape, const T* values) {
+  auto* tensor = scope->Var(name)->GetMutable<framework::LoDTensor>();
+  tensor->Resize(phi::make_ddim(shape));
+  T* data = tensor->mutable_data<T>(platform::CPUPlace());
+  std::copy(values, values + tensor->numel(), data);
+}
+
+const framework::LoDTensor& GetTensor(const framework::Scope& scope,
+                                      const std::string& name) {
+  return scope.FindVar(name)->Get<framework::LoDTensor>();
+}
+
+void ExpectEqualTensors(const framework::LoDTensor& out,
+                        const framework::LoDTensor& ref) {
+  ASSERT_EQ(out.dims(), ref.dims());
+  for (int64_t i = 0; i < ref.numel(); ++i) {
+    ASSERT_NEAR(out.data<float>()[i], ref.data<float>()[i], 1e-5)
+        << "at " << i;
+  }
+}
+
+// The fc of an input of the shape in_shape flattened at in_num_col_dims by
+// the k x n weight, against the float fc op.
+void TestInt8FC(const std::vector<int64_t>& in_shape, int in_num_col_dims,
+                int64_t n, bool with_bias, const std::string& activation) {
+  std::mt19937 rng(static_cast<unsigned int>(n));
+  int64_t m = 1, k = 1;
+  for (int i = 0; i < static_cast<int>(in_shape.size()); ++i) {
+    if (i < in_num_col_dims) {
+      m *= in_shape[i];
+    } else {
+      k *= in_shape[i];
+    }
+  }
+  auto qx = RandomInt8(m * k, &rng);
+  auto qw = RandomInt8(k * n, &rng);
+  std::vector<float> x(m * k), w(k * n), bias(n), scales(n);
+  for (int64_t i = 0; i < m * k; ++i) {
+    x[i] = qx[i] * kInputScale;
+  }
+  for (int64_t j = 0; j < n; ++j) {
+    scales[j] = WeightScale(j);
+    bias[j] = (j % 8) * 0.25f - 1.0f;
+  }
+  for (int64_t i = 0; i < k * n; ++i) {
+    w[i] = qw[i] * scales[i % n];
+  }
+  std::vector<int8_t> packed(phi::funcs::CpuInt8PackedSize(k, n));
+  std::vector<int32_t> sum(n);
+  phi::funcs::CpuInt8PackWeight(qw.data(), k, n, false, packed.data(),
+                                sum.data());
+
+  framework::Scope scope;
+  SetTensor(&scope, "x", in_shape, x.data());
+  SetTensor(&scope, "w", {k, n}, w.data());
+  SetTensor(&scope, "bias", {n}, bias.data());
+  SetTensor(&scope, "packed",
+            {phi::funcs::CpuInt8PaddedK(k), phi::funcs::CpuInt8PaddedN(n)},
+            packed.data());
+  SetTensor(&scope, "sum", {n}, sum.data());
+  framework::VariableNameMap bias_input;
+  if (with_bias) {
+    bias_input = {{"Bias", {"bias"}}};
+  }
+
+  framework::VariableNameMap inputs = {{"Input", {"x"}}, {"W", {"w"}}};
+  inputs.insert(bias_input.begin(), bias_input.end());
+  framework::AttributeMap attrs = {{"in_num_col_dims", in_num_col_dims},
+                                   {"activation_type", activation}};
+  framework::OpRegistry::CreateOp("fc", inputs, {{"Out", {"ref"}}}, attrs)
+      ->Run(scope, platform::CPUPlace());
+
+  inputs = {{"Input", {"x"}}, {"W", {"packed"}}, {"WeightSum", {"sum"}}};
+  inputs.insert(bias_input.begin(), bias_input.end());
+  attrs["Input_scale"] = kInputScale;
+  attrs["weight_scale"] = scales;
+  framework::OpRegistry::CreateOp("fusion_int8_fc", inputs,
+                                  {{"Out", {"out"}}}, attrs)
+      ->Run(scope, platform::CPUPlace());
+
+  ExpectEqualTensors(GetTensor(scope, "out"), GetTensor(scope, "ref"));
+}
+
+TEST(FusionInt8FC, compare_with_fc) {
+  TestInt8FC({7, 20}, 1, 19, true, "");
+  TestInt8FC({7, 20}, 1, 19, true, "relu");
+  TestInt8FC({2, 3, 37}, 2, 48, false, "relu");
+  TestInt8FC({1, 3, 2, 5}, 1, 5, true, "");
+}
+
+struct ConvCase {
+  std::string type;
+  std::vector<int64_t> in_shape;  // NCHW
+  int oc;
+  int kh;
+  int kw;
+  int groups;
+  std::vector<int> strides;
+  std::vector<int> paddings;
+  std::vector<int> dilations;
+  std::string padding_algorithm;
+};
+
+// The int8 conv with a bias against the float conv op with the bias added
+// to its output.
+void TestInt8Conv(const ConvCase& c) {
+  std::mt19937 rng(static_cast<unsigned int>(c.oc * c.kh * c.kw));
+  const int ic_per_group = c.in_shape[1] / c.groups;
+  const int64_t k = static_cast<int64_t>(ic_per_group) * c.kh * c.kw;
+  const int64_t oc_per_group = c.oc / c.groups;
+  const int64_t in_size =
+      c.in_shape[0] * c.in_shape[1] * c.in_shape[2] * c.in_shape[3];
+  auto qx = RandomInt8(in_size, &rng);
+  auto qw = RandomInt8(c.oc * k, &rng);
+  std::vector<float> x(in_size), w(c.oc * k), bias(c.oc), scales(c.oc);
+  for (int64_t i = 0; i < in_size; ++i) {
+    x[i] = qx[i] * kInputScale;
+  }
+  for (int64_t j = 0; j < c.oc; ++j) {
+    scales[j] = WeightScale(j);
+    bias[j] = (j % 8) * 0.25f - 1.0f;
+  }
+  for (int64_t i = 0; i < c.oc * k; ++i) {
+    w[i] = qw[i] * scales[i / k];
+  }
+  const int64_t group_size = phi::funcs::CpuInt8PackedSize(k, oc_per_group);
+  std::vector<int8_t> packed(c.groups * group_size);
+  std::vector<int32_t> sum(c.oc);
+  for (int g = 0; g < c.groups; ++g) {
+    phi::funcs::CpuInt8PackWeight(qw.data() + g * oc_per_group * k, k,
+                                  oc_per_group, true,
+                                  packed.data() + g * group_size,
+                                  sum.data() + g * oc_per_group);
+  }
+
+  std::vector<int> filter_shape = {c.oc, ic_per_group, c.kh, c.kw};
+  framework::Scope scope;
+  SetTensor(&scope, "x", c.in_shape, x.data());
+  SetTensor(&scope, "w", {c.oc, ic_per_group, c.kh, c.kw}, w.data());
+  SetTensor(&scope, "bias", {c.oc}, bias.data());
+  SetTensor(&scope, "packed",
+            {c.groups * phi::funcs::CpuInt8PaddedK(k),
+             phi::funcs::CpuInt8PaddedN(oc_per_group)},
+            packed.data());
+  SetTensor(&scope, "sum", {c.oc}, sum.data());
+
+  framework::AttributeMap attrs = {{"strides", c.strides},
+                                   {"paddings", c.paddings},
+                                   {"dilations", c.dilations},
+                                   {"groups", c.groups},
+                                   {"padding_algorithm", c.padding_algorithm}};
+  framework::OpRegistry::CreateOp(
+      c.type, {{"Input", {"x"}}, {"Filter", {"w"}}}, {{"Output", {"ref"}}},
+      attrs)
+      ->Run(scope, platform::CPUPlace());
+  auto* ref = scope.FindVar("ref")->GetMutable<framework::LoDTensor>();
+  const int64_t pixels = ref->dims()[2] * ref->dims()[3];
+  float* ref_data = ref->data<float>();
+  for (int64_t i = 0; i < ref->numel(); ++i) {
+    ref_data[i] += bias[i / pixels % c.oc];
+  }
+
+  attrs["filter_shape"] = filter_shape;
+  attrs["Input_scale"] = kInputScale;
+  attrs["weight_scale"] = scales;
+  framework::OpRegistry::CreateOp("fusion_int8_conv2d",
+                                  {{"Input", {"x"}},
+                                   {"Filter", {"packed"}},
+                                   {"WeightSum", {"sum"}},
+                                   {"Bias", {"bias"}}},
+                                  {{"Output", {"out"}}}, attrs)
+      ->Run(scope, platform::CPUPlace());
+
+  ExpectEqualTensors(GetTensor(scope, "out"), *ref);
+}
+
+TEST(FusionInt8Conv2D, compare_with_conv2d) {
+  TestInt8Conv({"conv2d", {2, 3, 9, 9}, 8, 3, 3, 1, {1, 1}, {1, 1}, {1, 1},
+                "EXPLICIT"});
+  TestInt8Conv({"conv2d", {1, 5, 7, 6}, 17, 1, 1, 1, {1, 1}, {0, 0}, {1, 1},
+                "EXPLICIT"});
+  TestInt8Conv({"conv2d", {1, 3, 8, 8}, 4, 3, 3, 1, {2, 2}, {0, 0}, {1, 1},
+                "SAME"});
+}
+
+TEST(FusionInt8Conv2D, groups_paddings_dilations) {
+  TestInt8Conv({"conv2d", {2, 4, 10, 9}, 6, 3, 2, 2, {2, 1}, {1, 0, 2, 1},
+                {1, 2}, "EXPLICIT"});
+  TestInt8Conv({"conv2d", {1, 6, 11, 11}, 9, 3, 3, 3, {1, 2}, {2, 2},
+                {2, 2}, "EXPLICIT"});
+}
+
+TEST(FusionInt8Conv2D, depthwise) {
+  TestInt8Conv({"depthwise_conv2d", {2, 8, 7, 7}, 8, 3, 3, 8, {1, 1},
+                {1, 1}, {1, 1}, "EXPLICIT"});
+  TestInt8Conv({"depthwise_conv2d", {1, 4, 9, 8}, 4, 3, 3, 4, {2, 2},
+                {2, 1}, {2, 2}, "EXPLICIT"});
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -109,40 +109,35 @@ class FusionSeqPoolCVMConcatKernel : public framework::OpKernel<T> {
     PADDLE_ENFORCE_EQ(y_dims[1] % w, 0,
                       paddle::platform::errors::InvalidArgument(
                           "The output of dims[1] should be dividable of w"));
-    jit::seq_pool_attr_t attr(w, jit::SeqPoolType::kSum);
+    size_t n = ins.size();
+    // Currently only use_cvm is true.
+    jit::emb_seq_pool_cvm_concat_attr_t attr(x0_dims[0], w, n, bs,
+                                             jit::SeqPoolType::kSum, true);
     if (pooltype == "AVERAGE") {
-      attr.type = jit::SeqPoolType::kAvg;
+      attr.pool_type = jit::SeqPoolType::kAvg;
     } else if (pooltype == "SQRT") {
-      attr.type = jit::SeqPoolType::kSqrt;
+      attr.pool_type = jit::SeqPoolType::kSqrt;
     }
-    auto seqpool =
-        jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
-            attr);
-    size_t n = ins.size();
-    size_t dst_step_size = n * w;
+    // the rows of every input are pooled in order, so no ids are looked up
+    std::vector<const T*> tables(n);
+    std::vector<const int64_t*> ids(n, nullptr);
+    std::vector<const size_t*> lods(n);
     for (size_t i = 0; i < n; ++i) {
       auto x_dims = ins[i]->dims();
-      auto x_lod = ins[i]->lod()[0];
-      const T* src = ins[i]->data<T>();
-      T* dst = y_data + i * w;
+      auto& x_lod = ins[i]->lod()[0];
       PADDLE_ENFORCE_EQ(static_cast<int>(ins[i]->numel() / x_dims[0]), w,
                         paddle::platform::errors::InvalidArgument(
                             "Width of all inputs should be equal."));
       PADDLE_ENFORCE_EQ(x_lod.size(), bs + 1,
                         paddle::platform::errors::InvalidArgument(
                             "Batchsize of all inputs should be equal."));
-      for (size_t j = 0; j < bs; ++j) {
-        attr.h = static_cast<int>(x_lod[j + 1] - x_lod[j]);
-        seqpool(src, dst, &attr);
-
-        // Currently only use_cvm is true.
-        dst[0] = log(dst[0] + 1);
-        dst[1] = log(dst[1] + 1) - dst[0];
-
-        dst += dst_step_size;
-        src += attr.h * attr.w;
-      }
+      tables[i] = ins[i]->data<T>();
+      lods[i] = x_lod.data();
     }
+    auto emb_seqpool_cvm_concat = jit::KernelFuncs<
+        jit::EmbSeqPoolCVMConcatTuple<T>, platform::CPUPlace>::Cache().At(attr);
+    emb_seqpool_cvm_concat(tables.data(), ids.data(), lods.data(), y_data,
+                           &attr);
   }
 };
 
@@ -0,0 +1,124 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/jit/autotune.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/jit/helper.h"
+
+DECLARE_bool(jit_autotune);
+DECLARE_string(jit_autotune_file);
+
+namespace paddle {
+namespace operators {
+namespace jit {
+
+// The model name of the first processor in /proc/cpuinfo, the fields of the
+// tuning file are separated by tabs so the tabs are replaced.
+static std::string ReadCPUModel() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    auto colon = line.find(':');
+    if (line.compare(0, 10, "model name") == 0 && colon != std::string::npos) {
+      auto pos = line.find_first_not_of(" \t", colon + 1);
+      if (pos != std::string::npos) {
+        std::string model = line.substr(pos);
+        std::replace(model.begin(), model.end(), '\t', ' ');
+        return model;
+      }
+    }
+  }
+  return "unknown";
+}
+
+AutotuneTable& AutotuneTable::Instance() {
+  static AutotuneTable table;
+  return table;
+}
+
+AutotuneTable::AutotuneTable() : cpu_model_(ReadCPUModel()) {}
+
+bool AutotuneTable::Enabled() const { return FLAGS_jit_autotune; }
+
+bool AutotuneTable::Active() const {
+  return FLAGS_jit_autotune || !FLAGS_jit_autotune_file.empty();
+}
+
+void AutotuneTable::LoadIfChanged() {
+  if (FLAGS_jit_autotune_file == loaded_file_) {
+    return;
+  }
+  loaded_file_ = FLAGS_jit_autotune_file;
+  choices_.clear();
+  if (loaded_file_.empty()) {
+    return;
+  }
+  // every line is "cpu model \t key \t impl", the later lines win
+  std::ifstream fin(loaded_file_);
+  std::string line;
+  while (std::getline(fin, line)) {
+    std::istringstream fields(line);
+    std::string model, key, impl;
+    if (std::getline(fields, model, '\t') && std::getline(fields, key, '\t') &&
+        std::getline(fields, impl) && model == cpu_model_) {
+      choices_[key] = impl;
+    }
+  }
+  VLOG(3) << "Load " << choices_.size() << " jit kernel choices of "
+          << cpu_model_ << " from " << loaded_file_;
+}
+
+bool AutotuneTable::Find(const std::string& key, std::string* impl) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LoadIfChanged();
+  auto iter = choices_.find(key);
+  if (iter == choices_.end()) {
+    return false;
+  }
+  *impl = iter->second;
+  return true;
+}
+
+void AutotuneTable::Insert(const std::string& key, const std::string& impl) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LoadIfChanged();
+  if (!choices_.emplace(key, impl).second) {
+    return;
+  }
+  if (!loaded_file_.empty()) {
+    // appending keeps the lines written by the other processes
+    std::ofstream fout(loaded_file_, std::ios::app);
+    fout << cpu_model_ << '\t' << key << '\t' << impl << '\n';
+    if (!fout) {
+      LOG_FIRST_N(WARNING, 1) << "Failed to save the jit kernel choices to "
+                              << loaded_file_;
+    }
+  }
+}
+
+std::string AutotuneKey(KernelType type, const char* data_type,
+                        int64_t attr_key) {
+  std::ostringstream key;
+  key << to_string(type) << ',' << data_type << ',' << attr_key;
+  return key.str();
+}
+
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
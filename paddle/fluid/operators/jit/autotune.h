@@ -0,0 +1,316 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/operators/jit/kernel_base.h"
+
+namespace paddle {
+namespace operators {
+namespace jit {
+
+// The implementations chosen by timing their candidates, keyed by the kernel
+// type, the data type and the attr key. It is shared by all the threads, the
+// choices made on this CPU model are read from and appended to
+// FLAGS_jit_autotune_file.
+class AutotuneTable {
+ public:
+  static AutotuneTable& Instance();
+
+  // whether the candidates of an unknown attr should be timed
+  bool Enabled() const;
+  // whether the table is used at all, tuning or reading the file
+  bool Active() const;
+
+  // the name (ImplType) of the implementation chosen for the key
+  bool Find(const std::string& key, std::string* impl);
+  void Insert(const std::string& key, const std::string& impl);
+
+  const std::string& CPUModel() const { return cpu_model_; }
+
+ private:
+  AutotuneTable();
+  // loads the choices of this CPU model when the file flag changes
+  void LoadIfChanged();
+
+  std::string cpu_model_;
+  std::string loaded_file_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::string> choices_;
+  DISABLE_COPY_AND_ASSIGN(AutotuneTable);
+};
+
+template <typename T>
+inline const char* AutotuneDataType() {
+  return std::is_same<T, float>::value
+             ? "float"
+             : (std::is_same<T, double>::value ? "double" : "other");
+}
+
+std::string AutotuneKey(KernelType type, const char* data_type,
+                        int64_t attr_key);
+
+namespace autotune {
+
+// The calls of one round take about this long, the best round is kept.
+constexpr double kRoundNs = 2e5;
+constexpr int kRounds = 3;
+constexpr int kMaxRepeat = 10000;
+// the rows of the kernels whose attr does not hold the height
+constexpr int kRows = 16;
+// the rows of the embedding table that are looked up
+constexpr int64_t kTableRows = 1024;
+
+template <typename T>
+std::vector<T> RandomData(size_t n) {
+  std::mt19937 rng(2022);
+  std::uniform_real_distribution<double> dist(-2.0, 2.0);
+  std::vector<T> data(n);
+  for (auto& v : data) {
+    v = static_cast<T>(dist(rng));
+  }
+  return data;
+}
+
+// the time in ns of one call(func), the best of a few rounds
+template <typename Func, typename Call>
+double TimeOne(Func func, Call&& call) {
+  using Clock = std::chrono::steady_clock;
+  auto elapsed = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start)
+        .count();
+  };
+  call(func);  // warm up
+  auto start = Clock::now();
+  call(func);
+  int repeat = static_cast<int>(std::min<double>(
+      kMaxRepeat, std::max(1.0, kRoundNs / std::max(elapsed(start), 1.0))));
+  double best = std::numeric_limits<double>::max();
+  for (int r = 0; r < kRounds; ++r) {
+    start = Clock::now();
+    for (int i = 0; i < repeat; ++i) {
+      call(func);
+    }
+    best = std::min(best, elapsed(start) / repeat);
+  }
+  return best;
+}
+
+template <typename Func, typename Call>
+bool TimeAll(const std::vector<std::pair<std::string, Func>>& funcs,
+             Call&& call, std::vector<double>* times) {
+  times->clear();
+  for (auto& f : funcs) {
+    times->push_back(TimeOne(f.second, call));
+  }
+  return true;
+}
+
+// The Time overloads prepare the data of the attr for the kind of the tuple
+// and time every candidate, the kinds without an overload are not tuned.
+template <typename Func, typename Attr>
+bool Time(const void*, const std::vector<std::pair<std::string, Func>>& funcs,
+          const Attr& attr, std::vector<double>* times) {
+  return false;
+}
+
+template <typename T>
+bool Time(const XYZNTuple<T>*,
+          const std::vector<std::pair<std::string,
+                                      typename XYZNTuple<T>::func_type>>& funcs,
+          const int& n, std::vector<double>* times) {
+  auto x = RandomData<T>(n), y = RandomData<T>(n);
+  std::vector<T> z(n);
+  return TimeAll(funcs,
+                 [&](typename XYZNTuple<T>::func_type f) {
+                   f(x.data(), y.data(), z.data(), n);
+                 },
+                 times);
+}
+
+template <typename T>
+bool Time(const AXYNTuple<T>*,
+          const std::vector<std::pair<std::string,
+                                      typename AXYNTuple<T>::func_type>>& funcs,
+          const int& n, std::vector<double>* times) {
+  const T a = static_cast<T>(0.5);
+  auto x = RandomData<T>(n);
+  std::vector<T> y(n);
+  return TimeAll(
+      funcs,
+      [&](typename AXYNTuple<T>::func_type f) { f(&a, x.data(), y.data(), n); },
+      times);
+}
+
+template <typename T>
+bool Time(const XYNTuple<T>*,
+          const std::vector<std::pair<std::string,
+                                      typename XYNTuple<T>::func_type>>& funcs,
+          const int& n, std::vector<double>* times) {
+  auto x = RandomData<T>(n);
+  std::vector<T> y(n);
+  return TimeAll(
+      funcs,
+      [&](typename XYNTuple<T>::func_type f) { f(x.data(), y.data(), n); },
+      times);
+}
+
+template <typename T>
+bool Time(const XRNTuple<T>*,
+          const std::vector<std::pair<std::string,
+                                      typename XRNTuple<T>::func_type>>& funcs,
+          const int& n, std::vector<double>* times) {
+  auto x = RandomData<T>(n);
+  T res;
+  return TimeAll(
+      funcs, [&](typename XRNTuple<T>::func_type f) { f(x.data(), &res, n); },
+      times);
+}
+
+template <typename T>
+bool Time(
+    const VBroadcastTuple<T>*,
+    const std::vector<
+        std::pair<std::string, typename VBroadcastTuple<T>::func_type>>& funcs,
+    const int64_t& w, std::vector<double>* times) {
+  auto x = RandomData<T>(w);
+  std::vector<T> y(kRows * w);
+  return TimeAll(funcs,
+                 [&](typename VBroadcastTuple<T>::func_type f) {
+                   f(x.data(), y.data(), kRows, w);
+                 },
+                 times);
+}
+
+template <typename T>
+bool Time(const SeqPoolTuple<T>*,
+          const std::vector<std::pair<
+              std::string, typename SeqPoolTuple<T>::func_type>>& funcs,
+          const seq_pool_attr_t& attr, std::vector<double>* times) {
+  seq_pool_attr_t run_attr = attr;
+  run_attr.h = std::max(attr.h, 1);
+  auto x = RandomData<T>(run_attr.h * run_attr.w);
+  std::vector<T> y(run_attr.w);
+  return TimeAll(funcs,
+                 [&](typename SeqPoolTuple<T>::func_type f) {
+                   f(x.data(), y.data(), &run_attr);
+                 },
+                 times);
+}
+
+template <typename T>
+bool Time(const EmbSeqPoolTuple<T>*,
+          const std::vector<std::pair<
+              std::string, typename EmbSeqPoolTuple<T>::func_type>>& funcs,
+          const emb_seq_pool_attr_t& attr, std::vector<double>* times) {
+  // only the first rows of the table are looked up
+  emb_seq_pool_attr_t run_attr = attr;
+  run_attr.table_height = std::min(attr.table_height, kTableRows);
+  if (run_attr.table_height <= 0 || attr.index_height <= 0) {
+    return false;
+  }
+  auto table = RandomData<T>(run_attr.table_height * attr.table_width);
+  std::vector<int64_t> idx(attr.index_height * attr.index_width);
+  std::mt19937 rng(2022);
+  for (auto& i : idx) {
+    i = rng() % run_attr.table_height;
+  }
+  std::vector<T> out(attr.out_width);
+  return TimeAll(funcs,
+                 [&](typename EmbSeqPoolTuple<T>::func_type f) {
+                   f(table.data(), idx.data(), out.data(), &run_attr);
+                 },
+                 times);
+}
+
+template <typename T>
+bool Time(const MatMulTuple<T>*,
+          const std::vector<std::pair<std::string,
+                                      typename MatMulTuple<T>::func_type>>&
+              funcs,
+          const matmul_attr_t& attr, std::vector<double>* times) {
+  // the bias of the attr is only known to be set
+  matmul_attr_t run_attr = attr;
+  run_attr.batch = 1;
+  auto a = RandomData<T>(attr.m * attr.k), b = RandomData<T>(attr.k * attr.n);
+  auto bias = RandomData<T>(attr.n);
+  if (attr.bias) {
+    run_attr.bias = bias.data();
+  }
+  std::vector<T> c(attr.m * attr.n);
+  return TimeAll(funcs,
+                 [&](typename MatMulTuple<T>::func_type f) {
+                   f(a.data(), b.data(), c.data(), &run_attr);
+                 },
+                 times);
+}
+
+template <typename T>
+bool Time(const LayerNormTuple<T>*,
+          const std::vector<std::pair<
+              std::string, typename LayerNormTuple<T>::func_type>>& funcs,
+          const int& right, std::vector<double>* times) {
+  auto x = RandomData<T>(kRows * right);
+  auto scale = RandomData<T>(right), bias = RandomData<T>(right);
+  std::vector<T> out(kRows * right), mean(kRows), var(kRows);
+  return TimeAll(funcs,
+                 [&](typename LayerNormTuple<T>::func_type f) {
+                   f(x.data(), out.data(), mean.data(), var.data(),
+                     scale.data(), bias.data(), kRows, 1e-5f, right);
+                 },
+                 times);
+}
+
+template <typename T>
+bool Time(const SoftmaxTuple<T>*,
+          const std::vector<std::pair<std::string,
+                                      typename SoftmaxTuple<T>::func_type>>&
+              funcs,
+          const int& n, std::vector<double>* times) {
+  auto x = RandomData<T>(kRows * n);
+  std::vector<T> y(kRows * n);
+  return TimeAll(funcs,
+                 [&](typename SoftmaxTuple<T>::func_type f) {
+                   f(x.data(), y.data(), n, kRows, 1);
+                 },
+                 times);
+}
+
+}  // namespace autotune
+
+// Times the candidates of the attr into times, in the order of funcs. It
+// returns false if the kernel type is not tuned.
+template <typename KernelTuple>
+bool TimeCandidateFuncs(
+    const std::vector<std::pair<std::string, typename KernelTuple::func_type>>&
+        funcs,
+    const typename KernelTuple::attr_type& attr, std::vector<double>* times) {
+  return autotune::Time(static_cast<const KernelTuple*>(nullptr), funcs, attr,
+                        times);
+}
+
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
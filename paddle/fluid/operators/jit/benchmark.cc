@@ -311,6 +311,44 @@ void BenchKernelEmbSeqPool() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelEmbSeqPoolCVMConcat() {
+  using T = typename KernelTuple::data_type;
+  // the slots of a CTR model share one large table, a sequence has a few ids
+  const int64_t tbl_h = 1e5;
+  for (int tbl_w : {10, 18}) {
+    Tensor table;
+    table.Resize({tbl_h, tbl_w});
+    RandomVec<T>(tbl_h * tbl_w, table.mutable_data<T>(PlaceType()), 0.f, 2.f);
+    for (int slot_num : {26, 128}) {
+      for (int bs : {16, 64}) {
+        std::vector<const T*> tables(slot_num, table.data<T>());
+        std::vector<std::vector<int64_t>> ids(slot_num);
+        std::vector<std::vector<size_t>> lods(slot_num);
+        std::vector<const int64_t*> ids_data(slot_num);
+        std::vector<const size_t*> lods_data(slot_num);
+        for (int s = 0; s < slot_num; ++s) {
+          lods[s].push_back(0);
+          for (int b = 0; b < bs; ++b) {
+            lods[s].push_back(lods[s].back() + 1 + (b + s) % 3);
+          }
+          ids[s].resize(lods[s].back());
+          RandomVec<int64_t>(ids[s].size(), ids[s].data(), 0, tbl_h - 1);
+          ids_data[s] = ids[s].data();
+          lods_data[s] = lods[s].data();
+        }
+        jit::emb_seq_pool_cvm_concat_attr_t attr(tbl_h, tbl_w, slot_num, bs);
+        Tensor out;
+        out.Resize({bs, slot_num * tbl_w});
+        T* o_data = out.mutable_data<T>(PlaceType());
+        BenchAllImpls<KernelTuple, PlaceType>(attr, tables.data(),
+                                              ids_data.data(),
+                                              lods_data.data(), o_data, &attr);
+      }
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelSgd() {
   using T = typename KernelTuple::data_type;
@@ -382,6 +420,34 @@ void BenchKernelMatMul() {
       }
     }
   }
+  // the small gemm of fc with the bias and relu, and of the transposed B
+  for (int m : {1, 4, 8, 16}) {
+    for (int n : {16, 64, 100, 256}) {
+      for (int k : {16, 64, 256}) {
+        for (bool trans_b : {false, true}) {
+          Tensor a, b, c, bias;
+          a.Resize({m * k});
+          b.Resize({k * n});
+          c.Resize({m * n});
+          bias.Resize({n});
+          RandomVec<T>(m * k, a.mutable_data<T>(PlaceType()), -2.f, 2.f);
+          RandomVec<T>(k * n, b.mutable_data<T>(PlaceType()), -2.f, 2.f);
+          RandomVec<T>(n, bias.mutable_data<T>(PlaceType()), -2.f, 2.f);
+          const T* a_data = a.data<T>();
+          const T* b_data = b.data<T>();
+          T* c_data = c.mutable_data<T>(PlaceType());
+          jit::matmul_attr_t attr{m, n, k};
+          attr.trans_b = trans_b;
+          if (!trans_b) {
+            attr.bias = bias.data<T>();
+            attr.act = jit::kVRelu;
+          }
+          BenchAllImpls<KernelTuple, PlaceType>(attr, a_data, b_data, c_data,
+                                                &attr);
+        }
+      }
+    }
+  }
 }
 
 template <typename KernelTuple, typename PlaceType>
@@ -555,6 +621,7 @@ BENCH_FP32_CPU(CRFDecoding);
 
 BENCH_FP32_CPU(SeqPool);
 BENCH_FP32_CPU(EmbSeqPool);
+BENCH_FP32_CPU(EmbSeqPoolCVMConcat);
 BENCH_FP32_CPU(MatMul);
 BENCH_FP32_CPU(Softmax);
 BENCH_FP32_CPU(Sgd);
@@ -15,6 +15,8 @@
 #include "paddle/fluid/operators/jit/gen/matmul.h"
 
 #include <stddef.h>  // offsetof
+#include <algorithm>
+#include <limits>
 
 #include "paddle/fluid/operators/jit/registry.h"
 #include "paddle/fluid/platform/cpu_info.h"
@@ -24,100 +26,304 @@ namespace operators {
 namespace jit {
 namespace gen {
 
-void MatMulJitCode::genCode() {
-  preCode();
-  int block, rest;
-  const auto groups = packed_groups(n_, k_, &block, &rest);
-  PADDLE_ENFORCE_GT(
-      groups.front(), 0,
-      platform::errors::InvalidArgument("The number of rest registers should "
-                                        "be larger than 0. But it is %d.",
-                                        groups.front()));
-
-  const int block_len = sizeof(float) * block;
-  const int x_reg_idx = (block == ZMM_FLOAT_BLOCK ? 32 : 16) - 1;
-  const int w_reg_idx = x_reg_idx - 1;
-  // from packed mov(reg_ptr_wgt, ptr[param_attr + offsetof(matmul_attr_t,
-  // packed_weight)]);
-  mov(reg_ptr_wgt, param_y);
-  size_t z_offset = 0;
-  size_t wgt_offset = 0;
-  for (size_t g = 0; g < groups.size(); ++g) {
-    size_t x_offset = 0;
-    size_t wgt_offset_tmp = 0;
-    for (size_t i = 0; i < g; ++i) {
-      wgt_offset_tmp += groups[i] * block_len;
-    }
-    for (int k = 0; k < k_; ++k) {
-      wgt_offset = wgt_offset_tmp;
-      vbroadcastss(zmm_t(x_reg_idx), ptr[param_x + x_offset]);
-      // clean
-      if (k == 0) {
-        for (int i = 0; i < groups[g]; ++i) {
-          vxorps(zmm_t(i), zmm_t(i), zmm_t(i));
-        }
+// the mask of the first i floats of ymm starts at 8 - i
+static const int32_t g_tail_mask[2 * YMM_FLOAT_BLOCK] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+template <typename JMM>
+void MatMulJitCode::loadVec(const JMM& dst, const Xbyak::Address& src,
+                            bool tail) {
+  if (!tail) {
+    vmovups(dst, src);
+  } else if (use_zmm_) {
+    vmovups(dst | k1 | T_z, src);
+  } else {
+    vmaskmovps(dst, ymm_t(num_regs_ - 1), src);
+  }
+}
+
+template <typename JMM>
+void MatMulJitCode::storeVec(const Xbyak::Address& dst, const JMM& src,
+                             bool tail) {
+  if (!tail) {
+    vmovups(dst, src);
+  } else if (use_zmm_) {
+    vmovups(dst | k1, src);
+  } else {
+    vmaskmovps(dst, ymm_t(num_regs_ - 1), src);
+  }
+}
+
+void MatMulJitCode::zeroVec(int idx) {
+  if (use_zmm_) {
+    vpxord(zmm_t(idx), zmm_t(idx), zmm_t(idx));
+  } else {
+    vxorps(ymm_t(idx), ymm_t(idx), ymm_t(idx));
+  }
+}
+
+void MatMulJitCode::reduceVec(int idx) {
+  if (use_zmm_) {
+    vextractf64x4(ymm_t(0), zmm_t(idx), 0);
+    vextractf64x4(ymm_t(1), zmm_t(idx), 1);
+    vaddps(ymm_t(0), ymm_t(0), ymm_t(1));
+    vextractf128(xmm_t(1), ymm_t(0), 1);
+    vaddps(xmm_t(0), xmm_t(0), xmm_t(1));
+  } else {
+    vextractf128(xmm_t(1), ymm_t(idx), 1);
+    vaddps(xmm_t(0), xmm_t(idx), xmm_t(1));
+  }
+  vhaddps(xmm_t(0), xmm_t(0), xmm_t(0));
+  vhaddps(xmm_t(0), xmm_t(0), xmm_t(0));
+}
+
+// The registers are the vecs vectors of a row of B, the broadcast of A and
+// the rows * vecs accumulators.
+template <typename JMM>
+void MatMulJitCode::genNoTransBTile(int m_offset, int rows, int vecs,
+                                    bool with_tail) {
+  const size_t vec_bytes = block_ * sizeof(float);
+  const int a_idx = vecs;
+  auto acc = [=](int i, int v) { return vecs + 1 + i * vecs + v; };
+  for (int i = 0; i < rows; ++i) {
+    for (int v = 0; v < vecs; ++v) {
+      zeroVec(acc(i, v));
+    }
+  }
+  lea(reg_ptr_a, ptr[param_a + m_offset * k_ * sizeof(float)]);
+  mov(reg_ptr_b, reg_tile_b);
+  mov(reg_k, k_);
+  Label l_next_k;
+  L(l_next_k);
+  {
+    for (int v = 0; v < vecs; ++v) {
+      loadVec(JMM(v), ptr[reg_ptr_b + v * vec_bytes],
+              with_tail && v == vecs - 1);
+    }
+    for (int i = 0; i < rows; ++i) {
+      vbroadcastss(JMM(a_idx), ptr[reg_ptr_a + i * k_ * sizeof(float)]);
+      for (int v = 0; v < vecs; ++v) {
+        vfmadd231ps(JMM(acc(i, v)), JMM(v), JMM(a_idx));
+      }
+    }
+    add(reg_ptr_a, sizeof(float));
+    add(reg_ptr_b, n_ * sizeof(float));
+    dec(reg_k);
+    jnz(l_next_k, T_NEAR);
+  }
+
+  if (relu_) {
+    zeroVec(a_idx);
+  }
+  for (int v = 0; v < vecs; ++v) {
+    const bool tail = with_tail && v == vecs - 1;
+    if (with_bias_) {
+      loadVec(JMM(v), ptr[reg_tile_bias + v * vec_bytes], tail);
+    }
+    for (int i = 0; i < rows; ++i) {
+      if (with_bias_) {
+        vaddps(JMM(acc(i, v)), JMM(acc(i, v)), JMM(v));
+      }
+      if (relu_) {
+        vmaxps(JMM(acc(i, v)), JMM(acc(i, v)), JMM(a_idx));
+      }
+      storeVec(ptr[reg_tile_c + (i * n_ + v * block_) * sizeof(float)],
+               JMM(acc(i, v)), tail);
+    }
+  }
+}
+
+template <typename JMM>
+void MatMulJitCode::genNoTransB() {
+  const int tail = n_ % block_;
+  const int num_vecs = (n_ + block_ - 1) / block_;
+  const int max_rows = std::min(m_, use_zmm_ ? 8 : 6);
+  const int free_regs = num_regs_ - 1 - (!use_zmm_ && tail != 0 ? 1 : 0);
+  const int vecs = std::min(num_vecs, free_regs / (max_rows + 1));
+  // the full tiles run in a loop, the rest vectors hold the tail
+  const int full_tiles = (n_ / block_) / vecs;
+  const int rest_vecs = num_vecs - full_tiles * vecs;
+  const size_t tile_bytes = vecs * block_ * sizeof(float);
+  for (int m_offset = 0; m_offset < m_; m_offset += max_rows) {
+    const int rows = std::min(max_rows, m_ - m_offset);
+    mov(reg_tile_b, param_b);
+    lea(reg_tile_c, ptr[param_c + m_offset * n_ * sizeof(float)]);
+    if (with_bias_) {
+      mov(reg_tile_bias, reg_bias);
+    }
+    if (full_tiles > 0) {
+      Label l_next_tile;
+      mov(reg_tiles, full_tiles);
+      L(l_next_tile);
+      genNoTransBTile<JMM>(m_offset, rows, vecs, false);
+      add(reg_tile_b, tile_bytes);
+      add(reg_tile_c, tile_bytes);
+      if (with_bias_) {
+        add(reg_tile_bias, tile_bytes);
       }
-      for (int i = 0; i < groups[g]; ++i) {
-        vmovups(zmm_t(w_reg_idx),
-                ptr[reg_ptr_wgt + wgt_offset + k * n_ * sizeof(float)]);
-        vfmadd231ps(zmm_t(i), zmm_t(w_reg_idx), zmm_t(x_reg_idx));
-        wgt_offset += block_len;
+      dec(reg_tiles);
+      jnz(l_next_tile, T_NEAR);
+    }
+    if (rest_vecs > 0) {
+      genNoTransBTile<JMM>(m_offset, rows, rest_vecs, tail != 0);
+    }
+  }
+}
+
+// Every accumulator is the dot of a row of A and a row of B along K. The
+// registers are the rows of A, the vector of B, the zeros of relu and the
+// rows * cols accumulators, xmm0 and xmm1 reduce the accumulators.
+template <typename JMM>
+void MatMulJitCode::genTransBTile(int m_offset, int rows, int cols) {
+  const size_t vec_bytes = block_ * sizeof(float);
+  const size_t row_bytes = k_ * sizeof(float);
+  const int b_idx = rows;
+  const int first_acc = std::max(rows + 1, 3);
+  auto acc = [=](int i, int j) { return first_acc + i * cols + j; };
+  auto fma = [&](bool tail) {
+    for (int i = 0; i < rows; ++i) {
+      loadVec(JMM(i), ptr[reg_ptr_a + i * row_bytes], tail);
+    }
+    for (int j = 0; j < cols; ++j) {
+      loadVec(JMM(b_idx), ptr[reg_ptr_b + j * row_bytes], tail);
+      for (int i = 0; i < rows; ++i) {
+        vfmadd231ps(JMM(acc(i, j)), JMM(i), JMM(b_idx));
       }
-      // last one, save
-      if (k == k_ - 1) {
-        for (int i = 0; i < groups[g]; ++i) {
-          // only rest save should be careful
-          if (rest != 0 && g == groups.size() - 1 && i == groups[g] - 1) {
-            break;
-          }
-          vmovups(ptr[param_z + z_offset + i * block_len], zmm_t(i));
-        }
+    }
+  };
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      zeroVec(acc(i, j));
+    }
+  }
+  lea(reg_ptr_a, ptr[param_a + m_offset * row_bytes]);
+  mov(reg_ptr_b, reg_tile_b);
+  if (k_ >= block_) {
+    Label l_next_k;
+    mov(reg_k, k_ / block_);
+    L(l_next_k);
+    fma(false);
+    add(reg_ptr_a, vec_bytes);
+    add(reg_ptr_b, vec_bytes);
+    dec(reg_k);
+    jnz(l_next_k, T_NEAR);
+  }
+  if (k_ % block_ != 0) {
+    fma(true);
+  }
+
+  if (relu_) {
+    vxorps(xmm_t(2), xmm_t(2), xmm_t(2));
+  }
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      reduceVec(acc(i, j));
+      if (with_bias_) {
+        vaddss(xmm_t(0), xmm_t(0), ptr[reg_tile_bias + j * sizeof(float)]);
       }
-      x_offset += sizeof(float);
-    }
-    z_offset += block_len * groups[g];
-  }
-
-  if (rest != 0) {
-    // below should refine with mask
-    int reg_idx = groups.back() - 1;
-    z_offset = (n_ - rest) * sizeof(float);
-    int inner_block = 8;
-    while (rest > 0) {
-      if (rest >= 8) {
-        inner_block = 8;
-        vmovups(ptr[param_z + z_offset], ymm_t(reg_idx));
-        // shift zmm of inner_block, change reg_idx if update
-      } else if (rest >= 4) {
-        inner_block = 4;
-        vmovups(ptr[param_z + z_offset], xmm_t(reg_idx));
-      } else if (rest >= 2) {
-        inner_block = 2;
-        vmovq(ptr[param_z + z_offset], xmm_t(reg_idx));
-      } else {
-        inner_block = 1;
-        vmovss(ptr[param_z + z_offset], xmm_t(reg_idx));
+      if (relu_) {
+        vmaxss(xmm_t(0), xmm_t(0), xmm_t(2));
       }
-      z_offset += inner_block * sizeof(float);
-      rest -= inner_block;
+      vmovss(ptr[reg_tile_c + (i * n_ + j) * sizeof(float)], xmm_t(0));
+    }
+  }
+}
+
+template <typename JMM>
+void MatMulJitCode::genTransB() {
+  const int max_rows = std::min(m_, use_zmm_ ? 4 : 2);
+  const int first_acc = std::max(max_rows + 1, 3);
+  const int free_regs =
+      num_regs_ - first_acc - (!use_zmm_ && k_ % block_ != 0 ? 1 : 0);
+  const int cols = std::min(n_, free_regs / max_rows);
+  const int full_tiles = n_ / cols;
+  const int rest_cols = n_ % cols;
+  for (int m_offset = 0; m_offset < m_; m_offset += max_rows) {
+    const int rows = std::min(max_rows, m_ - m_offset);
+    mov(reg_tile_b, param_b);
+    lea(reg_tile_c, ptr[param_c + m_offset * n_ * sizeof(float)]);
+    if (with_bias_) {
+      mov(reg_tile_bias, reg_bias);
+    }
+    Label l_next_tile;
+    mov(reg_tiles, full_tiles);
+    L(l_next_tile);
+    genTransBTile<JMM>(m_offset, rows, cols);
+    add(reg_tile_b, cols * k_ * sizeof(float));
+    add(reg_tile_c, cols * sizeof(float));
+    if (with_bias_) {
+      add(reg_tile_bias, cols * sizeof(float));
+    }
+    dec(reg_tiles);
+    jnz(l_next_tile, T_NEAR);
+    if (rest_cols > 0) {
+      genTransBTile<JMM>(m_offset, rows, rest_cols);
     }
   }
+}
 
+void MatMulJitCode::genCode() {
+  preCode();
+  if (with_bias_) {
+    mov(reg_bias, ptr[param_attr + offsetof(matmul_attr_t, bias)]);
+  }
+  mov(reg_batch.cvt32(), dword[param_attr + offsetof(matmul_attr_t, batch)]);
+  const int tail = (trans_b_ ? k_ : n_) % block_;
+  if (tail != 0) {
+    if (use_zmm_) {
+      mov(reg_tmp.cvt32(), (1 << tail) - 1);
+      kmovw(k1, reg_tmp.cvt32());
+    } else {
+      mov(reg_tmp, reinterpret_cast<size_t>(g_tail_mask + block_ - tail));
+      vmovups(ymm_t(num_regs_ - 1), ptr[reg_tmp]);
+    }
+  }
+
+  Label l_next_batch, l_end;
+  test(reg_batch.cvt32(), reg_batch.cvt32());
+  jle(l_end, T_NEAR);
+  L(l_next_batch);
+  {
+    if (use_zmm_ && trans_b_) {
+      genTransB<zmm_t>();
+    } else if (use_zmm_) {
+      genNoTransB<zmm_t>();
+    } else if (trans_b_) {
+      genTransB<ymm_t>();
+    } else {
+      genNoTransB<ymm_t>();
+    }
+    add(param_a, m_ * k_ * sizeof(float));
+    add(param_b, k_ * n_ * sizeof(float));
+    add(param_c, m_ * n_ * sizeof(float));
+    dec(reg_batch.cvt32());
+    jnz(l_next_batch, T_NEAR);
+  }
+  L(l_end);
   postCode();
 }
 
 class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
  public:
   bool CanBeUsed(const matmul_attr_t& attr) const override {
-    return attr.m == 1 && platform::MayIUse(platform::avx512f) &&
-           attr.n % ZMM_FLOAT_BLOCK == 0 && attr.k < 512;
+    // the blocks of rows are unrolled and B is read once for every block, so
+    // only the small M is generated; the strides of the batches are 32-bit
+    // immediates
+    const int64_t max_size =
+        std::max({static_cast<int64_t>(attr.m) * attr.k,
+                  static_cast<int64_t>(attr.k) * attr.n,
+                  static_cast<int64_t>(attr.m) * attr.n});
+    return (platform::MayIUse(platform::avx512f) ||
+            platform::MayIUse(platform::avx2)) &&
+           (attr.act == kVIdentity || attr.act == kVRelu) && attr.m > 0 &&
+           attr.m <= 16 && attr.n > 0 && attr.k > 0 &&
+           max_size * sizeof(float) <
+               static_cast<size_t>(std::numeric_limits<int>::max());
   }
   size_t CodeSize(const matmul_attr_t& attr) const override {
-    int block = YMM_FLOAT_BLOCK;
-    if (platform::MayIUse(platform::avx512f)) {
-      block = ZMM_FLOAT_BLOCK;
-    }
-    return 96 + 4 * attr.k * (attr.n / block + 1) * 8;
+    // every block of at least 2 rows has two tiles of at most 32
+    // accumulators, less than 16 instructions of 12 bytes each accumulator
+    return 512 + (attr.m + 1) / 2 * 2 * (64 + 32 * 16) * 12;
   }
   std::unique_ptr<GenBase> CreateJitCode(
       const matmul_attr_t& attr) const override {
@@ -27,16 +27,28 @@ namespace operators {
 namespace jit {
 namespace gen {
 
+// The register blocked GEMM of small shapes, on zmm with AVX512F or else on
+// ymm with AVX2. The tiles of C are accumulated in registers over the runtime
+// loop of K, the bias and the relu are applied before the tiles are stored.
 class MatMulJitCode : public JitCode {
  public:
   explicit MatMulJitCode(const matmul_attr_t& attr,
                          size_t code_size = 256 * 1024,
                          void* code_ptr = nullptr)
-      : JitCode(code_size, code_ptr), m_(attr.m), n_(attr.n), k_(attr.k) {
-    PADDLE_ENFORCE_EQ(m_, 1, platform::errors::Unimplemented(
-                                 "Jitcode of matmul only support m==1 (first "
-                                 "matrix's row) now. But m is %d.",
-                                 m_));
+      : JitCode(code_size, code_ptr),
+        m_(attr.m),
+        n_(attr.n),
+        k_(attr.k),
+        trans_b_(attr.trans_b),
+        relu_(attr.act == kVRelu),
+        with_bias_(attr.bias != nullptr),
+        use_zmm_(platform::MayIUse(platform::avx512f)) {
+    PADDLE_ENFORCE_EQ(
+        attr.act == kVIdentity || attr.act == kVRelu, true,
+        platform::errors::Unimplemented(
+            "Jitcode of matmul only supports identity and relu now."));
+    block_ = use_zmm_ ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
+    num_regs_ = use_zmm_ ? 32 : 16;
     this->genCode();
   }
 
@@ -44,20 +56,60 @@ class MatMulJitCode : public JitCode {
     std::string base = "MatMulJitCode";
     base = base + "_M" + std::to_string(m_) + "_N" + std::to_string(n_) + "_K" +
            std::to_string(k_);
-    return base;
+    if (trans_b_) {
+      base += "_TransB";
+    }
+    if (with_bias_) {
+      base += "_Bias";
+    }
+    if (relu_) {
+      base += "_Relu";
+    }
+    return base + (use_zmm_ ? "_AVX512" : "_AVX2");
   }
   void genCode() override;
 
  private:
+  // C += A * B, B is (K,N)
+  template <typename JMM>
+  void genNoTransB();
+  template <typename JMM>
+  void genNoTransBTile(int m_offset, int rows, int vecs, bool with_tail);
+  // C += A * B^T, B is (N,K)
+  template <typename JMM>
+  void genTransB();
+  template <typename JMM>
+  void genTransBTile(int m_offset, int rows, int cols);
+
+  // only the first floats of the tail are loaded, the others are zeros
+  template <typename JMM>
+  void loadVec(const JMM& dst, const Xbyak::Address& src, bool tail);
+  template <typename JMM>
+  void storeVec(const Xbyak::Address& dst, const JMM& src, bool tail);
+  void zeroVec(int idx);
+  // the sum of the floats of the vector idx into xmm0
+  void reduceVec(int idx);
+
   int m_, n_, k_;
+  bool trans_b_, relu_, with_bias_, use_zmm_;
+  int block_, num_regs_;
 
-  reg64_t param_x{abi_param1};
-  reg64_t param_y{abi_param2};
-  reg64_t param_z{abi_param3};
+  reg64_t param_a{abi_param1};
+  reg64_t param_b{abi_param2};
+  reg64_t param_c{abi_param3};
   reg64_t param_attr{abi_param4};
   reg64_t reg_tmp{rax};
 
-  reg64_t reg_ptr_wgt{r10};
+  reg64_t reg_k{rbx};
+  reg64_t reg_batch{r8};
+  reg64_t reg_bias{r9};
+  reg64_t reg_ptr_a{r10};
+  reg64_t reg_ptr_b{r11};
+  // the first B, C and bias of the current tile of C
+  reg64_t reg_tile_b{r12};
+  reg64_t reg_tile_c{r13};
+  reg64_t reg_tile_bias{r14};
+  reg64_t reg_tiles{r15};
 };
 
 }  // namespace gen
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -22,6 +23,7 @@
 #include <utility>  // for std::move
 #include <vector>
 
+#include "paddle/fluid/operators/jit/autotune.h"
 #include "paddle/fluid/operators/jit/gen_base.h"
 #include "paddle/fluid/operators/jit/kernel_base.h"
 #include "paddle/fluid/operators/jit/kernel_key.h"
@@ -191,6 +193,48 @@ typename KernelTuple::func_type GetDefaultBestFunc(
   return funcs[0];
 }
 
+// With FLAGS_jit_autotune, the candidates of an attr first seen are timed and
+// the fastest one is kept in the AutotuneTable. The choices already in the
+// table, or read from FLAGS_jit_autotune_file, are used without timing.
+template <typename KernelTuple, typename PlaceType = platform::CPUPlace>
+typename KernelTuple::func_type GetAutotunedBestFunc(
+    const typename KernelTuple::attr_type& attr) {
+  auto& table = AutotuneTable::Instance();
+  if (!table.Active()) {
+    return GetDefaultBestFunc<KernelTuple, PlaceType>(attr);
+  }
+  auto funcs = GetAllCandidateFuncsWithTypes<KernelTuple, PlaceType>(attr);
+  PADDLE_ENFORCE_GE(funcs.size(), 1UL,
+                    platform::errors::InvalidArgument(
+                        "The candicate jit kernel is at least one in CPU."));
+  if (funcs.size() == 1UL) {
+    return funcs[0].second;
+  }
+  std::string key = AutotuneKey(
+      KernelTuple::kernel_type,
+      AutotuneDataType<typename KernelTuple::data_type>(),
+      JitCodeKey<typename KernelTuple::attr_type>(attr));
+  std::string impl;
+  if (table.Find(key, &impl)) {
+    for (auto& f : funcs) {
+      if (f.first == impl) {
+        return f.second;
+      }
+    }
+  }
+  std::vector<double> times;
+  if (!table.Enabled() ||
+      !TimeCandidateFuncs<KernelTuple>(funcs, attr, &times)) {
+    return funcs[0].second;
+  }
+  size_t best = std::min_element(times.begin(), times.end()) - times.begin();
+  VLOG(3) << "Autotune " << key << ": " << funcs[best].first << " takes "
+          << times[best] << " ns, " << funcs[0].first << " takes " << times[0]
+          << " ns";
+  table.Insert(key, funcs[best].first);
+  return funcs[best].second;
+}
+
 extern std::map<size_t, std::shared_ptr<void>>& GetFuncCacheMap();
 
 template <typename KernelTuple, typename PlaceType>
@@ -219,8 +263,9 @@ class KernelFuncs {
     if (Has(key)) {
       return funcs_.at(key);
     }
-    // If do not have this attr in cache then get the default best
-    auto func = GetDefaultBestFunc<KernelTuple, PlaceType>(attr);
+    // If do not have this attr in cache then get the default best, or the
+    // tuned one with FLAGS_jit_autotune
+    auto func = GetAutotunedBestFunc<KernelTuple, PlaceType>(attr);
     Insert(key, func);
     return func;
   }
@@ -275,6 +320,15 @@ inline std::ostream& operator<<(std::ostream& os,
   return os;
 }
 
+inline std::ostream& operator<<(std::ostream& os,
+                                const emb_seq_pool_cvm_concat_attr_t& attr) {
+  os << "table_height[" << attr.table_height << "],table_width["
+     << attr.table_width << "],slot_num[" << attr.slot_num << "],batch_size["
+     << attr.batch_size << "],pool_type[" << to_string(attr.pool_type)
+     << "],use_cvm[" << attr.use_cvm << "]";
+  return os;
+}
+
 inline std::ostream& operator<<(std::ostream& os, const adam_attr_t& attr) {
   os << "beta1[" << attr.beta1 << "],beta2[" << attr.beta2 << "]";
   return os;
@@ -289,7 +343,9 @@ inline std::ostream& operator<<(std::ostream& os, const sgd_attr_t& attr) {
 }
 
 inline std::ostream& operator<<(std::ostream& os, const matmul_attr_t& attr) {
-  os << "M[" << attr.m << "],N[" << attr.n << "],K[" << attr.k << "]";
+  os << "M[" << attr.m << "],N[" << attr.n << "],K[" << attr.k << "],TransB["
+     << attr.trans_b << "],Bias[" << (attr.bias != nullptr) << "],Act["
+     << to_string(attr.act) << "]";
   return os;
 }
 
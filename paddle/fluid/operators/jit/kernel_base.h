@@ -13,6 +13,7 @@
  * limitations under the License. */
 
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include "paddle/fluid/operators/jit/macro.h"
 #include "paddle/fluid/platform/macros.h"
@@ -27,6 +28,7 @@ typedef enum {
   kAdam = 1,
   kCRFDecoding,
   kEmbSeqPool,
+  kEmbSeqPoolCVMConcat,
   kGRUH1,
   kGRUHtPart1,
   kGRUHtPart2,
@@ -247,6 +249,39 @@ struct EmbSeqPoolTuple {
                             const emb_seq_pool_attr_t*);
 };
 
+// The sequences of every slot are looked up in the table of the slot (the
+// rows are consecutive if the ids of the slot are null), pooled and
+// transformed by CVM, the slots of a sequence are concatenated in the row of
+// out. The first two columns of the tables are show and click.
+typedef struct emb_seq_pool_cvm_concat_attr_s {
+  int64_t table_height, table_width;
+  int64_t slot_num, batch_size;
+  SeqPoolType pool_type;
+  // log the show and click if use_cvm, or else drop them
+  bool use_cvm;
+  emb_seq_pool_cvm_concat_attr_s() = default;
+  explicit emb_seq_pool_cvm_concat_attr_s(
+      int64_t tbl_height, int64_t tbl_width, int64_t slots, int64_t batch,
+      SeqPoolType seqpool_type = SeqPoolType::kSum, bool cvm = true)
+      : table_height(tbl_height),
+        table_width(tbl_width),
+        slot_num(slots),
+        batch_size(batch),
+        pool_type(seqpool_type),
+        use_cvm(cvm) {}
+} emb_seq_pool_cvm_concat_attr_t;
+
+template <typename T>
+struct EmbSeqPoolCVMConcatTuple {
+  static constexpr KernelType kernel_type = kEmbSeqPoolCVMConcat;
+  typedef T data_type;
+  typedef emb_seq_pool_cvm_concat_attr_t attr_type;
+  // tables, ids and the LoD offsets of every slot, out
+  typedef void (*func_type)(const T* const*, const int64_t* const*,
+                            const size_t* const*, T*,
+                            const emb_seq_pool_cvm_concat_attr_t*);
+};
+
 typedef struct sgd_attr_s {
   int64_t param_height, param_width;
   int64_t grad_height, grad_width;
@@ -285,9 +320,16 @@ struct AdamTuple {
                             const T*, T*, T*, T*);
 };
 
+// C(M,N) = act(A(M,K) * B(K,N) + bias(N)), B is stored as (N,K) if trans_b.
+// The batch matrices are contiguous and share the bias, the batch and the bias
+// pointer are read when the kernel runs.
 typedef struct matmul_attr_s {
   int m, n, k;
   void* packed_weight{nullptr};
+  bool trans_b{false};
+  KernelType act{kVIdentity};  // kVIdentity or kVRelu
+  const void* bias{nullptr};
+  int batch{1};
   matmul_attr_s() = default;
   explicit matmul_attr_s(int m_, int n_, int k_, void* packed_weight_ = nullptr)
       : m(m_), n(n_), k(k_), packed_weight(packed_weight_) {}
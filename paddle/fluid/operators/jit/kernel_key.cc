@@ -50,7 +50,11 @@ int64_t JitCodeKey<seq_pool_attr_t>(const seq_pool_attr_t& attr) {
 
 template <>
 int64_t JitCodeKey<matmul_attr_t>(const matmul_attr_t& attr) {
-  return XXH64(&attr, sizeof(int) * 3, 0);  // m, n, k
+  // the batch is read at runtime, only the existence of the bias matters
+  int keys[6] = {attr.m, attr.n, attr.k, static_cast<int>(attr.trans_b),
+                 static_cast<int>(attr.act),
+                 static_cast<int>(attr.bias != nullptr)};
+  return XXH64(keys, sizeof(int) * 6, 0);
 }
 
 template <>
@@ -58,6 +62,15 @@ int64_t JitCodeKey<emb_seq_pool_attr_t>(const emb_seq_pool_attr_t& attr) {
   return attr.table_width;
 }
 
+template <>
+int64_t JitCodeKey<emb_seq_pool_cvm_concat_attr_t>(
+    const emb_seq_pool_cvm_concat_attr_t& attr) {
+  // the slots and the batch are read at runtime
+  int64_t keys[3] = {attr.table_width, static_cast<int64_t>(attr.pool_type),
+                     static_cast<int64_t>(attr.use_cvm)};
+  return XXH64(keys, sizeof(int64_t) * 3, 0);
+}
+
 template <>
 int64_t JitCodeKey<sgd_attr_t>(const sgd_attr_t& attr) {
   return attr.grad_width;
@@ -0,0 +1,170 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/jit/more/intrinsic/emb_seq_pool_cvm_concat.h"
+#include <cmath>
+#include <cstring>
+#include "paddle/fluid/operators/jit/registry.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+namespace paddle {
+namespace operators {
+namespace jit {
+namespace more {
+namespace intrinsic {
+
+// The pooled row of a sequence is kept in at most kMaxVecs ymm registers.
+constexpr int kMaxVecs = 8;
+// How many ids ahead the rows are prefetched.
+constexpr int kPrefetchDistance = 4;
+
+static inline const float* Row(const float* table, const int64_t* ids,
+                               size_t j, int64_t w) {
+  return table + (ids ? ids[j] : static_cast<int64_t>(j)) * w;
+}
+
+static inline void PrefetchRow(const float* row, int64_t w) {
+  // 16 floats in one cache line
+  for (int64_t i = 0; i < w; i += 16) {
+    _mm_prefetch(reinterpret_cast<const char*>(row + i), _MM_HINT_T0);
+  }
+}
+
+template <int kVecs>
+static void PoolCVMConcat(const float* const* tables, const int64_t* const* ids,
+                          const size_t* const* lods, float* out,
+                          const emb_seq_pool_cvm_concat_attr_t* attr) {
+  const int64_t w = attr->table_width;
+  const int64_t slot_num = attr->slot_num;
+  const int64_t out_w = attr->use_cvm ? w : w - 2;
+  // the last vector of a row only loads the rest of the row
+  alignas(32) int tail[YMM_FLOAT_BLOCK];
+  const int64_t rest = w - (kVecs - 1) * YMM_FLOAT_BLOCK;
+  for (int i = 0; i < YMM_FLOAT_BLOCK; ++i) {
+    tail[i] = i < rest ? -1 : 0;
+  }
+  const __m256i tail_mask =
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+  alignas(32) float pooled[kMaxVecs * YMM_FLOAT_BLOCK];
+  __m256 acc[kVecs];
+  for (int64_t b = 0; b < attr->batch_size; ++b) {
+    for (int64_t s = 0; s < slot_num; ++s) {
+      const float* table = tables[s];
+      const int64_t* id = ids[s];
+      const size_t begin = lods[s][b], end = lods[s][b + 1];
+      // the sequences are short in CTR models, so the first rows of the next
+      // sequence are prefetched while this one is pooled
+      int64_t next_s = s + 1 < slot_num ? s + 1 : 0;
+      int64_t next_b = s + 1 < slot_num ? b : b + 1;
+      if (next_b < attr->batch_size) {
+        size_t next_begin = lods[next_s][next_b];
+        size_t next_end = lods[next_s][next_b + 1];
+        for (size_t j = next_begin;
+             j < next_end && j < next_begin + kPrefetchDistance; ++j) {
+          PrefetchRow(Row(tables[next_s], ids[next_s], j, w), w);
+        }
+      }
+      for (int v = 0; v < kVecs; ++v) {
+        acc[v] = _mm256_setzero_ps();
+      }
+      for (size_t j = begin; j < end; ++j) {
+        if (j + kPrefetchDistance < end) {
+          PrefetchRow(Row(table, id, j + kPrefetchDistance, w), w);
+        }
+        const float* row = Row(table, id, j, w);
+        for (int v = 0; v < kVecs - 1; ++v) {
+          acc[v] =
+              _mm256_add_ps(acc[v], _mm256_loadu_ps(row + v * YMM_FLOAT_BLOCK));
+        }
+        acc[kVecs - 1] = _mm256_add_ps(
+            acc[kVecs - 1],
+            _mm256_maskload_ps(row + (kVecs - 1) * YMM_FLOAT_BLOCK, tail_mask));
+      }
+      const int64_t h = end - begin;
+      if (h > 0 && attr->pool_type != SeqPoolType::kSum) {
+        const __m256 scalar = _mm256_set1_ps(
+            attr->pool_type == SeqPoolType::kAvg
+                ? 1.f / static_cast<float>(h)
+                : 1.f / std::sqrt(static_cast<float>(h)));
+        for (int v = 0; v < kVecs; ++v) {
+          acc[v] = _mm256_mul_ps(acc[v], scalar);
+        }
+      }
+      float* dst = out + (b * slot_num + s) * out_w;
+      if (attr->use_cvm) {
+        // the embedding is stored in place, then show and click are logged
+        for (int v = 0; v < kVecs - 1; ++v) {
+          _mm256_storeu_ps(dst + v * YMM_FLOAT_BLOCK, acc[v]);
+        }
+        _mm256_maskstore_ps(dst + (kVecs - 1) * YMM_FLOAT_BLOCK, tail_mask,
+                            acc[kVecs - 1]);
+        dst[0] = std::log(dst[0] + 1);
+        dst[1] = std::log(dst[1] + 1) - dst[0];
+      } else {
+        for (int v = 0; v < kVecs; ++v) {
+          _mm256_store_ps(pooled + v * YMM_FLOAT_BLOCK, acc[v]);
+        }
+        std::memcpy(dst, pooled + 2, (w - 2) * sizeof(float));
+      }
+    }
+  }
+}
+
+void EmbSeqPoolCVMConcat(const float* const* tables, const int64_t* const* ids,
+                         const size_t* const* lods, float* out,
+                         const emb_seq_pool_cvm_concat_attr_t* attr) {
+  switch ((attr->table_width + YMM_FLOAT_BLOCK - 1) / YMM_FLOAT_BLOCK) {
+    case 1:
+      PoolCVMConcat<1>(tables, ids, lods, out, attr);
+      break;
+    case 2:
+      PoolCVMConcat<2>(tables, ids, lods, out, attr);
+      break;
+    case 3:
+      PoolCVMConcat<3>(tables, ids, lods, out, attr);
+      break;
+    case 4:
+      PoolCVMConcat<4>(tables, ids, lods, out, attr);
+      break;
+    case 5:
+      PoolCVMConcat<5>(tables, ids, lods, out, attr);
+      break;
+    case 6:
+      PoolCVMConcat<6>(tables, ids, lods, out, attr);
+      break;
+    case 7:
+      PoolCVMConcat<7>(tables, ids, lods, out, attr);
+      break;
+    default:
+      PoolCVMConcat<kMaxVecs>(tables, ids, lods, out, attr);
+      break;
+  }
+}
+
+bool EmbSeqPoolCVMConcatKernel::CanBeUsed(
+    const emb_seq_pool_cvm_concat_attr_t& attr) const {
+  return platform::MayIUse(platform::avx) && attr.table_width > 2 &&
+         attr.table_width <= kMaxVecs * YMM_FLOAT_BLOCK;
+}
+
+}  // namespace intrinsic
+}  // namespace more
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
+
+namespace intrinsic = paddle::operators::jit::more::intrinsic;
+
+REGISTER_JITKERNEL_MORE(kEmbSeqPoolCVMConcat, intrinsic,
+                        intrinsic::EmbSeqPoolCVMConcatKernel);
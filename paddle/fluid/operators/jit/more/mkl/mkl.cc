@@ -24,20 +24,51 @@ namespace jit {
 namespace more {
 namespace mkl {
 
+// adds the bias to the rows of C and applies the activation
+template <typename T>
+static void MatMulBiasAct(T* c, const matmul_attr_t* attr) {
+  PADDLE_ENFORCE_EQ(
+      attr->act == kVIdentity || attr->act == kVRelu, true,
+      platform::errors::Unimplemented(
+          "The activation of MatMul only supports identity and relu now."));
+  const T* bias = reinterpret_cast<const T*>(attr->bias);
+  if (bias == nullptr && attr->act == kVIdentity) {
+    return;
+  }
+  const int rows = attr->batch * attr->m;
+  for (int i = 0; i < rows; ++i) {
+    T* pc = c + i * attr->n;
+    for (int j = 0; j < attr->n; ++j) {
+      T v = bias ? pc[j] + bias[j] : pc[j];
+      pc[j] = (attr->act == kVRelu && v < static_cast<T>(0)) ? 0 : v;
+    }
+  }
+}
+
 template <>
 void MatMul<float>(const float* a, const float* b, float* c,
                    const matmul_attr_t* attr) {
-  platform::dynload::cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
-                                 attr->m, attr->n, attr->k, 1.f, a, attr->k, b,
-                                 attr->n, 0.f, c, attr->n);
+  const int m = attr->m, n = attr->n, k = attr->k;
+  for (int i = 0; i < attr->batch; ++i) {
+    platform::dynload::cblas_sgemm(
+        CblasRowMajor, CblasNoTrans, attr->trans_b ? CblasTrans : CblasNoTrans,
+        m, n, k, 1.f, a + i * m * k, k, b + i * k * n, attr->trans_b ? k : n,
+        0.f, c + i * m * n, n);
+  }
+  MatMulBiasAct(c, attr);
 }
 
 template <>
 void MatMul<double>(const double* a, const double* b, double* c,
                     const matmul_attr_t* attr) {
-  platform::dynload::cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
-                                 attr->m, attr->n, attr->k, 1.0, a, attr->k, b,
-                                 attr->n, 0.0, c, attr->n);
+  const int m = attr->m, n = attr->n, k = attr->k;
+  for (int i = 0; i < attr->batch; ++i) {
+    platform::dynload::cblas_dgemm(
+        CblasRowMajor, CblasNoTrans, attr->trans_b ? CblasTrans : CblasNoTrans,
+        m, n, k, 1.0, a + i * m * k, k, b + i * k * n, attr->trans_b ? k : n,
+        0.0, c + i * m * n, n);
+  }
+  MatMulBiasAct(c, attr);
 }
 
 template <>
@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/operators/jit/helper.h"
 #include "paddle/fluid/operators/jit/kernel_base.h"
@@ -378,22 +380,42 @@ void SeqPool(const T* x, T* y, const seq_pool_attr_t* attr) {
   }
 }
 
-// A(M,K) * B(K,N) = C(M,N)
+// act(A(M,K) * B(K,N) + bias(N)) = C(M,N) of every batch, B is (N,K) if
+// trans_b
 template <typename T>
 void MatMul(const T* A, const T* B, T* C, const matmul_attr_t* attr) {
   int M = attr->m;
   int N = attr->n;
   int K = attr->k;
-  for (int m = 0; m < M; ++m) {
-    const T* pa = A + m * K;
-    T* pc = C + m * N;
-    for (int n = 0; n < N; ++n) {
-      const T* pb = B + n;
-      pc[n] = pa[0] * pb[0];
-      for (int k = 1; k < K; ++k) {
-        pc[n] += pa[k] * pb[k * N];
+  PADDLE_ENFORCE_EQ(
+      attr->act == kVIdentity || attr->act == kVRelu, true,
+      platform::errors::Unimplemented(
+          "The activation of MatMul only supports identity and relu now."));
+  const T* bias = reinterpret_cast<const T*>(attr->bias);
+  // the strides of B between k and n
+  const int stride_k = attr->trans_b ? 1 : N;
+  const int stride_n = attr->trans_b ? K : 1;
+  for (int i = 0; i < attr->batch; ++i) {
+    for (int m = 0; m < M; ++m) {
+      const T* pa = A + m * K;
+      T* pc = C + m * N;
+      for (int n = 0; n < N; ++n) {
+        const T* pb = B + n * stride_n;
+        pc[n] = pa[0] * pb[0];
+        for (int k = 1; k < K; ++k) {
+          pc[n] += pa[k] * pb[k * stride_k];
+        }
+        if (bias) {
+          pc[n] += bias[n];
+        }
+        if (attr->act == kVRelu) {
+          pc[n] = pc[n] > static_cast<T>(0) ? pc[n] : static_cast<T>(0);
+        }
       }
     }
+    A += M * K;
+    B += K * N;
+    C += M * N;
   }
 }
 
@@ -503,6 +525,54 @@ void EmbSeqPool(const T* table, const int64_t* idx, T* out,
   }
 }
 
+// Looks up, pools and transforms by CVM the sequence b of every slot s into
+// out[b][s * out_w : (s + 1) * out_w], out_w is table_width if use_cvm and
+// table_width - 2 if not. The sequence b of the slot s is the ids (or the
+// rows if the ids are null) lods[s][b] to lods[s][b + 1].
+template <typename T>
+void EmbSeqPoolCVMConcat(const T* const* tables, const int64_t* const* ids,
+                         const size_t* const* lods, T* out,
+                         const emb_seq_pool_cvm_concat_attr_t* attr) {
+  const int64_t w = attr->table_width;
+  PADDLE_ENFORCE_GT(w, 2, platform::errors::InvalidArgument(
+                              "The attribute table_width of "
+                              "EmbSeqPoolCVMConcat should hold the show, the "
+                              "click and the embedding. But it is %d.",
+                              w));
+  const int64_t out_w = attr->use_cvm ? w : w - 2;
+  std::vector<T> pooled(w);
+  for (int64_t b = 0; b < attr->batch_size; ++b) {
+    for (int64_t s = 0; s < attr->slot_num; ++s) {
+      std::fill(pooled.begin(), pooled.end(), static_cast<T>(0));
+      const int64_t h = lods[s][b + 1] - lods[s][b];
+      for (size_t j = lods[s][b]; j < lods[s][b + 1]; ++j) {
+        int64_t row = ids[s] ? ids[s][j] : static_cast<int64_t>(j);
+        PADDLE_ENFORCE_EQ(
+            ids[s] == nullptr || (row >= 0 && row < attr->table_height), true,
+            platform::errors::InvalidArgument(
+                "The id of EmbSeqPoolCVMConcat should be in [0, %d). But the "
+                "%dth id of the slot %d is %d.",
+                attr->table_height, j, s, row));
+        VAdd(tables[s] + row * w, pooled.data(), pooled.data(), w);
+      }
+      if (h > 0 && attr->pool_type != SeqPoolType::kSum) {
+        T scalar = attr->pool_type == SeqPoolType::kAvg
+                       ? static_cast<T>(1) / static_cast<T>(h)
+                       : static_cast<T>(1) / std::sqrt(static_cast<T>(h));
+        VScal<T>(&scalar, pooled.data(), pooled.data(), w);
+      }
+      T* dst = out + (b * attr->slot_num + s) * out_w;
+      if (attr->use_cvm) {
+        dst[0] = std::log(pooled[0] + 1);
+        dst[1] = std::log(pooled[1] + 1) - dst[0];
+        std::copy(pooled.begin() + 2, pooled.end(), dst + 2);
+      } else {
+        std::copy(pooled.begin() + 2, pooled.end(), dst);
+      }
+    }
+  }
+}
+
 // SGD algorithm:
 // lr is pointor of learning rate scalar
 // param is an input matrix with (param_h, param_w)
@@ -616,6 +686,7 @@ DECLARE_REFER_KERNEL(SeqPool);
 DECLARE_REFER_KERNEL(MatMul);
 DECLARE_REFER_KERNEL(Softmax);
 DECLARE_REFER_KERNEL(EmbSeqPool);
+DECLARE_REFER_KERNEL(EmbSeqPoolCVMConcat);
 DECLARE_REFER_KERNEL(Adam);
 DECLARE_REFER_KERNEL(Sgd);
 DECLARE_REFER_KERNEL(VBroadcast);
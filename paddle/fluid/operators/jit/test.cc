@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <random>
 
@@ -23,6 +25,8 @@ limitations under the License. */
 #include "paddle/fluid/platform/place.h"
 
 DEFINE_double(acc, 1e-5, "Test accuracy threshold.");
+DECLARE_bool(jit_autotune);
+DECLARE_string(jit_autotune_file);
 
 template <typename T>
 void RandomVec(const int n, T* a, const T lower = static_cast<T>(-2.f),
@@ -671,6 +675,74 @@ void TestKernelEmbSeqPool() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void TestKernelEmbSeqPoolCVMConcat() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  int64_t tbl_h = 1e3;
+  std::vector<jit::SeqPoolType> pool_types = {
+      jit::SeqPoolType::kSum, jit::SeqPoolType::kAvg, jit::SeqPoolType::kSqrt};
+  for (int tbl_w : {3, 8, 9, 11, 18, 31, 64, 100}) {
+    for (int slot_num : {1, 3, 26}) {
+      for (int bs : {1, 7}) {
+        // the tables of the slots, or the rows of the sequences if no ids
+        std::vector<std::vector<T>> tables(slot_num);
+        std::vector<std::vector<int64_t>> ids(slot_num);
+        std::vector<std::vector<size_t>> lods(slot_num);
+        std::vector<const T*> table_data(slot_num);
+        std::vector<const int64_t*> ids_data(slot_num);
+        std::vector<const size_t*> lods_data(slot_num);
+        for (int s = 0; s < slot_num; ++s) {
+          lods[s].push_back(0);
+          for (int b = 0; b < bs; ++b) {
+            // the empty sequences are pooled to zeros
+            lods[s].push_back(lods[s].back() + (b * 3 + s) % 5);
+          }
+          int64_t len = lods[s].back();
+          tables[s].resize(std::max(tbl_h, len) * tbl_w);
+          // show and click are not negative
+          RandomVec<T>(tables[s].size(), tables[s].data(), 0.f, 2.f);
+          ids[s].resize(len);
+          RandomVec<int64_t>(len, ids[s].data(), 0, tbl_h - 1);
+          table_data[s] = tables[s].data();
+          lods_data[s] = lods[s].data();
+        }
+        for (bool use_ids : {true, false}) {
+          for (int s = 0; s < slot_num; ++s) {
+            ids_data[s] = use_ids ? ids[s].data() : nullptr;
+          }
+          for (auto type : pool_types) {
+            for (bool use_cvm : {true, false}) {
+              auto ref = jit::GetReferFunc<KernelTuple>();
+              EXPECT_TRUE(ref != nullptr);
+              jit::emb_seq_pool_cvm_concat_attr_t attr(tbl_h, tbl_w, slot_num,
+                                                       bs, type, use_cvm);
+              int64_t out_w = use_cvm ? tbl_w : tbl_w - 2;
+              std::vector<T> oref(bs * slot_num * out_w);
+              ref(table_data.data(), ids_data.data(), lods_data.data(),
+                  oref.data(), &attr);
+
+              auto verifier = [](const typename KernelTuple::func_type tgt,
+                                 const std::vector<const T*>& tables,
+                                 const std::vector<const int64_t*>& ids,
+                                 const std::vector<const size_t*>& lods,
+                                 const std::vector<T>& oref,
+                                 const typename KernelTuple::attr_type& attr) {
+                EXPECT_TRUE(tgt != nullptr);
+                std::vector<T> out(oref.size());
+                tgt(tables.data(), ids.data(), lods.data(), out.data(), &attr);
+                ExpectEQ<T>(out.data(), oref.data(), oref.size());
+              };
+              TestAllImpls<KernelTuple, PlaceType>(
+                  attr, verifier, table_data, ids_data, lods_data, oref, attr);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void TestKernelMatMul() {
   using T = typename KernelTuple::data_type;
@@ -679,36 +751,60 @@ void TestKernelMatMul() {
   // export MKL_CBWR=AVX would make MKL force to use AVX
   // export KMP_DETERMINISTIC_REDUCTION=yes would make the result deterministic
   FLAGS_acc = 1e-3;
+  auto verifier = [](const typename KernelTuple::func_type tgt,
+                     const std::vector<T>& a, const std::vector<T>& b,
+                     const std::vector<T>& cref,
+                     const typename KernelTuple::attr_type& attr) {
+    EXPECT_TRUE(tgt != nullptr);
+    EXPECT_EQ(a.size(), static_cast<size_t>(attr.batch * attr.m * attr.k));
+    EXPECT_EQ(b.size(), static_cast<size_t>(attr.batch * attr.k * attr.n));
+    EXPECT_EQ(cref.size(), static_cast<size_t>(attr.batch * attr.m * attr.n));
+    std::vector<T> c(cref.size());
+    const T* a_data = a.data();
+    const T* b_data = b.data();
+    const T* cref_data = cref.data();
+    T* c_data = c.data();
+    tgt(a_data, b_data, c_data, &attr);
+    ExpectEQ<T>(c_data, cref_data, cref.size());
+  };
+  auto test = [&](const jit::matmul_attr_t& attr) {
+    auto ref = jit::GetReferFunc<KernelTuple>();
+    EXPECT_TRUE(ref != nullptr);
+    const int m = attr.m, n = attr.n, k = attr.k, batch = attr.batch;
+    std::vector<T> a(batch * m * k), b(batch * k * n), c(batch * m * n);
+    RandomVec<T>(batch * m * k, a.data());
+    RandomVec<T>(batch * k * n, b.data());
+    const T* a_data = a.data();
+    const T* b_data = b.data();
+    T* c_data = c.data();
+    ref(a_data, b_data, c_data, &attr);
+    TestAllImpls<KernelTuple, PlaceType>(attr, verifier, a, b, c, attr);
+  };
   for (int m : {1, 2, 3, 4}) {
     for (int n : {1, 2, 3, 4}) {
       for (int k : TestSizes()) {
-        auto ref = jit::GetReferFunc<KernelTuple>();
-        EXPECT_TRUE(ref != nullptr);
-        std::vector<T> a(m * k), b(k * n), c(m * n);
-        RandomVec<T>(m * k, a.data());
-        RandomVec<T>(k * n, b.data());
-        const T* a_data = a.data();
-        const T* b_data = b.data();
-        T* c_data = c.data();
-        const jit::matmul_attr_t attr{m, n, k};
-        ref(a_data, b_data, c_data, &attr);
-        auto verifier = [](const typename KernelTuple::func_type tgt,
-                           const std::vector<T>& a, const std::vector<T>& b,
-                           const std::vector<T>& cref,
-                           const typename KernelTuple::attr_type& attr) {
-          EXPECT_TRUE(tgt != nullptr);
-          EXPECT_EQ(a.size(), static_cast<size_t>(attr.m * attr.k));
-          EXPECT_EQ(b.size(), static_cast<size_t>(attr.k * attr.n));
-          EXPECT_EQ(cref.size(), static_cast<size_t>(attr.m * attr.n));
-          std::vector<T> c(cref.size());
-          const T* a_data = a.data();
-          const T* b_data = b.data();
-          const T* cref_data = cref.data();
-          T* c_data = c.data();
-          tgt(a_data, b_data, c_data, &attr);
-          ExpectEQ<T>(c_data, cref_data, attr.m * attr.n);
-        };
-        TestAllImpls<KernelTuple, PlaceType>(attr, verifier, a, b, c, attr);
+        test(jit::matmul_attr_t{m, n, k});
+      }
+    }
+  }
+  // the tails of the tiles with the transposed B, the bias, relu and batches
+  for (int m : {1, 5, 9, 16}) {
+    for (int n : {1, 7, 16, 33}) {
+      for (int k : {1, 17, 64}) {
+        std::vector<T> bias(n);
+        RandomVec<T>(n, bias.data());
+        for (bool trans_b : {false, true}) {
+          for (int batch : {1, 3}) {
+            jit::matmul_attr_t attr(m, n, k);
+            attr.trans_b = trans_b;
+            attr.batch = batch;
+            test(attr);
+            attr.bias = bias.data();
+            test(attr);
+            attr.act = jit::kVRelu;
+            test(attr);
+          }
+        }
       }
     }
   }
@@ -1068,7 +1164,7 @@ TEST(JITKernel_pool, more) {
   size_t target_num = 8;
 
 #ifdef __AVX__
-  target_num += 2;
+  target_num += 3;
 #endif
 
 #ifdef PADDLE_WITH_MKLML
@@ -1080,7 +1176,7 @@ TEST(JITKernel_pool, more) {
 
 TEST(JITKernel_pool, refer) {
   const auto& kers = jit::ReferKernelPool::Instance().AllKernels();
-  EXPECT_EQ(kers.size(), 32UL);
+  EXPECT_EQ(kers.size(), 33UL);
 }
 
 // test helper
@@ -1252,7 +1348,52 @@ TEST(JITKernel_helper, attr) {
 
   out.str("");
   out << jit::matmul_attr_t(1, 2, 3);
-  EXPECT_EQ(out.str().size(), 14UL);
+  EXPECT_EQ(out.str().size(), 48UL);
+}
+
+TEST(JITKernel_helper, autotune) {
+  using KernelTuple = jit::MatMulTuple<float>;
+  jit::matmul_attr_t attr(3, 17, 40);
+  auto funcs = jit::GetAllCandidateFuncsWithTypes<KernelTuple, CPUPlace>(attr);
+  std::string key = jit::AutotuneKey(jit::kMatMul, "float",
+                                     jit::JitCodeKey<jit::matmul_attr_t>(attr));
+  const std::string& model = jit::AutotuneTable::Instance().CPUModel();
+  std::string tuned_file = "jit_autotune_tuned.txt";
+  std::string refer_file = "jit_autotune_refer.txt";
+  std::remove(tuned_file.c_str());
+
+  // the fastest candidate is chosen and saved
+  FLAGS_jit_autotune = true;
+  FLAGS_jit_autotune_file = tuned_file;
+  auto tuned = jit::GetAutotunedBestFunc<KernelTuple, CPUPlace>(attr);
+  std::string impl;
+  for (auto& f : funcs) {
+    if (f.second == tuned) {
+      impl = f.first;
+    }
+  }
+  EXPECT_FALSE(impl.empty());
+  if (funcs.size() > 1UL) {
+    std::ifstream fin(tuned_file);
+    std::string line;
+    std::getline(fin, line);
+    EXPECT_EQ(line, model + "\t" + key + "\t" + impl);
+  }
+
+  // the choices of this CPU model in the file are used without timing
+  FLAGS_jit_autotune = false;
+  std::ofstream fout(refer_file);
+  fout << model << "\t" << key << "\tRefer\n";
+  fout << "another cpu\t" << key << "\t" << funcs[0].first << "\n";
+  fout.close();
+  FLAGS_jit_autotune_file = refer_file;
+  EXPECT_EQ(jit::GetAutotunedBestFunc<KernelTuple>(attr),
+            jit::GetReferFunc<KernelTuple>());
+
+  FLAGS_jit_autotune_file = "";
+  EXPECT_EQ(jit::GetAutotunedBestFunc<KernelTuple>(attr), funcs[0].second);
+  std::remove(tuned_file.c_str());
+  std::remove(refer_file.c_str());
 }
 
 // test keys
@@ -1341,6 +1482,20 @@ TEST(JITKernel_key, matmul) {
   EXPECT_TRUE(key2 != key3);
   EXPECT_TRUE(key2 != key4);
   EXPECT_TRUE(key3 != key4);
+
+  // the batch and the address of the bias are read at runtime
+  float bias1[2], bias2[2];
+  attr1.batch = 4;
+  attr1.bias = bias1;
+  attr2.bias = bias2;
+  EXPECT_TRUE(jit::JitCodeKey<jit::matmul_attr_t>(attr1) ==
+              jit::JitCodeKey<jit::matmul_attr_t>(attr2));
+  EXPECT_TRUE(jit::JitCodeKey<jit::matmul_attr_t>(attr2) != key2);
+  attr2.act = jit::kVRelu;
+  EXPECT_TRUE(jit::JitCodeKey<jit::matmul_attr_t>(attr1) !=
+              jit::JitCodeKey<jit::matmul_attr_t>(attr2));
+  attr3.trans_b = true;
+  EXPECT_TRUE(jit::JitCodeKey<jit::matmul_attr_t>(attr3) != key3);
 }
 
 TEST(JITKernel_key, emb_seq_pool) {
@@ -1461,6 +1616,7 @@ TEST_CPU_KERNEL(CRFDecoding);
 
 TEST_CPU_KERNEL(SeqPool);
 TEST_CPU_KERNEL(EmbSeqPool);
+TEST_CPU_KERNEL(EmbSeqPoolCVMConcat);
 TEST_CPU_KERNEL(MatMul);
 TEST_CPU_KERNEL(Softmax);
 TEST_CPU_KERNEL(Adam);
@@ -269,6 +269,192 @@ class LayerNormGradOpMaker : public framework::SingleGradOpMaker<T> {
 DECLARE_NO_NEED_BUFFER_VARS_INFERER(LayerNormGradNoNeedBufferVarInferer,
                                     "Bias");
 
+// The float values of a Scale or Bias of float or bfloat16.
+static std::vector<float> ParamAsFloat(const Tensor *param, int64_t size) {
+  std::vector<float> values;
+  if (param == nullptr) {
+    return values;
+  }
+  PADDLE_ENFORCE_EQ(param->numel(), size,
+                    platform::errors::InvalidArgument(
+                        "The length of scale or bias (%d) is not equal with "
+                        "expected (%d).",
+                        param->numel(), size));
+  values.resize(size);
+  if (param->dtype() == phi::DataType::BFLOAT16) {
+    phi::funcs::CpuBf16ToFloat(param->data<platform::bfloat16>(),
+                               values.data(), size);
+  } else {
+    std::copy_n(param->data<float>(), size, values.data());
+  }
+  return values;
+}
+
+// Normalizes the row of x in place, returns its mean and variance.
+static std::pair<float, float> NormalizeRow(float *x, int64_t size,
+                                            float epsilon) {
+  float mean = 0.0f;
+  for (int64_t j = 0; j < size; ++j) {
+    mean += x[j];
+  }
+  mean /= size;
+  float var = 0.0f;
+  for (int64_t j = 0; j < size; ++j) {
+    var += (x[j] - mean) * (x[j] - mean);
+  }
+  var /= size;
+  const float rstd = 1.0f / std::sqrt(var + epsilon);
+  for (int64_t j = 0; j < size; ++j) {
+    x[j] = (x[j] - mean) * rstd;
+  }
+  return {mean, var};
+}
+
+// bfloat16 layer_norm on CPU normalizes every row in float, Y, Mean and
+// Variance are rounded when they are stored. Scale and Bias may be float or
+// bfloat16.
+template <>
+class LayerNormKernel<platform::CPUDeviceContext, platform::bfloat16>
+    : public framework::OpKernel<platform::bfloat16> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    using bfloat16 = platform::bfloat16;
+    const float epsilon = ctx.Attr<float>("epsilon");
+    auto *x = ctx.Input<Tensor>("X");
+    auto *y = ctx.Output<Tensor>("Y");
+    auto *mean = ctx.Output<Tensor>("Mean");
+    auto *var = ctx.Output<Tensor>("Variance");
+    auto matrix_dim =
+        phi::flatten_to_2d(x->dims(), ctx.Attr<int>("begin_norm_axis"));
+    const int64_t left = matrix_dim[0];
+    const int64_t right = matrix_dim[1];
+    auto scale = ParamAsFloat(ctx.Input<Tensor>("Scale"), right);
+    auto bias = ParamAsFloat(ctx.Input<Tensor>("Bias"), right);
+
+    const auto *x_data = x->data<bfloat16>();
+    auto *y_data = y->mutable_data<bfloat16>(ctx.GetPlace());
+    auto *mean_data = mean->mutable_data<bfloat16>(ctx.GetPlace());
+    auto *var_data = var->mutable_data<bfloat16>(ctx.GetPlace());
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    const int64_t grain_size = std::max<int64_t>(1, 16384 / right);
+    dev_ctx.ParallelFor(0, left, grain_size, [&](int64_t begin, int64_t end) {
+      std::vector<float> row(right);
+      for (int64_t i = begin; i < end; ++i) {
+        phi::funcs::CpuBf16ToFloat(x_data + i * right, row.data(), right);
+        auto stats = NormalizeRow(row.data(), right, epsilon);
+        for (int64_t j = 0; !scale.empty() && j < right; ++j) {
+          row[j] *= scale[j];
+        }
+        for (int64_t j = 0; !bias.empty() && j < right; ++j) {
+          row[j] += bias[j];
+        }
+        phi::funcs::CpuFloatToBf16(row.data(), y_data + i * right, right);
+        mean_data[i] = static_cast<bfloat16>(stats.first);
+        var_data[i] = static_cast<bfloat16>(stats.second);
+      }
+    });
+  }
+};
+
+// Stores the float values into the gradient of a Scale or Bias, which has
+// the data type of the parameter.
+static void SetParamGrad(const std::vector<float> &values, const Tensor &param,
+                         const platform::Place &place, Tensor *grad) {
+  if (param.dtype() == phi::DataType::BFLOAT16) {
+    phi::funcs::CpuFloatToBf16(values.data(),
+                               grad->mutable_data<platform::bfloat16>(place),
+                               values.size());
+  } else {
+    std::copy(values.begin(), values.end(), grad->mutable_data<float>(place));
+  }
+}
+
+// NOTE: the rounded Mean and Variance of the forward are not used, the
+// gradients recompute them in float from X.
+template <>
+class LayerNormGradKernel<platform::CPUDeviceContext, platform::bfloat16>
+    : public framework::OpKernel<platform::bfloat16> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    using bfloat16 = platform::bfloat16;
+    const float epsilon = ctx.Attr<float>("epsilon");
+    auto *x = ctx.Input<Tensor>("X");
+    auto *scale_tensor = ctx.Input<Tensor>("Scale");
+    auto *d_y = ctx.Input<Tensor>(framework::GradVarName("Y"));
+    auto *d_x = ctx.Output<Tensor>(framework::GradVarName("X"));
+    auto *d_scale = ctx.Output<Tensor>(framework::GradVarName("Scale"));
+    auto *d_bias = ctx.Output<Tensor>(framework::GradVarName("Bias"));
+    auto matrix_dim =
+        phi::flatten_to_2d(x->dims(), ctx.Attr<int>("begin_norm_axis"));
+    const int64_t left = matrix_dim[0];
+    const int64_t right = matrix_dim[1];
+    auto scale = ParamAsFloat(scale_tensor, right);
+
+    std::vector<float> x_norm(left * right);
+    std::vector<float> dy(left * right);
+    const auto *x_data = x->data<bfloat16>();
+    const auto *dy_data = d_y->data<bfloat16>();
+    bfloat16 *dx_data =
+        d_x ? d_x->mutable_data<bfloat16>(ctx.GetPlace()) : nullptr;
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    const int64_t grain_size = std::max<int64_t>(1, 16384 / right);
+    dev_ctx.ParallelFor(0, left, grain_size, [&](int64_t begin, int64_t end) {
+      std::vector<float> g(right);
+      for (int64_t i = begin; i < end; ++i) {
+        float *row = x_norm.data() + i * right;
+        float *dy_row = dy.data() + i * right;
+        phi::funcs::CpuBf16ToFloat(x_data + i * right, row, right);
+        phi::funcs::CpuBf16ToFloat(dy_data + i * right, dy_row, right);
+        const float var = NormalizeRow(row, right, epsilon).second;
+        const float rstd = 1.0f / std::sqrt(var + epsilon);
+        if (dx_data == nullptr) {
+          continue;
+        }
+        float mean_g = 0.0f;
+        float mean_g_x = 0.0f;
+        for (int64_t j = 0; j < right; ++j) {
+          g[j] = scale.empty() ? dy_row[j] : dy_row[j] * scale[j];
+          mean_g += g[j];
+          mean_g_x += g[j] * row[j];
+        }
+        mean_g /= right;
+        mean_g_x /= right;
+        for (int64_t j = 0; j < right; ++j) {
+          g[j] = (g[j] - mean_g - row[j] * mean_g_x) * rstd;
+        }
+        phi::funcs::CpuFloatToBf16(g.data(), dx_data + i * right, right);
+      }
+    });
+
+    if (d_scale == nullptr && d_bias == nullptr) {
+      return;
+    }
+    // the columns are summed over the rows in order, whatever the threads
+    std::vector<float> d_scale_values(d_scale ? right : 0);
+    std::vector<float> d_bias_values(d_bias ? right : 0);
+    const int64_t col_grain = std::max<int64_t>(1, 16384 / left);
+    dev_ctx.ParallelFor(0, right, col_grain, [&](int64_t begin, int64_t end) {
+      for (int64_t i = 0; i < left; ++i) {
+        for (int64_t j = begin; j < end; ++j) {
+          if (d_scale) {
+            d_scale_values[j] += dy[i * right + j] * x_norm[i * right + j];
+          }
+          if (d_bias) {
+            d_bias_values[j] += dy[i * right + j];
+          }
+        }
+      }
+    });
+    if (d_scale) {
+      SetParamGrad(d_scale_values, *scale_tensor, ctx.GetPlace(), d_scale);
+    }
+    if (d_bias) {
+      SetParamGrad(d_bias_values, *ctx.Input<Tensor>("Bias"), ctx.GetPlace(),
+                   d_bias);
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
@@ -280,8 +466,12 @@ REGISTER_OPERATOR(layer_norm_grad, ops::LayerNormGradOp,
                   ops::LayerNormGradNoNeedBufferVarInferer);
 REGISTER_OP_CPU_KERNEL(
     layer_norm, ops::LayerNormKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::LayerNormKernel<paddle::platform::CPUDeviceContext, double>);
+    ops::LayerNormKernel<paddle::platform::CPUDeviceContext, double>,
+    ops::LayerNormKernel<paddle::platform::CPUDeviceContext,
+                         paddle::platform::bfloat16>);
 REGISTER_OP_CPU_KERNEL(
     layer_norm_grad,
     ops::LayerNormGradKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::LayerNormGradKernel<paddle::platform::CPUDeviceContext, double>);
+    ops::LayerNormGradKernel<paddle::platform::CPUDeviceContext, double>,
+    ops::LayerNormGradKernel<paddle::platform::CPUDeviceContext,
+                             paddle::platform::bfloat16>);
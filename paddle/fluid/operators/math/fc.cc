@@ -21,6 +21,9 @@ namespace paddle {
 namespace operators {
 namespace math {
 
+// the rows of the inputs computed by the jit small gemm kernels
+constexpr int kFCSmallRows = 16;
+
 template <typename T>
 class FCFunctor<platform::CPUDeviceContext, T> {
  public:
@@ -28,6 +31,19 @@ class FCFunctor<platform::CPUDeviceContext, T> {
                   const int N, const int K, const T* X, const T* W, T* Y,
                   const T* B = nullptr, bool relu = false,
                   bool padding_weights = false) {
+    // the gemm, the bias and the relu of the small batches are fused in one
+    // jit kernel
+    jit::matmul_attr_t attr(M, N, K);
+    attr.bias = B;
+    attr.act = relu ? jit::kVRelu : jit::kVIdentity;
+    if (!padding_weights && M <= kFCSmallRows && (B != nullptr || !relu) &&
+        jit::GetJitCode<jit::MatMulTuple<T>, platform::CPUPlace>(attr)) {
+      auto matmul =
+          jit::KernelFuncs<jit::MatMulTuple<T>, platform::CPUPlace>::Cache().At(
+              attr);
+      matmul(X, W, Y, &attr);
+      return;
+    }
     auto blas = phi::funcs::GetBlas<platform::CPUDeviceContext, T>(context);
     framework::Tensor Y1;
     T* Y1_data = nullptr;
@@ -26,6 +26,12 @@ template class SoftmaxFunctor<platform::CPUDeviceContext, double, true>;
 template class SoftmaxFunctor<platform::CPUDeviceContext, double, false>;
 template class SoftmaxGradFunctor<platform::CPUDeviceContext, float>;
 template class SoftmaxGradFunctor<platform::CPUDeviceContext, double>;
+template class SoftmaxFunctor<platform::CPUDeviceContext, platform::bfloat16,
+                              true>;
+template class SoftmaxFunctor<platform::CPUDeviceContext, platform::bfloat16,
+                              false>;
+template class SoftmaxGradFunctor<platform::CPUDeviceContext,
+                                  platform::bfloat16>;
 
 template class SoftmaxFunctor<phi::CPUContext, float, true>;
 template class SoftmaxFunctor<phi::CPUContext, float, false>;
@@ -33,6 +39,9 @@ template class SoftmaxFunctor<phi::CPUContext, double, true>;
 template class SoftmaxFunctor<phi::CPUContext, double, false>;
 template class SoftmaxGradFunctor<phi::CPUContext, float>;
 template class SoftmaxGradFunctor<phi::CPUContext, double>;
+template class SoftmaxFunctor<phi::CPUContext, platform::bfloat16, true>;
+template class SoftmaxFunctor<phi::CPUContext, platform::bfloat16, false>;
+template class SoftmaxGradFunctor<phi::CPUContext, platform::bfloat16>;
 
 }  // namespace math
 }  // namespace operators
@@ -19,6 +19,7 @@ limitations under the License. */
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/cpu_vec.h"
 #include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/phi/kernels/funcs/cpu_bf16.h"
 
 namespace paddle {
 namespace operators {
@@ -224,7 +225,11 @@ void SoftmaxFunctor<DeviceContext, T, is_test, Enable>::operator()(
 
 template <class DeviceContext>
 using enable_if_CPU = typename std::enable_if<
-    std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type;
+    std::is_same<DeviceContext, platform::CPUDeviceContext>::value ||
+    std::is_same<DeviceContext, phi::CPUContext>::value>::type;
+
+// the elements computed by one intra-op thread at least
+static constexpr int64_t kSoftmaxGrainSize = 16384;
 
 template <typename DeviceContext, typename T, bool is_test>
 class SoftmaxFunctor<DeviceContext, T, is_test, enable_if_CPU<DeviceContext>> {
@@ -240,24 +245,32 @@ class SoftmaxFunctor<DeviceContext, T, is_test, enable_if_CPU<DeviceContext>> {
     const int num_remain = num_classes / axis_dim;
 
     if (num_remain == 1 && platform::MayIUse(platform::avx)) {
-      const T* in_data = X->data<T>();
-      T* out_data = Y->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T max_val = *std::max_element(in_data, in_data + num_classes);
-        max_val *= static_cast<T>(-1);
-        vec_add_bias<T, platform::avx>(num_classes, max_val, in_data, out_data);
-        vec_clip<T, platform::avx>(num_classes, static_cast<T>(-64), out_data,
-                                   out_data);
-        vec_exp<T>(num_classes, out_data, out_data);
-
-        T sum = 0;
-        vec_sum<T, platform::avx>(num_classes, out_data, &sum);
-        sum = static_cast<T>(1) / sum;
-        vec_scal<T, platform::avx>(num_classes, sum, out_data, out_data);
-
-        in_data += num_classes;
-        out_data += num_classes;
-      }
+      const T* x_data = X->data<T>();
+      T* y_data = Y->data<T>();
+      int64_t grain_size =
+          std::max<int64_t>(1, kSoftmaxGrainSize / std::max(num_classes, 1));
+      context.ParallelFor(0, batch_size, grain_size, [&](int64_t begin,
+                                                         int64_t end) {
+        const T* in_data = x_data + begin * num_classes;
+        T* out_data = y_data + begin * num_classes;
+        for (int64_t bs = begin; bs < end; ++bs) {
+          T max_val = *std::max_element(in_data, in_data + num_classes);
+          max_val *= static_cast<T>(-1);
+          vec_add_bias<T, platform::avx>(num_classes, max_val, in_data,
+                                         out_data);
+          vec_clip<T, platform::avx>(num_classes, static_cast<T>(-64),
+                                     out_data, out_data);
+          vec_exp<T>(num_classes, out_data, out_data);
+
+          T sum = 0;
+          vec_sum<T, platform::avx>(num_classes, out_data, &sum);
+          sum = static_cast<T>(1) / sum;
+          vec_scal<T, platform::avx>(num_classes, sum, out_data, out_data);
+
+          in_data += num_classes;
+          out_data += num_classes;
+        }
+      });
     } else {
       SoftmaxEigen<DeviceContext, T, is_test>()(context, axis_dim, X, Y);
     }
@@ -283,6 +296,65 @@ class SoftmaxFunctor<DeviceContext, float, true, enable_if_CPU<DeviceContext>> {
   }
 };
 
+// bfloat16 is computed in float, only the outputs are rounded: the rows of
+// the last axis one by one, the other axes by the float Eigen path on a
+// widened copy.
+template <typename DeviceContext, bool is_test>
+class SoftmaxFunctor<DeviceContext, platform::bfloat16, is_test,
+                     enable_if_CPU<DeviceContext>> {
+ public:
+  void operator()(const DeviceContext& context, const int axis_dim,
+                  const framework::Tensor* X, framework::Tensor* Y) {
+    auto in_dims = X->dims();
+    constexpr int kBatchDim = 0;
+    constexpr int kClassDim = 1;
+
+    const int num_classes = in_dims[kClassDim];
+    const int batch_size = in_dims[kBatchDim];
+    const int num_remain = num_classes / axis_dim;
+
+    if (num_remain != 1) {
+      framework::Tensor x_fp32, y_fp32;
+      x_fp32.mutable_data<float>(in_dims, context.GetPlace());
+      y_fp32.mutable_data<float>(in_dims, context.GetPlace());
+      phi::funcs::CpuBf16ToFloat(context, X->data<platform::bfloat16>(),
+                                 x_fp32.data<float>(), X->numel());
+      SoftmaxEigen<DeviceContext, float, is_test>()(context, axis_dim,
+                                                    &x_fp32, &y_fp32);
+      phi::funcs::CpuFloatToBf16(context, y_fp32.data<float>(),
+                                 Y->data<platform::bfloat16>(), Y->numel());
+      return;
+    }
+    const platform::bfloat16* x_data = X->data<platform::bfloat16>();
+    platform::bfloat16* y_data = Y->data<platform::bfloat16>();
+    int64_t grain_size =
+        std::max<int64_t>(1, kSoftmaxGrainSize / std::max(num_classes, 1));
+    context.ParallelFor(0, batch_size, grain_size, [&](int64_t begin,
+                                                       int64_t end) {
+      std::vector<float> row(num_classes);
+      for (int64_t bs = begin; bs < end; ++bs) {
+        phi::funcs::CpuBf16ToFloat(x_data + bs * num_classes, row.data(),
+                                   num_classes);
+        float max_val = *std::max_element(row.begin(), row.end());
+        for (int i = 0; i < num_classes; ++i) {
+          row[i] = std::max(row[i] - max_val, -64.0f);
+        }
+        vec_exp<float>(num_classes, row.data(), row.data());
+        float sum = 0;
+        for (int i = 0; i < num_classes; ++i) {
+          sum += row[i];
+        }
+        const float scale = 1.0f / sum;
+        for (int i = 0; i < num_classes; ++i) {
+          row[i] *= scale;
+        }
+        phi::funcs::CpuFloatToBf16(row.data(), y_data + bs * num_classes,
+                                   num_classes);
+      }
+    });
+  }
+};
+
 template <typename DeviceContext, typename T>
 class SoftmaxGradEigen {
  public:
@@ -402,20 +474,29 @@ class SoftmaxGradFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
     const int num_remain = num_classes / axis_dim;
 
     if (num_remain == 1 && platform::MayIUse(platform::avx)) {
-      const T* out_data = y->data<T>();
-      const T* out_grad = y_grad->data<T>();
-      T* in_grad = x_grad->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T scalar;
-        vec_mul_reduce<T, platform::avx>(num_classes, out_grad, out_data,
-                                         &scalar);
-        scalar *= static_cast<T>(-1);
-        vec_add_bias<T, platform::avx>(num_classes, scalar, out_grad, in_grad);
-        vec_mul<T, platform::avx>(num_classes, out_data, in_grad, in_grad);
-        out_data += num_classes;
-        out_grad += num_classes;
-        in_grad += num_classes;
-      }
+      const T* y_data = y->data<T>();
+      const T* y_grad_data = y_grad->data<T>();
+      T* x_grad_data = x_grad->data<T>();
+      int64_t grain_size =
+          std::max<int64_t>(1, kSoftmaxGrainSize / std::max(num_classes, 1));
+      context.ParallelFor(0, batch_size, grain_size, [&](int64_t begin,
+                                                         int64_t end) {
+        const T* out_data = y_data + begin * num_classes;
+        const T* out_grad = y_grad_data + begin * num_classes;
+        T* in_grad = x_grad_data + begin * num_classes;
+        for (int64_t bs = begin; bs < end; ++bs) {
+          T scalar;
+          vec_mul_reduce<T, platform::avx>(num_classes, out_grad, out_data,
+                                           &scalar);
+          scalar *= static_cast<T>(-1);
+          vec_add_bias<T, platform::avx>(num_classes, scalar, out_grad,
+                                         in_grad);
+          vec_mul<T, platform::avx>(num_classes, out_data, in_grad, in_grad);
+          out_data += num_classes;
+          out_grad += num_classes;
+          in_grad += num_classes;
+        }
+      });
     } else {
       SoftmaxGradEigen<DeviceContext, T>()(context, axis_dim, y, y_grad,
                                            x_grad);
@@ -423,6 +504,63 @@ class SoftmaxGradFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
   }
 };
 
+template <typename DeviceContext>
+class SoftmaxGradFunctor<DeviceContext, platform::bfloat16,
+                         enable_if_CPU<DeviceContext>> {
+ public:
+  void operator()(const DeviceContext& context, const int axis_dim,
+                  const framework::Tensor* y, const framework::Tensor* y_grad,
+                  framework::Tensor* x_grad) {
+    auto out_dims = y->dims();
+    constexpr int kBatchDim = 0;
+    constexpr int kClassDim = 1;
+    const int num_classes = out_dims[kClassDim];
+    const int batch_size = out_dims[kBatchDim];
+    const int num_remain = num_classes / axis_dim;
+
+    if (num_remain != 1) {
+      framework::Tensor y_fp32, y_grad_fp32, x_grad_fp32;
+      y_fp32.mutable_data<float>(out_dims, context.GetPlace());
+      y_grad_fp32.mutable_data<float>(out_dims, context.GetPlace());
+      x_grad_fp32.mutable_data<float>(out_dims, context.GetPlace());
+      phi::funcs::CpuBf16ToFloat(context, y->data<platform::bfloat16>(),
+                                 y_fp32.data<float>(), y->numel());
+      phi::funcs::CpuBf16ToFloat(context, y_grad->data<platform::bfloat16>(),
+                                 y_grad_fp32.data<float>(), y_grad->numel());
+      SoftmaxGradEigen<DeviceContext, float>()(context, axis_dim, &y_fp32,
+                                               &y_grad_fp32, &x_grad_fp32);
+      phi::funcs::CpuFloatToBf16(context, x_grad_fp32.data<float>(),
+                                 x_grad->data<platform::bfloat16>(),
+                                 x_grad->numel());
+      return;
+    }
+    const platform::bfloat16* y_data = y->data<platform::bfloat16>();
+    const platform::bfloat16* y_grad_data = y_grad->data<platform::bfloat16>();
+    platform::bfloat16* x_grad_data = x_grad->data<platform::bfloat16>();
+    int64_t grain_size =
+        std::max<int64_t>(1, kSoftmaxGrainSize / std::max(num_classes, 1));
+    context.ParallelFor(0, batch_size, grain_size, [&](int64_t begin,
+                                                       int64_t end) {
+      std::vector<float> out(num_classes), out_grad(num_classes);
+      for (int64_t bs = begin; bs < end; ++bs) {
+        phi::funcs::CpuBf16ToFloat(y_data + bs * num_classes, out.data(),
+                                   num_classes);
+        phi::funcs::CpuBf16ToFloat(y_grad_data + bs * num_classes,
+                                   out_grad.data(), num_classes);
+        float dot = 0;
+        for (int i = 0; i < num_classes; ++i) {
+          dot += out[i] * out_grad[i];
+        }
+        for (int i = 0; i < num_classes; ++i) {
+          out[i] *= out_grad[i] - dot;
+        }
+        phi::funcs::CpuFloatToBf16(out.data(), x_grad_data + bs * num_classes,
+                                   num_classes);
+      }
+    });
+  }
+};
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/optimizers/adam_op.h"
+#include <cmath>
 #include "paddle/fluid/framework/op_version_registry.h"
 #include "paddle/fluid/operators/optimizers/adamw_op.h"
 
@@ -251,6 +252,171 @@ class AdamWOpMaker : public AdamOpMaker {
   }
 };
 
+// Read a float or bfloat16 CPU tensor of one element as float.
+static float ScalarAsFloat(const framework::Tensor& tensor) {
+  if (tensor.dtype() == phi::DataType::BFLOAT16) {
+    return static_cast<float>(tensor.data<platform::bfloat16>()[0]);
+  }
+  return tensor.data<float>()[0];
+}
+
+static void SetScalar(float value, const platform::Place& place,
+                      const framework::Tensor& like, framework::Tensor* out) {
+  if (like.dtype() == phi::DataType::BFLOAT16) {
+    out->mutable_data<platform::bfloat16>(place)[0] =
+        static_cast<platform::bfloat16>(value);
+  } else {
+    out->mutable_data<float>(place)[0] = value;
+  }
+}
+
+// The moments are stored as MT, float or bfloat16, the master parameters
+// are float. Everything is computed in float.
+template <typename MT>
+static void Bf16AdamUpdate(const platform::CPUDeviceContext& dev_ctx,
+                           float beta1, float beta2, float lr, float eps,
+                           int64_t numel, const platform::bfloat16* grad,
+                           const MT* mom1, const MT* mom2,
+                           const float* master_param,
+                           const platform::bfloat16* param, MT* mom1_out,
+                           MT* mom2_out, float* master_param_out,
+                           platform::bfloat16* param_out) {
+  dev_ctx.ParallelFor(0, numel, 4096, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      float g = static_cast<float>(grad[i]);
+      float m1 = beta1 * static_cast<float>(mom1[i]) + (1 - beta1) * g;
+      float m2 = beta2 * static_cast<float>(mom2[i]) + (1 - beta2) * g * g;
+      float p = master_param ? master_param[i] : static_cast<float>(param[i]);
+      p -= lr * (m1 / (std::sqrt(m2) + eps));
+      mom1_out[i] = static_cast<MT>(m1);
+      mom2_out[i] = static_cast<MT>(m2);
+      if (master_param_out) {
+        master_param_out[i] = p;
+      }
+      param_out[i] = static_cast<platform::bfloat16>(p);
+    }
+  });
+}
+
+// Adam of bfloat16 parameters on CPU with dense gradients. The moments, the
+// learning rate and the beta powers may be float or bfloat16, the update is
+// computed in float and rounded only when it is stored.
+template <>
+class AdamOpKernel<platform::CPUDeviceContext, platform::bfloat16>
+    : public framework::OpKernel<platform::bfloat16> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    using LoDTensor = framework::LoDTensor;
+    using bfloat16 = platform::bfloat16;
+    auto* grad_var = ctx.InputVar("Grad");
+    PADDLE_ENFORCE_EQ(grad_var->IsType<LoDTensor>(), true,
+                      platform::errors::Unimplemented(
+                          "The bfloat16 adam on CPU only supports the dense "
+                          "gradients, but received %s.",
+                          framework::ToTypeName(grad_var->Type())));
+
+    auto* param = ctx.Input<LoDTensor>("Param");
+    auto* grad = ctx.Input<LoDTensor>("Grad");
+    auto* mom1 = ctx.Input<LoDTensor>("Moment1");
+    auto* mom2 = ctx.Input<LoDTensor>("Moment2");
+    auto* lr = ctx.Input<LoDTensor>("LearningRate");
+    auto* beta1_pow = ctx.Input<LoDTensor>("Beta1Pow");
+    auto* beta2_pow = ctx.Input<LoDTensor>("Beta2Pow");
+
+    auto* param_out = ctx.Output<LoDTensor>("ParamOut");
+    auto* mom1_out = ctx.Output<LoDTensor>("Moment1Out");
+    auto* mom2_out = ctx.Output<LoDTensor>("Moment2Out");
+    auto* beta1_pow_out = ctx.Output<LoDTensor>("Beta1PowOut");
+    auto* beta2_pow_out = ctx.Output<LoDTensor>("Beta2PowOut");
+
+    const LoDTensor* master_param = nullptr;
+    LoDTensor* master_param_out = nullptr;
+    if (ctx.Attr<bool>("multi_precision")) {
+      PADDLE_ENFORCE_EQ(
+          ctx.HasInput("MasterParam") && ctx.HasOutput("MasterParamOut"),
+          true, platform::errors::InvalidArgument(
+                    "The Input(MasterParam) and Output(MasterParamOut) "
+                    "should not be null when the attr `multi_precision` is "
+                    "true"));
+      master_param = ctx.Input<LoDTensor>("MasterParam");
+      master_param_out = ctx.Output<LoDTensor>("MasterParamOut");
+    }
+
+    if (ctx.HasInput("SkipUpdate")) {
+      auto* skip_update = ctx.Input<framework::Tensor>("SkipUpdate");
+      PADDLE_ENFORCE_EQ(skip_update->numel(), 1,
+                        platform::errors::InvalidArgument(
+                            "Input(SkipUpdate) size must be 1, but get %d",
+                            skip_update->numel()));
+      if (skip_update->data<bool>()[0]) {
+        VLOG(4) << "Adam skip update";
+        auto& dev_ctx = ctx.device_context();
+        framework::TensorCopy(*param, ctx.GetPlace(), dev_ctx, param_out);
+        framework::TensorCopy(*mom1, ctx.GetPlace(), dev_ctx, mom1_out);
+        framework::TensorCopy(*mom2, ctx.GetPlace(), dev_ctx, mom2_out);
+        framework::TensorCopy(*beta1_pow, ctx.GetPlace(), dev_ctx,
+                              beta1_pow_out);
+        framework::TensorCopy(*beta2_pow, ctx.GetPlace(), dev_ctx,
+                              beta2_pow_out);
+        if (master_param) {
+          framework::TensorCopy(*master_param, ctx.GetPlace(), dev_ctx,
+                                master_param_out);
+        }
+        return;
+      }
+    }
+
+    float beta1 = ctx.Attr<float>("beta1");
+    if (ctx.HasInput("Beta1Tensor")) {
+      beta1 = GetAttrFromTensor(ctx.Input<framework::Tensor>("Beta1Tensor"));
+    }
+    float beta2 = ctx.Attr<float>("beta2");
+    if (ctx.HasInput("Beta2Tensor")) {
+      beta2 = GetAttrFromTensor(ctx.Input<framework::Tensor>("Beta2Tensor"));
+    }
+    float epsilon = ctx.Attr<float>("epsilon");
+    if (ctx.HasInput("EpsilonTensor")) {
+      epsilon =
+          GetAttrFromTensor(ctx.Input<framework::Tensor>("EpsilonTensor"));
+    }
+
+    const float beta1_p = ScalarAsFloat(*beta1_pow);
+    const float beta2_p = ScalarAsFloat(*beta2_pow);
+    if (!ctx.Attr<bool>("use_global_beta_pow")) {
+      SetScalar(beta1 * beta1_p, ctx.GetPlace(), *beta1_pow, beta1_pow_out);
+      SetScalar(beta2 * beta2_p, ctx.GetPlace(), *beta2_pow, beta2_pow_out);
+    }
+    const float learning_rate =
+        ScalarAsFloat(*lr) * (std::sqrt(1 - beta2_p) / (1 - beta1_p));
+    const float eps = epsilon * std::sqrt(1 - beta2_p);
+
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    const float* master_in_data =
+        master_param ? master_param->data<float>() : nullptr;
+    float* master_out_data =
+        master_param ? master_param_out->mutable_data<float>(ctx.GetPlace())
+                     : nullptr;
+    auto* param_out_data = param_out->mutable_data<bfloat16>(ctx.GetPlace());
+    if (mom1->dtype() == phi::DataType::BFLOAT16) {
+      Bf16AdamUpdate<bfloat16>(
+          dev_ctx, beta1, beta2, learning_rate, eps, param->numel(),
+          grad->data<bfloat16>(), mom1->data<bfloat16>(),
+          mom2->data<bfloat16>(), master_in_data, param->data<bfloat16>(),
+          mom1_out->mutable_data<bfloat16>(ctx.GetPlace()),
+          mom2_out->mutable_data<bfloat16>(ctx.GetPlace()), master_out_data,
+          param_out_data);
+    } else {
+      Bf16AdamUpdate<float>(
+          dev_ctx, beta1, beta2, learning_rate, eps, param->numel(),
+          grad->data<bfloat16>(), mom1->data<float>(), mom2->data<float>(),
+          master_in_data, param->data<bfloat16>(),
+          mom1_out->mutable_data<float>(ctx.GetPlace()),
+          mom2_out->mutable_data<float>(ctx.GetPlace()), master_out_data,
+          param_out_data);
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
@@ -261,7 +427,9 @@ REGISTER_OP_WITHOUT_GRADIENT(adamw, ops::AdamWOp, ops::AdamWOpMaker);
 
 REGISTER_OP_CPU_KERNEL(
     adam, ops::AdamOpKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::AdamOpKernel<paddle::platform::CPUDeviceContext, double>);
+    ops::AdamOpKernel<paddle::platform::CPUDeviceContext, double>,
+    ops::AdamOpKernel<paddle::platform::CPUDeviceContext,
+                      paddle::platform::bfloat16>);
 
 REGISTER_OP_VERSION(adam)
     .AddCheckpoint(
@@ -110,7 +110,9 @@ REGISTER_OPERATOR(
     ops::MomentumOpInferVarType);
 REGISTER_OP_CPU_KERNEL(
     momentum, ops::MomentumOpKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::MomentumOpKernel<paddle::platform::CPUDeviceContext, double>);
+    ops::MomentumOpKernel<paddle::platform::CPUDeviceContext, double>,
+    ops::MomentumOpKernel<paddle::platform::CPUDeviceContext,
+                          paddle::platform::bfloat16>);
 
 REGISTER_OP_VERSION(momentum)
     .AddCheckpoint(
@@ -15,10 +15,12 @@ limitations under the License. */
 #pragma once
 #include <memory>
 #include <string>
+#include <type_traits>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/amp/fp16_type_traits.h"
 #include "paddle/fluid/operators/math/selected_rows_functor.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/float16.h"
 #include "paddle/fluid/platform/for_range.h"
 #include "paddle/phi/kernels/funcs/algorithm.h"
@@ -173,6 +175,38 @@ class CPUDenseMomentumFunctor {
   }
 };
 
+// bfloat16 parameters and velocities are updated in float, and rounded only
+// when they are stored.
+template <>
+class CPUDenseMomentumFunctor<platform::bfloat16> {
+ public:
+  void operator()(const Tensor* param, const Tensor* grad,
+                  const Tensor* velocity, const Tensor* learning_rate,
+                  const platform::bfloat16 mu, const bool use_nesterov,
+                  const RegularizationType regularization_flag,
+                  const platform::bfloat16 regularization_coeff,
+                  Tensor* param_out, Tensor* velocity_out) {
+    const auto* param_data = param->data<platform::bfloat16>();
+    const auto* grad_data = grad->data<platform::bfloat16>();
+    const auto* velocity_data = velocity->data<platform::bfloat16>();
+    auto* param_out_data = param_out->data<platform::bfloat16>();
+    auto* velocity_out_data = velocity_out->data<platform::bfloat16>();
+    const float lr = learning_rate->data<float>()[0];
+    const float mu_f = static_cast<float>(mu);
+    const float coeff = regularization_flag == RegularizationType::kL2DECAY
+                            ? static_cast<float>(regularization_coeff)
+                            : 0.0f;
+    for (int64_t i = 0; i < param->numel(); ++i) {
+      float p = static_cast<float>(param_data[i]);
+      float g = static_cast<float>(grad_data[i]) + p * coeff;
+      float v = static_cast<float>(velocity_data[i]) * mu_f + g;
+      p -= use_nesterov ? (g + v * mu_f) * lr : v * lr;
+      velocity_out_data[i] = static_cast<platform::bfloat16>(v);
+      param_out_data[i] = static_cast<platform::bfloat16>(p);
+    }
+  }
+};
+
 template <typename T, typename MT, RegularizationType kRegType,
           typename UpdateMethod>
 class DenseMomentumFunctor;
@@ -508,12 +542,16 @@ class MomentumOpKernel : public framework::OpKernel<T> {
     auto* grad_var = ctx.InputVar("Grad");
     if (grad_var->IsType<framework::LoDTensor>()) {
       auto grad = ctx.Input<framework::Tensor>("Grad");
-      if (platform::is_cpu_place(ctx.GetPlace())) {
+      // NOTE: the multi precision bfloat16 parameters on CPU are updated by
+      // the functors of the master parameters below.
+      if (platform::is_cpu_place(ctx.GetPlace()) &&
+          std::is_same<T, MT>::value) {
         CPUDenseMomentumFunctor<MT> functor;
         functor(param, grad, velocity, learning_rate, mu, use_nesterov,
                 regularization_flag, regularization_coeff, param_out,
                 velocity_out);
-      } else if (platform::is_gpu_place(ctx.GetPlace())) {
+      } else if (platform::is_cpu_place(ctx.GetPlace()) ||
+                 platform::is_gpu_place(ctx.GetPlace())) {
         platform::ForRange<DeviceContext> for_range(
             static_cast<const DeviceContext&>(ctx.device_context()),
             param->numel());
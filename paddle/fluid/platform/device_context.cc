@@ -12,9 +12,14 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 #include "paddle/fluid/platform/device_context.h"
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <set>
+#include <thread>  // NOLINT
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/stream/cuda_stream.h"
 #include "paddle/phi/backends/gpu/gpu_context.h"
@@ -36,6 +41,8 @@ limitations under the License. */
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 
+DECLARE_int32(cpu_intra_op_threads);
+
 namespace paddle {
 namespace memory {
 
@@ -275,12 +282,26 @@ DeviceContextPool::DeviceContextPool(
   }
 }
 
+// FLAGS_cpu_intra_op_threads, 0 takes as many threads as OpenMP does now.
+static int CpuIntraOpThreads() {
+  if (FLAGS_cpu_intra_op_threads > 0) {
+    return FLAGS_cpu_intra_op_threads;
+  }
+#ifdef _OPENMP
+  return std::max(omp_get_max_threads(), 1);
+#else
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+#endif
+}
+
 CPUDeviceContext::CPUDeviceContext() : phi::CPUContext() {
   phi::CPUContext::Init();
+  SetIntraOpThreads(CpuIntraOpThreads());
 }
 
 CPUDeviceContext::CPUDeviceContext(CPUPlace place) : phi::CPUContext(place) {
   phi::CPUContext::Init();
+  SetIntraOpThreads(CpuIntraOpThreads());
 }
 
 #ifdef PADDLE_WITH_IPU
@@ -48,6 +48,51 @@ ExportedFlagInfoMap *GetMutableExportedFlagInfoMap() {
 PADDLE_DEFINE_EXPORTED_int32(paddle_num_threads, 1,
                              "Number of threads for each paddle instance.");
 
+/**
+ * Operator related FLAG
+ * Name: FLAGS_cpu_intra_op_threads
+ * Since Version: 2.3.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_cpu_intra_op_threads=8, the CPU kernels that support it
+ * split their work among 8 threads of the CPUDeviceContext.
+ * Note: 1 runs the kernels on the calling thread only, so that they do not
+ * compete with the threads set by SetCpuMathLibraryNumThreads. 0 uses as
+ * many threads as OpenMP, or the hardware threads if Paddle is built without
+ * OpenMP, counted when the device context is created. The threads are shared by the operators running concurrently, an
+ * operator that finds them busy runs on its own thread.
+ */
+PADDLE_DEFINE_EXPORTED_int32(
+    cpu_intra_op_threads, 1,
+    "Number of intra-op threads of the CPU device context, 0 uses as many "
+    "threads as OpenMP.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_jit_autotune
+ * Since Version: 2.3.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_jit_autotune=true, the candidates of a jit kernel are timed
+ * on the first use of an attribute and the fastest one is used.
+ * Note: The choices are kept in FLAGS_jit_autotune_file if it is set.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    jit_autotune, false,
+    "Whether to choose the jit kernels by timing their candidates.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_jit_autotune_file
+ * Since Version: 2.3.0
+ * Value Range: string, default=""
+ * Example: FLAGS_jit_autotune_file=/path/to/jit_tuning.txt
+ * Note: The choices of the jit kernels tuned on this CPU model are read from
+ * the file and the new ones are appended to it, so the next processes start
+ * with the tuned kernels. The file may hold the choices of other CPU models.
+ */
+PADDLE_DEFINE_EXPORTED_string(
+    jit_autotune_file, "",
+    "The file keeping the jit kernels chosen by FLAGS_jit_autotune.");
+
 /**
  * Operator related FLAG
  * Name: FLAGS_check_nan_inf
@@ -42,6 +42,8 @@ const char* ChromeTracingLogger::categary_name_[] = {
     "OperatorInner", "Forward",    "Backward",         "Optimization",
     "Communication", "PythonOp",   "PythonUserDefined"};
 
+static const char* kMemEventTypeName[] = {"Allocate", "Free"};
+
 void ChromeTracingLogger::OpenFile() {
   output_file_stream_.open(filename_,
                            std::ofstream::out | std::ofstream::trunc);
@@ -82,6 +84,10 @@ void ChromeTracingLogger::LogNodeTrees(const NodeTrees& node_trees) {
       if (hostnode != it->second.begin()) {  // skip root node
         (*hostnode)->LogMe(this);
       }
+      for (auto memnode = (*hostnode)->GetMemTraceEventNodes().begin();
+           memnode != (*hostnode)->GetMemTraceEventNodes().end(); ++memnode) {
+        (*memnode)->LogMe(this);
+      }
       for (auto runtimenode = (*hostnode)->GetRuntimeTraceEventNodes().begin();
            runtimenode != (*hostnode)->GetRuntimeTraceEventNodes().end();
            ++runtimenode) {
@@ -152,6 +158,51 @@ void ChromeTracingLogger::LogHostTraceEventNode(
   pid_tid_set_.insert({host_node.ProcessId(), host_node.ThreadId()});
 }
 
+void ChromeTracingLogger::LogMemTraceEventNode(
+    const MemTraceEventNode& mem_node) {
+  if (!output_file_stream_) {
+    return;
+  }
+  // an instant event on the thread which requests or releases the memory
+  output_file_stream_ << string_format(
+      std::string(
+          R"JSON(
+  { 
+    "name": "%s", "pid": %lld, "tid": "%lld(C++)",
+    "ts": %lld,
+    "ph": "i", "s": "t", "cat": "Memory", 
+    "args": {
+      "place": "%s",
+      "addr": "%llu",
+      "increase_bytes": %lld,
+      "timestamp_ns": %lld
+    }
+  },
+  )JSON"),
+      kMemEventTypeName[static_cast<int>(mem_node.Type())],
+      mem_node.ProcessId(), mem_node.ThreadId(), nsToUs(mem_node.TimeStampNs()),
+      mem_node.Place().c_str(), mem_node.Addr(), mem_node.IncreaseBytes(),
+      mem_node.TimeStampNs());
+  // a counter event drawing the memory timeline of the place
+  output_file_stream_ << string_format(
+      std::string(
+          R"JSON(
+  { 
+    "name": "Memory %s", "pid": %lld,
+    "ts": %lld,
+    "ph": "C", "cat": "Memory", 
+    "args": {
+      "Allocated": %llu,
+      "Peak Allocated": %llu
+    }
+  },
+  )JSON"),
+      mem_node.Place().c_str(), mem_node.ProcessId(),
+      nsToUs(mem_node.TimeStampNs()), mem_node.CurrentAllocated(),
+      mem_node.PeakAllocated());
+  pid_tid_set_.insert({mem_node.ProcessId(), mem_node.ThreadId()});
+}
+
 void ChromeTracingLogger::LogRuntimeTraceEventNode(
     const CudaRuntimeTraceEventNode& runtime_node) {
   if (!output_file_stream_) {
@@ -34,6 +34,7 @@ class ChromeTracingLogger : public BaseLogger {
   void LogDeviceTraceEventNode(const DeviceTraceEventNode&) override;
   void LogHostTraceEventNode(const HostTraceEventNode&) override;
   void LogRuntimeTraceEventNode(const CudaRuntimeTraceEventNode&) override;
+  void LogMemTraceEventNode(const MemTraceEventNode&) override;
   void LogNodeTrees(const NodeTrees&) override;
   void LogMetaInfo(const std::unordered_map<std::string, std::string>);
 
@@ -18,6 +18,7 @@
 #include <functional>
 #include <string>
 #include "paddle/fluid/platform/event.h"  // import EventRole, TODO(TIEXING): remove later
+#include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler/trace_event.h"
 
 namespace paddle {
@@ -62,5 +63,27 @@ struct CommonEvent {
   const char *attr = nullptr;  // not owned, designed for performance
 };
 
+struct CommonMemEvent {
+ public:
+  CommonMemEvent(uint64_t timestamp_ns, uint64_t addr, TracerMemEventType type,
+                 int64_t increase_bytes, const Place &place,
+                 uint64_t current_allocated, uint64_t peak_allocated)
+      : timestamp_ns(timestamp_ns),
+        addr(addr),
+        type(type),
+        increase_bytes(increase_bytes),
+        place(place),
+        current_allocated(current_allocated),
+        peak_allocated(peak_allocated) {}
+
+  uint64_t timestamp_ns;
+  uint64_t addr;
+  TracerMemEventType type;
+  int64_t increase_bytes;
+  Place place;
+  uint64_t current_allocated;
+  uint64_t peak_allocated;
+};
+
 }  // namespace platform
 }  // namespace paddle
@@ -29,6 +29,9 @@ HostTraceEventNode::~HostTraceEventNode() {
   for (auto it = children_.begin(); it != children_.end(); ++it) {
     delete *it;
   }
+  for (auto it = mem_node_ptrs_.begin(); it != mem_node_ptrs_.end(); ++it) {
+    delete *it;
+  }
 }
 
 CudaRuntimeTraceEventNode::~CudaRuntimeTraceEventNode() {
@@ -50,7 +53,8 @@ NodeTrees::~NodeTrees() {
 void NodeTrees::BuildTrees(
     const std::vector<HostTraceEventNode*>& host_event_nodes,
     std::vector<CudaRuntimeTraceEventNode*>& runtime_event_nodes,
-    const std::vector<DeviceTraceEventNode*>& device_event_nodes) {
+    const std::vector<DeviceTraceEventNode*>& device_event_nodes,
+    const std::vector<MemTraceEventNode*>& mem_event_nodes) {
   // seperate Host Event Nodes into different threads
   std::map<uint64_t, std::vector<HostTraceEventNode*>>
       thread2host_event_nodes;  // used to store HostTraceEventNodes per thread
@@ -65,6 +69,11 @@ void NodeTrees::BuildTrees(
   for (auto it = host_event_nodes.begin(); it != host_event_nodes.end(); ++it) {
     thread2host_event_nodes[(*it)->ThreadId()].push_back(*it);
   }
+  std::map<uint64_t, std::vector<MemTraceEventNode*>>
+      thread2mem_event_nodes;  // used to store MemTraceEventNode per thread
+  for (auto it = mem_event_nodes.begin(); it != mem_event_nodes.end(); ++it) {
+    thread2mem_event_nodes[(*it)->ThreadId()].push_back(*it);
+  }
   // construct thread2runtime_event_nodes and
   // correlation_id2runtime_event_node
   for (auto it = runtime_event_nodes.begin(); it != runtime_event_nodes.end();
@@ -131,10 +140,49 @@ void NodeTrees::BuildTrees(
     thread_set.insert(it->first);
   }
 
+  for (auto it = thread2mem_event_nodes.begin();
+       it != thread2mem_event_nodes.end(); ++it) {
+    thread_set.insert(it->first);
+  }
+
   for (auto it = thread_set.begin(); it != thread_set.end(); ++it) {
     thread_event_trees_map_[*it] = BuildTreeRelationship(
         thread2host_event_nodes[*it], thread2runtime_event_nodes[*it]);
   }
+
+  // attach every memory event to the innermost host event which covers it
+  for (auto it = thread2mem_event_nodes.begin();
+       it != thread2mem_event_nodes.end(); ++it) {
+    std::stable_sort(it->second.begin(), it->second.end(),
+                     [](MemTraceEventNode* node1, MemTraceEventNode* node2) {
+                       return node1->TimeStampNs() < node2->TimeStampNs();
+                     });
+    AssignMemTraceEventNodes(thread_event_trees_map_[it->first],
+                             it->second.cbegin(), it->second.cend());
+  }
+}
+
+void NodeTrees::AssignMemTraceEventNodes(
+    HostTraceEventNode* node,
+    std::vector<MemTraceEventNode*>::const_iterator begin,
+    std::vector<MemTraceEventNode*>::const_iterator end) {
+  // children are sorted by start_ns and have no time range intersection,
+  // memory nodes in [begin, end) are sorted by timestamp_ns.
+  auto cur = begin;
+  for (auto child : node->GetChildren()) {
+    for (; cur != end && (*cur)->TimeStampNs() < child->StartNs(); ++cur) {
+      node->AddMemNode(*cur);
+    }
+    auto child_end = cur;
+    while (child_end != end && (*child_end)->TimeStampNs() <= child->EndNs()) {
+      ++child_end;
+    }
+    AssignMemTraceEventNodes(child, cur, child_end);
+    cur = child_end;
+  }
+  for (; cur != end; ++cur) {
+    node->AddMemNode(*cur);
+  }
 }
 
 HostTraceEventNode* NodeTrees::BuildTreeRelationship(
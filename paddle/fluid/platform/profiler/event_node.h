@@ -27,6 +27,34 @@ limitations under the License. */
 namespace paddle {
 namespace platform {
 
+class MemTraceEventNode {
+ public:
+  // constructor
+  explicit MemTraceEventNode(const MemTraceEvent& mem_event)
+      : mem_event_(mem_event) {}
+
+  // destructor
+  ~MemTraceEventNode() {}
+
+  // getter
+  TracerMemEventType Type() const { return mem_event_.type; }
+  uint64_t Addr() const { return mem_event_.addr; }
+  uint64_t TimeStampNs() const { return mem_event_.timestamp_ns; }
+  uint64_t ProcessId() const { return mem_event_.process_id; }
+  uint64_t ThreadId() const { return mem_event_.thread_id; }
+  int64_t IncreaseBytes() const { return mem_event_.increase_bytes; }
+  std::string Place() const { return mem_event_.place; }
+  uint64_t CurrentAllocated() const { return mem_event_.current_allocated; }
+  uint64_t PeakAllocated() const { return mem_event_.peak_allocated; }
+
+  // member function
+  void LogMe(BaseLogger* logger) { logger->LogMemTraceEventNode(*this); }
+
+ private:
+  // data
+  MemTraceEvent mem_event_;
+};
+
 class DeviceTraceEventNode {
  public:
   // constructor
@@ -139,10 +167,14 @@ class HostTraceEventNode {
   void AddCudaRuntimeNode(CudaRuntimeTraceEventNode* node) {
     runtime_node_ptrs_.push_back(node);
   }
+  void AddMemNode(MemTraceEventNode* node) { mem_node_ptrs_.push_back(node); }
   std::vector<HostTraceEventNode*>& GetChildren() { return children_; }
   std::vector<CudaRuntimeTraceEventNode*>& GetRuntimeTraceEventNodes() {
     return runtime_node_ptrs_;
   }
+  std::vector<MemTraceEventNode*>& GetMemTraceEventNodes() {
+    return mem_node_ptrs_;
+  }
   void LogMe(BaseLogger* logger) { logger->LogHostTraceEventNode(*this); }
 
  private:
@@ -152,6 +184,8 @@ class HostTraceEventNode {
   std::vector<CudaRuntimeTraceEventNode*> runtime_node_ptrs_;
   // host events called by this
   std::vector<HostTraceEventNode*> children_;
+  // memory events happened during this, but not during its children
+  std::vector<MemTraceEventNode*> mem_node_ptrs_;
 };
 
 class NodeTrees {
@@ -159,10 +193,18 @@ class NodeTrees {
   // constructor
   NodeTrees(const std::list<HostTraceEvent>& host_events,
             const std::list<RuntimeTraceEvent>& runtime_events,
-            const std::list<DeviceTraceEvent>& device_events) {
+            const std::list<DeviceTraceEvent>& device_events)
+      : NodeTrees(host_events, runtime_events, device_events,
+                  std::list<MemTraceEvent>()) {}
+
+  NodeTrees(const std::list<HostTraceEvent>& host_events,
+            const std::list<RuntimeTraceEvent>& runtime_events,
+            const std::list<DeviceTraceEvent>& device_events,
+            const std::list<MemTraceEvent>& mem_events) {
     std::vector<HostTraceEventNode*> host_event_nodes;
     std::vector<CudaRuntimeTraceEventNode*> runtime_event_nodes;
     std::vector<DeviceTraceEventNode*> device_event_nodes;
+    std::vector<MemTraceEventNode*> mem_event_nodes;
     // encapsulate event into nodes
     for (auto it = host_events.begin(); it != host_events.end(); ++it) {
       host_event_nodes.push_back(new HostTraceEventNode(*it));
@@ -173,8 +215,12 @@ class NodeTrees {
     for (auto it = device_events.begin(); it != device_events.end(); ++it) {
       device_event_nodes.push_back(new DeviceTraceEventNode(*it));
     }
+    for (auto it = mem_events.begin(); it != mem_events.end(); ++it) {
+      mem_event_nodes.push_back(new MemTraceEventNode(*it));
+    }
     // build tree
-    BuildTrees(host_event_nodes, runtime_event_nodes, device_event_nodes);
+    BuildTrees(host_event_nodes, runtime_event_nodes, device_event_nodes,
+               mem_event_nodes);
   }
 
   explicit NodeTrees(
@@ -197,10 +243,15 @@ class NodeTrees {
   std::map<uint64_t, HostTraceEventNode*> thread_event_trees_map_;
   void BuildTrees(const std::vector<HostTraceEventNode*>&,
                   std::vector<CudaRuntimeTraceEventNode*>&,
-                  const std::vector<DeviceTraceEventNode*>&);
+                  const std::vector<DeviceTraceEventNode*>&,
+                  const std::vector<MemTraceEventNode*>&);
   HostTraceEventNode* BuildTreeRelationship(
       std::vector<HostTraceEventNode*> host_event_nodes,
       std::vector<CudaRuntimeTraceEventNode*> runtime_event_nodes);
+  void AssignMemTraceEventNodes(
+      HostTraceEventNode* node,
+      std::vector<MemTraceEventNode*>::const_iterator begin,
+      std::vector<MemTraceEventNode*>::const_iterator end);
 };
 
 }  // namespace platform
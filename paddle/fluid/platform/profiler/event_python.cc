@@ -10,6 +10,9 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/profiler/event_python.h"
+
+#include <algorithm>
+
 #include "paddle/fluid/platform/profiler/chrometracing_logger.h"
 #include "paddle/fluid/platform/profiler/dump/deserialization_reader.h"
 #include "paddle/fluid/platform/profiler/dump/serialization_logger.h"
@@ -112,6 +115,81 @@ void ProfilerResult::Save(const std::string& file_name,
   return;
 }
 
+// Collect the memory events of an operator call. The events of a nested
+// operator (e.g. an op in the sub-block of while) belong to that operator
+// only, so the subtrees of nested operators are skipped.
+static void CollectMemTraceEventNodes(HostTraceEventNode* node,
+                                      std::vector<MemTraceEventNode*>* nodes) {
+  nodes->insert(nodes->end(), node->GetMemTraceEventNodes().begin(),
+                node->GetMemTraceEventNodes().end());
+  for (auto child : node->GetChildren()) {
+    if (child->Type() == TracerEventType::Operator) {
+      continue;
+    }
+    CollectMemTraceEventNodes(child, nodes);
+  }
+}
+
+std::map<std::string, std::map<std::string, OpMemorySummary>>
+ProfilerResult::GetOpMemorySummary() const {
+  std::map<std::string, std::map<std::string, OpMemorySummary>> summary;
+  if (tree_ == nullptr) {
+    return summary;
+  }
+  const std::map<uint64_t, std::vector<HostTraceEventNode*>>
+      thread2host_event_nodes = tree_->Traverse(true);
+  for (auto it = thread2host_event_nodes.begin();
+       it != thread2host_event_nodes.end(); ++it) {
+    for (auto hostnode : it->second) {
+      if (hostnode->Type() != TracerEventType::Operator) {
+        continue;
+      }
+      std::vector<MemTraceEventNode*> mem_nodes;
+      CollectMemTraceEventNodes(hostnode, &mem_nodes);
+      if (mem_nodes.empty()) {
+        continue;
+      }
+      std::stable_sort(mem_nodes.begin(), mem_nodes.end(),
+                       [](MemTraceEventNode* node1, MemTraceEventNode* node2) {
+                         return node1->TimeStampNs() < node2->TimeStampNs();
+                       });
+      // replay the memory events of this call place by place
+      struct CallState {
+        int64_t increase = 0;
+        int64_t peak_increase = 0;
+        std::unordered_map<uint64_t, uint64_t> alive;  // addr -> bytes
+        OpMemorySummary delta;
+      };
+      std::map<std::string, CallState> states;
+      for (auto memnode : mem_nodes) {
+        auto& state = states[memnode->Place()];
+        state.increase += memnode->IncreaseBytes();
+        state.peak_increase = std::max(state.peak_increase, state.increase);
+        if (memnode->Type() == TracerMemEventType::Allocate) {
+          state.delta.allocated_bytes += memnode->IncreaseBytes();
+          state.alive[memnode->Addr()] = memnode->IncreaseBytes();
+        } else {
+          state.delta.freed_bytes += -memnode->IncreaseBytes();
+          state.alive.erase(memnode->Addr());
+        }
+      }
+      for (auto& kv : states) {
+        auto& op_summary = summary[kv.first][hostnode->Name()];
+        op_summary.calls += 1;
+        op_summary.allocated_bytes += kv.second.delta.allocated_bytes;
+        op_summary.freed_bytes += kv.second.delta.freed_bytes;
+        op_summary.peak_increase_bytes =
+            std::max(op_summary.peak_increase_bytes,
+                     static_cast<uint64_t>(kv.second.peak_increase));
+        for (auto& alive : kv.second.alive) {
+          op_summary.retained_bytes += alive.second;
+        }
+      }
+    }
+  }
+  return summary;
+}
+
 std::unique_ptr<ProfilerResult> LoadProfilerResult(std::string filename) {
   DeserializationReader reader(filename);
   std::unique_ptr<ProfilerResult> result = reader.Parse();
@@ -66,6 +66,21 @@ struct HostPythonNode {
   std::vector<DevicePythonNode*> device_node_ptrs;
 };
 
+// Memory attributed to one operator type on one place, accumulated over
+// all calls of the operator.
+struct OpMemorySummary {
+  // number of calls which allocate or free memory on the place
+  uint64_t calls = 0;
+  // total bytes allocated during the calls
+  uint64_t allocated_bytes = 0;
+  // total bytes freed during the calls
+  uint64_t freed_bytes = 0;
+  // max increase of allocated bytes within one call
+  uint64_t peak_increase_bytes = 0;
+  // total bytes allocated during the calls and still alive after them
+  uint64_t retained_bytes = 0;
+};
+
 class ProfilerResult {
  public:
   ProfilerResult() : tree_(nullptr) {}
@@ -84,6 +99,11 @@ class ProfilerResult {
 
   std::unique_ptr<NodeTrees>& GetNodeTrees() { return tree_; }
 
+  // Per operator memory usage, {place: {op name: summary}}. Each memory event
+  // is attributed to the innermost operator it happened in.
+  std::map<std::string, std::map<std::string, OpMemorySummary>>
+  GetOpMemorySummary() const;
+
  private:
   std::map<uint64_t, HostPythonNode*> thread_event_trees_map_;
   std::unique_ptr<NodeTrees> tree_;
@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <string>
 #include "paddle/fluid/platform/event.h"
+#include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler/trace_event.h"
 
 namespace paddle {
@@ -24,6 +25,8 @@ namespace platform {
 // Default tracing level.
 // It is Recommended to set the level explicitly.
 static constexpr uint32_t kDefaultTraceLevel = 4;
+// Tracing level of memory events, the same as the default host_trace_level.
+static constexpr uint32_t kMemTraceLevel = 2;
 
 // Host event tracing. A trace marks something that happens but has no duration
 // associated with it. For example, thread starts working.
@@ -41,6 +44,29 @@ struct RecordInstantEvent {
                               uint32_t level = kDefaultTraceLevel);
 };
 
+// Memory event tracing. A trace marks an allocation or a free of memory.
+// The event is attached to the innermost host event recorded by the same
+// thread, which is usually the operator that requests or releases the memory.
+// Chrome Trace Viewer Format: Counter Event
+struct RecordMemEvent {
+  /**
+   * @param ptr: The address of the allocation.
+   * @param place: The place of the allocation.
+   * @param size: Bytes of the allocation.
+   * @param current_allocated: Allocated bytes of the place after this
+   * manipulation.
+   * @param peak_allocated: Peak allocated bytes of the place up to this
+   * manipulation.
+   * @param type: Allocate or Free.
+   * @param level: Used to filter events, works like glog VLOG(level).
+   * RecordMemEvent will works if HostTraceLevel >= level.
+   */
+  RecordMemEvent(const void* ptr, const Place& place, size_t size,
+                 uint64_t current_allocated, uint64_t peak_allocated,
+                 const TracerMemEventType type = TracerMemEventType::Allocate,
+                 uint32_t level = kMemTraceLevel);
+};
+
 // Host event tracing. A trace starts when an object of this clas is created and
 // stops when the object is destroyed.
 // Chrome Trace Viewer Format: Duration Event/Complte Event
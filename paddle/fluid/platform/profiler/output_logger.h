@@ -23,6 +23,7 @@ namespace platform {
 class DeviceTraceEventNode;       // forward declaration
 class HostTraceEventNode;         // forward declaration
 class CudaRuntimeTraceEventNode;  // forward declaration
+class MemTraceEventNode;          // forward declaration
 class NodeTrees;                  // forward declaration
 
 class BaseLogger {
@@ -32,6 +33,7 @@ class BaseLogger {
   virtual void LogDeviceTraceEventNode(const DeviceTraceEventNode&) {}
   virtual void LogHostTraceEventNode(const HostTraceEventNode&) {}
   virtual void LogRuntimeTraceEventNode(const CudaRuntimeTraceEventNode&) {}
+  virtual void LogMemTraceEventNode(const MemTraceEventNode&) {}
   virtual void LogNodeTrees(const NodeTrees&) {}
 };
 
@@ -16,6 +16,7 @@
 
 #include "paddle/fluid/platform/profiler/chrometracing_logger.h"
 #include "paddle/fluid/platform/profiler/event_node.h"
+#include "paddle/fluid/platform/profiler/event_python.h"
 
 using paddle::platform::ChromeTracingLogger;
 using paddle::platform::NodeTrees;
@@ -29,6 +30,11 @@ using paddle::platform::TracerEventType;
 using paddle::platform::KernelEventInfo;
 using paddle::platform::MemcpyEventInfo;
 using paddle::platform::MemsetEventInfo;
+using paddle::platform::MemTraceEvent;
+using paddle::platform::MemTraceEventNode;
+using paddle::platform::TracerMemEventType;
+using paddle::platform::ExtraInfo;
+using paddle::platform::ProfilerResult;
 TEST(NodeTreesTest, LogMe_case0) {
   std::list<HostTraceEvent> host_events;
   std::list<RuntimeTraceEvent> runtime_events;
@@ -201,3 +207,121 @@ TEST(NodeTreesTest, HandleTrees_case0) {
   tree.HandleTrees(host_event_node_handle, runtime_event_node_handle,
                    device_event_node_handle);
 }
+
+TEST(NodeTreesTest, MemTraceEventNode_case0) {
+  std::list<HostTraceEvent> host_events;
+  std::list<RuntimeTraceEvent> runtime_events;
+  std::list<DeviceTraceEvent> device_events;
+  std::list<MemTraceEvent> mem_events;
+  host_events.push_back(HostTraceEvent(
+      std::string("op1"), TracerEventType::Operator, 10000, 20000, 10, 10));
+  host_events.push_back(HostTraceEvent(std::string("op1::compute"),
+                                       TracerEventType::OperatorInner, 12000,
+                                       18000, 10, 10));
+  host_events.push_back(HostTraceEvent(
+      std::string("op2"), TracerEventType::Operator, 21000, 30000, 10, 10));
+  mem_events.push_back(MemTraceEvent(11000, 0x1000,
+                                     TracerMemEventType::Allocate, 10, 10, 64,
+                                     "Place(cpu)", 64, 64));
+  mem_events.push_back(MemTraceEvent(13000, 0x2000,
+                                     TracerMemEventType::Allocate, 10, 10, 128,
+                                     "Place(cpu)", 192, 192));
+  mem_events.push_back(MemTraceEvent(19000, 0x1000,
+                                     TracerMemEventType::Free, 10, 10, -64,
+                                     "Place(cpu)", 128, 192));
+  mem_events.push_back(MemTraceEvent(25000, 0x2000,
+                                     TracerMemEventType::Free, 10, 10, -128,
+                                     "Place(cpu)", 0, 192));
+  mem_events.push_back(MemTraceEvent(35000, 0x3000,
+                                     TracerMemEventType::Allocate, 10, 11, 32,
+                                     "Place(cpu)", 32, 192));
+  ChromeTracingLogger logger("test_nodetrees_memtraceeventnode_case0.json");
+  NodeTrees tree(host_events, runtime_events, device_events, mem_events);
+  std::map<uint64_t, std::vector<HostTraceEventNode*>> nodes =
+      tree.Traverse(true);
+  EXPECT_EQ(nodes[10].size(), 4u);
+  EXPECT_EQ(nodes[11].size(), 1u);
+  for (auto it = nodes[10].begin(); it != nodes[10].end(); it++) {
+    if ((*it)->Name() == "op1") {
+      EXPECT_EQ((*it)->GetMemTraceEventNodes().size(), 2u);
+    }
+    if ((*it)->Name() == "op1::compute") {
+      EXPECT_EQ((*it)->GetMemTraceEventNodes().size(), 1u);
+      EXPECT_EQ((*it)->GetMemTraceEventNodes()[0]->Addr(), 0x2000u);
+    }
+    if ((*it)->Name() == "op2") {
+      EXPECT_EQ((*it)->GetMemTraceEventNodes().size(), 1u);
+    }
+  }
+  // thread 11 has no host event, its memory event belongs to the root node
+  EXPECT_EQ(nodes[11][0]->GetMemTraceEventNodes().size(), 1u);
+  tree.LogMe(&logger);
+}
+
+TEST(NodeTreesTest, OpMemorySummary_case0) {
+  // A while op whose sub-block runs fill_constant and elementwise_add.
+  std::list<HostTraceEvent> host_events;
+  std::list<RuntimeTraceEvent> runtime_events;
+  std::list<DeviceTraceEvent> device_events;
+  std::list<MemTraceEvent> mem_events;
+  host_events.push_back(HostTraceEvent(
+      std::string("while"), TracerEventType::Operator, 10000, 50000, 10, 10));
+  host_events.push_back(HostTraceEvent(std::string("fill_constant"),
+                                       TracerEventType::Operator, 20000, 25000,
+                                       10, 10));
+  host_events.push_back(HostTraceEvent(std::string("elementwise_add"),
+                                       TracerEventType::Operator, 30000, 40000,
+                                       10, 10));
+  host_events.push_back(HostTraceEvent(std::string("elementwise_add::compute"),
+                                       TracerEventType::OperatorInner, 32000,
+                                       38000, 10, 10));
+  mem_events.push_back(MemTraceEvent(11000, 0x1000,
+                                     TracerMemEventType::Allocate, 10, 10, 64,
+                                     "Place(cpu)", 64, 64));
+  mem_events.push_back(MemTraceEvent(21000, 0x2000,
+                                     TracerMemEventType::Allocate, 10, 10, 128,
+                                     "Place(cpu)", 192, 192));
+  mem_events.push_back(MemTraceEvent(33000, 0x3000,
+                                     TracerMemEventType::Allocate, 10, 10, 256,
+                                     "Place(cpu)", 448, 448));
+  mem_events.push_back(MemTraceEvent(35000, 0x2000,
+                                     TracerMemEventType::Free, 10, 10, -128,
+                                     "Place(cpu)", 320, 448));
+  mem_events.push_back(MemTraceEvent(45000, 0x3000,
+                                     TracerMemEventType::Free, 10, 10, -256,
+                                     "Place(cpu)", 64, 448));
+  ProfilerResult result(
+      std::unique_ptr<NodeTrees>(new NodeTrees(host_events, runtime_events,
+                                               device_events, mem_events)),
+      ExtraInfo());
+  auto summary = result.GetOpMemorySummary();
+  ASSERT_EQ(summary.size(), 1u);
+  auto& ops = summary["Place(cpu)"];
+  ASSERT_EQ(ops.size(), 3u);
+
+  // The events of the nested ops are not counted again in while.
+  EXPECT_EQ(ops["while"].calls, 1u);
+  EXPECT_EQ(ops["while"].allocated_bytes, 64u);
+  EXPECT_EQ(ops["while"].freed_bytes, 256u);
+  EXPECT_EQ(ops["while"].peak_increase_bytes, 64u);
+  EXPECT_EQ(ops["while"].retained_bytes, 64u);
+
+  EXPECT_EQ(ops["fill_constant"].allocated_bytes, 128u);
+  EXPECT_EQ(ops["fill_constant"].freed_bytes, 0u);
+  EXPECT_EQ(ops["fill_constant"].retained_bytes, 128u);
+
+  // OperatorInner events still belong to their operator.
+  EXPECT_EQ(ops["elementwise_add"].allocated_bytes, 256u);
+  EXPECT_EQ(ops["elementwise_add"].freed_bytes, 128u);
+  EXPECT_EQ(ops["elementwise_add"].peak_increase_bytes, 256u);
+  EXPECT_EQ(ops["elementwise_add"].retained_bytes, 256u);
+
+  // Every event is counted exactly once.
+  uint64_t allocated = 0, freed = 0;
+  for (auto& op : ops) {
+    allocated += op.second.allocated_bytes;
+    freed += op.second.freed_bytes;
+  }
+  EXPECT_EQ(allocated, 64u + 128u + 256u);
+  EXPECT_EQ(freed, 128u + 256u);
+}
@@ -54,6 +54,15 @@ enum class TracerEventType {
   NumTypes
 };
 
+enum class TracerMemEventType {
+  // Used to mark memory allocation
+  Allocate = 0,
+  // Used to mark memory free
+  Free = 1,
+  // A flag to denote the number of current types
+  NumTypes
+};
+
 struct KernelEventInfo {
   // The X-dimension block size for the kernel.
   uint32_t block_x;
@@ -240,5 +249,42 @@ struct DeviceTraceEvent {
   };
 };
 
+struct MemTraceEvent {
+  MemTraceEvent() = default;
+  MemTraceEvent(uint64_t timestamp_ns, uint64_t addr, TracerMemEventType type,
+                uint64_t process_id, uint64_t thread_id, int64_t increase_bytes,
+                const std::string& place, uint64_t current_allocated,
+                uint64_t peak_allocated)
+      : timestamp_ns(timestamp_ns),
+        addr(addr),
+        type(type),
+        process_id(process_id),
+        thread_id(thread_id),
+        increase_bytes(increase_bytes),
+        place(place),
+        current_allocated(current_allocated),
+        peak_allocated(peak_allocated) {}
+
+  // timestamp of the record
+  uint64_t timestamp_ns;
+  // memory address of allocation or free
+  uint64_t addr;
+  // memory manipulation type
+  TracerMemEventType type;
+  // process id of the record
+  uint64_t process_id;
+  // thread id of the record
+  uint64_t thread_id;
+  // increase bytes after this manipulation, allocation for sign +, free for
+  // sign -
+  int64_t increase_bytes;
+  // place
+  std::string place;
+  // allocated bytes of the place after this manipulation
+  uint64_t current_allocated;
+  // peak allocated bytes of the place up to this manipulation
+  uint64_t peak_allocated;
+};
+
 }  // namespace platform
 }  // namespace paddle
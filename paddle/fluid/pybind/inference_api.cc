@@ -579,10 +579,23 @@ void BindAnalysisConfig(py::module *m) {
       .def("ir_optim", &AnalysisConfig::ir_optim)
       .def("enable_memory_optim", &AnalysisConfig::EnableMemoryOptim,
            py::arg("x") = true)
+      .def("enable_memory_offset_plan",
+           &AnalysisConfig::EnableMemoryOffsetPlan,
+           py::arg("shape_range_info_path") = std::string(""))
+      .def("memory_offset_plan_enabled",
+           &AnalysisConfig::memory_offset_plan_enabled)
       .def("enable_profile", &AnalysisConfig::EnableProfile)
       .def("disable_glog_info", &AnalysisConfig::DisableGlogInfo)
       .def("glog_info_disabled", &AnalysisConfig::glog_info_disabled)
       .def("set_optim_cache_dir", &AnalysisConfig::SetOptimCacheDir)
+      .def("enable_optimized_program_cache",
+           &AnalysisConfig::EnableOptimizedProgramCache, py::arg("x") = true)
+      .def("optimized_program_cache_enabled",
+           &AnalysisConfig::optimized_program_cache_enabled)
+      .def("enable_weight_sharing", &AnalysisConfig::EnableWeightSharing,
+           py::arg("shm_dir") = "")
+      .def("weight_sharing_enabled", &AnalysisConfig::weight_sharing_enabled)
+      .def("weight_sharing_dir", &AnalysisConfig::weight_sharing_dir)
       .def("switch_use_feed_fetch_ops", &AnalysisConfig::SwitchUseFeedFetchOps,
            py::arg("x") = true)
       .def("use_feed_fetch_ops_enabled",
@@ -647,6 +660,8 @@ void BindAnalysisConfig(py::module *m) {
       .def("to_native_config", &AnalysisConfig::ToNativeConfig)
       .def("enable_quantizer", &AnalysisConfig::EnableMkldnnQuantizer)
       .def("enable_mkldnn_bfloat16", &AnalysisConfig::EnableMkldnnBfloat16)
+      .def("enable_cpu_int8", &AnalysisConfig::EnableCpuInt8)
+      .def("cpu_int8_enabled", &AnalysisConfig::cpu_int8_enabled)
 #ifdef PADDLE_WITH_MKLDNN
       .def("quantizer_config", &AnalysisConfig::mkldnn_quantizer_config,
            py::return_value_policy::reference)
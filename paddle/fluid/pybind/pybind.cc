@@ -3278,7 +3278,21 @@ All parameter, weight, gradient are variables in Paddle.
       .def("get_data", &paddle::platform::ProfilerResult::GetData,
            py::return_value_policy::automatic_reference)
       .def("save", &paddle::platform::ProfilerResult::Save)
-      .def("get_extra_info", &paddle::platform::ProfilerResult::GetExtraInfo);
+      .def("get_extra_info", &paddle::platform::ProfilerResult::GetExtraInfo)
+      .def("get_op_memory_summary",
+           &paddle::platform::ProfilerResult::GetOpMemorySummary);
+
+  py::class_<paddle::platform::OpMemorySummary>(m, "OpMemorySummary")
+      .def(py::init<>())
+      .def_readwrite("calls", &paddle::platform::OpMemorySummary::calls)
+      .def_readwrite("allocated_bytes",
+                     &paddle::platform::OpMemorySummary::allocated_bytes)
+      .def_readwrite("freed_bytes",
+                     &paddle::platform::OpMemorySummary::freed_bytes)
+      .def_readwrite("peak_increase_bytes",
+                     &paddle::platform::OpMemorySummary::peak_increase_bytes)
+      .def_readwrite("retained_bytes",
+                     &paddle::platform::OpMemorySummary::retained_bytes);
 
   py::class_<paddle::platform::DevicePythonNode>(m, "DevicePythonNode")
       .def(py::init<>())
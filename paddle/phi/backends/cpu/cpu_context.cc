@@ -14,7 +14,12 @@
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 #include "paddle/phi/api/ext/exception.h"
+#include "paddle/phi/backends/cpu/cpu_thread_pool.h"
 #include "paddle/phi/common/place.h"
 
 // NOTE: The paddle framework should add WITH_EIGEN option to support compile
@@ -45,9 +50,33 @@ struct CPUContext::Impl {
     return eigen_device_;
   }
 
+  std::shared_ptr<CPUThreadPool> GetThreadPool() {
+    std::lock_guard<std::mutex> guard(pool_mutex_);
+    if (thread_pool_ == nullptr && intra_op_threads_ > 1) {
+      thread_pool_ = std::make_shared<CPUThreadPool>(intra_op_threads_);
+    }
+    return thread_pool_;
+  }
+
+  void SetIntraOpThreads(int num_threads) {
+    PD_CHECK(num_threads >= 1,
+             "the number of intra-op threads should be at least 1.");
+    std::lock_guard<std::mutex> guard(pool_mutex_);
+    if (num_threads != intra_op_threads_) {
+      intra_op_threads_ = num_threads;
+      // a running ParallelFor keeps the old pool alive until it returns
+      thread_pool_.reset();
+    }
+  }
+
   bool owned_{false};
   Eigen::DefaultDevice* eigen_device_{nullptr};
   Place place_;
+
+  std::mutex pool_mutex_;
+  std::atomic<int> intra_op_threads_{1};
+  // created at the first ParallelFor that needs it
+  std::shared_ptr<CPUThreadPool> thread_pool_;
 };
 
 CPUContext::CPUContext()
@@ -70,6 +99,42 @@ Eigen::DefaultDevice* CPUContext::eigen_device() const {
 
 const Place& CPUContext::GetPlace() const { return impl_->place_; }
 
+void CPUContext::ParallelFor(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& fn) const {
+  if (begin >= end) {
+    return;
+  }
+  grain_size = std::max<int64_t>(grain_size, 1);
+  const int64_t range = end - begin;
+  int64_t num_chunks = std::min<int64_t>((range + grain_size - 1) / grain_size,
+                                         impl_->intra_op_threads_);
+  if (num_chunks <= 1 || CPUThreadPool::InParallelRegion()) {
+    fn(begin, end);
+    return;
+  }
+
+  auto pool = impl_->GetThreadPool();
+  const int64_t chunk_size = (range + num_chunks - 1) / num_chunks;
+  num_chunks = (range + chunk_size - 1) / chunk_size;
+  bool done = pool != nullptr &&
+              pool->TryRun(num_chunks, [&](int64_t chunk) {
+                int64_t chunk_begin = begin + chunk * chunk_size;
+                fn(chunk_begin, std::min(chunk_begin + chunk_size, end));
+              });
+  if (!done) {
+    fn(begin, end);
+  }
+}
+
+int CPUContext::GetIntraOpThreads() const { return impl_->intra_op_threads_; }
+
+void CPUContext::SetIntraOpThreads(int num_threads) {
+  impl_->SetIntraOpThreads(num_threads);
+}
+
 void CPUContext::SetEigenDevice(Eigen::DefaultDevice* device) {
   impl_->eigen_device_ = device;
 }
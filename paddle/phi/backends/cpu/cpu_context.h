@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <functional>
 #include <memory>
 
 #include "paddle/phi/backends/cpu/forwards.h"
@@ -34,6 +35,21 @@ class CPUContext : public DeviceContext {
   Eigen::DefaultDevice* eigen_device() const;
   const Place& GetPlace() const override;
 
+  // Run fn(chunk_begin, chunk_end) on the chunks of [begin, end) using the
+  // intra-op threads, each chunk has at least grain_size elements except the
+  // last one. It runs fn(begin, end) on the calling thread when there is one
+  // intra-op thread, the range is not larger than grain_size, the threads are
+  // busy with another ParallelFor, or it is called inside a ParallelFor.
+  void ParallelFor(int64_t begin,
+                   int64_t end,
+                   int64_t grain_size,
+                   const std::function<void(int64_t, int64_t)>& fn) const;
+
+  int GetIntraOpThreads() const;
+
+  // The calling thread counts as one of the num_threads.
+  void SetIntraOpThreads(int num_threads);
+
  public:
   // NOTE: DeviceContext hold resources. Used in training scenarios.
   // The interface used by the training scene, DeviceContext will initialize
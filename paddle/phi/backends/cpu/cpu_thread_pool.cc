@@ -0,0 +1,110 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/backends/cpu/cpu_thread_pool.h"
+
+namespace phi {
+
+static thread_local bool in_parallel_region = false;
+
+bool CPUThreadPool::InParallelRegion() { return in_parallel_region; }
+
+CPUThreadPool::CPUThreadPool(int num_threads) {
+  for (int i = 1; i < num_threads; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+CPUThreadPool::~CPUThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  job_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void CPUThreadPool::WorkerLoop() {
+  in_parallel_region = true;
+  uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      job_cv_.wait(
+          lock, [&] { return stop_ || generation_ != seen_generation; });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+    RunChunks();
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (--busy_workers_ == 0) {
+        done_cv_.notify_one();
+      }
+    }
+  }
+}
+
+void CPUThreadPool::RunChunks() {
+  for (int64_t chunk = next_chunk_++; chunk < num_chunks_;
+       chunk = next_chunk_++) {
+    try {
+      (*chunk_fn_)(chunk);
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(error_mutex_);
+      if (error_ == nullptr) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+}
+
+bool CPUThreadPool::TryRun(int64_t num_chunks,
+                           const std::function<void(int64_t)>& chunk_fn) {
+  std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+  if (!run_lock.owns_lock()) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    chunk_fn_ = &chunk_fn;
+    num_chunks_ = num_chunks;
+    next_chunk_ = 0;
+    error_ = nullptr;
+    busy_workers_ = static_cast<int>(workers_.size());
+    ++generation_;
+  }
+  job_cv_.notify_all();
+
+  in_parallel_region = true;
+  RunChunks();
+  in_parallel_region = false;
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&] { return busy_workers_ == 0; });
+    chunk_fn_ = nullptr;
+  }
+  if (error_ != nullptr) {
+    std::rethrow_exception(error_);
+  }
+  return true;
+}
+
+}  // namespace phi
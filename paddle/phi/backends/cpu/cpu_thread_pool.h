@@ -0,0 +1,78 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phi {
+
+/*
+ * The intra-op threads of a CPUContext. A job is split into chunks which are
+ * taken by the workers and the calling thread together, so a pool of
+ * num_threads runs num_threads - 1 workers.
+ *
+ * Only one job runs at a time. A caller that finds the pool busy, e.g. an
+ * inter-op thread of an executor while another one is running a parallel
+ * kernel, is told to run its job by itself, and the jobs issued from inside
+ * a job run inline as well, so the threads are never oversubscribed.
+ */
+class CPUThreadPool {
+ public:
+  explicit CPUThreadPool(int num_threads);
+  ~CPUThreadPool();
+
+  CPUThreadPool(const CPUThreadPool&) = delete;
+  CPUThreadPool& operator=(const CPUThreadPool&) = delete;
+
+  int NumThreads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Run chunk_fn(0) ... chunk_fn(num_chunks - 1) on the pool and wait for
+  // them. Returns false without running anything if the pool is busy. The
+  // first exception thrown by chunk_fn is rethrown after all chunks finish.
+  bool TryRun(int64_t num_chunks, const std::function<void(int64_t)>& chunk_fn);
+
+  // Whether the current thread is running a chunk of some pool.
+  static bool InParallelRegion();
+
+ private:
+  void WorkerLoop();
+  void RunChunks();
+
+  std::vector<std::thread> workers_;
+
+  std::mutex run_mutex_;  // held by the caller of the running job
+
+  std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  bool stop_{false};
+  uint64_t generation_{0};
+  int busy_workers_{0};
+
+  const std::function<void(int64_t)>* chunk_fn_{nullptr};
+  int64_t num_chunks_{0};
+  std::atomic<int64_t> next_chunk_{0};
+
+  std::mutex error_mutex_;
+  std::exception_ptr error_{nullptr};
+};
+
+}  // namespace phi
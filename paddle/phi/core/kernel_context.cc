@@ -99,4 +99,35 @@ const std::pair<int, int>& KernelContext::OutputRangeAt(size_t idx) const {
   return output_range_.at(idx);
 }
 
+void KernelContext::Clear() {
+  dev_ctx_ = nullptr;
+  inputs_.clear();
+  outputs_.clear();
+  attrs_.clear();
+  input_range_.clear();
+  output_range_.clear();
+}
+
+// the KernelContexts of this thread that are not in use
+static std::vector<std::unique_ptr<KernelContext>>& FreeKernelContexts() {
+  thread_local std::vector<std::unique_ptr<KernelContext>> contexts;
+  return contexts;
+}
+
+ScopedKernelContext::ScopedKernelContext(DeviceContext* dev_ctx) {
+  auto& free_contexts = FreeKernelContexts();
+  if (free_contexts.empty()) {
+    ctx_ = std::make_unique<KernelContext>(dev_ctx);
+  } else {
+    ctx_ = std::move(free_contexts.back());
+    free_contexts.pop_back();
+    ctx_->SetDeviceContext(dev_ctx);
+  }
+}
+
+ScopedKernelContext::~ScopedKernelContext() {
+  ctx_->Clear();
+  FreeKernelContexts().emplace_back(std::move(ctx_));
+}
+
 }  // namespace phi
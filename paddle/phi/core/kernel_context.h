@@ -15,7 +15,9 @@
 #pragma once
 
 #include <iterator>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "paddle/phi/core/device_context.h"
 #include "paddle/phi/core/enforce.h"
@@ -119,6 +121,9 @@ class KernelContext {
   size_t OutputsSize() const { return outputs_.size(); }
   size_t AttrsSize() const { return attrs_.size(); }
 
+  // Drops the arguments but keeps the storage, to build another call.
+  void Clear();
+
  private:
   DeviceContext* dev_ctx_;
 
@@ -130,4 +135,26 @@ class KernelContext {
   paddle::SmallVector<std::pair<int, int>> output_range_;
 };
 
+/**
+ * ScopedKernelContext takes one of the KernelContexts kept by the current
+ * thread and gives it back cleared when it goes out of scope, so a kernel
+ * call reuses the storage grown by the previous calls instead of building a
+ * fresh KernelContext. A kernel called while the thread is running another
+ * one, e.g. from a control flow kernel, just takes another context.
+ */
+class ScopedKernelContext {
+ public:
+  explicit ScopedKernelContext(DeviceContext* dev_ctx = nullptr);
+  ~ScopedKernelContext();
+
+  ScopedKernelContext(const ScopedKernelContext&) = delete;
+  ScopedKernelContext& operator=(const ScopedKernelContext&) = delete;
+
+  KernelContext* get() const { return ctx_.get(); }
+  KernelContext* operator->() const { return ctx_.get(); }
+
+ private:
+  std::unique_ptr<KernelContext> ctx_;
+};
+
 }  // namespace phi
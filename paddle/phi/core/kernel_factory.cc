@@ -95,6 +95,41 @@ const Kernel& KernelFactory::SelectKernelOrThrowError(
                                   KernelKey(backend, layout, dtype));
 }
 
+const Kernel& KernelHandle::SelectKernelOrThrowError(
+    const KernelKey& kernel_key) const {
+  const auto& factory = KernelFactory::Instance();
+  const uint64_t version = factory.version();
+  const uint32_t key_hash = kernel_key.hash_value();
+  const Cache* cache = cache_.load(std::memory_order_acquire);
+  if (cache != nullptr && cache->version == version) {
+    for (size_t i = 0; i < cache->size; ++i) {
+      if (cache->key_hashes[i] == key_hash) {
+        return *cache->kernels[i];
+      }
+    }
+  }
+
+  const Kernel& kernel =
+      factory.SelectKernelOrThrowError(kernel_name_, kernel_key);
+  std::lock_guard<std::mutex> guard(mutex_);
+  cache = cache_.load(std::memory_order_relaxed);
+  auto new_cache = std::make_unique<Cache>();
+  new_cache->version = version;
+  if (cache != nullptr && cache->version == version) {
+    if (cache->size == kCacheSize) {
+      // more keys than the cache holds, the others are looked up every time
+      return kernel;
+    }
+    *new_cache = *cache;
+  }
+  new_cache->key_hashes[new_cache->size] = key_hash;
+  new_cache->kernels[new_cache->size] = &kernel;
+  ++new_cache->size;
+  cache_.store(new_cache.get(), std::memory_order_release);
+  caches_.emplace_back(std::move(new_cache));
+  return kernel;
+}
+
 // print kernel info with json format:
 // {
 //   "(CPU, Undefined(AnyLayout), complex64)": {
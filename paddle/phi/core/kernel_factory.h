@@ -14,11 +14,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "paddle/phi/common/backend.h"
 #include "paddle/phi/common/data_type.h"
@@ -223,7 +227,17 @@ class KernelFactory {
  public:
   static KernelFactory& Instance();
 
-  KernelNameMap& kernels() { return kernels_; }
+  // The caller may change the kernels, so the caches of KernelHandle are
+  // dropped.
+  KernelNameMap& kernels() {
+    version_.fetch_add(1, std::memory_order_relaxed);
+    return kernels_;
+  }
+
+  const KernelNameMap& kernels() const { return kernels_; }
+
+  // Changes whenever the kernels may have changed.
+  uint64_t version() const { return version_.load(std::memory_order_relaxed); }
 
   bool HasCompatiblePhiKernel(const std::string& op_type) const {
     return kernels_.find(TransToPhiKernelName(op_type)) != kernels_.end();
@@ -246,6 +260,51 @@ class KernelFactory {
   KernelFactory() = default;
 
   KernelNameMap kernels_;
+  std::atomic<uint64_t> version_{0};
+};
+
+/**
+ * KernelHandle selects the kernels of one kernel name without hashing the
+ * name again. The kernels it has selected are kept in a small cache keyed
+ * by (backend, layout, dtype), so the dispatch of an op called again with
+ * the same key is a few comparisons. The cache is dropped when the kernels
+ * of the KernelFactory change, e.g. when custom kernels are loaded.
+ *
+ * Since kernels are registered by static objects, a handle is meant to be
+ * a function-local static of the caller, which is created at the first call
+ * after all the kernels are registered:
+ *
+ *   static const phi::KernelHandle handle("scale");
+ *   const auto& kernel = handle.SelectKernelOrThrowError(kernel_key);
+ */
+class KernelHandle {
+ public:
+  explicit KernelHandle(const std::string& kernel_name)
+      : kernel_name_(kernel_name) {}
+
+  KernelHandle(const KernelHandle&) = delete;
+  KernelHandle& operator=(const KernelHandle&) = delete;
+
+  const std::string& kernel_name() const { return kernel_name_; }
+
+  const Kernel& SelectKernelOrThrowError(const KernelKey& kernel_key) const;
+
+ private:
+  static constexpr size_t kCacheSize = 4;
+
+  // Never changed after it is published, so reading it takes no lock.
+  struct Cache {
+    uint64_t version{0};
+    size_t size{0};
+    uint32_t key_hashes[kCacheSize];
+    const Kernel* kernels[kCacheSize];
+  };
+
+  std::string kernel_name_;
+  mutable std::atomic<const Cache*> cache_{nullptr};
+  // all the published caches, a reader may still hold an old one
+  mutable std::mutex mutex_;
+  mutable std::vector<std::unique_ptr<Cache>> caches_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
@@ -74,11 +74,26 @@ DEFINE_CPU_ACT_KERNEL_WITH_ONE_ATTRS(ThresholdedRelu,
 DEFINE_CPU_ACT_KERNEL_WITH_TWO_ATTRS(BRelu, funcs::BReluFunctor, t_min, t_max)
 
 }  // namespace phi
-PD_REGISTER_KERNEL(relu, CPU, ALL_LAYOUT, phi::ReluKernel, float, double) {}
+PD_REGISTER_KERNEL(relu,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::ReluKernel,
+                   float,
+                   double,
+                   phi::dtype::bfloat16) {}
 
 #define PD_REGISTER_ACTIVATION_KERNEL(name, func) \
   PD_REGISTER_KERNEL(name, CPU, ALL_LAYOUT, phi::func##Kernel, float, double) {}
 
+#define PD_REGISTER_ACTIVATION_KERNEL_WITH_BF16(name, func) \
+  PD_REGISTER_KERNEL(name,                                  \
+                     CPU,                                   \
+                     ALL_LAYOUT,                            \
+                     phi::func##Kernel,                     \
+                     float,                                 \
+                     double,                                \
+                     phi::dtype::bfloat16) {}
+
 PD_REGISTER_ACTIVATION_KERNEL(sin, Sin)
 PD_REGISTER_ACTIVATION_KERNEL(cos, Cos)
 PD_REGISTER_ACTIVATION_KERNEL(tan, Tan)
@@ -90,7 +105,7 @@ PD_REGISTER_ACTIVATION_KERNEL(cosh, Cosh)
 PD_REGISTER_ACTIVATION_KERNEL(asinh, Asinh)
 PD_REGISTER_ACTIVATION_KERNEL(acosh, Acosh)
 PD_REGISTER_ACTIVATION_KERNEL(atanh, Atanh)
-PD_REGISTER_ACTIVATION_KERNEL(tanh, Tanh)
+PD_REGISTER_ACTIVATION_KERNEL_WITH_BF16(tanh, Tanh)
 PD_REGISTER_ACTIVATION_KERNEL(brelu, BRelu)
-PD_REGISTER_ACTIVATION_KERNEL(leaky_relu, LeakyRelu)
+PD_REGISTER_ACTIVATION_KERNEL_WITH_BF16(leaky_relu, LeakyRelu)
 PD_REGISTER_ACTIVATION_KERNEL(thresholded_relu, ThresholdedRelu)
@@ -17,6 +17,7 @@
 #include "paddle/phi/api/ext/dispatch.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_bf16.h"
 
 // See Note [ Why still include the fluid headers? ]
 #include "paddle/fluid/platform/transform.h"
@@ -34,16 +35,39 @@ void CastKernelImpl(const CPUContext& dev_ctx,
                     DenseTensor* out) {
   auto* in_begin = x.data<InT>();
   auto numel = x.numel();
-  auto* in_end = in_begin + numel;
 
   auto* out_begin = dev_ctx.Alloc<OutT>(out);
 
-  paddle::platform::Transform<CPUContext> trans;
-  trans(dev_ctx,
-        in_begin,
-        in_end,
-        out_begin,
-        CastOpTransformFunctor<InT, OutT>());
+  constexpr int64_t kGrainSize = 32768;
+  dev_ctx.ParallelFor(0, numel, kGrainSize, [&](int64_t begin, int64_t end) {
+    paddle::platform::Transform<CPUContext> trans;
+    trans(dev_ctx,
+          in_begin + begin,
+          in_begin + end,
+          out_begin + begin,
+          CastOpTransformFunctor<InT, OutT>());
+  });
+}
+
+// the casts between float and bfloat16 take the vectorized conversions
+template <>
+void CastKernelImpl<float, phi::dtype::bfloat16>(const CPUContext& dev_ctx,
+                                                 const DenseTensor& x,
+                                                 DenseTensor* out) {
+  funcs::CpuFloatToBf16(dev_ctx,
+                        x.data<float>(),
+                        dev_ctx.Alloc<phi::dtype::bfloat16>(out),
+                        x.numel());
+}
+
+template <>
+void CastKernelImpl<phi::dtype::bfloat16, float>(const CPUContext& dev_ctx,
+                                                 const DenseTensor& x,
+                                                 DenseTensor* out) {
+  funcs::CpuBf16ToFloat(dev_ctx,
+                        x.data<phi::dtype::bfloat16>(),
+                        dev_ctx.Alloc<float>(out),
+                        x.numel());
 }
 
 template <typename T, typename Context>
@@ -18,63 +18,251 @@
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
-#include "paddle/phi/core/hostdevice.h"
-#include "paddle/phi/kernels/funcs/eigen/common.h"
+#include "paddle/phi/core/enforce.h"
 
 namespace phi {
 
-template <typename T>
-struct GraphSendRecvSumFunctor {
-  void operator()(const bool& first_flag,
-                  const DenseTensor& src_slice,
-                  DenseTensor* dst_slice) {
-    auto eigen_src = phi::EigenVector<T>::Flatten(src_slice);
-    auto eigen_dst = phi::EigenVector<T>::Flatten(*dst_slice);
-    eigen_dst += eigen_src;
-  }
+/*
+ * The CPU graph_send_recv kernels are segment reductions: the edges are
+ * grouped by the row they write (the dst of the forward, the src of the
+ * backward) with a stable counting sort, then every output row is reduced
+ * from its own edges by one thread, so the rows are split among the
+ * intra-op threads without conflicts and the feature loops run on
+ * contiguous rows. The edges of a row are visited in their input order,
+ * the results do not depend on the number of threads.
+ */
+
+// the multiply-adds of one task of the row loops
+constexpr int64_t kGraphSendRecvGrainSize = 32768;
+
+// The edges grouped by segment: the edges of the segment s are the members
+// [offsets[s], offsets[s + 1]), where members holds the other end of the
+// edges.
+struct GraphSegments {
+  std::vector<int64_t> offsets;
+  std::vector<int64_t> members;
+
+  int64_t num_segments() const { return offsets.size() - 1; }
+  int64_t Count(int64_t s) const { return offsets[s + 1] - offsets[s]; }
 };
 
-template <typename T>
-struct GraphSendRecvMinFunctor {
-  void operator()(const bool& first_flag,
-                  const DenseTensor& src_slice,
-                  DenseTensor* dst_slice) {
-    auto eigen_src = phi::EigenVector<T>::Flatten(src_slice);
-    auto eigen_dst = phi::EigenVector<T>::Flatten(*dst_slice);
-    if (first_flag) {
-      eigen_dst += eigen_src;
-    } else {
-      eigen_dst = eigen_dst.cwiseMin(eigen_src);
+// Groups the edges with one counting pass over the indices, which costs less
+// than the reduction of the rows it is built for.
+template <typename IndexT>
+GraphSegments BuildGraphSegments(const IndexT* segment_ids,
+                                 const IndexT* member_ids,
+                                 int64_t num_edges,
+                                 int64_t num_segments,
+                                 int64_t num_members) {
+  GraphSegments segments;
+  segments.offsets.assign(num_segments + 1, 0);
+  for (int64_t i = 0; i < num_edges; ++i) {
+    PADDLE_ENFORCE_EQ(
+        segment_ids[i] >= 0 && segment_ids[i] < num_segments &&
+            member_ids[i] >= 0 && member_ids[i] < num_members,
+        true,
+        phi::errors::InvalidArgument(
+            "The index of the edge %d of graph_send_recv is out of range, "
+            "expected the rows to be in [0, %d) but got (%d, %d).",
+            i,
+            std::min(num_segments, num_members),
+            segment_ids[i],
+            member_ids[i]));
+    ++segments.offsets[segment_ids[i] + 1];
+  }
+  for (int64_t s = 0; s < num_segments; ++s) {
+    segments.offsets[s + 1] += segments.offsets[s];
+  }
+  segments.members.resize(num_edges);
+  std::vector<int64_t> next(segments.offsets.begin(),
+                            segments.offsets.end() - 1);
+  for (int64_t i = 0; i < num_edges; ++i) {
+    segments.members[next[segment_ids[i]]++] = member_ids[i];
+  }
+  return segments;
+}
+
+// Runs fn(s) for every segment, the segments are split into tasks of about
+// the same number of edges, so the hubs of a power-law graph do not leave
+// the other threads idle.
+template <typename Fn>
+void ForEachGraphSegment(const CPUContext& ctx,
+                         const GraphSegments& segments,
+                         int64_t width,
+                         Fn&& fn) {
+  const int64_t num_segments = segments.num_segments();
+  const int64_t num_edges = segments.members.size();
+  const int64_t work =
+      (num_edges + num_segments) * std::max<int64_t>(width, 1);
+  const int64_t num_tasks = std::max<int64_t>(
+      1,
+      std::min<int64_t>(num_segments, work / kGraphSendRecvGrainSize));
+  std::vector<int64_t> bounds(num_tasks + 1, num_segments);
+  bounds[0] = 0;
+  for (int64_t t = 1; t < num_tasks; ++t) {
+    const int64_t edge = num_edges * t / num_tasks;
+    bounds[t] = std::upper_bound(segments.offsets.begin(),
+                                 segments.offsets.end(),
+                                 edge) -
+                segments.offsets.begin() - 1;
+    bounds[t] = std::max(bounds[t], bounds[t - 1]);
+  }
+  ctx.ParallelFor(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t s = bounds[begin]; s < bounds[end]; ++s) {
+      fn(s);
     }
+  });
+}
+
+///////// Forward /////////
+
+enum class GraphPool { kSum, kMean, kMin, kMax };
+
+struct GraphSumOp {
+  template <typename T>
+  static T Apply(T a, T b) {
+    return a + b;
   }
 };
 
-template <typename T>
-struct GraphSendRecvMaxFunctor {
-  void operator()(const int& first_flag,
-                  const DenseTensor& src_slice,
-                  DenseTensor* dst_slice) {
-    auto eigen_src = phi::EigenVector<T>::Flatten(src_slice);
-    auto eigen_dst = phi::EigenVector<T>::Flatten(*dst_slice);
-    if (first_flag) {
-      eigen_dst += eigen_src;
-    } else {
-      eigen_dst = eigen_dst.cwiseMax(eigen_src);
-    }
+struct GraphMinOp {
+  template <typename T>
+  static T Apply(T a, T b) {
+    return b < a ? b : a;
   }
 };
 
-template <typename T, typename IndexT, typename Functor>
-void ElementwiseInnerOperation(const DenseTensor& src,
-                               DenseTensor* dst,
-                               const IndexT& src_index,
-                               const IndexT& dst_index,
-                               const bool& first_flag,
-                               Functor functor) {
-  auto src_slice = src.Slice(src_index, src_index + 1);
-  auto dst_slice = dst->Slice(dst_index, dst_index + 1);
-
-  functor(first_flag, src_slice, &dst_slice);
+struct GraphMaxOp {
+  template <typename T>
+  static T Apply(T a, T b) {
+    return b > a ? b : a;
+  }
+};
+
+namespace detail {
+
+template <typename T, typename Op>
+void GraphSegmentReduce(const CPUContext& ctx,
+                        const GraphSegments& segments,
+                        const T* x,
+                        int64_t width,
+                        bool mean,
+                        T* out) {
+  const int64_t* offsets = segments.offsets.data();
+  const int64_t* members = segments.members.data();
+  ForEachGraphSegment(ctx, segments, width, [=](int64_t s) {
+    T* out_row = out + s * width;
+    const int64_t begin = offsets[s];
+    const int64_t end = offsets[s + 1];
+    if (begin == end) {
+      std::fill(out_row, out_row + width, static_cast<T>(0));
+      return;
+    }
+    const T* first = x + members[begin] * width;
+    std::copy(first, first + width, out_row);
+    for (int64_t j = begin + 1; j < end; ++j) {
+      const T* x_row = x + members[j] * width;
+      for (int64_t k = 0; k < width; ++k) {
+        out_row[k] = Op::Apply(out_row[k], x_row[k]);
+      }
+    }
+    if (mean) {
+      const T count = static_cast<T>(end - begin);
+      for (int64_t k = 0; k < width; ++k) {
+        out_row[k] = out_row[k] / count;
+      }
+    }
+  });
+}
+
+}  // namespace detail
+
+// out[s] = pool(x[m]) over the members m of the segment s, the rows without
+// edges are 0.
+template <typename T>
+void GraphSegmentPool(const CPUContext& ctx,
+                      const GraphSegments& segments,
+                      GraphPool pool,
+                      const T* x,
+                      int64_t width,
+                      T* out) {
+  switch (pool) {
+    case GraphPool::kSum:
+    case GraphPool::kMean:
+      detail::GraphSegmentReduce<T, GraphSumOp>(
+          ctx, segments, x, width, pool == GraphPool::kMean, out);
+      break;
+    case GraphPool::kMin:
+      detail::GraphSegmentReduce<T, GraphMinOp>(
+          ctx, segments, x, width, false, out);
+      break;
+    case GraphPool::kMax:
+      detail::GraphSegmentReduce<T, GraphMaxOp>(
+          ctx, segments, x, width, false, out);
+      break;
+  }
+}
+
+///////// Backward /////////
+
+// x_grad[s] = sum(out_grad[m] / dst_count[m]) over the members m of the
+// segment s, whose segments are the sources of the forward edges. Without
+// dst_count it is the gradient of SUM.
+template <typename T>
+void GraphSegmentSumGrad(const CPUContext& ctx,
+                         const GraphSegments& segments,
+                         const T* out_grad,
+                         const int* dst_count,
+                         int64_t width,
+                         T* x_grad) {
+  const int64_t* offsets = segments.offsets.data();
+  const int64_t* members = segments.members.data();
+  ForEachGraphSegment(ctx, segments, width, [=](int64_t s) {
+    T* grad_row = x_grad + s * width;
+    std::fill(grad_row, grad_row + width, static_cast<T>(0));
+    for (int64_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+      const int64_t m = members[j];
+      const T* out_grad_row = out_grad + m * width;
+      if (dst_count == nullptr) {
+        for (int64_t k = 0; k < width; ++k) {
+          grad_row[k] += out_grad_row[k];
+        }
+      } else {
+        const T count = static_cast<T>(dst_count[m]);
+        for (int64_t k = 0; k < width; ++k) {
+          grad_row[k] += out_grad_row[k] / count;
+        }
+      }
+    }
+  });
+}
+
+// x_grad[s] = sum(out_grad[m] * (out[m] == x[s])) over the members m of the
+// segment s, the gradient of MIN and MAX.
+template <typename T>
+void GraphSegmentMinMaxGrad(const CPUContext& ctx,
+                            const GraphSegments& segments,
+                            const T* out_grad,
+                            const T* x,
+                            const T* out,
+                            int64_t width,
+                            T* x_grad) {
+  const int64_t* offsets = segments.offsets.data();
+  const int64_t* members = segments.members.data();
+  ForEachGraphSegment(ctx, segments, width, [=](int64_t s) {
+    T* grad_row = x_grad + s * width;
+    const T* x_row = x + s * width;
+    std::fill(grad_row, grad_row + width, static_cast<T>(0));
+    for (int64_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+      const int64_t m = members[j];
+      const T* out_grad_row = out_grad + m * width;
+      const T* out_row = out + m * width;
+      for (int64_t k = 0; k < width; ++k) {
+        grad_row[k] += out_row[k] == x_row[k] ? out_grad_row[k]
+                                              : static_cast<T>(0);
+      }
+    }
+  });
 }
 
 }  // namespace phi
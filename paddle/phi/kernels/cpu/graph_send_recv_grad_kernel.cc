@@ -16,59 +16,14 @@
 #include "paddle/phi/kernels/cpu/graph_send_recv_funcs.h"
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
 
 namespace phi {
 
-template <typename T, typename IndexT, typename Functor>
-void GraphSendRecvCpuGradLoop(const int& input_size,
-                              const int& index_size,
-                              const IndexT* s_index,
-                              const IndexT* d_index,
-                              const DenseTensor& src,
-                              DenseTensor* dst,
-                              const std::string& pool_type,
-                              const int* dst_count = nullptr,
-                              const DenseTensor* input = nullptr,
-                              const DenseTensor* output = nullptr) {
-  if (pool_type == "SUM") {
-    Functor functor;
-    for (int i = 0; i < index_size; ++i) {
-      const IndexT& src_idx = s_index[i];
-      const IndexT& dst_idx = d_index[i];
-      ElementwiseInnerOperation<T, IndexT, Functor>(
-          src, dst, src_idx, dst_idx, false, functor);
-    }
-  } else if (pool_type == "MEAN") {
-    for (int i = 0; i < index_size; ++i) {
-      const IndexT& src_idx = s_index[i];
-      const IndexT& dst_idx = d_index[i];
-      auto src_slice = src.Slice(src_idx, src_idx + 1);
-      auto dst_slice = dst->Slice(dst_idx, dst_idx + 1);
-      auto eigen_src = phi::EigenVector<T>::Flatten(src_slice);
-      auto eigen_dst = phi::EigenVector<T>::Flatten(dst_slice);
-      eigen_dst += (eigen_src / static_cast<T>(dst_count[src_idx]));
-    }
-  } else if (pool_type == "MIN" || pool_type == "MAX") {
-    for (int i = 0; i < index_size; ++i) {
-      const IndexT& forward_src_idx = d_index[i];
-      const IndexT& forward_dst_idx = s_index[i];
-      auto input_slice = input->Slice(forward_src_idx, forward_src_idx + 1);
-      auto output_slice = output->Slice(forward_dst_idx, forward_dst_idx + 1);
-      auto eigen_input = phi::EigenVector<T>::Flatten(input_slice);
-      auto eigen_output = phi::EigenVector<T>::Flatten(output_slice);
-
-      auto src_slice = src.Slice(forward_dst_idx, forward_dst_idx + 1);
-      auto dst_slice = dst->Slice(forward_src_idx, forward_src_idx + 1);
-      auto eigen_src = phi::EigenVector<T>::Flatten(src_slice);
-      auto eigen_dst = phi::EigenVector<T>::Flatten(dst_slice);
-      eigen_dst += eigen_src * (eigen_output == eigen_input);
-    }
-  }
-}
-
 template <typename Context, typename T, typename IndexT>
 void GraphSendRecvGradOpKernelLaunchHelper(
     const Context& ctx,
@@ -80,47 +35,47 @@ void GraphSendRecvGradOpKernelLaunchHelper(
     const DenseTensor* dst_count = nullptr,
     const DenseTensor* x = nullptr,
     const DenseTensor* out = nullptr) {
-  const int& index_size = dst_index.dims()[0];
+  const int64_t index_size = dst_index.dims()[0];
+  const auto& src_dims = out_grad.dims();
+  const int64_t num_rows = src_dims[0];
+  const int64_t width = num_rows == 0 ? 0 : out_grad.numel() / num_rows;
 
   ctx.template Alloc<T>(x_grad);
   T* p_output = x_grad->data<T>();
-  const auto& src_dims = out_grad.dims();
-  int64_t memset_size = 1;
-  for (int i = 0; i < src_dims.size(); ++i) memset_size *= src_dims[i];
-  const size_t& memset_bytes = memset_size * sizeof(T);
-  memset(p_output, 0, memset_bytes);
-
-  if (index_size == 0) return;
-
-  const IndexT* s_index = src_index.data<IndexT>();
-  const IndexT* d_index = dst_index.data<IndexT>();
+  if (index_size == 0) {
+    memset(p_output, 0, out_grad.numel() * sizeof(T));
+    return;
+  }
 
+  // the rows of x_grad gather the edges by their src
+  auto segments = BuildGraphSegments(src_index.data<IndexT>(),
+                                     dst_index.data<IndexT>(),
+                                     index_size,
+                                     num_rows,
+                                     num_rows);
   if (pool_type == "SUM") {
-    GraphSendRecvCpuGradLoop<T, IndexT, GraphSendRecvSumFunctor<T>>(
-        src_dims[0], index_size, d_index, s_index, out_grad, x_grad, pool_type);
+    GraphSegmentSumGrad<T>(
+        ctx, segments, out_grad.data<T>(), nullptr, width, p_output);
   } else if (pool_type == "MEAN") {
-    const int* s_count = dst_count->data<int>();
-    // Functor not used here.
-    GraphSendRecvCpuGradLoop<T, IndexT, GraphSendRecvSumFunctor<T>>(src_dims[0],
-                                                                    index_size,
-                                                                    d_index,
-                                                                    s_index,
-                                                                    out_grad,
-                                                                    x_grad,
-                                                                    pool_type,
-                                                                    s_count);
+    GraphSegmentSumGrad<T>(ctx,
+                           segments,
+                           out_grad.data<T>(),
+                           dst_count->data<int>(),
+                           width,
+                           p_output);
   } else if (pool_type == "MIN" || pool_type == "MAX") {
-    // Functor not used here.
-    GraphSendRecvCpuGradLoop<T, IndexT, GraphSendRecvMinFunctor<T>>(src_dims[0],
-                                                                    index_size,
-                                                                    d_index,
-                                                                    s_index,
-                                                                    out_grad,
-                                                                    x_grad,
-                                                                    pool_type,
-                                                                    nullptr,
-                                                                    x,
-                                                                    out);
+    GraphSegmentMinMaxGrad<T>(ctx,
+                              segments,
+                              out_grad.data<T>(),
+                              x->data<T>(),
+                              out->data<T>(),
+                              width,
+                              p_output);
+  } else {
+    PADDLE_THROW(phi::errors::InvalidArgument(
+        "The pool_type of graph_send_recv should be SUM, MEAN, MIN or MAX, "
+        "but got %s.",
+        pool_type));
   }
 }
 
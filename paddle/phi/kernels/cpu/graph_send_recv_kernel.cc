@@ -16,67 +16,14 @@
 #include "paddle/phi/kernels/cpu/graph_send_recv_funcs.h"
 
 #include <algorithm>
-#include <set>
+#include <cstring>
 #include <vector>
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
-#include "paddle/phi/core/hostdevice.h"
 #include "paddle/phi/core/kernel_registry.h"
 
 namespace phi {
 
-template <typename T, typename IndexT, typename Functor>
-void GraphSendRecvCpuLoop(const int& input_size,
-                          const int& index_size,
-                          const IndexT* s_index,
-                          const IndexT* d_index,
-                          const DenseTensor& src,
-                          DenseTensor* dst,
-                          const std::string& pool_type,
-                          int* dst_count = nullptr) {
-  Functor functor;
-  if (pool_type == "SUM") {
-    for (int i = 0; i < index_size; ++i) {
-      const IndexT& src_idx = s_index[i];
-      const IndexT& dst_idx = d_index[i];
-      ElementwiseInnerOperation<T, IndexT, Functor>(
-          src, dst, src_idx, dst_idx, false, functor);
-    }
-  } else if (pool_type == "MEAN") {
-    for (int i = 0; i < index_size; ++i) {
-      const IndexT& src_idx = s_index[i];
-      const IndexT& dst_idx = d_index[i];
-      ElementwiseInnerOperation<T, IndexT, Functor>(
-          src, dst, src_idx, dst_idx, false, functor);
-    }
-    for (int i = 0; i < index_size; ++i) {
-      IndexT dst_idx = d_index[i];
-      *(dst_count + dst_idx) += 1;
-    }
-    for (int i = 0; i < input_size; ++i) {
-      if (*(dst_count + i) == 0) continue;
-      auto dst_slice = dst->Slice(i, i + 1);
-      auto eigen_dst = phi::EigenVector<T>::Flatten(dst_slice);
-      eigen_dst = eigen_dst / static_cast<T>(*(dst_count + i));
-    }
-  } else if (pool_type == "MIN" || pool_type == "MAX") {
-    std::set<IndexT> existed_dst;
-    for (int i = 0; i < index_size; ++i) {
-      const IndexT& src_idx = s_index[i];
-      const IndexT& dst_idx = d_index[i];
-      bool in_set = existed_dst.find(dst_idx) != existed_dst.end();
-      if (!in_set) {
-        ElementwiseInnerOperation<T, IndexT, Functor>(
-            src, dst, src_idx, dst_idx, true, functor);
-        existed_dst.emplace(dst_idx);
-      } else {
-        ElementwiseInnerOperation<T, IndexT, Functor>(
-            src, dst, src_idx, dst_idx, false, functor);
-      }
-    }
-  }
-}
-
 template <typename Context, typename T, typename IndexT>
 void GraphSendRecvOpKernelLaunchHelper(const Context& ctx,
                                        const DenseTensor& x,
@@ -85,41 +32,53 @@ void GraphSendRecvOpKernelLaunchHelper(const Context& ctx,
                                        const std::string& pool_type,
                                        DenseTensor* out,
                                        DenseTensor* dst_count = nullptr) {
-  const int& index_size = src_index.dims()[0];
+  const int64_t index_size = src_index.dims()[0];
+  const auto& src_dims = x.dims();
+  const int64_t num_rows = src_dims[0];
+  const int64_t width = num_rows == 0 ? 0 : x.numel() / num_rows;
 
   ctx.template Alloc<T>(out);
   T* p_output = out->data<T>();
-  const auto& src_dims = x.dims();
-  int64_t memset_size = 1;
-  for (int i = 0; i < src_dims.size(); ++i) memset_size *= src_dims[i];
-  const size_t& memset_bytes = memset_size * sizeof(T);
-  memset(p_output, 0, memset_bytes);
-
-  if (index_size == 0) return;
+  int* p_dst_count = nullptr;
+  if (pool_type == "MEAN") {
+    ctx.template Alloc<int>(dst_count);
+    p_dst_count = dst_count->data<int>();
+  }
+  if (index_size == 0) {
+    memset(p_output, 0, x.numel() * sizeof(T));
+    if (p_dst_count != nullptr) {
+      memset(p_dst_count, 0, num_rows * sizeof(int));
+    }
+    return;
+  }
 
-  const IndexT* s_index = src_index.data<IndexT>();
-  const IndexT* d_index = dst_index.data<IndexT>();
+  GraphPool pool;
   if (pool_type == "SUM") {
-    GraphSendRecvCpuLoop<T, IndexT, GraphSendRecvSumFunctor<T>>(
-        src_dims[0], index_size, s_index, d_index, x, out, pool_type);
+    pool = GraphPool::kSum;
+  } else if (pool_type == "MEAN") {
+    pool = GraphPool::kMean;
   } else if (pool_type == "MIN") {
-    GraphSendRecvCpuLoop<T, IndexT, GraphSendRecvMinFunctor<T>>(
-        src_dims[0], index_size, s_index, d_index, x, out, pool_type);
+    pool = GraphPool::kMin;
   } else if (pool_type == "MAX") {
-    GraphSendRecvCpuLoop<T, IndexT, GraphSendRecvMaxFunctor<T>>(
-        src_dims[0], index_size, s_index, d_index, x, out, pool_type);
-  } else if (pool_type == "MEAN") {
-    ctx.template Alloc<int>(dst_count);
-    int* p_dst_count = dst_count->data<int>();
-    memset(p_dst_count, 0, src_dims[0] * sizeof(int));
-    GraphSendRecvCpuLoop<T, IndexT, GraphSendRecvSumFunctor<T>>(src_dims[0],
-                                                                index_size,
-                                                                s_index,
-                                                                d_index,
-                                                                x,
-                                                                out,
-                                                                pool_type,
-                                                                p_dst_count);
+    pool = GraphPool::kMax;
+  } else {
+    PADDLE_THROW(phi::errors::InvalidArgument(
+        "The pool_type of graph_send_recv should be SUM, MEAN, MIN or MAX, "
+        "but got %s.",
+        pool_type));
+  }
+
+  // the rows of out gather the edges by their dst
+  auto segments = BuildGraphSegments(dst_index.data<IndexT>(),
+                                     src_index.data<IndexT>(),
+                                     index_size,
+                                     num_rows,
+                                     num_rows);
+  GraphSegmentPool<T>(ctx, segments, pool, x.data<T>(), width, p_output);
+  if (p_dst_count != nullptr) {
+    for (int64_t i = 0; i < num_rows; ++i) {
+      p_dst_count[i] = static_cast<int>(segments.Count(i));
+    }
   }
 }
 
@@ -25,6 +25,7 @@ PD_REGISTER_KERNEL(matmul_grad,
                    phi::MatmulGradKernel,
                    float,
                    double,
+                   phi::dtype::bfloat16,
                    phi::dtype::complex<float>,
                    phi::dtype::complex<double>) {}
 
@@ -22,6 +22,7 @@
 
 #include "paddle/phi/api/lib/utils/storage.h"
 #include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/cpu_reduce.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 // See Note [ Why still include the fluid headers? ]
@@ -151,6 +152,29 @@ void HandleLargeDim(const DeviceContext& dev_ctx,
 
 ////////////// ReduceKernel
 
+template <typename Functor, typename OutT>
+bool CpuReduceFastPath(const phi::CPUContext& dev_ctx,
+                       const phi::DenseTensor& input,
+                       phi::DenseTensor* output,
+                       const std::vector<int64_t>& dims,
+                       bool reduce_all) {
+  return funcs::CpuReduceIfSupported<Functor, OutT>(dev_ctx,
+                                                    input.data<OutT>(),
+                                                    output->data<OutT>(),
+                                                    input.dims(),
+                                                    dims,
+                                                    reduce_all);
+}
+
+template <typename Functor, typename OutT, typename DeviceContext>
+bool CpuReduceFastPath(const DeviceContext& dev_ctx,
+                       const phi::DenseTensor& input,
+                       phi::DenseTensor* output,
+                       const std::vector<int64_t>& dims,
+                       bool reduce_all) {
+  return false;
+}
+
 template <typename DeviceContext, typename T, typename OutT, typename Functor>
 void ReduceKernelImpl(const DeviceContext& dev_ctx,
                       const phi::DenseTensor& input,
@@ -160,6 +184,14 @@ void ReduceKernelImpl(const DeviceContext& dev_ctx,
                       bool reduce_all) {
   dev_ctx.template Alloc<OutT>(output);
 
+  // the functors and types supported by the rank-generic engine skip the
+  // Eigen instantiations below
+  if (input.dtype() == output->dtype() &&
+      CpuReduceFastPath<Functor, OutT>(
+          dev_ctx, input, output, dims, reduce_all)) {
+    return;
+  }
+
   if (reduce_all) {
     // Flatten and reduce 1-D tensor
     auto x = EigenVector<OutT>::Flatten(input);
@@ -24,6 +24,7 @@
 
 #include "paddle/phi/common/bfloat16.h"
 #include "paddle/phi/common/complex.h"
+#include "paddle/phi/kernels/funcs/cpu_bf16.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
 namespace phi {
@@ -40,6 +41,18 @@ static void axpy(
     x = x + incx;
   }
 }
+
+// a row-major bfloat16 matrix of rows x cols with the leading dimension ld,
+// widened to float with the same leading dimension
+inline std::vector<float> Bf16MatrixToFloat(const phi::dtype::bfloat16 *x,
+                                            int rows,
+                                            int cols,
+                                            int ld) {
+  std::vector<float> out(
+      rows > 0 && cols > 0 ? static_cast<size_t>(rows - 1) * ld + cols : 0);
+  CpuBf16ToFloat(x, out.data(), out.size());
+  return out;
+}
 }  // namespace detail
 
 template <typename T>
@@ -63,51 +76,6 @@ struct CBlas<int16_t> {
   }
 };
 
-template <>
-struct CBlas<phi::dtype::bfloat16> {
-  template <typename... ARGS>
-  static void AXPY(ARGS... args) {
-    detail::axpy(args...);
-  }
-
-  template <typename... ARGS>
-  static void VCOPY(ARGS... args) {
-    PADDLE_THROW(phi::errors::Unimplemented(
-        "Blas VCOPY do not supported on CPU with bfloat16,"
-        " please check your code"));
-  }
-
-  template <typename... ARGS>
-  static void VADD(int n,
-                   const phi::dtype::bfloat16 *x,
-                   const phi::dtype::bfloat16 *y,
-                   phi::dtype::bfloat16 *z) {
-    for (int i = 0; i < n; ++i) {
-      z[i] = x[i] + y[i];
-    }
-  }
-
-  template <typename... ARGS>
-  static void VMUL(int n,
-                   const phi::dtype::bfloat16 *x,
-                   const phi::dtype::bfloat16 *y,
-                   phi::dtype::bfloat16 *z) {
-    for (int i = 0; i < n; ++i) {
-      z[i] = x[i] * y[i];
-    }
-  }
-
-  template <typename... ARGS>
-  static void VSUB(int n,
-                   const phi::dtype::bfloat16 *x,
-                   const phi::dtype::bfloat16 *y,
-                   phi::dtype::bfloat16 *z) {
-    for (int i = 0; i < n; ++i) {
-      z[i] = x[i] - y[i];
-    }
-  }
-};
-
 #ifdef PADDLE_WITH_MKLML
 template <>
 struct CBlas<float> {
@@ -953,6 +921,182 @@ struct CBlas<phi::dtype::complex<double>> {
 
 #endif
 
+template <>
+struct CBlas<phi::dtype::bfloat16> {
+  template <typename... ARGS>
+  static void AXPY(ARGS... args) {
+    detail::axpy(args...);
+  }
+
+  template <typename... ARGS>
+  static void VCOPY(ARGS... args) {
+    PADDLE_THROW(phi::errors::Unimplemented(
+        "Blas VCOPY do not supported on CPU with bfloat16,"
+        " please check your code"));
+  }
+
+  template <typename... ARGS>
+  static void VADD(int n,
+                   const phi::dtype::bfloat16 *x,
+                   const phi::dtype::bfloat16 *y,
+                   phi::dtype::bfloat16 *z) {
+    for (int i = 0; i < n; ++i) {
+      z[i] = x[i] + y[i];
+    }
+  }
+
+  template <typename... ARGS>
+  static void VMUL(int n,
+                   const phi::dtype::bfloat16 *x,
+                   const phi::dtype::bfloat16 *y,
+                   phi::dtype::bfloat16 *z) {
+    for (int i = 0; i < n; ++i) {
+      z[i] = x[i] * y[i];
+    }
+  }
+
+  template <typename... ARGS>
+  static void VSUB(int n,
+                   const phi::dtype::bfloat16 *x,
+                   const phi::dtype::bfloat16 *y,
+                   phi::dtype::bfloat16 *z) {
+    for (int i = 0; i < n; ++i) {
+      z[i] = x[i] - y[i];
+    }
+  }
+
+  // The matrix products run by the float BLAS: the inputs are widened
+  // exactly and the products are accumulated in float, only the results are
+  // rounded to bfloat16.
+  static void GEMM(CBLAS_LAYOUT layout,
+                   CBLAS_TRANSPOSE trans_a,
+                   CBLAS_TRANSPOSE trans_b,
+                   int M,
+                   int N,
+                   int K,
+                   phi::dtype::bfloat16 alpha,
+                   const phi::dtype::bfloat16 *A,
+                   int lda,
+                   const phi::dtype::bfloat16 *B,
+                   int ldb,
+                   phi::dtype::bfloat16 beta,
+                   phi::dtype::bfloat16 *C,
+                   int ldc) {
+    PADDLE_ENFORCE_EQ(layout,
+                      CblasRowMajor,
+                      phi::errors::Unimplemented(
+                          "bfloat16 GEMM only supports the row major layout."));
+    auto a = detail::Bf16MatrixToFloat(A,
+                                       trans_a == CblasNoTrans ? M : K,
+                                       trans_a == CblasNoTrans ? K : M,
+                                       lda);
+    auto b = detail::Bf16MatrixToFloat(B,
+                                       trans_b == CblasNoTrans ? K : N,
+                                       trans_b == CblasNoTrans ? N : K,
+                                       ldb);
+    const float beta_f = static_cast<float>(beta);
+    std::vector<float> c =
+        beta_f == 0.0f ? std::vector<float>(static_cast<size_t>(M) * N)
+                       : detail::Bf16MatrixToFloat(C, M, N, ldc);
+    const int ldc_f = beta_f == 0.0f ? N : ldc;
+    CBlas<float>::GEMM(layout,
+                       trans_a,
+                       trans_b,
+                       M,
+                       N,
+                       K,
+                       static_cast<float>(alpha),
+                       a.data(),
+                       lda,
+                       b.data(),
+                       ldb,
+                       beta_f,
+                       c.data(),
+                       ldc_f);
+    for (int i = 0; i < M; ++i) {
+      CpuFloatToBf16(c.data() + static_cast<size_t>(i) * ldc_f,
+                     C + static_cast<size_t>(i) * ldc,
+                     N);
+    }
+  }
+
+  static void GEMV(CBLAS_LAYOUT layout,
+                   CBLAS_TRANSPOSE trans_a,
+                   int M,
+                   int N,
+                   phi::dtype::bfloat16 alpha,
+                   const phi::dtype::bfloat16 *A,
+                   int lda,
+                   const phi::dtype::bfloat16 *X,
+                   int incx,
+                   phi::dtype::bfloat16 beta,
+                   phi::dtype::bfloat16 *Y,
+                   int incy) {
+    PADDLE_ENFORCE_EQ(layout == CblasRowMajor && incx == 1 && incy == 1,
+                      true,
+                      phi::errors::Unimplemented(
+                          "bfloat16 GEMV only supports the row major layout "
+                          "and contiguous vectors."));
+    const int x_len = trans_a == CblasNoTrans ? N : M;
+    const int y_len = trans_a == CblasNoTrans ? M : N;
+    auto a = detail::Bf16MatrixToFloat(A, M, N, lda);
+    auto x = detail::Bf16MatrixToFloat(X, 1, x_len, x_len);
+    auto y = detail::Bf16MatrixToFloat(Y, 1, y_len, y_len);
+    CBlas<float>::GEMV(layout,
+                       trans_a,
+                       M,
+                       N,
+                       static_cast<float>(alpha),
+                       a.data(),
+                       lda,
+                       x.data(),
+                       1,
+                       static_cast<float>(beta),
+                       y.data(),
+                       1);
+    CpuFloatToBf16(y.data(), Y, y_len);
+  }
+
+#ifdef PADDLE_WITH_MKLML
+  static void GEMM_BATCH(CBLAS_LAYOUT layout,
+                         const CBLAS_TRANSPOSE *trans_a,
+                         const CBLAS_TRANSPOSE *trans_b,
+                         const int *M,
+                         const int *N,
+                         const int *K,
+                         const phi::dtype::bfloat16 *alpha,
+                         const phi::dtype::bfloat16 **A,
+                         const int *lda,
+                         const phi::dtype::bfloat16 **B,
+                         const int *ldb,
+                         const phi::dtype::bfloat16 *beta,
+                         phi::dtype::bfloat16 **C,
+                         const int *ldc,
+                         int group_count,
+                         const int *group_size) {
+    int index = 0;
+    for (int g = 0; g < group_count; ++g) {
+      for (int i = 0; i < group_size[g]; ++i, ++index) {
+        GEMM(layout,
+             trans_a[g],
+             trans_b[g],
+             M[g],
+             N[g],
+             K[g],
+             alpha[g],
+             A[index],
+             lda[g],
+             B[index],
+             ldb[g],
+             beta[g],
+             C[index],
+             ldc[g]);
+      }
+    }
+  }
+#endif
+};
+
 template <>
 struct CBlas<phi::dtype::float16> {
   static void GEMM(...) {
@@ -14,9 +14,14 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/funcs/concat_and_split_functor.h"
 
+#include <algorithm>
+
 namespace phi {
 namespace funcs {
 
+// the elements copied by one thread at least
+static constexpr int64_t kCopyGrainSize = 32768;
+
 /*
  * All tensors' dimension should be the same and the values of
  * each dimension must be the same, except the axis dimension.
@@ -47,19 +52,24 @@ struct ConcatFunctor<phi::CPUContext, T> {
 
     // computation
     auto output_data = output->data<T>();
-    int64_t col_idx = 0;
-    for (size_t j = 0; j < num; ++j) {
-      int64_t col_len = input_cols[j];
-      auto input_data = input[j].data<T>();
-      for (int64_t k = 0; k < out_rows; ++k) {
-        paddle::memory::Copy(cpu_place,
-                             output_data + k * out_cols + col_idx,
-                             cpu_place,
-                             input_data + k * col_len,
-                             sizeof(T) * col_len);
-      }
-      col_idx += col_len;
-    }
+    int64_t grain_size =
+        std::max<int64_t>(1, kCopyGrainSize / std::max<int64_t>(out_cols, 1));
+    context.ParallelFor(
+        0, out_rows, grain_size, [&](int64_t row_begin, int64_t row_end) {
+          int64_t col_idx = 0;
+          for (size_t j = 0; j < num; ++j) {
+            int64_t col_len = input_cols[j];
+            auto input_data = input[j].data<T>();
+            for (int64_t k = row_begin; k < row_end; ++k) {
+              paddle::memory::Copy(cpu_place,
+                                   output_data + k * out_cols + col_idx,
+                                   cpu_place,
+                                   input_data + k * col_len,
+                                   sizeof(T) * col_len);
+            }
+            col_idx += col_len;
+          }
+        });
   }
 };
 
@@ -101,23 +111,28 @@ struct SplitFunctor<phi::CPUContext, T> {
     auto cpu_place = context.GetPlace();
 
     // computation
-    for (int k = 0; k < input_rows; ++k) {
-      const T* src_ptr = input.data<T>() + k * input_cols;
-      int col_idx = 0;
-      for (size_t j = 0; j < num; ++j) {
-        int col_len = output_cols[j];
-        auto* out_tensor = outputs->at(j);
-        if (out_tensor != nullptr) {
-          T* dst_ptr = out_tensor->data<T>() + k * col_len;
-          paddle::memory::Copy(cpu_place,
-                               dst_ptr,
-                               cpu_place,
-                               src_ptr + col_idx,
-                               sizeof(T) * col_len);
-        }
-        col_idx += col_len;
-      }
-    }
+    int64_t grain_size =
+        std::max<int64_t>(1, kCopyGrainSize / std::max(input_cols, 1));
+    context.ParallelFor(
+        0, input_rows, grain_size, [&](int64_t row_begin, int64_t row_end) {
+          for (int64_t k = row_begin; k < row_end; ++k) {
+            const T* src_ptr = input.data<T>() + k * input_cols;
+            int col_idx = 0;
+            for (size_t j = 0; j < num; ++j) {
+              int col_len = output_cols[j];
+              auto* out_tensor = outputs->at(j);
+              if (out_tensor != nullptr) {
+                T* dst_ptr = out_tensor->data<T>() + k * col_len;
+                paddle::memory::Copy(cpu_place,
+                                     dst_ptr,
+                                     cpu_place,
+                                     src_ptr + col_idx,
+                                     sizeof(T) * col_len);
+              }
+              col_idx += col_len;
+            }
+          }
+        });
   }
 };
 
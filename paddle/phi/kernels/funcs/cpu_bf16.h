@@ -0,0 +1,185 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/bfloat16.h"
+
+// The vector paths are compiled with function target attributes and picked
+// by the CPU at runtime, so they do not depend on the -m flags of the build.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__CUDACC__) && \
+    !defined(__HIPCC__)
+#include <immintrin.h>
+#define PADDLE_CPU_BF16_SIMD
+#endif
+
+namespace phi {
+namespace funcs {
+
+/*
+ * Bulk conversions between bfloat16 and float for the CPU kernels that
+ * compute bfloat16 in float, e.g. GEMM, reductions and softmax. The results
+ * are bit-identical to the scalar conversions of phi::dtype::bfloat16: the
+ * widening is exact, and the narrowing keeps the high 16 bits of the float
+ * as bfloat16(float) does, whichever instruction set runs.
+ */
+
+namespace detail {
+
+inline void Bf16ToFloatScalar(const dtype::bfloat16* x,
+                              float* out,
+                              int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = static_cast<float>(x[i]);
+  }
+}
+
+inline void FloatToBf16Scalar(const float* x,
+                              dtype::bfloat16* out,
+                              int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = dtype::bfloat16(x[i]);
+  }
+}
+
+#ifdef PADDLE_CPU_BF16_SIMD
+
+__attribute__((target("avx2"))) inline void Bf16ToFloatAvx2(
+    const dtype::bfloat16* x, float* out, int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+    __m256i bits = _mm256_slli_epi32(_mm256_cvtepu16_epi32(half), 16);
+    _mm256_storeu_ps(out + i, _mm256_castsi256_ps(bits));
+  }
+  Bf16ToFloatScalar(x + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline void FloatToBf16Avx2(
+    const float* x, dtype::bfloat16* out, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i lo = _mm256_srli_epi32(
+        _mm256_castps_si256(_mm256_loadu_ps(x + i)), 16);
+    __m256i hi = _mm256_srli_epi32(
+        _mm256_castps_si256(_mm256_loadu_ps(x + i + 8)), 16);
+    // packus works within the 128-bit lanes, the permute puts the quarters
+    // back in order
+    __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+  }
+  FloatToBf16Scalar(x + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void Bf16ToFloatAvx512(
+    const dtype::bfloat16* x, float* out, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i half = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    __m512i bits = _mm512_slli_epi32(_mm512_cvtepu16_epi32(half), 16);
+    _mm512_storeu_ps(out + i, _mm512_castsi512_ps(bits));
+  }
+  Bf16ToFloatScalar(x + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void FloatToBf16Avx512(
+    const float* x, dtype::bfloat16* out, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i bits = _mm512_srli_epi32(
+        _mm512_castps_si512(_mm512_loadu_ps(x + i)), 16);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtepi32_epi16(bits));
+  }
+  FloatToBf16Scalar(x + i, out + i, n - i);
+}
+
+#endif  // PADDLE_CPU_BF16_SIMD
+
+enum class CpuBf16Isa { kScalar, kAvx2, kAvx512 };
+
+inline CpuBf16Isa GetCpuBf16Isa() {
+#ifdef PADDLE_CPU_BF16_SIMD
+  static const CpuBf16Isa isa =
+      paddle::platform::MayIUse(paddle::platform::avx512f)
+          ? CpuBf16Isa::kAvx512
+          : (paddle::platform::MayIUse(paddle::platform::avx2)
+                 ? CpuBf16Isa::kAvx2
+                 : CpuBf16Isa::kScalar);
+  return isa;
+#else
+  return CpuBf16Isa::kScalar;
+#endif
+}
+
+}  // namespace detail
+
+inline void CpuBf16ToFloat(const dtype::bfloat16* x, float* out, int64_t n) {
+#ifdef PADDLE_CPU_BF16_SIMD
+  switch (detail::GetCpuBf16Isa()) {
+    case detail::CpuBf16Isa::kAvx512:
+      return detail::Bf16ToFloatAvx512(x, out, n);
+    case detail::CpuBf16Isa::kAvx2:
+      return detail::Bf16ToFloatAvx2(x, out, n);
+    default:
+      break;
+  }
+#endif
+  detail::Bf16ToFloatScalar(x, out, n);
+}
+
+inline void CpuFloatToBf16(const float* x, dtype::bfloat16* out, int64_t n) {
+#ifdef PADDLE_CPU_BF16_SIMD
+  switch (detail::GetCpuBf16Isa()) {
+    case detail::CpuBf16Isa::kAvx512:
+      return detail::FloatToBf16Avx512(x, out, n);
+    case detail::CpuBf16Isa::kAvx2:
+      return detail::FloatToBf16Avx2(x, out, n);
+    default:
+      break;
+  }
+#endif
+  detail::FloatToBf16Scalar(x, out, n);
+}
+
+// the elements converted by one intra-op thread at least
+constexpr int64_t kCpuBf16GrainSize = 32768;
+
+// The conversions of large buffers, split among the intra-op threads.
+inline void CpuBf16ToFloat(const CPUContext& ctx,
+                           const dtype::bfloat16* x,
+                           float* out,
+                           int64_t n) {
+  ctx.ParallelFor(0, n, kCpuBf16GrainSize, [&](int64_t begin, int64_t end) {
+    CpuBf16ToFloat(x + begin, out + begin, end - begin);
+  });
+}
+
+inline void CpuFloatToBf16(const CPUContext& ctx,
+                           const float* x,
+                           dtype::bfloat16* out,
+                           int64_t n) {
+  ctx.ParallelFor(0, n, kCpuBf16GrainSize, [&](int64_t begin, int64_t end) {
+    CpuFloatToBf16(x + begin, out + begin, end - begin);
+  });
+}
+
+}  // namespace funcs
+}  // namespace phi
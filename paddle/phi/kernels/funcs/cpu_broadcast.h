@@ -0,0 +1,215 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * The broadcast engine of the CPU binary elementwise kernels. The dims whose
+ * output size is 1 are dropped and the adjacent dims that are laid out
+ * contiguously in both inputs (or broadcast in the same input) are merged,
+ * e.g. [N, C, H, W] + [1, C, 1, 1] becomes [N, C, H*W] with the strides of y
+ * [0, 1, 0]. The innermost dim then takes one of the loops below, which are
+ * plain contiguous loops the compiler vectorizes:
+ *   - both inputs contiguous, also used by the row broadcast [N, C] + [C],
+ *   - one input broadcast as a scalar, the column broadcast [N, C] + [N, 1]
+ *     and the scalar broadcast [N] + [1].
+ * The outer dims are walked by strides and split among the intra-op threads
+ * of the CPUContext.
+ */
+struct CpuBroadcastShape {
+  std::vector<int64_t> out_dims;
+  std::vector<int64_t> x_strides;  // 0 for a broadcast dim
+  std::vector<int64_t> y_strides;
+};
+
+// The dims arrays are the ones given by GetBroadcastDimsArrays, of the same
+// rank max_dim.
+inline CpuBroadcastShape CollapseBroadcastDims(const int* x_dims,
+                                               const int* y_dims,
+                                               const int* out_dims,
+                                               int max_dim) {
+  std::vector<int64_t> x_strides(max_dim), y_strides(max_dim);
+  int64_t x_stride = 1, y_stride = 1;
+  for (int i = max_dim - 1; i >= 0; --i) {
+    x_strides[i] = x_dims[i] == 1 ? 0 : x_stride;
+    y_strides[i] = y_dims[i] == 1 ? 0 : y_stride;
+    x_stride *= x_dims[i];
+    y_stride *= y_dims[i];
+  }
+
+  CpuBroadcastShape shape;
+  for (int i = 0; i < max_dim; ++i) {
+    if (out_dims[i] == 1) {
+      continue;
+    }
+    // the previous dim steps over this one in both inputs
+    if (!shape.out_dims.empty() &&
+        shape.x_strides.back() == x_strides[i] * out_dims[i] &&
+        shape.y_strides.back() == y_strides[i] * out_dims[i]) {
+      shape.out_dims.back() *= out_dims[i];
+      shape.x_strides.back() = x_strides[i];
+      shape.y_strides.back() = y_strides[i];
+    } else {
+      shape.out_dims.push_back(out_dims[i]);
+      shape.x_strides.push_back(x_strides[i]);
+      shape.y_strides.push_back(y_strides[i]);
+    }
+  }
+  if (shape.out_dims.empty()) {
+    shape.out_dims.push_back(1);
+    shape.x_strides.push_back(1);
+    shape.y_strides.push_back(1);
+  }
+  return shape;
+}
+
+namespace detail {
+
+// the output elements of one task
+constexpr int64_t kCpuBroadcastBlock = 16384;
+
+// Walks the outer dims of a broadcast and keeps the offsets of both inputs.
+class BroadcastOffsets {
+ public:
+  explicit BroadcastOffsets(const CpuBroadcastShape& shape)
+      : shape_(shape), index_(shape.out_dims.size() - 1, 0) {}
+
+  void Seek(int64_t row) {
+    x_offset_ = y_offset_ = 0;
+    for (int i = static_cast<int>(index_.size()) - 1; i >= 0; --i) {
+      index_[i] = row % shape_.out_dims[i];
+      row /= shape_.out_dims[i];
+      x_offset_ += index_[i] * shape_.x_strides[i];
+      y_offset_ += index_[i] * shape_.y_strides[i];
+    }
+  }
+
+  void Next() {
+    for (int i = static_cast<int>(index_.size()) - 1; i >= 0; --i) {
+      x_offset_ += shape_.x_strides[i];
+      y_offset_ += shape_.y_strides[i];
+      if (++index_[i] < shape_.out_dims[i]) {
+        return;
+      }
+      x_offset_ -= index_[i] * shape_.x_strides[i];
+      y_offset_ -= index_[i] * shape_.y_strides[i];
+      index_[i] = 0;
+    }
+  }
+
+  int64_t x_offset() const { return x_offset_; }
+  int64_t y_offset() const { return y_offset_; }
+
+ private:
+  const CpuBroadcastShape& shape_;
+  std::vector<int64_t> index_;
+  int64_t x_offset_{0};
+  int64_t y_offset_{0};
+};
+
+template <typename Functor, typename T, typename OutType>
+inline void BroadcastInner(const T* x,
+                           int64_t x_stride,
+                           const T* y,
+                           int64_t y_stride,
+                           OutType* out,
+                           int64_t n,
+                           Functor func) {
+  if (x_stride == 1 && y_stride == 1) {
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x[i], y[i]);
+    }
+  } else if (x_stride == 1) {
+    const T y_value = y[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x[i], y_value);
+    }
+  } else {
+    const T x_value = x[0];
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = func(x_value, y[i]);
+    }
+  }
+}
+
+}  // namespace detail
+
+// out = func(x, y) with the broadcast described by shape.
+template <typename Functor, typename T, typename OutType>
+void CpuBroadcastBinary(const CPUContext& ctx,
+                        const T* x,
+                        const T* y,
+                        OutType* out,
+                        const CpuBroadcastShape& shape,
+                        Functor func) {
+  const int rank = shape.out_dims.size();
+  const int64_t inner = shape.out_dims[rank - 1];
+  const int64_t x_inner_stride = shape.x_strides[rank - 1];
+  const int64_t y_inner_stride = shape.y_strides[rank - 1];
+  int64_t rows = 1;
+  for (int i = 0; i < rank - 1; ++i) {
+    rows *= shape.out_dims[i];
+  }
+
+  // a task covers several short rows, or a block of a long row
+  const int64_t rows_per_task =
+      std::max<int64_t>(1, detail::kCpuBroadcastBlock / std::max<int64_t>(
+                                                           inner, 1));
+  const int64_t blocks_per_row =
+      inner > detail::kCpuBroadcastBlock
+          ? (inner + detail::kCpuBroadcastBlock - 1) /
+                detail::kCpuBroadcastBlock
+          : 1;
+  const int64_t num_row_tasks = (rows + rows_per_task - 1) / rows_per_task;
+  const int64_t num_tasks = num_row_tasks * blocks_per_row;
+
+  auto run_tasks = [&](int64_t begin, int64_t end) {
+    detail::BroadcastOffsets offsets(shape);
+    for (int64_t task = begin; task < end; ++task) {
+      const int64_t row_begin = (task / blocks_per_row) * rows_per_task;
+      const int64_t row_end = std::min(rows, row_begin + rows_per_task);
+      const int64_t k_begin =
+          (task % blocks_per_row) * detail::kCpuBroadcastBlock;
+      const int64_t k_len = blocks_per_row == 1
+                                ? inner
+                                : std::min(detail::kCpuBroadcastBlock,
+                                           inner - k_begin);
+      offsets.Seek(row_begin);
+      for (int64_t row = row_begin; row < row_end; ++row, offsets.Next()) {
+        detail::BroadcastInner(
+            x + offsets.x_offset() + k_begin * x_inner_stride,
+            x_inner_stride,
+            y + offsets.y_offset() + k_begin * y_inner_stride,
+            y_inner_stride,
+            out + row * inner + k_begin,
+            k_len,
+            func);
+      }
+    }
+  };
+  // a task has about kCpuBroadcastBlock outputs, run at least 4 of them on
+  // each thread
+  ctx.ParallelFor(0, num_tasks, 4, run_tasks);
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,454 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+// The vector paths are compiled with function target attributes and picked
+// by the CPU at runtime, so they do not depend on the -m flags of the build.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__CUDACC__) && \
+    !defined(__HIPCC__)
+#include <immintrin.h>
+#define PADDLE_CPU_INT8_GEMM_SIMD
+#endif
+
+namespace phi {
+namespace funcs {
+
+/*
+ * The int8 GEMM of the CPU kernels that run the quantized models without
+ * oneDNN: c[m x n] = a[m x k] * w[k x n], where a holds the activations as
+ * uint8 (the int8 values shifted by kCpuInt8Shift) and w the int8 weights
+ * packed by CpuInt8PackWeight. The int32 results are exact whichever
+ * instruction set runs, the caller subtracts kCpuInt8Shift times the column
+ * sums of w to get the products of the int8 activations.
+ *
+ * The packed weight holds blocks of 16 columns, each of them holds the
+ * groups of 4 rows of the 16 columns, so that one group is the 64 bytes of
+ * an AVX512-VNNI dot product of 4 uint8 by 4 int8 into int32. The AVX2 path
+ * widens both sides to int16 before the multiply-add, vpmaddubsw would
+ * saturate the sums of two products of uint8 by int8 in int16.
+ */
+
+constexpr int64_t kCpuInt8BlockN = 16;
+constexpr int64_t kCpuInt8BlockK = 4;
+constexpr int32_t kCpuInt8Shift = 128;
+
+// the columns of a row of a that the GEMM reads, the padding is not used
+inline int64_t CpuInt8PaddedK(int64_t k) {
+  return (k + kCpuInt8BlockK - 1) / kCpuInt8BlockK * kCpuInt8BlockK;
+}
+
+inline int64_t CpuInt8PaddedN(int64_t n) {
+  return (n + kCpuInt8BlockN - 1) / kCpuInt8BlockN * kCpuInt8BlockN;
+}
+
+// the bytes of the packed weight of k x n
+inline int64_t CpuInt8PackedSize(int64_t k, int64_t n) {
+  return CpuInt8PaddedK(k) * CpuInt8PaddedN(n);
+}
+
+// Packs w, the k x n weight in row-major order, or n x k when trans is set,
+// and writes the sums of its n columns to col_sum.
+inline void CpuInt8PackWeight(const int8_t* w,
+                              int64_t k,
+                              int64_t n,
+                              bool trans,
+                              int8_t* packed,
+                              int32_t* col_sum) {
+  const int64_t padded_k = CpuInt8PaddedK(k);
+  std::memset(packed, 0, CpuInt8PackedSize(k, n));
+  for (int64_t j = 0; j < n; ++j) {
+    int8_t* block = packed + j / kCpuInt8BlockN * padded_k * kCpuInt8BlockN;
+    int32_t sum = 0;
+    for (int64_t i = 0; i < k; ++i) {
+      int8_t v = trans ? w[j * k + i] : w[i * n + j];
+      block[(i / kCpuInt8BlockK * kCpuInt8BlockN + j % kCpuInt8BlockN) *
+                kCpuInt8BlockK +
+            i % kCpuInt8BlockK] = v;
+      sum += v;
+    }
+    col_sum[j] = sum;
+  }
+}
+
+// Quantizes x to the uint8 activations of the GEMM, the int8 values are
+// round(x / scale) clipped to [-127, 127].
+inline void CpuInt8Quantize(const float* x,
+                            int64_t n,
+                            float scale,
+                            uint8_t* out) {
+  const float inv_scale = scale > 0.0f ? 1.0f / scale : 0.0f;
+  for (int64_t i = 0; i < n; ++i) {
+    float v = std::nearbyint(x[i] * inv_scale);
+    v = std::min(std::max(v, -127.0f), 127.0f);
+    out[i] = static_cast<uint8_t>(static_cast<int32_t>(v) + kCpuInt8Shift);
+  }
+}
+
+// The n outputs of a row of c: (c - kCpuInt8Shift * col_sum) * scale + bias,
+// clipped at zero when relu is set. bias may be null.
+inline void CpuInt8DequantizeRow(const int32_t* c,
+                                 const int32_t* col_sum,
+                                 const float* scale,
+                                 const float* bias,
+                                 int64_t n,
+                                 bool relu,
+                                 float* out) {
+  for (int64_t j = 0; j < n; ++j) {
+    float v = static_cast<float>(c[j] - kCpuInt8Shift * col_sum[j]) * scale[j];
+    v = bias ? v + bias[j] : v;
+    out[j] = relu ? std::max(v, 0.0f) : v;
+  }
+}
+
+namespace detail {
+
+// the rows of a computed together by the vector paths, the AVX2 path keeps
+// four accumulators of every row
+constexpr int kCpuInt8VnniRows = 6;
+constexpr int kCpuInt8Avx2Rows = 2;
+
+// c of rows x 16 columns from the block of the packed weight, only the first
+// cols columns are stored
+inline void CpuInt8BlockScalar(const uint8_t* a,
+                               int64_t lda,
+                               const int8_t* block,
+                               int64_t rows,
+                               int64_t cols,
+                               int64_t k,
+                               int32_t* c,
+                               int64_t ldc) {
+  const int64_t groups = CpuInt8PaddedK(k) / kCpuInt8BlockK;
+  for (int64_t r = 0; r < rows; ++r) {
+    int32_t acc[kCpuInt8BlockN] = {0};
+    for (int64_t g = 0; g < groups; ++g) {
+      const uint8_t* av = a + r * lda + g * kCpuInt8BlockK;
+      const int8_t* wv = block + g * kCpuInt8BlockN * kCpuInt8BlockK;
+      for (int64_t j = 0; j < kCpuInt8BlockN; ++j) {
+        for (int64_t t = 0; t < kCpuInt8BlockK; ++t) {
+          acc[j] += static_cast<int32_t>(av[t]) * wv[j * kCpuInt8BlockK + t];
+        }
+      }
+    }
+    std::copy(acc, acc + cols, c + r * ldc);
+  }
+}
+
+#ifdef PADDLE_CPU_INT8_GEMM_SIMD
+
+template <int kRows>
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) inline void
+CpuInt8BlockVnni(const uint8_t* a,
+                 int64_t lda,
+                 const int8_t* block,
+                 int64_t cols,
+                 int64_t k,
+                 int32_t* c,
+                 int64_t ldc) {
+  const int64_t groups = CpuInt8PaddedK(k) / kCpuInt8BlockK;
+  __m512i acc[kRows];
+  for (int r = 0; r < kRows; ++r) {
+    acc[r] = _mm512_setzero_si512();
+  }
+  for (int64_t g = 0; g < groups; ++g) {
+    __m512i w = _mm512_loadu_si512(block + g * kCpuInt8BlockN * kCpuInt8BlockK);
+    for (int r = 0; r < kRows; ++r) {
+      int32_t four;
+      std::memcpy(&four, a + r * lda + g * kCpuInt8BlockK, sizeof(four));
+      acc[r] = _mm512_dpbusd_epi32(acc[r], _mm512_set1_epi32(four), w);
+    }
+  }
+  const __mmask16 mask = static_cast<__mmask16>((1U << cols) - 1);
+  for (int r = 0; r < kRows; ++r) {
+    _mm512_mask_storeu_epi32(c + r * ldc, mask, acc[r]);
+  }
+}
+
+template <int kRows>
+__attribute__((target("avx2"))) inline void CpuInt8BlockAvx2(
+    const uint8_t* a,
+    int64_t lda,
+    const int8_t* block,
+    int64_t cols,
+    int64_t k,
+    int32_t* c,
+    int64_t ldc) {
+  const int64_t groups = CpuInt8PaddedK(k) / kCpuInt8BlockK;
+  // acc[r][q] holds the pairs of partial sums of the columns 4q to 4q + 3
+  __m256i acc[kRows][4];
+  for (int r = 0; r < kRows; ++r) {
+    for (int q = 0; q < 4; ++q) {
+      acc[r][q] = _mm256_setzero_si256();
+    }
+  }
+  for (int64_t g = 0; g < groups; ++g) {
+    const int8_t* w = block + g * kCpuInt8BlockN * kCpuInt8BlockK;
+    __m256i av[kRows];
+    for (int r = 0; r < kRows; ++r) {
+      int32_t four;
+      std::memcpy(&four, a + r * lda + g * kCpuInt8BlockK, sizeof(four));
+      av[r] = _mm256_broadcastq_epi64(
+          _mm_cvtepu8_epi16(_mm_cvtsi32_si128(four)));
+    }
+    for (int q = 0; q < 4; ++q) {
+      __m256i wq = _mm256_cvtepi8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + 16 * q)));
+      for (int r = 0; r < kRows; ++r) {
+        acc[r][q] =
+            _mm256_add_epi32(acc[r][q], _mm256_madd_epi16(av[r], wq));
+      }
+    }
+  }
+  for (int r = 0; r < kRows; ++r) {
+    // hadd works within the 128-bit lanes, the permute puts the columns back
+    // in order
+    __m256i lo = _mm256_permute4x64_epi64(
+        _mm256_hadd_epi32(acc[r][0], acc[r][1]), 0xD8);
+    __m256i hi = _mm256_permute4x64_epi64(
+        _mm256_hadd_epi32(acc[r][2], acc[r][3]), 0xD8);
+    if (cols == kCpuInt8BlockN) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc), lo);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc + 8), hi);
+    } else {
+      alignas(32) int32_t out[kCpuInt8BlockN];
+      _mm256_store_si256(reinterpret_cast<__m256i*>(out), lo);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(out + 8), hi);
+      std::copy(out, out + cols, c + r * ldc);
+    }
+  }
+}
+
+#endif  // PADDLE_CPU_INT8_GEMM_SIMD
+
+enum class CpuInt8Isa { kScalar, kAvx2, kAvx512Vnni };
+
+inline CpuInt8Isa GetCpuInt8Isa() {
+#ifdef PADDLE_CPU_INT8_GEMM_SIMD
+  static const CpuInt8Isa isa =
+      paddle::platform::MayIUse(paddle::platform::avx512_core_vnni)
+          ? CpuInt8Isa::kAvx512Vnni
+          : (paddle::platform::MayIUse(paddle::platform::avx2)
+                 ? CpuInt8Isa::kAvx2
+                 : CpuInt8Isa::kScalar);
+  return isa;
+#else
+  return CpuInt8Isa::kScalar;
+#endif
+}
+
+#ifdef PADDLE_CPU_INT8_GEMM_SIMD
+template <int kRows>
+struct CpuInt8VnniRows {
+  static void Run(const uint8_t* a,
+                  int64_t lda,
+                  const int8_t* block,
+                  int64_t cols,
+                  int64_t k,
+                  int32_t* c,
+                  int64_t ldc) {
+    CpuInt8BlockVnni<kRows>(a, lda, block, cols, k, c, ldc);
+  }
+};
+
+template <int kRows>
+struct CpuInt8Avx2Rows {
+  static void Run(const uint8_t* a,
+                  int64_t lda,
+                  const int8_t* block,
+                  int64_t cols,
+                  int64_t k,
+                  int32_t* c,
+                  int64_t ldc) {
+    CpuInt8BlockAvx2<kRows>(a, lda, block, cols, k, c, ldc);
+  }
+};
+
+// Block<rows>::Run for the rows left after the full blocks of rows, rows is
+// not larger than kRows
+template <template <int> class Block, int kRows>
+struct CpuInt8TailRows {
+  static void Run(int64_t rows,
+                  const uint8_t* a,
+                  int64_t lda,
+                  const int8_t* block,
+                  int64_t cols,
+                  int64_t k,
+                  int32_t* c,
+                  int64_t ldc) {
+    if (rows == kRows) {
+      Block<kRows>::Run(a, lda, block, cols, k, c, ldc);
+    } else {
+      CpuInt8TailRows<Block, kRows - 1>::Run(
+          rows, a, lda, block, cols, k, c, ldc);
+    }
+  }
+};
+
+template <template <int> class Block>
+struct CpuInt8TailRows<Block, 0> {
+  static void Run(int64_t rows,
+                  const uint8_t* a,
+                  int64_t lda,
+                  const int8_t* block,
+                  int64_t cols,
+                  int64_t k,
+                  int32_t* c,
+                  int64_t ldc) {}
+};
+
+template <template <int> class Block, int kBlockRows>
+inline void CpuInt8RunRows(const uint8_t* a,
+                           int64_t lda,
+                           const int8_t* block,
+                           int64_t rows,
+                           int64_t cols,
+                           int64_t k,
+                           int32_t* c,
+                           int64_t ldc) {
+  int64_t r = 0;
+  for (; r + kBlockRows <= rows; r += kBlockRows) {
+    Block<kBlockRows>::Run(a + r * lda, lda, block, cols, k, c + r * ldc, ldc);
+  }
+  CpuInt8TailRows<Block, kBlockRows - 1>::Run(
+      rows - r, a + r * lda, lda, block, cols, k, c + r * ldc, ldc);
+}
+#endif  // PADDLE_CPU_INT8_GEMM_SIMD
+
+// the rows of c in [row_begin, row_end) and the column blocks in
+// [block_begin, block_end)
+inline void CpuInt8GemmTile(CpuInt8Isa isa,
+                            const uint8_t* a,
+                            int64_t lda,
+                            const int8_t* packed,
+                            int64_t row_begin,
+                            int64_t row_end,
+                            int64_t block_begin,
+                            int64_t block_end,
+                            int64_t n,
+                            int64_t k,
+                            int32_t* c,
+                            int64_t ldc) {
+  const int64_t block_size = CpuInt8PaddedK(k) * kCpuInt8BlockN;
+  const uint8_t* a_rows = a + row_begin * lda;
+  int32_t* c_rows = c + row_begin * ldc;
+  const int64_t rows = row_end - row_begin;
+  for (int64_t b = block_begin; b < block_end; ++b) {
+    const int8_t* block = packed + b * block_size;
+    const int64_t cols = std::min(kCpuInt8BlockN, n - b * kCpuInt8BlockN);
+    int32_t* c_block = c_rows + b * kCpuInt8BlockN;
+    switch (isa) {
+#ifdef PADDLE_CPU_INT8_GEMM_SIMD
+      case CpuInt8Isa::kAvx512Vnni:
+        CpuInt8RunRows<CpuInt8VnniRows, kCpuInt8VnniRows>(
+            a_rows, lda, block, rows, cols, k, c_block, ldc);
+        break;
+      case CpuInt8Isa::kAvx2:
+        CpuInt8RunRows<CpuInt8Avx2Rows, kCpuInt8Avx2Rows>(
+            a_rows, lda, block, rows, cols, k, c_block, ldc);
+        break;
+#endif
+      default:
+        CpuInt8BlockScalar(a_rows, lda, block, rows, cols, k, c_block, ldc);
+        break;
+    }
+  }
+}
+
+// the rows of a tile, the column blocks of the tile share the rows of a
+constexpr int64_t kCpuInt8TileM = 64;
+// the multiply-adds of the tiles run by one intra-op thread at least
+constexpr int64_t kCpuInt8GrainOps = 1 << 20;
+
+}  // namespace detail
+
+// c[m x n] = a[m x k] * w, where w is packed by CpuInt8PackWeight. The rows
+// of a are lda apart and hold CpuInt8PaddedK(k) readable bytes. The isa is
+// the one picked by the CPU when it is not given.
+inline void CpuInt8Gemm(const uint8_t* a,
+                        int64_t lda,
+                        const int8_t* packed,
+                        int64_t m,
+                        int64_t n,
+                        int64_t k,
+                        int32_t* c,
+                        int64_t ldc,
+                        detail::CpuInt8Isa isa = detail::GetCpuInt8Isa()) {
+  detail::CpuInt8GemmTile(isa,
+                          a,
+                          lda,
+                          packed,
+                          0,
+                          m,
+                          0,
+                          CpuInt8PaddedN(n) / kCpuInt8BlockN,
+                          n,
+                          k,
+                          c,
+                          ldc);
+}
+
+// The GEMM split into the tiles of rows and column blocks among the intra-op
+// threads.
+inline void CpuInt8Gemm(const CPUContext& ctx,
+                        const uint8_t* a,
+                        int64_t lda,
+                        const int8_t* packed,
+                        int64_t m,
+                        int64_t n,
+                        int64_t k,
+                        int32_t* c,
+                        int64_t ldc,
+                        detail::CpuInt8Isa isa = detail::GetCpuInt8Isa()) {
+  const int64_t blocks = CpuInt8PaddedN(n) / kCpuInt8BlockN;
+  const int64_t row_tiles =
+      (m + detail::kCpuInt8TileM - 1) / detail::kCpuInt8TileM;
+  const int64_t tile_ops = std::min(m, detail::kCpuInt8TileM) *
+                           kCpuInt8BlockN * std::max<int64_t>(k, 1);
+  const int64_t grain =
+      std::max<int64_t>(1, detail::kCpuInt8GrainOps / tile_ops);
+  // the tiles of one column block are next to each other, so a thread
+  // reuses the block of the packed weight
+  ctx.ParallelFor(
+      0, blocks * row_tiles, grain, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+          const int64_t b = t / row_tiles;
+          const int64_t row_begin = t % row_tiles * detail::kCpuInt8TileM;
+          const int64_t row_end =
+              std::min(m, row_begin + detail::kCpuInt8TileM);
+          detail::CpuInt8GemmTile(isa,
+                                  a,
+                                  lda,
+                                  packed,
+                                  row_begin,
+                                  row_end,
+                                  b,
+                                  b + 1,
+                                  n,
+                                  k,
+                                  c,
+                                  ldc);
+        }
+      });
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,477 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/phi/kernels/funcs/cpu_bf16.h"
+#include "paddle/phi/kernels/funcs/reduce_functor.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * A rank-generic reduction engine for CPU. The input shape is first collapsed
+ * by dropping the size-1 dims and merging the adjacent dims that are both
+ * reduced or both kept, so any reduction becomes one of:
+ *   - a full reduction of a contiguous buffer,
+ *   - an innermost reduced dim, e.g. [rows, cols] reduced on cols,
+ *   - an innermost kept dim, e.g. [rows, cols] reduced on rows,
+ * with the outer dims walked by strides. The innermost loops work on
+ * contiguous memory with several independent accumulators so that the
+ * compiler vectorizes them, and the outputs (or the chunks of a full
+ * reduction) are split among the intra-op threads of the CPUContext.
+ * A reducer may accumulate in a wider type than the data, e.g. bfloat16 is
+ * reduced in float and only the outputs are rounded to bfloat16.
+ */
+
+///////// Reducers /////////
+
+template <typename T>
+struct CpuSumReducer {
+  static T Init() { return static_cast<T>(0); }
+  static T Apply(T a, T b) { return static_cast<T>(a + b); }
+  static T Finalize(T a, int64_t n) { return a; }
+};
+
+template <typename T>
+struct CpuMeanReducer {
+  static T Init() { return static_cast<T>(0); }
+  static T Apply(T a, T b) { return static_cast<T>(a + b); }
+  static T Finalize(T a, int64_t n) { return a / static_cast<T>(n); }
+};
+
+template <typename T>
+struct CpuProdReducer {
+  static T Init() { return static_cast<T>(1); }
+  static T Apply(T a, T b) { return static_cast<T>(a * b); }
+  static T Finalize(T a, int64_t n) { return a; }
+};
+
+template <typename T>
+struct CpuMaxReducer {
+  static T Init() {
+    return std::numeric_limits<T>::has_infinity
+               ? -std::numeric_limits<T>::infinity()
+               : std::numeric_limits<T>::lowest();
+  }
+  static T Apply(T a, T b) { return a > b ? a : b; }
+  static T Finalize(T a, int64_t n) { return a; }
+};
+
+template <typename T>
+struct CpuMinReducer {
+  static T Init() {
+    return std::numeric_limits<T>::has_infinity
+               ? std::numeric_limits<T>::infinity()
+               : std::numeric_limits<T>::max();
+  }
+  static T Apply(T a, T b) { return a < b ? a : b; }
+  static T Finalize(T a, int64_t n) { return a; }
+};
+
+struct CpuAnyReducer {
+  static bool Init() { return false; }
+  static bool Apply(bool a, bool b) { return a || b; }
+  static bool Finalize(bool a, int64_t n) { return a; }
+};
+
+struct CpuAllReducer {
+  static bool Init() { return true; }
+  static bool Apply(bool a, bool b) { return a && b; }
+  static bool Finalize(bool a, int64_t n) { return a; }
+};
+
+// Maps a reduce functor of reduce_functor.h and the data type to the reducer
+// of the engine, the unsupported pairs (float16, complex, custom functors)
+// stay on the Eigen path.
+template <typename Functor, typename T, typename Enable = void>
+struct CpuReducerOf {
+  static constexpr bool kSupported = false;
+};
+
+template <typename T>
+using EnableIfCpuReduceArith = typename std::enable_if<
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type;
+
+template <typename T>
+struct CpuReducerOf<SumFunctor, T, EnableIfCpuReduceArith<T>> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuSumReducer<T>;
+};
+
+template <typename T>
+struct CpuReducerOf<MeanFunctor, T, EnableIfCpuReduceArith<T>> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuMeanReducer<T>;
+};
+
+template <typename T>
+struct CpuReducerOf<ProdFunctor, T, EnableIfCpuReduceArith<T>> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuProdReducer<T>;
+};
+
+template <typename T>
+struct CpuReducerOf<MaxFunctor, T, EnableIfCpuReduceArith<T>> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuMaxReducer<T>;
+};
+
+template <typename T>
+struct CpuReducerOf<MinFunctor, T, EnableIfCpuReduceArith<T>> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuMinReducer<T>;
+};
+
+// bfloat16 is accumulated in float
+template <>
+struct CpuReducerOf<SumFunctor, dtype::bfloat16> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuSumReducer<float>;
+};
+
+template <>
+struct CpuReducerOf<MeanFunctor, dtype::bfloat16> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuMeanReducer<float>;
+};
+
+template <>
+struct CpuReducerOf<MaxFunctor, dtype::bfloat16> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuMaxReducer<float>;
+};
+
+template <>
+struct CpuReducerOf<MinFunctor, dtype::bfloat16> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuMinReducer<float>;
+};
+
+template <>
+struct CpuReducerOf<AnyFunctor, bool> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuAnyReducer;
+};
+
+template <>
+struct CpuReducerOf<AllFunctor, bool> {
+  static constexpr bool kSupported = true;
+  using Reducer = CpuAllReducer;
+};
+
+///////// Shape collapsing /////////
+
+struct CpuReduceShape {
+  std::vector<int64_t> dims;
+  std::vector<bool> reduced;
+};
+
+// e.g. reducing dims {1, 2} of [8, 16, 32, 1, 4] gives the dims [8, 512, 4]
+// whose reduced flags are [false, true, false].
+inline CpuReduceShape CollapseReduceDims(const DDim& x_dims,
+                                         const std::vector<int64_t>& dims,
+                                         bool reduce_all) {
+  int rank = x_dims.size();
+  std::vector<bool> is_reduced(rank, reduce_all);
+  for (auto dim : dims) {
+    is_reduced[dim < 0 ? dim + rank : dim] = true;
+  }
+
+  CpuReduceShape shape;
+  for (int i = 0; i < rank; ++i) {
+    if (x_dims[i] == 1) {
+      continue;
+    }
+    if (!shape.dims.empty() && shape.reduced.back() == is_reduced[i]) {
+      shape.dims.back() *= x_dims[i];
+    } else {
+      shape.dims.push_back(x_dims[i]);
+      shape.reduced.push_back(is_reduced[i]);
+    }
+  }
+  if (shape.dims.empty()) {
+    shape.dims.push_back(1);
+    shape.reduced.push_back(true);
+  }
+  return shape;
+}
+
+///////// Kernels /////////
+
+namespace detail {
+
+constexpr int kCpuReduceLanes = 8;
+// the elements of one chunk of a full reduction
+constexpr int64_t kCpuReduceChunk = 16384;
+// the outputs of one task when the innermost dim is kept
+constexpr int64_t kCpuReduceBlock = 256;
+// the input elements reduced by one intra-op thread at least
+constexpr int64_t kCpuReduceGrainSize = 32768;
+
+// Walks a row-major grid of the input dims and keeps the input offset of the
+// current index.
+class StridedOffset {
+ public:
+  StridedOffset(const std::vector<int64_t>& dims,
+                const std::vector<int64_t>& strides)
+      : dims_(dims), strides_(strides), index_(dims.size(), 0) {}
+
+  void Seek(int64_t linear) {
+    offset_ = 0;
+    for (int i = static_cast<int>(dims_.size()) - 1; i >= 0; --i) {
+      index_[i] = linear % dims_[i];
+      linear /= dims_[i];
+      offset_ += index_[i] * strides_[i];
+    }
+  }
+
+  void Next() {
+    for (int i = static_cast<int>(dims_.size()) - 1; i >= 0; --i) {
+      offset_ += strides_[i];
+      if (++index_[i] < dims_[i]) {
+        return;
+      }
+      offset_ -= index_[i] * strides_[i];
+      index_[i] = 0;
+    }
+  }
+
+  int64_t offset() const { return offset_; }
+
+ private:
+  const std::vector<int64_t>& dims_;
+  const std::vector<int64_t>& strides_;
+  std::vector<int64_t> index_;
+  int64_t offset_{0};
+};
+
+// the type a reducer accumulates in
+template <typename Reducer>
+using CpuReduceAccT = decltype(Reducer::Init());
+
+template <typename Reducer, typename T>
+struct ContiguousReduce {
+  using AccT = CpuReduceAccT<Reducer>;
+
+  static AccT Run(const T* x, int64_t n, AccT init) {
+    AccT acc[kCpuReduceLanes];
+    for (int l = 0; l < kCpuReduceLanes; ++l) {
+      acc[l] = Reducer::Init();
+    }
+    int64_t i = 0;
+    for (; i + kCpuReduceLanes <= n; i += kCpuReduceLanes) {
+      for (int l = 0; l < kCpuReduceLanes; ++l) {
+        acc[l] = Reducer::Apply(acc[l], static_cast<AccT>(x[i + l]));
+      }
+    }
+    AccT result = init;
+    for (int l = 0; l < kCpuReduceLanes; ++l) {
+      result = Reducer::Apply(result, acc[l]);
+    }
+    for (; i < n; ++i) {
+      result = Reducer::Apply(result, static_cast<AccT>(x[i]));
+    }
+    return result;
+  }
+};
+
+// bfloat16 is widened to float block by block, so the float loop above
+// stays vectorized
+template <typename Reducer>
+struct ContiguousReduce<Reducer, dtype::bfloat16> {
+  static float Run(const dtype::bfloat16* x, int64_t n, float init) {
+    constexpr int64_t kBlock = 1024;
+    float buffer[kBlock];
+    float result = init;
+    for (int64_t i = 0; i < n; i += kBlock) {
+      const int64_t len = std::min(kBlock, n - i);
+      CpuBf16ToFloat(x + i, buffer, len);
+      result = ContiguousReduce<Reducer, float>::Run(buffer, len, result);
+    }
+    return result;
+  }
+};
+
+template <typename Reducer, typename T>
+inline CpuReduceAccT<Reducer> ReduceContiguous(const T* x,
+                                               int64_t n,
+                                               CpuReduceAccT<Reducer> init) {
+  return ContiguousReduce<Reducer, T>::Run(x, n, init);
+}
+
+template <typename T, typename Reducer>
+void ReduceAll(const CPUContext& ctx, const T* x, int64_t n, T* out) {
+  int64_t num_chunks = (n + kCpuReduceChunk - 1) / kCpuReduceChunk;
+  if (num_chunks <= 1) {
+    out[0] = static_cast<T>(
+        Reducer::Finalize(ReduceContiguous<Reducer>(x, n, Reducer::Init()), n));
+    return;
+  }
+  // The partial results are combined in a fixed order, the result does not
+  // depend on the number of threads.
+  std::vector<CpuReduceAccT<Reducer>> partials(num_chunks);
+  int64_t grain_size =
+      std::max<int64_t>(1, kCpuReduceGrainSize / kCpuReduceChunk);
+  ctx.ParallelFor(0, num_chunks, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      int64_t offset = c * kCpuReduceChunk;
+      int64_t len = std::min(kCpuReduceChunk, n - offset);
+      partials[c] = ReduceContiguous<Reducer>(x + offset, len, Reducer::Init());
+    }
+  });
+  auto result = Reducer::Init();
+  for (auto& partial : partials) {
+    result = Reducer::Apply(result, partial);
+  }
+  out[0] = static_cast<T>(Reducer::Finalize(result, n));
+}
+
+}  // namespace detail
+
+// Reduce x of the collapsed shape into out, which has the kept dims in the
+// input order.
+template <typename T, typename Reducer>
+void CpuReduce(const CPUContext& ctx,
+               const T* x,
+               T* out,
+               const CpuReduceShape& shape) {
+  int rank = shape.dims.size();
+  int64_t numel = 1;
+  std::vector<int64_t> strides(rank);
+  for (int i = rank - 1; i >= 0; --i) {
+    strides[i] = numel;
+    numel *= shape.dims[i];
+  }
+  if (rank == 1 && shape.reduced[0]) {
+    detail::ReduceAll<T, Reducer>(ctx, x, numel, out);
+    return;
+  }
+
+  // split the outer dims into the kept and the reduced ones
+  std::vector<int64_t> kept_dims, kept_strides, reduce_dims, reduce_strides;
+  int64_t num_groups = 1, num_reduced = 1;
+  for (int i = 0; i < rank - 1; ++i) {
+    if (shape.reduced[i]) {
+      reduce_dims.push_back(shape.dims[i]);
+      reduce_strides.push_back(strides[i]);
+      num_reduced *= shape.dims[i];
+    } else {
+      kept_dims.push_back(shape.dims[i]);
+      kept_strides.push_back(strides[i]);
+      num_groups *= shape.dims[i];
+    }
+  }
+  const int64_t inner = shape.dims[rank - 1];
+
+  if (shape.reduced[rank - 1]) {
+    // out[g] = reduce(x[g, r, i]) over r and the contiguous i
+    const int64_t count = num_reduced * inner;
+    int64_t grain_size = std::max<int64_t>(
+        1, detail::kCpuReduceGrainSize / std::max<int64_t>(count, 1));
+    ctx.ParallelFor(0, num_groups, grain_size, [&](int64_t begin, int64_t end) {
+      detail::StridedOffset group(kept_dims, kept_strides);
+      detail::StridedOffset red(reduce_dims, reduce_strides);
+      group.Seek(begin);
+      for (int64_t g = begin; g < end; ++g, group.Next()) {
+        auto acc = Reducer::Init();
+        for (int64_t r = 0; r < num_reduced; ++r, red.Next()) {
+          acc = detail::ReduceContiguous<Reducer>(
+              x + group.offset() + red.offset(), inner, acc);
+        }
+        out[g] = static_cast<T>(Reducer::Finalize(acc, count));
+      }
+    });
+    return;
+  }
+
+  // out[g, k] = reduce(x[g, r, k]) over r, for a block of contiguous k
+  const int64_t num_blocks =
+      (inner + detail::kCpuReduceBlock - 1) / detail::kCpuReduceBlock;
+  const int64_t block_len = std::min(detail::kCpuReduceBlock, inner);
+  int64_t grain_size = std::max<int64_t>(
+      1,
+      detail::kCpuReduceGrainSize /
+          std::max<int64_t>(num_reduced * block_len, 1));
+  auto reduce_blocks = [&](int64_t begin, int64_t end) {
+    detail::StridedOffset group(kept_dims, kept_strides);
+    detail::StridedOffset red(reduce_dims, reduce_strides);
+    detail::CpuReduceAccT<Reducer> acc[detail::kCpuReduceBlock];
+    for (int64_t task = begin; task < end; ++task) {
+      const int64_t g = task / num_blocks;
+      const int64_t k_begin = (task % num_blocks) * detail::kCpuReduceBlock;
+      const int64_t k_len =
+          std::min(detail::kCpuReduceBlock, inner - k_begin);
+      group.Seek(g);
+
+      for (int64_t k = 0; k < k_len; ++k) {
+        acc[k] = Reducer::Init();
+      }
+      const T* base = x + group.offset() + k_begin;
+      for (int64_t r = 0; r < num_reduced; ++r, red.Next()) {
+        const T* row = base + red.offset();
+        for (int64_t k = 0; k < k_len; ++k) {
+          acc[k] = Reducer::Apply(
+              acc[k], static_cast<detail::CpuReduceAccT<Reducer>>(row[k]));
+        }
+      }
+      T* out_row = out + g * inner + k_begin;
+      for (int64_t k = 0; k < k_len; ++k) {
+        out_row[k] = static_cast<T>(Reducer::Finalize(acc[k], num_reduced));
+      }
+    }
+  };
+  ctx.ParallelFor(0, num_groups * num_blocks, grain_size, reduce_blocks);
+}
+
+// Runs the reduction by the engine and returns true if the functor and the
+// data type are supported, otherwise returns false and leaves out untouched.
+template <typename Functor, typename T>
+typename std::enable_if<CpuReducerOf<Functor, T>::kSupported, bool>::type
+CpuReduceIfSupported(const CPUContext& ctx,
+                     const T* x,
+                     T* out,
+                     const DDim& x_dims,
+                     const std::vector<int64_t>& dims,
+                     bool reduce_all) {
+  // leave the empty inputs to Eigen, the mean of integers would divide by 0
+  if (product(x_dims) == 0) {
+    return false;
+  }
+  CpuReduce<T, typename CpuReducerOf<Functor, T>::Reducer>(
+      ctx, x, out, CollapseReduceDims(x_dims, dims, reduce_all));
+  return true;
+}
+
+template <typename Functor, typename T>
+typename std::enable_if<!CpuReducerOf<Functor, T>::kSupported, bool>::type
+CpuReduceIfSupported(const CPUContext& ctx,
+                     const T* x,
+                     T* out,
+                     const DDim& x_dims,
+                     const std::vector<int64_t>& dims,
+                     bool reduce_all) {
+  return false;
+}
+
+}  // namespace funcs
+}  // namespace phi
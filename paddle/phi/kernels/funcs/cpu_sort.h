@@ -0,0 +1,394 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * The top-k and argsort engines of the CPU kernels, for rows of contiguous
+ * values. Every value is mapped to an unsigned key whose ascending order is
+ * the order of the output: NaN is larger than any number, -0.0 equals 0.0,
+ * and a descending order inverts the keys. Equal values keep the order of
+ * their indices, so the results are deterministic.
+ *
+ * top-k picks the algorithm by k and the row length n:
+ *   - a small k keeps a heap of the k first values, the keys of the row
+ *     are computed by blocks in a vectorized loop and only the ones below
+ *     the worst kept key touch the heap,
+ *   - a larger k runs a quickselect (nth_element) over the keys alone and
+ *     sorts the selected values by radix,
+ *   - a long row of a tensor with fewer rows than threads is split into
+ *     chunks whose top-k are selected by the intra-op threads and merged.
+ * argsort sorts the keys of long rows with an LSD radix sort of 8-bit
+ * digits, skipping the digits that are the same for the whole row, and the
+ * short rows with std::sort.
+ */
+
+template <typename T, typename Enable = void>
+struct CpuSortKey;
+
+template <typename T>
+struct CpuSortKey<
+    T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  using Key =
+      typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+  static constexpr Key kSignBit = Key(1) << (sizeof(Key) * 8 - 1);
+
+  static Key Get(T v) {
+    // +0.0 for -0.0
+    T canonical = v == static_cast<T>(0) ? static_cast<T>(0) : v;
+    Key bits;
+    std::memcpy(&bits, &canonical, sizeof(bits));
+    Key key = (bits & kSignBit) ? ~bits : (bits | kSignBit);
+    return v != v ? ~Key(0) : key;
+  }
+};
+
+template <typename T>
+struct CpuSortKey<T,
+                  typename std::enable_if<std::is_integral<T>::value>::type> {
+  using Key = typename std::make_unsigned<T>::type;
+  static constexpr Key kSignBit =
+      std::is_signed<T>::value ? Key(1) << (sizeof(Key) * 8 - 1) : Key(0);
+
+  static Key Get(T v) { return static_cast<Key>(v) ^ kSignBit; }
+};
+
+namespace detail {
+
+// the values whose keys are computed at once
+constexpr int64_t kCpuTopKBlock = 256;
+// a row longer than this is split among the threads when the rows are few
+constexpr int64_t kCpuTopKSplitSize = 1 << 16;
+// the rows shorter than this are sorted by std::sort
+constexpr int64_t kCpuRadixSortMinSize = 256;
+// the values handled by one intra-op thread at least
+constexpr int64_t kCpuSortGrainSize = 32768;
+
+template <typename T>
+using SortKeyT = typename CpuSortKey<T>::Key;
+
+template <typename T>
+using KeyIndex = std::pair<SortKeyT<T>, int64_t>;
+
+// the keys of x[0, n), inverted for a descending order
+template <typename T>
+inline void ComputeSortKeys(const T* x,
+                            int64_t n,
+                            bool descending,
+                            SortKeyT<T>* keys) {
+  const SortKeyT<T> flip = descending ? ~SortKeyT<T>(0) : SortKeyT<T>(0);
+  for (int64_t i = 0; i < n; ++i) {
+    keys[i] = CpuSortKey<T>::Get(x[i]) ^ flip;
+  }
+}
+
+template <typename Key>
+void RadixSort(std::vector<Key>* keys,
+               std::vector<int64_t>* index,
+               std::vector<Key>* keys_tmp,
+               std::vector<int64_t>* index_tmp) {
+  constexpr int kPasses = sizeof(Key);
+  const int64_t n = keys->size();
+  std::vector<int64_t> counts(kPasses * 256, 0);
+  for (int64_t i = 0; i < n; ++i) {
+    Key key = (*keys)[i];
+    for (int p = 0; p < kPasses; ++p) {
+      ++counts[p * 256 + ((key >> (p * 8)) & 0xFF)];
+    }
+  }
+  keys_tmp->resize(n);
+  index_tmp->resize(n);
+  for (int p = 0; p < kPasses; ++p) {
+    int64_t* count = counts.data() + p * 256;
+    // a digit shared by the whole row does not move anything
+    if (*std::max_element(count, count + 256) == n) {
+      continue;
+    }
+    int64_t offset = 0;
+    for (int d = 0; d < 256; ++d) {
+      int64_t c = count[d];
+      count[d] = offset;
+      offset += c;
+    }
+    const Key* src_keys = keys->data();
+    const int64_t* src_index = index->data();
+    Key* dst_keys = keys_tmp->data();
+    int64_t* dst_index = index_tmp->data();
+    for (int64_t i = 0; i < n; ++i) {
+      int64_t pos = count[(src_keys[i] >> (p * 8)) & 0xFF]++;
+      dst_keys[pos] = src_keys[i];
+      dst_index[pos] = src_index[i];
+    }
+    keys->swap(*keys_tmp);
+    index->swap(*index_tmp);
+  }
+}
+
+// replaces the largest of a max-heap by a smaller value with one sift down
+template <typename Pair>
+inline void ReplaceHeapTop(std::vector<Pair>* heap, const Pair& value) {
+  Pair* h = heap->data();
+  const size_t size = heap->size();
+  size_t pos = 0;
+  while (true) {
+    size_t child = 2 * pos + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size && h[child] < h[child + 1]) {
+      ++child;
+    }
+    if (!(value < h[child])) {
+      break;
+    }
+    h[pos] = h[child];
+    pos = child;
+  }
+  h[pos] = value;
+}
+
+// The k first (key, index) of x[begin, end) in ascending order, by a heap of
+// the kept values.
+template <typename T>
+std::vector<KeyIndex<T>> HeapTopK(
+    const T* x, int64_t begin, int64_t end, int64_t k, bool descending) {
+  using Key = SortKeyT<T>;
+  std::vector<KeyIndex<T>> heap;
+  heap.reserve(k);
+  Key keys[kCpuTopKBlock];
+  for (int64_t b = begin; b < end; b += kCpuTopKBlock) {
+    const int64_t len = std::min(kCpuTopKBlock, end - b);
+    ComputeSortKeys(x + b, len, descending, keys);
+    int64_t i = 0;
+    for (; i < len && static_cast<int64_t>(heap.size()) < k; ++i) {
+      heap.emplace_back(keys[i], b + i);
+      std::push_heap(heap.begin(), heap.end());
+    }
+    if (i == len) {
+      continue;
+    }
+    // a later value with the key of the worst kept one has a larger index,
+    // only a smaller key gets in
+    Key threshold = heap.front().first;
+    for (; i < len; ++i) {
+      if (keys[i] < threshold) {
+        ReplaceHeapTop(&heap, KeyIndex<T>(keys[i], b + i));
+        threshold = heap.front().first;
+      }
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end());
+  return heap;
+}
+
+// The k first (key, index) of x[begin, end) by a quickselect of the keys
+// alone, in ascending order if sorted. The values with the k-th key are
+// taken in the order of their indices.
+template <typename T>
+std::vector<KeyIndex<T>> SelectTopK(const T* x,
+                                    int64_t begin,
+                                    int64_t end,
+                                    int64_t k,
+                                    bool descending,
+                                    bool sorted) {
+  using Key = SortKeyT<T>;
+  const int64_t n = end - begin;
+  std::vector<Key> keys(n);
+  ComputeSortKeys(x + begin, n, descending, keys.data());
+  std::vector<Key> selected(keys);
+  std::nth_element(selected.begin(), selected.begin() + k - 1, selected.end());
+  const Key kth = selected[k - 1];
+  int64_t num_equal =
+      k - std::count_if(selected.begin(), selected.begin() + k, [&](Key key) {
+        return key < kth;
+      });
+  std::vector<Key> top_keys;
+  std::vector<int64_t> top_index;
+  top_keys.reserve(k);
+  top_index.reserve(k);
+  for (int64_t i = 0; i < n; ++i) {
+    if (keys[i] < kth || (keys[i] == kth && num_equal-- > 0)) {
+      top_keys.push_back(keys[i]);
+      top_index.push_back(begin + i);
+    }
+  }
+  // the radix sort is stable and the indices are ascending
+  if (sorted && k >= kCpuRadixSortMinSize) {
+    std::vector<int64_t> index_tmp;
+    RadixSort(&top_keys, &top_index, &keys, &index_tmp);
+  }
+  std::vector<KeyIndex<T>> top(k);
+  for (int64_t j = 0; j < k; ++j) {
+    top[j] = KeyIndex<T>(top_keys[j], top_index[j]);
+  }
+  if (sorted && k < kCpuRadixSortMinSize) {
+    std::sort(top.begin(), top.end());
+  }
+  return top;
+}
+
+template <typename T>
+std::vector<KeyIndex<T>> RangeTopK(const T* x,
+                                   int64_t begin,
+                                   int64_t end,
+                                   int64_t k,
+                                   bool descending,
+                                   bool sorted) {
+  k = std::min(k, end - begin);
+  if (k * 64 <= end - begin) {
+    return HeapTopK(x, begin, end, k, descending);
+  }
+  return SelectTopK(x, begin, end, k, descending, sorted);
+}
+
+template <typename T>
+void WriteTopK(const T* x,
+               const std::vector<KeyIndex<T>>& top,
+               T* out,
+               int64_t* indices) {
+  for (size_t j = 0; j < top.size(); ++j) {
+    out[j] = x[top[j].second];
+    indices[j] = top[j].second;
+  }
+}
+
+// the top-k of one long row, selected by chunks among the threads
+template <typename T>
+void SplitRowTopK(const CPUContext& ctx,
+                  const T* x,
+                  int64_t n,
+                  int64_t k,
+                  bool descending,
+                  bool sorted,
+                  T* out,
+                  int64_t* indices) {
+  const int64_t chunk = std::max(kCpuTopKSplitSize / 2, k * 64);
+  const int64_t num_chunks = (n + chunk - 1) / chunk;
+  std::vector<std::vector<KeyIndex<T>>> partial(num_chunks);
+  ctx.ParallelFor(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      partial[c] = RangeTopK(
+          x, c * chunk, std::min(n, (c + 1) * chunk), k, descending, true);
+    }
+  });
+  std::vector<KeyIndex<T>> merged;
+  for (auto& p : partial) {
+    merged.insert(merged.end(), p.begin(), p.end());
+  }
+  if (static_cast<int64_t>(merged.size()) > k) {
+    std::nth_element(merged.begin(), merged.begin() + k - 1, merged.end());
+    merged.resize(k);
+  }
+  if (sorted) {
+    std::sort(merged.begin(), merged.end());
+  }
+  WriteTopK(x, merged, out, indices);
+}
+
+}  // namespace detail
+
+// The top k values of every row of x, which is [rows, n], into out and
+// indices, which are [rows, k]. They are in the output order if sorted,
+// otherwise in any order.
+template <typename T>
+void CpuTopK(const CPUContext& ctx,
+             const T* x,
+             int64_t rows,
+             int64_t n,
+             int64_t k,
+             bool largest,
+             bool sorted,
+             T* out,
+             int64_t* indices) {
+  if (rows == 0 || k <= 0) {
+    return;
+  }
+  if (rows < ctx.GetIntraOpThreads() && n >= detail::kCpuTopKSplitSize) {
+    for (int64_t r = 0; r < rows; ++r) {
+      detail::SplitRowTopK(
+          ctx, x + r * n, n, k, largest, sorted, out + r * k, indices + r * k);
+    }
+    return;
+  }
+  int64_t grain_size =
+      std::max<int64_t>(1, detail::kCpuSortGrainSize / std::max<int64_t>(n, 1));
+  ctx.ParallelFor(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; ++r) {
+      const T* row = x + r * n;
+      auto top = detail::RangeTopK(row, 0, n, k, largest, sorted);
+      detail::WriteTopK(row, top, out + r * k, indices + r * k);
+    }
+  });
+}
+
+// Sorts every row of x, which is [rows, n], into out with the indices of
+// the values in indices. Equal values keep their order.
+template <typename T>
+void CpuArgsort(const CPUContext& ctx,
+                const T* x,
+                int64_t rows,
+                int64_t n,
+                bool descending,
+                T* out,
+                int64_t* indices) {
+  using Key = detail::SortKeyT<T>;
+  int64_t grain_size =
+      std::max<int64_t>(1, detail::kCpuSortGrainSize / std::max<int64_t>(n, 1));
+  ctx.ParallelFor(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<Key> keys, keys_tmp;
+    std::vector<int64_t> index, index_tmp;
+    std::vector<detail::KeyIndex<T>> pairs;
+    for (int64_t r = begin; r < end; ++r) {
+      const T* row = x + r * n;
+      T* out_row = out + r * n;
+      int64_t* index_row = indices + r * n;
+      keys.resize(n);
+      detail::ComputeSortKeys(row, n, descending, keys.data());
+      if (n < detail::kCpuRadixSortMinSize) {
+        pairs.resize(n);
+        for (int64_t i = 0; i < n; ++i) {
+          pairs[i] = detail::KeyIndex<T>(keys[i], i);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        detail::WriteTopK(row, pairs, out_row, index_row);
+        continue;
+      }
+      index.resize(n);
+      for (int64_t i = 0; i < n; ++i) {
+        index[i] = i;
+      }
+      detail::RadixSort(&keys, &index, &keys_tmp, &index_tmp);
+      for (int64_t i = 0; i < n; ++i) {
+        out_row[i] = row[index[i]];
+        index_row[i] = index[i];
+      }
+    }
+  });
+}
+
+}  // namespace funcs
+}  // namespace phi
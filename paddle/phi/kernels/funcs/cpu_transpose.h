@@ -0,0 +1,390 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/ddim.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * The transpose engine of the CPU transpose kernels. The dims of size 1 are
+ * dropped and the input dims that stay adjacent and in order in the output
+ * are merged, e.g. [N, C, H, W] with axis [0, 2, 3, 1] becomes [N, C, H*W]
+ * with axis [0, 2, 1]. Then
+ *   - an identity permutation is a copy,
+ *   - a permutation that keeps the innermost dim copies contiguous rows,
+ *   - otherwise the innermost dims of the input and the output form a 2-D
+ *     transpose, done by square tiles that stay in the L1 cache, with
+ *     register transposes of 8x8 floats or 4x4 doubles inside a tile.
+ * The tiles (or rows) of all the outer dims are split among the intra-op
+ * threads of the CPUContext.
+ */
+struct CpuTransposeShape {
+  std::vector<int64_t> dims;  // the input dims
+  std::vector<int> axis;      // the output dim i is the input dim axis[i]
+};
+
+inline CpuTransposeShape CollapseTransposeDims(const DDim& x_dims,
+                                               const std::vector<int>& axis) {
+  const int rank = axis.size();
+  // drop the dims of size 1 and renumber the others
+  std::vector<int> new_index(rank, -1);
+  std::vector<int64_t> kept_dims;
+  for (int i = 0; i < rank; ++i) {
+    if (x_dims[i] != 1) {
+      new_index[i] = kept_dims.size();
+      kept_dims.push_back(x_dims[i]);
+    }
+  }
+  std::vector<int> kept_axis;
+  for (int i = 0; i < rank; ++i) {
+    if (new_index[axis[i]] >= 0) {
+      kept_axis.push_back(new_index[axis[i]]);
+    }
+  }
+
+  // the input dim d merges into d - 1 if it follows d - 1 in the output too
+  std::vector<bool> merged(kept_dims.size(), false);
+  for (size_t i = 1; i < kept_axis.size(); ++i) {
+    if (kept_axis[i] == kept_axis[i - 1] + 1) {
+      merged[kept_axis[i]] = true;
+    }
+  }
+  CpuTransposeShape shape;
+  std::vector<int> group(kept_dims.size());
+  for (size_t d = 0; d < kept_dims.size(); ++d) {
+    if (merged[d]) {
+      shape.dims.back() *= kept_dims[d];
+    } else {
+      shape.dims.push_back(kept_dims[d]);
+    }
+    group[d] = shape.dims.size() - 1;
+  }
+  for (int d : kept_axis) {
+    if (!merged[d]) {
+      shape.axis.push_back(group[d]);
+    }
+  }
+  if (shape.dims.empty()) {
+    shape.dims.push_back(1);
+    shape.axis.push_back(0);
+  }
+  return shape;
+}
+
+namespace detail {
+
+// the side of a tile, 32 x 32 floats take 4KB of both input and output
+constexpr int64_t kCpuTransposeTile = 32;
+// the elements copied by one task
+constexpr int64_t kCpuTransposeGrainSize = 32768;
+
+// Walks the outer dims of a transpose and keeps the offsets of the input
+// and the output.
+class TransposeOffsets {
+ public:
+  TransposeOffsets(const std::vector<int64_t>& sizes,
+                   const std::vector<int64_t>& src_strides,
+                   const std::vector<int64_t>& dst_strides)
+      : sizes_(sizes),
+        src_strides_(src_strides),
+        dst_strides_(dst_strides),
+        index_(sizes.size(), 0) {}
+
+  void Seek(int64_t n) {
+    src_offset_ = dst_offset_ = 0;
+    for (int i = static_cast<int>(index_.size()) - 1; i >= 0; --i) {
+      index_[i] = n % sizes_[i];
+      n /= sizes_[i];
+      src_offset_ += index_[i] * src_strides_[i];
+      dst_offset_ += index_[i] * dst_strides_[i];
+    }
+  }
+
+  void Next() {
+    for (int i = static_cast<int>(index_.size()) - 1; i >= 0; --i) {
+      src_offset_ += src_strides_[i];
+      dst_offset_ += dst_strides_[i];
+      if (++index_[i] < sizes_[i]) {
+        return;
+      }
+      src_offset_ -= index_[i] * src_strides_[i];
+      dst_offset_ -= index_[i] * dst_strides_[i];
+      index_[i] = 0;
+    }
+  }
+
+  int64_t src_offset() const { return src_offset_; }
+  int64_t dst_offset() const { return dst_offset_; }
+
+ private:
+  const std::vector<int64_t>& sizes_;
+  const std::vector<int64_t>& src_strides_;
+  const std::vector<int64_t>& dst_strides_;
+  std::vector<int64_t> index_;
+  int64_t src_offset_{0};
+  int64_t dst_offset_{0};
+};
+
+// The register transpose of a kBlock x kBlock block, by the size of the
+// element. kBlock is 1 if there is none.
+template <typename T, size_t kSize = sizeof(T)>
+struct MicroTranspose {
+  static constexpr int64_t kBlock = 1;
+  static void Run(const T* src, int64_t src_ld, T* dst, int64_t dst_ld) {
+    *dst = *src;
+  }
+};
+
+#if defined(__AVX__)
+template <typename T>
+struct MicroTranspose<T, 4> {
+  static constexpr int64_t kBlock = 8;
+  static void Run(const T* src, int64_t src_ld, T* dst, int64_t dst_ld) {
+    const float* s = reinterpret_cast<const float*>(src);
+    float* d = reinterpret_cast<float*>(dst);
+    __m256 r0 = _mm256_loadu_ps(s);
+    __m256 r1 = _mm256_loadu_ps(s + src_ld);
+    __m256 r2 = _mm256_loadu_ps(s + 2 * src_ld);
+    __m256 r3 = _mm256_loadu_ps(s + 3 * src_ld);
+    __m256 r4 = _mm256_loadu_ps(s + 4 * src_ld);
+    __m256 r5 = _mm256_loadu_ps(s + 5 * src_ld);
+    __m256 r6 = _mm256_loadu_ps(s + 6 * src_ld);
+    __m256 r7 = _mm256_loadu_ps(s + 7 * src_ld);
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+    __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+    __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+    __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+    r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    _mm256_storeu_ps(d, _mm256_permute2f128_ps(r0, r4, 0x20));
+    _mm256_storeu_ps(d + dst_ld, _mm256_permute2f128_ps(r1, r5, 0x20));
+    _mm256_storeu_ps(d + 2 * dst_ld, _mm256_permute2f128_ps(r2, r6, 0x20));
+    _mm256_storeu_ps(d + 3 * dst_ld, _mm256_permute2f128_ps(r3, r7, 0x20));
+    _mm256_storeu_ps(d + 4 * dst_ld, _mm256_permute2f128_ps(r0, r4, 0x31));
+    _mm256_storeu_ps(d + 5 * dst_ld, _mm256_permute2f128_ps(r1, r5, 0x31));
+    _mm256_storeu_ps(d + 6 * dst_ld, _mm256_permute2f128_ps(r2, r6, 0x31));
+    _mm256_storeu_ps(d + 7 * dst_ld, _mm256_permute2f128_ps(r3, r7, 0x31));
+  }
+};
+
+template <typename T>
+struct MicroTranspose<T, 8> {
+  static constexpr int64_t kBlock = 4;
+  static void Run(const T* src, int64_t src_ld, T* dst, int64_t dst_ld) {
+    const double* s = reinterpret_cast<const double*>(src);
+    double* d = reinterpret_cast<double*>(dst);
+    __m256d r0 = _mm256_loadu_pd(s);
+    __m256d r1 = _mm256_loadu_pd(s + src_ld);
+    __m256d r2 = _mm256_loadu_pd(s + 2 * src_ld);
+    __m256d r3 = _mm256_loadu_pd(s + 3 * src_ld);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(d + dst_ld, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(d + 2 * dst_ld, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(d + 3 * dst_ld, _mm256_permute2f128_pd(t1, t3, 0x31));
+  }
+};
+#elif defined(__SSE__)
+template <typename T>
+struct MicroTranspose<T, 4> {
+  static constexpr int64_t kBlock = 4;
+  static void Run(const T* src, int64_t src_ld, T* dst, int64_t dst_ld) {
+    const float* s = reinterpret_cast<const float*>(src);
+    float* d = reinterpret_cast<float*>(dst);
+    __m128 r0 = _mm_loadu_ps(s);
+    __m128 r1 = _mm_loadu_ps(s + src_ld);
+    __m128 r2 = _mm_loadu_ps(s + 2 * src_ld);
+    __m128 r3 = _mm_loadu_ps(s + 3 * src_ld);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(d, r0);
+    _mm_storeu_ps(d + dst_ld, r1);
+    _mm_storeu_ps(d + 2 * dst_ld, r2);
+    _mm_storeu_ps(d + 3 * dst_ld, r3);
+  }
+};
+#endif
+
+// dst[j * dst_ld + i] = src[i * src_ld + j] for i < rows and j < cols.
+template <typename T>
+void TransposeTile(const T* src,
+                   int64_t src_ld,
+                   T* dst,
+                   int64_t dst_ld,
+                   int64_t rows,
+                   int64_t cols) {
+  using Micro = MicroTranspose<T>;
+  constexpr int64_t kBlock = Micro::kBlock;
+  const int64_t block_rows = kBlock > 1 ? rows / kBlock * kBlock : 0;
+  const int64_t block_cols = kBlock > 1 ? cols / kBlock * kBlock : 0;
+  for (int64_t i = 0; i < block_rows; i += kBlock) {
+    for (int64_t j = 0; j < block_cols; j += kBlock) {
+      Micro::Run(src + i * src_ld + j, src_ld, dst + j * dst_ld + i, dst_ld);
+    }
+  }
+  // the edges that do not fill a register block
+  for (int64_t j = 0; j < cols; ++j) {
+    const int64_t i_begin = j < block_cols ? block_rows : 0;
+    for (int64_t i = i_begin; i < rows; ++i) {
+      dst[j * dst_ld + i] = src[i * src_ld + j];
+    }
+  }
+}
+
+}  // namespace detail
+
+template <typename T>
+void CpuTranspose(const CPUContext& ctx,
+                  const T* x,
+                  T* out,
+                  const CpuTransposeShape& shape) {
+  const int rank = shape.dims.size();
+  std::vector<int64_t> in_strides(rank);
+  int64_t numel = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    in_strides[i] = numel;
+    numel *= shape.dims[i];
+  }
+  if (numel == 0) {
+    return;
+  }
+  if (rank == 1) {
+    ctx.ParallelFor(0,
+                    numel,
+                    detail::kCpuTransposeGrainSize,
+                    [&](int64_t begin, int64_t end) {
+                      std::copy(x + begin, x + end, out + begin);
+                    });
+    return;
+  }
+
+  std::vector<int64_t> out_strides(rank);
+  int64_t stride = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    out_strides[i] = stride;
+    stride *= shape.dims[shape.axis[i]];
+  }
+
+  if (shape.axis[rank - 1] == rank - 1) {
+    // the innermost dim is kept, copy it row by row
+    const int64_t inner = shape.dims[rank - 1];
+    std::vector<int64_t> sizes, src_strides, dst_strides;
+    for (int i = 0; i < rank - 1; ++i) {
+      sizes.push_back(shape.dims[shape.axis[i]]);
+      src_strides.push_back(in_strides[shape.axis[i]]);
+      dst_strides.push_back(out_strides[i]);
+    }
+    ctx.ParallelFor(
+        0,
+        numel / inner,
+        std::max<int64_t>(1, detail::kCpuTransposeGrainSize / inner),
+        [&](int64_t begin, int64_t end) {
+          detail::TransposeOffsets offsets(sizes, src_strides, dst_strides);
+          offsets.Seek(begin);
+          for (int64_t row = begin; row < end; ++row, offsets.Next()) {
+            const T* src = x + offsets.src_offset();
+            std::copy(src, src + inner, out + offsets.dst_offset());
+          }
+        });
+    return;
+  }
+
+  // The tile is [rows, cols] of the input, rows is the innermost dim of the
+  // output and cols is the innermost dim of the input, at the output dim
+  // col_axis.
+  const int col_axis = static_cast<int>(
+      std::find(shape.axis.begin(), shape.axis.end(), rank - 1) -
+      shape.axis.begin());
+  const int64_t rows = shape.dims[shape.axis[rank - 1]];
+  const int64_t src_ld = in_strides[shape.axis[rank - 1]];
+  const int64_t cols = shape.dims[rank - 1];
+  const int64_t dst_ld = out_strides[col_axis];
+  std::vector<int64_t> sizes, src_strides, dst_strides;
+  int64_t outer = 1;
+  for (int i = 0; i < rank - 1; ++i) {
+    if (i != col_axis) {
+      sizes.push_back(shape.dims[shape.axis[i]]);
+      src_strides.push_back(in_strides[shape.axis[i]]);
+      dst_strides.push_back(out_strides[i]);
+      outer *= sizes.back();
+    }
+  }
+
+  const int64_t tile = detail::kCpuTransposeTile;
+  const int64_t row_tiles = (rows + tile - 1) / tile;
+  const int64_t col_tiles = (cols + tile - 1) / tile;
+  const int64_t tiles = row_tiles * col_tiles;
+  const int64_t tile_numel = std::min(rows, tile) * std::min(cols, tile);
+  ctx.ParallelFor(
+      0,
+      outer * tiles,
+      std::max<int64_t>(1, detail::kCpuTransposeGrainSize / tile_numel),
+      [&](int64_t begin, int64_t end) {
+        detail::TransposeOffsets offsets(sizes, src_strides, dst_strides);
+        int64_t current = begin / tiles;
+        offsets.Seek(current);
+        for (int64_t task = begin; task < end; ++task) {
+          if (task / tiles != current) {
+            ++current;
+            offsets.Next();
+          }
+          const int64_t i = (task % tiles) / col_tiles * tile;
+          const int64_t j = (task % col_tiles) * tile;
+          detail::TransposeTile(x + offsets.src_offset() + i * src_ld + j,
+                                src_ld,
+                                out + offsets.dst_offset() + j * dst_ld + i,
+                                dst_ld,
+                                std::min(tile, rows - i),
+                                std::min(tile, cols - j));
+        }
+      });
+}
+
+// out = transpose(x, axis), x is of x_dims.
+template <typename T>
+void CpuTranspose(const CPUContext& ctx,
+                  const T* x,
+                  T* out,
+                  const DDim& x_dims,
+                  const std::vector<int>& axis) {
+  CpuTranspose(ctx, x, out, CollapseTransposeDims(x_dims, axis));
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -19,6 +19,7 @@ limitations under the License. */
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/kernels/empty_kernel.h"
 #include "paddle/phi/kernels/funcs/common_shape.h"
+#include "paddle/phi/kernels/funcs/cpu_broadcast.h"
 #include "paddle/phi/kernels/funcs/elementwise_utils.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
@@ -283,7 +284,6 @@ void CommonForwardBroadcastCPU(const DenseTensor &x,
                                const CPUContext &ctx,
                                Functor func,
                                const bool is_xsize_larger = true) {
-  std::vector<int> index_array(max_dim, 0);
   const T *x_data = x.data<T>();
   const T *y_data = y.data<T>();
   PADDLE_ENFORCE_NOT_NULL(
@@ -292,19 +292,25 @@ void CommonForwardBroadcastCPU(const DenseTensor &x,
       y_data, errors::InvalidArgument("The input Y should not be empty."));
   OutType *out_data = ctx.Alloc<OutType>(z);
 
-  const int out_size = std::accumulate(
-      out_dims_array, out_dims_array + max_dim, 1, std::multiplies<int>());
-  int x_index, y_index;
-  for (int out_index = 0; out_index < out_size; ++out_index) {
-    x_index = GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
-    y_index = GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
-    if (is_xsize_larger) {
-      out_data[out_index] = func(x_data[x_index], y_data[y_index]);
-    } else {
-      out_data[out_index] = func(y_data[y_index], x_data[x_index]);
-    }
-
-    UpdateElementwiseIndexArray(out_dims_array, max_dim, index_array.data());
+  // the functor takes the larger input first
+  if (is_xsize_larger) {
+    CpuBroadcastBinary(
+        ctx,
+        x_data,
+        y_data,
+        out_data,
+        CollapseBroadcastDims(x_dims_array, y_dims_array, out_dims_array,
+                              max_dim),
+        func);
+  } else {
+    CpuBroadcastBinary(
+        ctx,
+        y_data,
+        x_data,
+        out_data,
+        CollapseBroadcastDims(y_dims_array, x_dims_array, out_dims_array,
+                              max_dim),
+        func);
   }
 }
 
@@ -356,14 +362,11 @@ void CommonElementwiseBroadcastForward(const CPUContext &dev_ctx,
 }
 
 // It is a common CPU implementation to compute binary calculation with the
-// support of broadcast. Note:
-// 1. CPU implementation cannot support the case when x needs broadcast, thus
-//    this function need to be called with XxxFunctor and XxxInverseFunctor,
-//    like AddFunctor and InverseAddFunctor.
-// 2. The corresponding GPU implementation supports all the broadcast cases,
-//    thus there is no need to define and call with XxxInverseFunctor.
-// TODO(liuyiqun): optimize the CPU implementation to support all broadcast
-// cases and avoid the need of XxxInverseFunctor.
+// support of broadcast. Both inputs may be broadcast, but the functor always
+// takes the input of the larger rank first, thus this function need to be
+// called with XxxFunctor and XxxInverseFunctor, like AddFunctor and
+// InverseAddFunctor. The corresponding GPU implementation has no such
+// restriction.
 template <typename Functor, typename T, typename OutType = T>
 void ElementwiseCompute(const CPUContext &dev_ctx,
                         const DenseTensor &x,
@@ -380,10 +383,20 @@ void ElementwiseCompute(const CPUContext &dev_ctx,
     is_xsize_larger = false;
     max_dim = y_dims.size();
   }
-  TransformFunctor<Functor, T, CPUContext, OutType> functor(
-      x, y, z, dev_ctx, func, is_xsize_larger);
   if (x_dims == y_dims) {
-    functor.Run();
+    CpuBroadcastShape shape;
+    shape.out_dims = {x.numel()};
+    shape.x_strides = {1};
+    shape.y_strides = {1};
+    CpuBroadcastBinary(dev_ctx,
+                       x.data<T>(),
+                       y.data<T>(),
+                       z->data<OutType>(),
+                       shape,
+                       func);
+    return;
+  }
+  if (z->numel() == 0) {
     return;
   }
 
@@ -401,44 +414,15 @@ void ElementwiseCompute(const CPUContext &dev_ctx,
                         max_dim,
                         axis));
 
-  int pre, n, post, is_run_common_broadcast, axis_trim = 0;
+  // the trailing 1s of the smaller input may exceed the larger one, e.g.
+  // x=[2,3] y=[3,1] with axis=1, they broadcast anyway
   if (is_xsize_larger) {
-    auto y_dims_trimed = TrimTrailingSingularDims(y_dims);
-    axis_trim = (y_dims_trimed.size() == 0) ? x_dims.size() : axis;
-    GetMidDims(x_dims,
-               y_dims_trimed,
-               axis_trim,
-               &pre,
-               &n,
-               &post,
-               &is_run_common_broadcast);
+    y_dims = TrimTrailingSingularDims(y_dims);
   } else {
-    auto x_dims_trimed = TrimTrailingSingularDims(x_dims);
-    axis_trim = (x_dims_trimed.size() == 0) ? y_dims.size() : axis;
-    GetMidDims(y_dims,
-               x_dims_trimed,
-               axis_trim,
-               &pre,
-               &n,
-               &post,
-               &is_run_common_broadcast);
-  }
-  // special case for common implementation.
-  // case 1: x=[2,3,1,5], y=[2,1,4,1]
-  // case 2: x=[2,3,4], y=[1,1,4]
-  if (is_run_common_broadcast == 1) {
-    CommonElementwiseBroadcastForward<Functor, T, OutType>(
-        dev_ctx, x, y, z, x_dims, y_dims, func, axis, is_xsize_larger);
-    return;
-  }
-
-  if (post == 1) {
-    functor.RunRowWise(n, pre);
-    return;
-  } else {
-    functor.RunMidWise(n, pre, post);
-    return;
+    x_dims = TrimTrailingSingularDims(x_dims);
   }
+  CommonElementwiseBroadcastForward<Functor, T, OutType>(
+      dev_ctx, x, y, z, x_dims, y_dims, func, axis, is_xsize_larger);
 }
 
 // for broadcast backwards
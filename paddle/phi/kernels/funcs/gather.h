@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 #include <memory.h>
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -70,27 +71,34 @@ void CPUGather(const phi::CPUContext& ctx,
 
   const size_t slice_bytes = slice_size * sizeof(T);
 
-  for (int64_t i = 0; i < index_size; ++i) {
-    IndexT index_ = p_index[i];
-    PADDLE_ENFORCE_LT(p_index[i],
-                      input_size,
-                      phi::errors::OutOfRange(
-                          "The element of Index must be less than the size of "
-                          "input dim size of axis which is %d, but received "
-                          "index element which is %d in the %d index.",
-                          input_size,
-                          p_index[i],
-                          i));
-    PADDLE_ENFORCE_GE(p_index[i],
-                      0,
-                      phi::errors::OutOfRange(
-                          "The element of Index must be greater than or equal "
-                          "to 0, but received index element which is %d in the "
-                          "%d index.",
-                          p_index[i],
-                          i));
-    memcpy(p_output + i * slice_size, p_src + index_ * slice_size, slice_bytes);
-  }
+  // the slices copied by one thread at least
+  int64_t grain_size =
+      std::max<int64_t>(1, 32768 / std::max<int64_t>(slice_size, 1));
+  ctx.ParallelFor(0, index_size, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      IndexT index_ = p_index[i];
+      PADDLE_ENFORCE_LT(p_index[i],
+                        input_size,
+                        phi::errors::OutOfRange(
+                            "The element of Index must be less than the size "
+                            "of input dim size of axis which is %d, but "
+                            "received index element which is %d in the %d "
+                            "index.",
+                            input_size,
+                            p_index[i],
+                            i));
+      PADDLE_ENFORCE_GE(p_index[i],
+                        0,
+                        phi::errors::OutOfRange(
+                            "The element of Index must be greater than or "
+                            "equal to 0, but received index element which is "
+                            "%d in the %d index.",
+                            p_index[i],
+                            i));
+      memcpy(
+          p_output + i * slice_size, p_src + index_ * slice_size, slice_bytes);
+    }
+  });
 }
 
 template <typename T, typename IndexT = int>
@@ -0,0 +1,56 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/small_gemm.h"
+
+#include <limits>
+
+#include "paddle/fluid/operators/jit/kernels.h"
+
+namespace phi {
+namespace funcs {
+
+// the rows of X computed by the jit small gemm kernels
+constexpr int kSmallGemmRows = 16;
+
+bool MatMulWithSmallGemm(const CPUContext& dev_ctx,
+                         const float* x_data,
+                         const float* y_data,
+                         int M,
+                         int N,
+                         int K,
+                         bool trans_y,
+                         int64_t batch_size,
+                         float* out_data) {
+  namespace jit = paddle::operators::jit;
+  if (M > kSmallGemmRows || batch_size > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  jit::matmul_attr_t attr(M, N, K);
+  attr.trans_b = trans_y;
+  attr.batch = static_cast<int>(batch_size);
+  // blas is faster than the other implementations of jit
+  if (jit::GetJitCode<jit::MatMulTuple<float>, paddle::platform::CPUPlace>(
+          attr) == nullptr) {
+    return false;
+  }
+  auto matmul = jit::KernelFuncs<jit::MatMulTuple<float>,
+                                 paddle::platform::CPUPlace>::Cache()
+                    .At(attr);
+  matmul(x_data, y_data, out_data, &attr);
+  return true;
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,51 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+// Out = X * Y of the small float products on CPU runs the jit GEMM kernels of
+// the batch strided matrices, it returns false to run blas on the other shapes
+// and devices.
+template <typename Context, typename T>
+bool MatMulWithSmallGemm(const Context& dev_ctx,
+                         const T* x_data,
+                         const T* y_data,
+                         int M,
+                         int N,
+                         int K,
+                         bool trans_y,
+                         int64_t batch_size,
+                         T* out_data) {
+  return false;
+}
+
+bool MatMulWithSmallGemm(const CPUContext& dev_ctx,
+                         const float* x_data,
+                         const float* y_data,
+                         int M,
+                         int N,
+                         int K,
+                         bool trans_y,
+                         int64_t batch_size,
+                         float* out_data);
+
+}  // namespace funcs
+}  // namespace phi
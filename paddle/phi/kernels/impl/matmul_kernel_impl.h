@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/funcs/blas/blas.h"
 #include "paddle/phi/kernels/funcs/complex_functors.h"
+#include "paddle/phi/kernels/funcs/small_gemm.h"
 
 #include "paddle/phi/core/dense_tensor.h"
 
@@ -356,7 +357,21 @@ void MatMulFunction(const Context& dev_ctx,
                       1LL,
                       std::multiplies<std::int64_t>());
   if (out_batch_size == 0) return;
-  if (x_batch_size == 1 && y_batch_size == 1) {
+  if (!trans_x && !flag && (x_batch_size == y_batch_size) &&
+      (x_batch_size == 1 || !is_broadcast_dims) &&
+      funcs::MatMulWithSmallGemm(dev_ctx,
+                                 x_data,
+                                 y_data,
+                                 M,
+                                 N,
+                                 K,
+                                 trans_y,
+                                 out_batch_size,
+                                 dev_ctx.template Alloc<T>(Out))) {
+    VLOG(3) << "MatMul's small gemm of " << out_batch_size
+            << " batches, M: " << M << ", N: " << N << ", K: " << K
+            << ", trans_y: " << trans_y;
+  } else if (x_batch_size == 1 && y_batch_size == 1) {
     VLOG(3) << "MatMul's case 8";
     blas.GEMM(trans_x ? CblasTrans : CblasNoTrans,
               trans_y ? CblasTrans : CblasNoTrans,
@@ -70,7 +70,8 @@ PD_REGISTER_KERNEL(add,
                    int,
                    int64_t,
                    complex64,
-                   complex128) {}
+                   complex128,
+                   phi::dtype::bfloat16) {}
 PD_REGISTER_KERNEL(subtract,
                    CPU,
                    ALL_LAYOUT,
@@ -92,7 +93,8 @@ PD_REGISTER_KERNEL(divide,
                    int,
                    int64_t,
                    complex64,
-                   complex128) {}
+                   complex128,
+                   phi::dtype::bfloat16) {}
 PD_REGISTER_KERNEL(multiply,
                    CPU,
                    ALL_LAYOUT,
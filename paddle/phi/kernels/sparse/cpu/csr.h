@@ -0,0 +1,245 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/kernels/empty_kernel.h"
+
+namespace phi {
+namespace sparse {
+
+// the work of one task of the row loops, in multiply-adds
+constexpr int64_t kCsrGrainSize = 32768;
+
+/**
+ * The rows of a 2-D CSR matrix, or of a batch of them for a 3-D
+ * SparseCsrTensor, as one list of rows: the entries of the row r of the
+ * matrix b are [offsets[b * rows + r], offsets[b * rows + r + 1]). The
+ * non_zero_crows of a SparseCsrTensor restart from 0 in every batch, the
+ * offsets here count from the first batch.
+ */
+struct CsrRows {
+  int64_t batch{1};
+  int64_t rows{0};
+  int64_t cols{0};
+  std::vector<int64_t> offsets;
+  const int64_t* col_index{nullptr};
+  // The entry j holds the value value_index[j] of the tensor, only set for
+  // a transposed matrix, whose entries are not in the order of the values.
+  std::vector<int64_t> value_index;
+  std::vector<int64_t> col_storage;
+
+  int64_t nnz() const { return offsets.back(); }
+
+  int64_t ValueAt(int64_t j) const {
+    return value_index.empty() ? j : value_index[j];
+  }
+
+  // the number of multiply-adds for a row of width n, to split the rows
+  int64_t GrainSize(int64_t n) const {
+    const int64_t total_rows = batch * rows;
+    const int64_t per_row =
+        std::max<int64_t>(1, (nnz() + total_rows - 1) / std::max<int64_t>(
+                                                              total_rows, 1)) *
+        std::max<int64_t>(n, 1);
+    return std::max<int64_t>(1, kCsrGrainSize / per_row);
+  }
+};
+
+inline CsrRows GetCsrRows(const SparseCsrTensor& x) {
+  const auto& dims = x.dims();
+  PADDLE_ENFORCE_EQ(
+      dims.size() == 2 || dims.size() == 3,
+      true,
+      phi::errors::InvalidArgument(
+          "SparseCsrTensor only support 2-D or 3-D matrix, but got %d-D.",
+          dims.size()));
+  CsrRows csr;
+  csr.batch = dims.size() == 2 ? 1 : dims[0];
+  csr.rows = dims[dims.size() - 2];
+  csr.cols = dims[dims.size() - 1];
+  csr.offsets.resize(csr.batch * csr.rows + 1, 0);
+  // an empty tensor has no crows
+  if (x.non_zero_crows().numel() == 0 || x.non_zero_cols().numel() == 0) {
+    return csr;
+  }
+  csr.col_index = x.non_zero_cols().data<int64_t>();
+  const int64_t* crows = x.non_zero_crows().data<int64_t>();
+  int64_t batch_offset = 0;
+  for (int64_t b = 0; b < csr.batch; ++b) {
+    const int64_t* batch_crows = crows + b * (csr.rows + 1);
+    for (int64_t r = 0; r < csr.rows; ++r) {
+      csr.offsets[b * csr.rows + r + 1] = batch_offset + batch_crows[r + 1];
+    }
+    batch_offset += batch_crows[csr.rows];
+  }
+  return csr;
+}
+
+// The rows of the transpose of x, by a counting sort of the entries by
+// column.
+inline CsrRows TransposeCsrRows(const CsrRows& x) {
+  CsrRows t;
+  t.batch = x.batch;
+  t.rows = x.cols;
+  t.cols = x.rows;
+  t.offsets.assign(t.batch * t.rows + 1, 0);
+  t.col_storage.resize(x.nnz());
+  t.value_index.resize(x.nnz());
+  for (int64_t b = 0; b < x.batch; ++b) {
+    for (int64_t j = x.offsets[b * x.rows]; j < x.offsets[(b + 1) * x.rows];
+         ++j) {
+      ++t.offsets[b * t.rows + x.col_index[j] + 1];
+    }
+  }
+  for (size_t i = 1; i < t.offsets.size(); ++i) {
+    t.offsets[i] += t.offsets[i - 1];
+  }
+  std::vector<int64_t> next(t.offsets.begin(), t.offsets.end() - 1);
+  for (int64_t b = 0; b < x.batch; ++b) {
+    for (int64_t r = 0; r < x.rows; ++r) {
+      for (int64_t j = x.offsets[b * x.rows + r];
+           j < x.offsets[b * x.rows + r + 1];
+           ++j) {
+        const int64_t pos = next[b * t.rows + x.col_index[j]]++;
+        t.col_storage[pos] = r;
+        t.value_index[pos] = x.ValueAt(j);
+      }
+    }
+  }
+  t.col_index = t.col_storage.data();
+  return t;
+}
+
+// [batch, rows, cols] of a 2-D or 3-D dense matrix
+inline std::vector<int64_t> GetMatrixDims(const DDim& dims) {
+  PADDLE_ENFORCE_EQ(
+      dims.size() == 2 || dims.size() == 3,
+      true,
+      phi::errors::InvalidArgument(
+          "The sparse matmul only support 2-D or 3-D matrix, but got %d-D.",
+          dims.size()));
+  if (dims.size() == 2) {
+    return {1, dims[0], dims[1]};
+  }
+  return {dims[0], dims[1], dims[2]};
+}
+
+inline DDim MakeMatrixDDim(int rank,
+                           int64_t batch,
+                           int64_t rows,
+                           int64_t cols) {
+  return rank == 2 ? make_ddim({rows, cols}) : make_ddim({batch, rows, cols});
+}
+
+template <typename T>
+inline void CsrAxpy(int64_t n, T a, const T* x, T* y) {
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] += a * x[i];
+  }
+}
+
+// a dot product with independent partial sums, which the compiler keeps in
+// vector registers
+template <typename T>
+inline T CsrDot(int64_t n, const T* x, const T* y) {
+  constexpr int kLanes = 8;
+  T partial[kLanes] = {0};
+  int64_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      partial[l] += x[i + l] * y[i + l];
+    }
+  }
+  T sum = 0;
+  for (; i < n; ++i) {
+    sum += x[i] * y[i];
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    sum += partial[l];
+  }
+  return sum;
+}
+
+// out[b] = a[b] * dense[b], where a[b] is [a.rows, a.cols], dense[b] is
+// [a.cols, n] and out[b] is [a.rows, n].
+template <typename T>
+void CsrMatmulDense(const CPUContext& dev_ctx,
+                    const CsrRows& a,
+                    const T* a_values,
+                    const T* dense,
+                    int64_t n,
+                    T* out) {
+  dev_ctx.ParallelFor(
+      0, a.batch * a.rows, a.GrainSize(n), [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const T* batch_dense = dense + row / a.rows * a.cols * n;
+          T* out_row = out + row * n;
+          std::fill(out_row, out_row + n, static_cast<T>(0));
+          for (int64_t j = a.offsets[row]; j < a.offsets[row + 1]; ++j) {
+            CsrAxpy(n,
+                    a_values[a.ValueAt(j)],
+                    batch_dense + a.col_index[j] * n,
+                    out_row);
+          }
+        }
+      });
+}
+
+// values[j] = dot(x[b, r, :], y_t[b, c, :]) for the entry j at (b, r, c) of
+// the pattern, x is [pattern.rows, k] and y_t is [pattern.cols, k] in every
+// batch.
+template <typename T>
+void DenseDotAtCsrPattern(const CPUContext& dev_ctx,
+                          const CsrRows& pattern,
+                          const T* x,
+                          const T* y_t,
+                          int64_t k,
+                          T* values) {
+  dev_ctx.ParallelFor(
+      0,
+      pattern.batch * pattern.rows,
+      pattern.GrainSize(k),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const T* x_row = x + row * k;
+          const T* batch_y_t = y_t + row / pattern.rows * pattern.cols * k;
+          for (int64_t j = pattern.offsets[row]; j < pattern.offsets[row + 1];
+               ++j) {
+            values[pattern.ValueAt(j)] =
+                CsrDot(k, x_row, batch_y_t + pattern.col_index[j] * k);
+          }
+        }
+      });
+}
+
+// out has the crows and cols of x, and uninitialized values.
+inline void EmptyLikeCsr(const CPUContext& dev_ctx,
+                         const SparseCsrTensor& x,
+                         SparseCsrTensor* out) {
+  const auto& x_values = x.non_zero_elements();
+  DenseTensor values = phi::Empty<CPUContext>(
+      dev_ctx,
+      DenseTensorMeta(x_values.dtype(), x_values.dims(), x_values.layout()));
+  out->SetMember(x.non_zero_crows(), x.non_zero_cols(), values, x.dims());
+}
+
+}  // namespace sparse
+}  // namespace phi
@@ -0,0 +1,132 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/sparse/csr_matmul_grad_kernel.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
+#include "paddle/phi/kernels/sparse/cpu/csr.h"
+
+namespace phi {
+namespace sparse {
+
+template <typename T, typename Context>
+void CsrDenseMatmulGradKernel(const Context& dev_ctx,
+                              const SparseCsrTensor& x,
+                              const DenseTensor& y,
+                              const DenseTensor& out_grad,
+                              SparseCsrTensor* x_grad,
+                              DenseTensor* y_grad) {
+  auto csr = GetCsrRows(x);
+  const int64_t n = GetMatrixDims(y.dims())[2];
+  const T* x_values =
+      csr.nnz() > 0 ? x.non_zero_elements().template data<T>() : nullptr;
+
+  // x_grad[m, k] = dot(out_grad[m, :], y[k, :])
+  if (x_grad) {
+    EmptyLikeCsr(dev_ctx, x, x_grad);
+    if (csr.nnz() > 0) {
+      DenseDotAtCsrPattern<T>(
+          dev_ctx,
+          csr,
+          out_grad.data<T>(),
+          y.data<T>(),
+          n,
+          x_grad->mutable_non_zero_elements()->template data<T>());
+    }
+  }
+
+  // y_grad = x^T * out_grad, by the rows of x^T so that the rows of y_grad
+  // are written by one thread each
+  if (y_grad) {
+    y_grad->Resize(y.dims());
+    T* y_grad_data = dev_ctx.template Alloc<T>(y_grad);
+    CsrMatmulDense<T>(dev_ctx,
+                      TransposeCsrRows(csr),
+                      x_values,
+                      out_grad.data<T>(),
+                      n,
+                      y_grad_data);
+  }
+}
+
+template <typename T, typename Context>
+void CsrMaskedMatmulGradKernel(const Context& dev_ctx,
+                               const DenseTensor& x,
+                               const DenseTensor& y,
+                               const SparseCsrTensor& out_grad,
+                               DenseTensor* x_grad,
+                               DenseTensor* y_grad) {
+  auto csr = GetCsrRows(out_grad);
+  const int64_t k = GetMatrixDims(x.dims())[2];
+  const T* out_grad_values =
+      csr.nnz() > 0 ? out_grad.non_zero_elements().template data<T>()
+                    : nullptr;
+
+  // x_grad = out_grad * y^T
+  if (x_grad) {
+    DenseTensor y_t = phi::Empty<Context>(
+        dev_ctx,
+        DenseTensorMeta(y.dtype(), {csr.batch, csr.cols, k}, y.layout()));
+    funcs::CpuTranspose(dev_ctx,
+                        y.data<T>(),
+                        y_t.data<T>(),
+                        make_ddim({csr.batch, k, csr.cols}),
+                        {0, 2, 1});
+    x_grad->Resize(x.dims());
+    T* x_grad_data = dev_ctx.template Alloc<T>(x_grad);
+    CsrMatmulDense<T>(
+        dev_ctx, csr, out_grad_values, y_t.data<T>(), k, x_grad_data);
+  }
+
+  // y_grad^T = out_grad^T * x
+  if (y_grad) {
+    DenseTensor y_grad_t = phi::Empty<Context>(
+        dev_ctx,
+        DenseTensorMeta(y.dtype(), {csr.batch, csr.cols, k}, y.layout()));
+    CsrMatmulDense<T>(dev_ctx,
+                      TransposeCsrRows(csr),
+                      out_grad_values,
+                      x.data<T>(),
+                      k,
+                      y_grad_t.data<T>());
+    y_grad->Resize(y.dims());
+    T* y_grad_data = dev_ctx.template Alloc<T>(y_grad);
+    funcs::CpuTranspose(dev_ctx,
+                        y_grad_t.data<T>(),
+                        y_grad_data,
+                        make_ddim({csr.batch, csr.cols, k}),
+                        {0, 2, 1});
+  }
+}
+
+}  // namespace sparse
+}  // namespace phi
+
+PD_REGISTER_KERNEL(csr_dense_matmul_grad,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::CsrDenseMatmulGradKernel,
+                   float,
+                   double) {
+  kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
+
+PD_REGISTER_KERNEL(csr_masked_matmul_grad,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::CsrMaskedMatmulGradKernel,
+                   float,
+                   double) {
+  kernel->InputAt(2).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
@@ -0,0 +1,119 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/sparse/csr_matmul_kernel.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
+#include "paddle/phi/kernels/sparse/cpu/csr.h"
+
+namespace phi {
+namespace sparse {
+
+template <typename T, typename Context>
+void CsrDenseMatmulKernel(const Context& dev_ctx,
+                          const SparseCsrTensor& x,
+                          const DenseTensor& y,
+                          DenseTensor* out) {
+  auto csr = GetCsrRows(x);
+  auto y_dims = GetMatrixDims(y.dims());
+  PADDLE_ENFORCE_EQ(y.dims().size(),
+                    x.dims().size(),
+                    phi::errors::InvalidArgument(
+                        "The rank of y (%d) should be equal to x (%d).",
+                        y.dims().size(),
+                        x.dims().size()));
+  PADDLE_ENFORCE_EQ(y_dims[0],
+                    csr.batch,
+                    phi::errors::InvalidArgument(
+                        "The batch of y (%d) should be equal to x (%d).",
+                        y_dims[0],
+                        csr.batch));
+  PADDLE_ENFORCE_EQ(
+      y_dims[1],
+      csr.cols,
+      phi::errors::InvalidArgument(
+          "The rows of y (%d) should be equal to the columns of x (%d).",
+          y_dims[1],
+          csr.cols));
+  const int64_t n = y_dims[2];
+  out->Resize(MakeMatrixDDim(x.dims().size(), csr.batch, csr.rows, n));
+  T* out_data = dev_ctx.template Alloc<T>(out);
+  const T* x_values =
+      csr.nnz() > 0 ? x.non_zero_elements().template data<T>() : nullptr;
+  CsrMatmulDense<T>(dev_ctx, csr, x_values, y.data<T>(), n, out_data);
+}
+
+template <typename T, typename Context>
+void CsrMaskedMatmulKernel(const Context& dev_ctx,
+                           const DenseTensor& x,
+                           const DenseTensor& y,
+                           const SparseCsrTensor& mask,
+                           SparseCsrTensor* out) {
+  auto csr = GetCsrRows(mask);
+  auto x_dims = GetMatrixDims(x.dims());
+  auto y_dims = GetMatrixDims(y.dims());
+  PADDLE_ENFORCE_EQ(
+      x_dims[0] == csr.batch && y_dims[0] == csr.batch &&
+          x_dims[1] == csr.rows && y_dims[2] == csr.cols &&
+          x_dims[2] == y_dims[1],
+      true,
+      phi::errors::InvalidArgument(
+          "The shapes of x %s and y %s do not match the mask %s.",
+          x.dims(),
+          y.dims(),
+          mask.dims()));
+  EmptyLikeCsr(dev_ctx, mask, out);
+  if (csr.nnz() == 0) {
+    return;
+  }
+
+  // the columns of y are taken as the rows of y^T, so that the dot products
+  // run over contiguous memory
+  const int64_t k = x_dims[2];
+  DenseTensor y_t = phi::Empty<Context>(
+      dev_ctx,
+      DenseTensorMeta(y.dtype(), {csr.batch, csr.cols, k}, y.layout()));
+  funcs::CpuTranspose(dev_ctx,
+                      y.data<T>(),
+                      y_t.data<T>(),
+                      make_ddim({csr.batch, k, csr.cols}),
+                      {0, 2, 1});
+  DenseDotAtCsrPattern<T>(dev_ctx,
+                          csr,
+                          x.data<T>(),
+                          y_t.data<T>(),
+                          k,
+                          out->mutable_non_zero_elements()->data<T>());
+}
+
+}  // namespace sparse
+}  // namespace phi
+
+PD_REGISTER_KERNEL(csr_dense_matmul,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::CsrDenseMatmulKernel,
+                   float,
+                   double) {
+  kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
+
+PD_REGISTER_KERNEL(csr_masked_matmul,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::CsrMaskedMatmulKernel,
+                   float,
+                   double) {
+  kernel->InputAt(2).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
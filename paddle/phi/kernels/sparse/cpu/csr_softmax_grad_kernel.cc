@@ -0,0 +1,68 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/sparse/csr_softmax_grad_kernel.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/sparse/cpu/csr.h"
+
+namespace phi {
+namespace sparse {
+
+// x_grad = out * (out_grad - sum(out * out_grad)) over every row
+template <typename T, typename Context>
+void CsrSoftmaxGradKernel(const Context& dev_ctx,
+                          const SparseCsrTensor& out,
+                          const SparseCsrTensor& out_grad,
+                          SparseCsrTensor* x_grad) {
+  auto csr = GetCsrRows(out);
+  PADDLE_ENFORCE_EQ(out_grad.non_zero_elements().numel(),
+                    csr.nnz(),
+                    phi::errors::InvalidArgument(
+                        "The out_grad should have the same non zero elements "
+                        "as out, but got %d and %d.",
+                        out_grad.non_zero_elements().numel(),
+                        csr.nnz()));
+  EmptyLikeCsr(dev_ctx, out, x_grad);
+  if (csr.nnz() == 0) {
+    return;
+  }
+  const T* out_values = out.non_zero_elements().data<T>();
+  const T* out_grad_values = out_grad.non_zero_elements().data<T>();
+  T* x_grad_values = x_grad->mutable_non_zero_elements()->data<T>();
+  auto run_rows = [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      const int64_t row_begin = csr.offsets[row];
+      const int64_t row_len = csr.offsets[row + 1] - row_begin;
+      const T dot = CsrDot(
+          row_len, out_values + row_begin, out_grad_values + row_begin);
+      for (int64_t j = row_begin; j < row_begin + row_len; ++j) {
+        x_grad_values[j] = out_values[j] * (out_grad_values[j] - dot);
+      }
+    }
+  };
+  dev_ctx.ParallelFor(0, csr.batch * csr.rows, csr.GrainSize(1), run_rows);
+}
+
+}  // namespace sparse
+}  // namespace phi
+
+PD_REGISTER_KERNEL(csr_softmax_grad,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::CsrSoftmaxGradKernel,
+                   float,
+                   double) {
+  kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+  kernel->InputAt(1).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
@@ -0,0 +1,70 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/sparse/csr_softmax_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/sparse/cpu/csr.h"
+
+namespace phi {
+namespace sparse {
+
+template <typename T, typename Context>
+void CsrSoftmaxKernel(const Context& dev_ctx,
+                      const SparseCsrTensor& x,
+                      SparseCsrTensor* out) {
+  auto csr = GetCsrRows(x);
+  EmptyLikeCsr(dev_ctx, x, out);
+  if (csr.nnz() == 0) {
+    return;
+  }
+  const T* x_values = x.non_zero_elements().data<T>();
+  T* out_values = out->mutable_non_zero_elements()->data<T>();
+  auto run_rows = [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      const int64_t row_begin = csr.offsets[row];
+      const int64_t row_end = csr.offsets[row + 1];
+      if (row_begin == row_end) {
+        continue;
+      }
+      T max_value = *std::max_element(x_values + row_begin,
+                                      x_values + row_end);
+      T sum = 0;
+      for (int64_t j = row_begin; j < row_end; ++j) {
+        out_values[j] = std::exp(x_values[j] - max_value);
+        sum += out_values[j];
+      }
+      const T scale = static_cast<T>(1) / sum;
+      for (int64_t j = row_begin; j < row_end; ++j) {
+        out_values[j] *= scale;
+      }
+    }
+  };
+  dev_ctx.ParallelFor(0, csr.batch * csr.rows, csr.GrainSize(1), run_rows);
+}
+
+}  // namespace sparse
+}  // namespace phi
+
+PD_REGISTER_KERNEL(csr_softmax,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::CsrSoftmaxKernel,
+                   float,
+                   double) {
+  kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
@@ -0,0 +1,49 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+
+namespace phi {
+namespace sparse {
+
+/**
+ * x_grad = out_grad * y^T at the non zero elements of x
+ * y_grad = x^T * out_grad
+ */
+template <typename T, typename Context>
+void CsrDenseMatmulGradKernel(const Context& dev_ctx,
+                              const SparseCsrTensor& x,
+                              const DenseTensor& y,
+                              const DenseTensor& out_grad,
+                              SparseCsrTensor* x_grad,
+                              DenseTensor* y_grad);
+
+/**
+ * out_grad has the crows and cols of mask
+ * x_grad = out_grad * y^T
+ * y_grad = x^T * out_grad
+ */
+template <typename T, typename Context>
+void CsrMaskedMatmulGradKernel(const Context& dev_ctx,
+                               const DenseTensor& x,
+                               const DenseTensor& y,
+                               const SparseCsrTensor& out_grad,
+                               DenseTensor* x_grad,
+                               DenseTensor* y_grad);
+
+}  // namespace sparse
+}  // namespace phi
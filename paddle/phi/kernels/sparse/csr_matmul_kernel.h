@@ -0,0 +1,75 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/kernels/empty_kernel.h"
+
+namespace phi {
+namespace sparse {
+
+/**
+ * SpMM, out = x * y
+ * x: (M, K) or (B, M, K), SparseCsrTensor
+ * y: (K, N) or (B, K, N)
+ * out: (M, N) or (B, M, N)
+ */
+template <typename T, typename Context>
+void CsrDenseMatmulKernel(const Context& dev_ctx,
+                          const SparseCsrTensor& x,
+                          const DenseTensor& y,
+                          DenseTensor* out);
+
+/**
+ * SDDMM, out = (x * y) at the non zero elements of mask
+ * x: (M, K) or (B, M, K)
+ * y: (K, N) or (B, K, N)
+ * mask: (M, N) or (B, M, N), SparseCsrTensor
+ * out: SparseCsrTensor of the crows and cols of mask
+ */
+template <typename T, typename Context>
+void CsrMaskedMatmulKernel(const Context& dev_ctx,
+                           const DenseTensor& x,
+                           const DenseTensor& y,
+                           const SparseCsrTensor& mask,
+                           SparseCsrTensor* out);
+
+template <typename T, typename Context>
+DenseTensor CsrDenseMatmul(const Context& dev_ctx,
+                           const SparseCsrTensor& x,
+                           const DenseTensor& y) {
+  DenseTensor dense_out = phi::Empty<Context>(
+      dev_ctx, DenseTensorMeta(y.dtype(), {1}, y.layout()));
+  CsrDenseMatmulKernel<T, Context>(dev_ctx, x, y, &dense_out);
+  return dense_out;
+}
+
+template <typename T, typename Context>
+SparseCsrTensor CsrMaskedMatmul(const Context& dev_ctx,
+                                const DenseTensor& x,
+                                const DenseTensor& y,
+                                const SparseCsrTensor& mask) {
+  DenseTensor non_zero_crows;
+  DenseTensor non_zero_cols;
+  DenseTensor non_zero_elements;
+  SparseCsrTensor csr(
+      non_zero_crows, non_zero_cols, non_zero_elements, mask.dims());
+  CsrMaskedMatmulKernel<T, Context>(dev_ctx, x, y, mask, &csr);
+  return csr;
+}
+
+}  // namespace sparse
+}  // namespace phi
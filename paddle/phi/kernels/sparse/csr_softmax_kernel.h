@@ -0,0 +1,46 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+
+namespace phi {
+namespace sparse {
+
+/**
+ * The softmax of every row of x over its non zero elements, the elements
+ * that are not stored are taken as -inf rather than 0.
+ * x: (M, N) or (B, M, N), SparseCsrTensor
+ * out: SparseCsrTensor of the crows and cols of x
+ */
+template <typename T, typename Context>
+void CsrSoftmaxKernel(const Context& dev_ctx,
+                      const SparseCsrTensor& x,
+                      SparseCsrTensor* out);
+
+template <typename T, typename Context>
+SparseCsrTensor CsrSoftmax(const Context& dev_ctx, const SparseCsrTensor& x) {
+  DenseTensor non_zero_crows;
+  DenseTensor non_zero_cols;
+  DenseTensor non_zero_elements;
+  SparseCsrTensor csr(
+      non_zero_crows, non_zero_cols, non_zero_elements, x.dims());
+  CsrSoftmaxKernel<T, Context>(dev_ctx, x, &csr);
+  return csr;
+}
+
+}  // namespace sparse
+}  // namespace phi
@@ -17,6 +17,7 @@ limitations under the License. */
 
 #include "paddle/phi/common/float16.h"
 #include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/kernel_context.h"
 #include "paddle/phi/core/kernel_factory.h"
 #include "paddle/phi/core/kernel_registry.h"
 
@@ -73,6 +74,103 @@ TEST(KernelRegistry, SetFP32Input) {
   EXPECT_EQ(output_defs.at(0).dtype, phi::DataType::FLOAT16);
 }
 
+TEST(KernelHandle, SelectKernel) {
+  const phi::KernelHandle handle("scale");
+  EXPECT_EQ(handle.kernel_name(), "scale");
+  for (auto dtype : {phi::DataType::FLOAT32,
+                     phi::DataType::FLOAT64,
+                     phi::DataType::INT32,
+                     phi::DataType::INT64,
+                     phi::DataType::INT8,
+                     phi::DataType::UINT8}) {
+    // twice, the second one is cached, except the keys beyond the cache
+    for (int i = 0; i < 2; ++i) {
+      for (auto layout : {phi::DataLayout::ALL_LAYOUT, phi::DataLayout::NCHW}) {
+        phi::KernelKey key(phi::Backend::CPU, layout, dtype);
+        const auto& expected =
+            phi::KernelFactory::Instance().SelectKernelOrThrowError("scale",
+                                                                    key);
+        EXPECT_EQ(&handle.SelectKernelOrThrowError(key), &expected);
+      }
+    }
+  }
+  EXPECT_THROW(handle.SelectKernelOrThrowError({phi::Backend::CPU,
+                                                phi::DataLayout::ALL_LAYOUT,
+                                                phi::DataType::COMPLEX128}),
+               phi::enforce::EnforceNotMet);
+  const phi::KernelHandle unknown("not_registered");
+  EXPECT_THROW(unknown.SelectKernelOrThrowError({phi::Backend::CPU,
+                                                 phi::DataLayout::ALL_LAYOUT,
+                                                 phi::DataType::FLOAT32}),
+               phi::enforce::EnforceNotMet);
+}
+
+TEST(KernelHandle, InvalidatedByFactoryChange) {
+  const phi::KernelHandle handle("scale");
+  phi::KernelKey key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  handle.SelectKernelOrThrowError(key);
+  auto version = phi::KernelFactory::Instance().version();
+  // inserting a kernel name may move the kernel maps
+  phi::KernelFactory::Instance().kernels()["kernel_handle_test"];
+  EXPECT_NE(phi::KernelFactory::Instance().version(), version);
+  EXPECT_EQ(&handle.SelectKernelOrThrowError(key),
+            &phi::KernelFactory::Instance().SelectKernelOrThrowError("scale",
+                                                                     key));
+  phi::KernelFactory::Instance().kernels().erase("kernel_handle_test");
+}
+
+void EmptyKernelFn(phi::KernelContext* ctx) {}
+
+TEST(KernelHandle, SeesReregistration) {
+  const std::string name = "kernel_handle_reregister";
+  phi::KernelKey key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  phi::KernelKey other_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT64);
+  // the variadic fns tell the registered kernels apart
+  int first_tag = 0, second_tag = 0;
+  auto& factory = phi::KernelFactory::Instance();
+  factory.kernels()[name][key] = phi::Kernel(EmptyKernelFn, &first_tag);
+
+  const phi::KernelHandle handle(name);
+  const auto& first = handle.SelectKernelOrThrowError(key);
+  EXPECT_EQ(&first, &factory.SelectKernelOrThrowError(name, key));
+  EXPECT_EQ(first.GetVariadicKernelFn<int*>(), &first_tag);
+  EXPECT_THROW(handle.SelectKernelOrThrowError(other_key),
+               phi::enforce::EnforceNotMet);
+
+  // the kernels registered after the handle selected one
+  factory.kernels()[name][key] = phi::Kernel(EmptyKernelFn, &second_tag);
+  factory.kernels()[name][other_key] = phi::Kernel(EmptyKernelFn, &first_tag);
+  const auto& second = handle.SelectKernelOrThrowError(key);
+  EXPECT_EQ(&second, &factory.SelectKernelOrThrowError(name, key));
+  EXPECT_EQ(second.GetVariadicKernelFn<int*>(), &second_tag);
+  const auto& other = handle.SelectKernelOrThrowError(other_key);
+  EXPECT_EQ(&other, &factory.SelectKernelOrThrowError(name, other_key));
+  EXPECT_EQ(other.GetVariadicKernelFn<int*>(), &first_tag);
+  factory.kernels().erase(name);
+}
+
+TEST(ScopedKernelContext, Reuse) {
+  phi::KernelContext* outer_ctx = nullptr;
+  {
+    phi::ScopedKernelContext ctx(nullptr);
+    ctx->EmplaceBackAttr(1);
+    outer_ctx = ctx.get();
+    {
+      // a nested call takes another context
+      phi::ScopedKernelContext nested(nullptr);
+      EXPECT_NE(nested.get(), outer_ctx);
+      EXPECT_EQ(nested->AttrsSize(), 0UL);
+    }
+  }
+  phi::ScopedKernelContext ctx(nullptr);
+  EXPECT_EQ(ctx.get(), outer_ctx);
+  EXPECT_EQ(ctx->AttrsSize(), 0UL);
+  EXPECT_EQ(ctx->InputsSize(), 0UL);
+}
+
 }  // namespace tests
 }  // namespace phi
 
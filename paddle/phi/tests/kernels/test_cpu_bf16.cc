@@ -0,0 +1,212 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/activation_kernel.h"
+#include "paddle/phi/kernels/funcs/cpu_bf16.h"
+#include "paddle/phi/kernels/math_kernel.h"
+#include "paddle/phi/kernels/matmul_kernel.h"
+#include "paddle/phi/kernels/reduce_kernel.h"
+#include "paddle/phi/kernels/softmax_kernel.h"
+
+namespace phi {
+namespace tests {
+
+using bfloat16 = phi::dtype::bfloat16;
+
+// the relative error of one truncation to bfloat16
+constexpr float kBf16Eps = 1.0f / 128;
+
+class CpuBf16Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    alloc_ = std::make_unique<paddle::experimental::DefaultAllocator>(
+        paddle::platform::CPUPlace());
+    dev_ctx_.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    dev_ctx_.Init();
+  }
+
+  // a bfloat16 tensor of values in [low, high) and the float tensor of the
+  // same values
+  std::pair<DenseTensor, DenseTensor> MakeTensors(
+      const std::vector<int64_t>& shape, float low, float high) {
+    DenseTensor bf(alloc_.get(),
+                   DenseTensorMeta(
+                       DataType::BFLOAT16, make_ddim(shape), DataLayout::NCHW));
+    DenseTensor fp(alloc_.get(),
+                   DenseTensorMeta(
+                       DataType::FLOAT32, make_ddim(shape), DataLayout::NCHW));
+    auto* bf_data = bf.mutable_data<bfloat16>(paddle::platform::CPUPlace());
+    auto* fp_data = fp.mutable_data<float>(paddle::platform::CPUPlace());
+    std::uniform_real_distribution<float> dist(low, high);
+    for (int64_t i = 0; i < bf.numel(); ++i) {
+      bf_data[i] = bfloat16(dist(rng_));
+      fp_data[i] = static_cast<float>(bf_data[i]);
+    }
+    return {std::move(bf), std::move(fp)};
+  }
+
+  DenseTensor Empty(DataType dtype) {
+    return DenseTensor(
+        alloc_.get(),
+        DenseTensorMeta(dtype, make_ddim({1}), DataLayout::NCHW));
+  }
+
+  std::unique_ptr<paddle::experimental::DefaultAllocator> alloc_;
+  CPUContext dev_ctx_;
+  std::mt19937 rng_{2022};
+};
+
+// out is within a bfloat16 rounding of the float result
+static void ExpectNearFloat(const DenseTensor& out,
+                            const DenseTensor& expected,
+                            float rel_tol,
+                            float abs_tol) {
+  ASSERT_EQ(out.numel(), expected.numel());
+  const auto* out_data = out.data<bfloat16>();
+  const auto* expected_data = expected.data<float>();
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    float e = expected_data[i];
+    ASSERT_NEAR(static_cast<float>(out_data[i]),
+                e,
+                std::abs(e) * rel_tol + abs_tol)
+        << "at " << i;
+  }
+}
+
+TEST_F(CpuBf16Test, conversion_matches_scalar) {
+  const int64_t n = 4099;
+  std::vector<float> x(n);
+  for (int64_t i = 0; i < n; ++i) {
+    uint32_t bits = rng_();
+    std::memcpy(&x[i], &bits, sizeof(bits));
+  }
+  const float specials[] = {0.0f,
+                            -0.0f,
+                            std::numeric_limits<float>::infinity(),
+                            -std::numeric_limits<float>::infinity(),
+                            std::numeric_limits<float>::quiet_NaN(),
+                            std::numeric_limits<float>::denorm_min(),
+                            65504.0f,
+                            1.0f / 3};
+  std::copy(std::begin(specials), std::end(specials), x.begin());
+
+  std::vector<bfloat16> bf(n);
+  std::vector<float> back(n);
+  for (int threads : {1, 4}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    funcs::CpuFloatToBf16(dev_ctx_, x.data(), bf.data(), n);
+    funcs::CpuBf16ToFloat(dev_ctx_, bf.data(), back.data(), n);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(bf[i].x, bfloat16(x[i]).x) << "at " << i;
+      float expected = static_cast<float>(bf[i]);
+      ASSERT_EQ(std::memcmp(&back[i], &expected, sizeof(float)), 0)
+          << "at " << i;
+    }
+  }
+}
+
+TEST_F(CpuBf16Test, matmul) {
+  for (auto trans : {std::make_pair(false, false),
+                     std::make_pair(true, false),
+                     std::make_pair(false, true)}) {
+    auto x = MakeTensors({65, 129}, -1.0f, 1.0f);
+    auto y = MakeTensors({129, 33}, -1.0f, 1.0f);
+    if (trans.first) {
+      x = MakeTensors({129, 65}, -1.0f, 1.0f);
+    }
+    if (trans.second) {
+      y = MakeTensors({33, 129}, -1.0f, 1.0f);
+    }
+    auto out = Empty(DataType::BFLOAT16);
+    auto expected = Empty(DataType::FLOAT32);
+    MatmulKernel<bfloat16>(
+        dev_ctx_, x.first, y.first, trans.first, trans.second, &out);
+    MatmulKernel<float>(
+        dev_ctx_, x.second, y.second, trans.first, trans.second, &expected);
+    // the inputs are the same, only the outputs are rounded
+    ExpectNearFloat(out, expected, kBf16Eps, 1e-5f);
+  }
+}
+
+TEST_F(CpuBf16Test, reduce) {
+  auto x = MakeTensors({37, 1000, 3}, 0.5f, 1.5f);
+  for (auto dims : {std::vector<int64_t>{1},
+                    std::vector<int64_t>{2},
+                    std::vector<int64_t>{0, 1, 2}}) {
+    auto out = Empty(DataType::BFLOAT16);
+    auto expected = Empty(DataType::FLOAT32);
+    SumRawKernel<bfloat16>(
+        dev_ctx_, x.first, dims, false, false, DataType::UNDEFINED, &out);
+    SumRawKernel<float>(
+        dev_ctx_, x.second, dims, false, false, DataType::UNDEFINED, &expected);
+    // a bfloat16 accumulator would stop growing at 256 after about 512 terms
+    ExpectNearFloat(out, expected, kBf16Eps, 1e-5f);
+
+    MeanRawKernel<bfloat16>(dev_ctx_, x.first, dims, false, false, &out);
+    MeanRawKernel<float>(dev_ctx_, x.second, dims, false, false, &expected);
+    ExpectNearFloat(out, expected, kBf16Eps, 1e-5f);
+
+    MaxRawKernel<bfloat16>(dev_ctx_, x.first, dims, false, false, &out);
+    MaxRawKernel<float>(dev_ctx_, x.second, dims, false, false, &expected);
+    ExpectNearFloat(out, expected, 0.0f, 0.0f);
+  }
+}
+
+TEST_F(CpuBf16Test, softmax) {
+  for (int axis : {-1, 1}) {
+    auto x = MakeTensors({16, 300, 5}, -8.0f, 8.0f);
+    auto out = Empty(DataType::BFLOAT16);
+    auto expected = Empty(DataType::FLOAT32);
+    SoftmaxKernel<bfloat16>(dev_ctx_, x.first, axis, &out);
+    SoftmaxKernel<float>(dev_ctx_, x.second, axis, &expected);
+    ExpectNearFloat(out, expected, 2 * kBf16Eps, 1e-6f);
+  }
+}
+
+TEST_F(CpuBf16Test, elementwise) {
+  auto x = MakeTensors({64, 513}, -4.0f, 4.0f);
+  auto y = MakeTensors({513}, -4.0f, 4.0f);
+  auto out = Empty(DataType::BFLOAT16);
+  auto expected = Empty(DataType::FLOAT32);
+
+  AddKernel<bfloat16>(dev_ctx_, x.first, y.first, &out);
+  AddKernel<float>(dev_ctx_, x.second, y.second, &expected);
+  ExpectNearFloat(out, expected, kBf16Eps, 0.0f);
+
+  ReluKernel<bfloat16>(dev_ctx_, x.first, &out);
+  ReluKernel<float>(dev_ctx_, x.second, &expected);
+  ExpectNearFloat(out, expected, 0.0f, 0.0f);
+
+  TanhKernel<bfloat16>(dev_ctx_, x.first, &out);
+  TanhKernel<float>(dev_ctx_, x.second, &expected);
+  ExpectNearFloat(out, expected, kBf16Eps, 1e-6f);
+}
+
+}  // namespace tests
+}  // namespace phi
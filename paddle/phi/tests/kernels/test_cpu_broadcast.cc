@@ -0,0 +1,133 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/elementwise_base.h"
+#include "paddle/phi/kernels/funcs/elementwise_functor.h"
+
+namespace phi {
+namespace tests {
+
+// The per element index computation used before the broadcast engine, kept
+// as the reference.
+void LegacyBroadcastAdd(const DenseTensor& x,
+                        const DenseTensor& y,
+                        int axis,
+                        DenseTensor* z) {
+  int max_dim = x.dims().size();
+  std::vector<int> x_dims_array(max_dim), y_dims_array(max_dim),
+      out_dims_array(max_dim), index_array(max_dim, 0);
+  funcs::GetBroadcastDimsArrays(x.dims(),
+                                y.dims(),
+                                x_dims_array.data(),
+                                y_dims_array.data(),
+                                out_dims_array.data(),
+                                max_dim,
+                                axis);
+  const float* x_data = x.data<float>();
+  const float* y_data = y.data<float>();
+  float* out_data = z->data<float>();
+  for (int64_t out_index = 0; out_index < z->numel(); ++out_index) {
+    int x_index = funcs::GetElementwiseIndex(
+        x_dims_array.data(), max_dim, index_array.data());
+    int y_index = funcs::GetElementwiseIndex(
+        y_dims_array.data(), max_dim, index_array.data());
+    out_data[out_index] = x_data[x_index] + y_data[y_index];
+    funcs::UpdateElementwiseIndexArray(
+        out_dims_array.data(), max_dim, index_array.data());
+  }
+}
+
+DenseTensor MakeTensor(Allocator* alloc,
+                       const std::vector<int64_t>& shape,
+                       bool fill) {
+  DenseTensor t(alloc,
+                DenseTensorMeta(
+                    DataType::FLOAT32, make_ddim(shape), DataLayout::NCHW));
+  auto* data = t.mutable_data<float>(paddle::platform::CPUPlace());
+  for (int64_t i = 0; fill && i < t.numel(); ++i) {
+    data[i] = static_cast<float>(i % 97) * 0.5f;
+  }
+  return t;
+}
+
+TEST(DEV_API, broadcast_add) {
+  const auto alloc = std::make_unique<paddle::experimental::DefaultAllocator>(
+      paddle::platform::CPUPlace());
+  CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.Init();
+
+  struct Case {
+    const char* name;
+    std::vector<int64_t> x_shape;
+    std::vector<int64_t> y_shape;
+    int axis;
+    std::vector<int64_t> out_shape;
+  };
+  std::vector<Case> cases = {
+      {"same shape", {64, 130}, {64, 130}, -1, {64, 130}},
+      {"scalar", {64, 130}, {1}, -1, {64, 130}},
+      {"row", {64, 130}, {130}, -1, {64, 130}},
+      {"column", {64, 130}, {64, 1}, -1, {64, 130}},
+      {"channel", {4, 16, 7, 7}, {16}, 1, {4, 16, 7, 7}},
+      {"general", {16, 1, 33}, {1, 16, 33}, -1, {16, 16, 33}}};
+  for (auto& c : cases) {
+    auto x = MakeTensor(alloc.get(), c.x_shape, true);
+    auto y = MakeTensor(alloc.get(), c.y_shape, true);
+    auto expected = MakeTensor(alloc.get(), c.out_shape, false);
+    auto out = MakeTensor(alloc.get(), c.out_shape, false);
+
+    int axis = c.axis == -1 ? x.dims().size() - y.dims().size() : c.axis;
+    LegacyBroadcastAdd(x, y, axis, &expected);
+    funcs::ElementwiseCompute<funcs::AddFunctor<float>, float>(
+        dev_ctx, x, y, c.axis, funcs::AddFunctor<float>(), &out);
+    for (int64_t i = 0; i < out.numel(); ++i) {
+      ASSERT_EQ(out.data<float>()[i], expected.data<float>()[i]) << c.name;
+    }
+  }
+}
+
+TEST(DEV_API, broadcast_inverse_functor) {
+  const auto alloc = std::make_unique<paddle::experimental::DefaultAllocator>(
+      paddle::platform::CPUPlace());
+  CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.Init();
+
+  // y has the larger rank, the functor takes y first
+  auto x = MakeTensor(alloc.get(), {8}, true);
+  auto y = MakeTensor(alloc.get(), {4, 8}, true);
+  auto out = MakeTensor(alloc.get(), {4, 8}, false);
+  funcs::ElementwiseCompute<funcs::InverseSubtractFunctor<float>, float>(
+      dev_ctx, x, y, -1, funcs::InverseSubtractFunctor<float>(), &out);
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    ASSERT_EQ(out.data<float>()[i],
+              x.data<float>()[i % 8] - y.data<float>()[i]);
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,198 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/cpu/graph_send_recv_funcs.h"
+#include "paddle/phi/kernels/graph_send_recv_grad_kernel.h"
+#include "paddle/phi/kernels/graph_send_recv_kernel.h"
+
+namespace phi {
+namespace tests {
+
+class CpuGraphSendRecvTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    alloc_ = std::make_unique<paddle::experimental::DefaultAllocator>(
+        paddle::platform::CPUPlace());
+    dev_ctx_.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    dev_ctx_.Init();
+  }
+
+  template <typename T>
+  DenseTensor MakeTensor(const std::vector<int64_t>& shape) {
+    DenseTensor t(alloc_.get(),
+                  DenseTensorMeta(paddle::experimental::CppTypeToDataType<
+                                      T>::Type(),
+                                  make_ddim(shape),
+                                  DataLayout::NCHW));
+    t.mutable_data<T>(paddle::platform::CPUPlace());
+    return t;
+  }
+
+  // the edges of a power-law graph: the sources are uniform, the
+  // destinations are skewed to the first rows
+  void MakeGraph(int64_t num_rows, int64_t num_edges) {
+    src_index_ = MakeTensor<int64_t>({num_edges});
+    dst_index_ = MakeTensor<int64_t>({num_edges});
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    for (int64_t i = 0; i < num_edges; ++i) {
+      double u = dist(rng_);
+      src_index_.data<int64_t>()[i] = rng_() % num_rows;
+      dst_index_.data<int64_t>()[i] = std::min<int64_t>(
+          num_rows - 1, static_cast<int64_t>(num_rows * u * u * u));
+    }
+  }
+
+  std::unique_ptr<paddle::experimental::DefaultAllocator> alloc_;
+  CPUContext dev_ctx_;
+  std::mt19937 rng_{2022};
+  DenseTensor src_index_;
+  DenseTensor dst_index_;
+};
+
+// the per-edge loops of the reference
+static void ReferenceForward(const std::vector<float>& x,
+                             const int64_t* src,
+                             const int64_t* dst,
+                             int64_t num_edges,
+                             int64_t width,
+                             const std::string& pool_type,
+                             std::vector<float>* out,
+                             std::vector<int>* count) {
+  std::fill(out->begin(), out->end(), 0.0f);
+  std::fill(count->begin(), count->end(), 0);
+  for (int64_t i = 0; i < num_edges; ++i) {
+    for (int64_t k = 0; k < width; ++k) {
+      float& o = (*out)[dst[i] * width + k];
+      float v = x[src[i] * width + k];
+      if (pool_type == "SUM" || pool_type == "MEAN" || (*count)[dst[i]] == 0) {
+        o += v;
+      } else if (pool_type == "MIN") {
+        o = std::min(o, v);
+      } else {
+        o = std::max(o, v);
+      }
+    }
+    ++(*count)[dst[i]];
+  }
+  if (pool_type == "MEAN") {
+    for (size_t r = 0; r < count->size(); ++r) {
+      for (int64_t k = 0; k < width && (*count)[r] > 0; ++k) {
+        (*out)[r * width + k] /= (*count)[r];
+      }
+    }
+  }
+}
+
+TEST_F(CpuGraphSendRecvTest, compare_with_reference) {
+  const int64_t num_rows = 301, width = 19, num_edges = 4000;
+  MakeGraph(num_rows, num_edges);
+  const int64_t* src = src_index_.data<int64_t>();
+  const int64_t* dst = dst_index_.data<int64_t>();
+  auto x = MakeTensor<float>({num_rows, width});
+  auto out_grad = MakeTensor<float>({num_rows, width});
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    // small integers, the sums are exact in any order
+    x.data<float>()[i] = static_cast<float>(static_cast<int>(rng_() % 21) - 10);
+    out_grad.data<float>()[i] = static_cast<float>(rng_() % 7);
+  }
+  std::vector<float> x_vec(x.data<float>(), x.data<float>() + x.numel());
+
+  for (int threads : {1, 4}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    for (std::string pool_type : {"SUM", "MEAN", "MIN", "MAX"}) {
+      auto out = MakeTensor<float>({num_rows, width});
+      auto dst_count = MakeTensor<int>({num_rows});
+      GraphSendRecvKernel<float>(
+          dev_ctx_, x, src_index_, dst_index_, pool_type, &out, &dst_count);
+
+      std::vector<float> expected(x.numel());
+      std::vector<int> count(num_rows);
+      ReferenceForward(
+          x_vec, src, dst, num_edges, width, pool_type, &expected, &count);
+      for (int64_t i = 0; i < out.numel(); ++i) {
+        ASSERT_FLOAT_EQ(out.data<float>()[i], expected[i]) << pool_type;
+      }
+      if (pool_type == "MEAN") {
+        for (int64_t r = 0; r < num_rows; ++r) {
+          ASSERT_EQ(dst_count.data<int>()[r], count[r]);
+        }
+      }
+
+      auto x_grad = MakeTensor<float>({num_rows, width});
+      GraphSendRecvGradKernel<float>(dev_ctx_,
+                                     out_grad,
+                                     x,
+                                     out,
+                                     src_index_,
+                                     dst_index_,
+                                     dst_count,
+                                     pool_type,
+                                     &x_grad);
+      std::vector<float> expected_grad(x.numel(), 0.0f);
+      for (int64_t i = 0; i < num_edges; ++i) {
+        for (int64_t k = 0; k < width; ++k) {
+          float g = out_grad.data<float>()[dst[i] * width + k];
+          if (pool_type == "MEAN") {
+            g /= count[dst[i]];
+          } else if (pool_type == "MIN" || pool_type == "MAX") {
+            g *= expected[dst[i] * width + k] == x_vec[src[i] * width + k];
+          }
+          expected_grad[src[i] * width + k] += g;
+        }
+      }
+      for (int64_t i = 0; i < x_grad.numel(); ++i) {
+        ASSERT_NEAR(x_grad.data<float>()[i], expected_grad[i], 1e-4f)
+            << pool_type;
+      }
+    }
+  }
+}
+
+TEST_F(CpuGraphSendRecvTest, segments_keep_edge_order) {
+  const int64_t num_rows = 50, num_edges = 200;
+  MakeGraph(num_rows, num_edges);
+  const int64_t* src = src_index_.data<int64_t>();
+  const int64_t* dst = dst_index_.data<int64_t>();
+  auto segments = BuildGraphSegments(dst, src, num_edges, num_rows, num_rows);
+  ASSERT_EQ(segments.num_segments(), num_rows);
+  for (int64_t s = 0; s < num_rows; ++s) {
+    std::vector<int64_t> members;
+    for (int64_t i = 0; i < num_edges; ++i) {
+      if (dst[i] == s) {
+        members.push_back(src[i]);
+      }
+    }
+    ASSERT_EQ(segments.Count(s), static_cast<int64_t>(members.size()));
+    EXPECT_TRUE(std::equal(members.begin(),
+                           members.end(),
+                           segments.members.begin() + segments.offsets[s]));
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
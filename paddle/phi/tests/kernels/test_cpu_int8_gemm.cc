@@ -0,0 +1,215 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/cpu_int8_gemm.h"
+
+namespace phi {
+namespace tests {
+
+using funcs::detail::CpuInt8Isa;
+
+class CpuInt8GemmTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dev_ctx_.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    dev_ctx_.Init();
+  }
+
+  // the instruction sets supported by this machine
+  std::vector<CpuInt8Isa> Isas() const {
+    std::vector<CpuInt8Isa> isas;
+    for (auto isa :
+         {CpuInt8Isa::kScalar, CpuInt8Isa::kAvx2, CpuInt8Isa::kAvx512Vnni}) {
+      if (isa <= funcs::detail::GetCpuInt8Isa()) {
+        isas.push_back(isa);
+      }
+    }
+    return isas;
+  }
+
+  std::vector<float> Random(int64_t n, float low, float high) {
+    std::vector<float> x(n);
+    std::uniform_real_distribution<float> dist(low, high);
+    for (auto& v : x) {
+      v = dist(rng_);
+    }
+    return x;
+  }
+
+  CPUContext dev_ctx_;
+  std::mt19937 rng_{2022};
+};
+
+// The quantized fully connected layer as fusion_int8_fc computes it, w is
+// per channel quantized with the scales of its columns.
+struct Int8FC {
+  Int8FC(const std::vector<float>& w, int64_t k, int64_t n) : k(k), n(n) {
+    std::vector<int8_t> qw(k * n);
+    scale.assign(n, 0.0f);
+    for (int64_t i = 0; i < k * n; ++i) {
+      scale[i % n] = std::max(scale[i % n], std::abs(w[i]) / 127);
+    }
+    for (int64_t i = 0; i < k * n; ++i) {
+      qw[i] = static_cast<int8_t>(std::nearbyint(w[i] / scale[i % n]));
+    }
+    packed.resize(funcs::CpuInt8PackedSize(k, n));
+    col_sum.resize(n);
+    funcs::CpuInt8PackWeight(
+        qw.data(), k, n, false, packed.data(), col_sum.data());
+  }
+
+  void Run(const CPUContext& ctx,
+           const float* x,
+           int64_t m,
+           float input_scale,
+           float* out) {
+    const int64_t padded_k = funcs::CpuInt8PaddedK(k);
+    a.assign(m * padded_k, static_cast<uint8_t>(funcs::kCpuInt8Shift));
+    c.resize(m * n);
+    std::vector<float> out_scale(n);
+    for (int64_t j = 0; j < n; ++j) {
+      out_scale[j] = input_scale * scale[j];
+    }
+    for (int64_t i = 0; i < m; ++i) {
+      funcs::CpuInt8Quantize(x + i * k, k, input_scale, &a[i * padded_k]);
+    }
+    funcs::CpuInt8Gemm(
+        ctx, a.data(), padded_k, packed.data(), m, n, k, c.data(), n);
+    for (int64_t i = 0; i < m; ++i) {
+      funcs::CpuInt8DequantizeRow(&c[i * n],
+                                  col_sum.data(),
+                                  out_scale.data(),
+                                  nullptr,
+                                  n,
+                                  false,
+                                  out + i * n);
+    }
+  }
+
+  int64_t k;
+  int64_t n;
+  std::vector<float> scale;
+  std::vector<int8_t> packed;
+  std::vector<int32_t> col_sum;
+  std::vector<uint8_t> a;
+  std::vector<int32_t> c;
+};
+
+TEST_F(CpuInt8GemmTest, exact_for_every_isa) {
+  const int64_t shapes[][3] = {{1, 1, 1},
+                               {3, 5, 7},
+                               {5, 17, 9},
+                               {67, 33, 130},
+                               {130, 100, 259},
+                               {1, 1000, 1023},
+                               {200, 3, 3}};
+  for (auto& shape : shapes) {
+    for (bool trans : {false, true}) {
+      const int64_t m = shape[0], n = shape[1], k = shape[2];
+      const int64_t padded_k = funcs::CpuInt8PaddedK(k);
+      std::vector<uint8_t> a(m * padded_k);
+      std::vector<int8_t> w(k * n);
+      for (auto& v : a) {
+        v = static_cast<uint8_t>(rng_() % 256);
+      }
+      for (auto& v : w) {
+        v = static_cast<int8_t>(static_cast<int>(rng_() % 255) - 127);
+      }
+      std::vector<int8_t> packed(funcs::CpuInt8PackedSize(k, n));
+      std::vector<int32_t> col_sum(n);
+      funcs::CpuInt8PackWeight(
+          w.data(), k, n, trans, packed.data(), col_sum.data());
+
+      std::vector<int32_t> expected(m * n);
+      for (int64_t j = 0; j < n; ++j) {
+        int32_t sum = 0;
+        for (int64_t t = 0; t < k; ++t) {
+          sum += trans ? w[j * k + t] : w[t * n + j];
+        }
+        ASSERT_EQ(col_sum[j], sum);
+        for (int64_t i = 0; i < m; ++i) {
+          int32_t acc = 0;
+          for (int64_t t = 0; t < k; ++t) {
+            acc += a[i * padded_k + t] * (trans ? w[j * k + t] : w[t * n + j]);
+          }
+          expected[i * n + j] = acc;
+        }
+      }
+
+      // the last column of the ldc is not written
+      const int64_t ldc = n + 1;
+      for (auto isa : Isas()) {
+        for (int threads : {1, 4}) {
+          dev_ctx_.SetIntraOpThreads(threads);
+          std::vector<int32_t> c(m * ldc, -1);
+          funcs::CpuInt8Gemm(dev_ctx_,
+                             a.data(),
+                             padded_k,
+                             packed.data(),
+                             m,
+                             n,
+                             k,
+                             c.data(),
+                             ldc,
+                             isa);
+          for (int64_t i = 0; i < m; ++i) {
+            for (int64_t j = 0; j < n; ++j) {
+              ASSERT_EQ(c[i * ldc + j], expected[i * n + j])
+                  << "isa " << static_cast<int>(isa) << " at " << i << ", "
+                  << j;
+            }
+            ASSERT_EQ(c[i * ldc + n], -1);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(CpuInt8GemmTest, fc_close_to_float) {
+  const int64_t m = 64, k = 256, n = 96;
+  auto x = Random(m * k, -1.0f, 1.0f);
+  auto w = Random(k * n, -0.2f, 0.2f);
+  Int8FC fc(w, k, n);
+  std::vector<float> out(m * n);
+  fc.Run(dev_ctx_, x.data(), m, 1.0f / 127, out.data());
+
+  double err = 0.0, norm = 0.0;
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      double acc = 0.0;
+      for (int64_t t = 0; t < k; ++t) {
+        acc += static_cast<double>(x[i * k + t]) * w[t * n + j];
+      }
+      err += (out[i * n + j] - acc) * (out[i * n + j] - acc);
+      norm += acc * acc;
+    }
+  }
+  // two roundings to 8 bits keep about 1% of the output norm
+  EXPECT_LT(std::sqrt(err / norm), 0.02);
+}
+
+}  // namespace tests
+}  // namespace phi
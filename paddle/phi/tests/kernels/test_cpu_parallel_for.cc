@@ -0,0 +1,147 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/cast_kernel.h"
+#include "paddle/phi/kernels/concat_kernel.h"
+#include "paddle/phi/kernels/reduce_kernel.h"
+#include "paddle/phi/kernels/softmax_kernel.h"
+
+namespace phi {
+namespace tests {
+
+class CpuParallelForTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    alloc_ = std::make_unique<paddle::experimental::DefaultAllocator>(
+        paddle::platform::CPUPlace());
+    dev_ctx_.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    dev_ctx_.Init();
+  }
+
+  DenseTensor MakeTensor(const std::vector<int64_t>& shape,
+                         DataType dtype = DataType::FLOAT32) {
+    DenseTensor t(alloc_.get(),
+                  DenseTensorMeta(dtype, make_ddim(shape), DataLayout::NCHW));
+    if (dtype == DataType::FLOAT32) {
+      auto* data = t.mutable_data<float>(paddle::platform::CPUPlace());
+      for (int64_t i = 0; i < t.numel(); ++i) {
+        data[i] = static_cast<float>(i % 89) * 0.25f;
+      }
+    }
+    return t;
+  }
+
+  std::unique_ptr<paddle::experimental::DefaultAllocator> alloc_;
+  CPUContext dev_ctx_;
+};
+
+TEST_F(CpuParallelForTest, covers_range_once) {
+  for (int threads : {1, 2, 3, 8}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    EXPECT_EQ(dev_ctx_.GetIntraOpThreads(), threads);
+    for (int64_t grain : {1, 7, 1000}) {
+      std::vector<std::atomic<int>> hits(10007);
+      dev_ctx_.ParallelFor(3, 10007, grain, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          ++hits[i];
+        }
+      });
+      for (int64_t i = 0; i < 10007; ++i) {
+        ASSERT_EQ(hits[i].load(), i < 3 ? 0 : 1) << threads << " " << grain;
+      }
+    }
+  }
+}
+
+TEST_F(CpuParallelForTest, nested_runs_inline) {
+  dev_ctx_.SetIntraOpThreads(4);
+  std::atomic<int64_t> sum{0};
+  dev_ctx_.ParallelFor(0, 64, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      // the inner loop is not split
+      dev_ctx_.ParallelFor(0, 100, 1, [&](int64_t inner, int64_t inner_end) {
+        EXPECT_EQ(inner, 0);
+        EXPECT_EQ(inner_end, 100);
+        sum += inner_end - inner;
+      });
+    }
+  });
+  EXPECT_EQ(sum.load(), 6400);
+}
+
+TEST_F(CpuParallelForTest, rethrows_exception) {
+  dev_ctx_.SetIntraOpThreads(4);
+  EXPECT_THROW(dev_ctx_.ParallelFor(0,
+                                    1000,
+                                    1,
+                                    [](int64_t begin, int64_t end) {
+                                      if (begin == 0) {
+                                        throw std::runtime_error("chunk 0");
+                                      }
+                                    }),
+               std::runtime_error);
+  // the pool is usable after a failed job
+  std::atomic<int64_t> count{0};
+  dev_ctx_.ParallelFor(
+      0, 1000, 1, [&](int64_t begin, int64_t end) { count += end - begin; });
+  EXPECT_EQ(count.load(), 1000);
+}
+
+TEST_F(CpuParallelForTest, results_independent_of_threads) {
+  auto x = MakeTensor({257, 129});
+  std::vector<DenseTensor> outs[2];
+  for (int threads : {1, 4}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    auto cast_out = MakeTensor({257, 129}, DataType::FLOAT64);
+    auto softmax_out = MakeTensor({257, 129});
+    auto concat_out = MakeTensor({514, 129});
+    auto sum_out = MakeTensor({257});
+    CastKernel<float>(dev_ctx_, x, DataType::FLOAT64, &cast_out);
+    SoftmaxKernel<float>(dev_ctx_, x, -1, &softmax_out);
+    ConcatKernel<float>(dev_ctx_, {&x, &x}, 0, &concat_out);
+    SumRawKernel<float>(
+        dev_ctx_, x, {1}, false, false, DataType::FLOAT32, &sum_out);
+    outs[threads > 1] = {cast_out, softmax_out, concat_out, sum_out};
+  }
+  for (size_t k = 0; k < outs[0].size(); ++k) {
+    auto& expected = outs[0][k];
+    auto& out = outs[1][k];
+    ASSERT_EQ(out.dims(), expected.dims());
+    if (out.dtype() == DataType::FLOAT64) {
+      for (int64_t i = 0; i < out.numel(); ++i) {
+        ASSERT_EQ(out.data<double>()[i], expected.data<double>()[i]);
+      }
+    } else {
+      for (int64_t i = 0; i < out.numel(); ++i) {
+        ASSERT_EQ(out.data<float>()[i], expected.data<float>()[i]) << k;
+      }
+    }
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,283 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/cpu/reduce.h"
+#include "paddle/phi/kernels/funcs/cpu_reduce.h"
+
+namespace phi {
+namespace tests {
+
+DenseTensor MakeInput(Allocator* alloc,
+                      const std::vector<int64_t>& shape,
+                      float low = -1.f,
+                      float high = 1.f) {
+  DenseTensor x(alloc,
+                DenseTensorMeta(
+                    DataType::FLOAT32, make_ddim(shape), DataLayout::NCHW));
+  auto* data = x.mutable_data<float>(paddle::platform::CPUPlace());
+  std::mt19937 rng(2022);
+  std::uniform_real_distribution<float> dist(low, high);
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    data[i] = dist(rng);
+  }
+  return x;
+}
+
+// all elements are value except num_flips random ones
+DenseTensor MakeBoolInput(Allocator* alloc,
+                          const std::vector<int64_t>& shape,
+                          bool value,
+                          int64_t num_flips) {
+  DenseTensor x(
+      alloc,
+      DenseTensorMeta(DataType::BOOL, make_ddim(shape), DataLayout::NCHW));
+  auto* data = x.mutable_data<bool>(paddle::platform::CPUPlace());
+  std::fill(data, data + x.numel(), value);
+  std::mt19937 rng(2022);
+  std::uniform_int_distribution<int64_t> dist(0, x.numel() - 1);
+  for (int64_t i = 0; i < num_flips; ++i) {
+    data[dist(rng)] = !value;
+  }
+  return x;
+}
+
+DenseTensor MakeOutput(Allocator* alloc,
+                       const DenseTensor& x,
+                       const std::vector<int64_t>& dims) {
+  auto out_shape = vectorize(x.dims());
+  for (auto dim : dims) {
+    out_shape[dim] = 1;
+  }
+  return DenseTensor(
+      alloc,
+      DenseTensorMeta(x.dtype(), make_ddim(out_shape), DataLayout::NCHW));
+}
+
+// a plain loop over the input, for the ranks and types the Eigen path of
+// this test does not cover
+template <typename T, typename Op>
+std::vector<T> NaiveReduce(const T* x,
+                           const std::vector<int64_t>& shape,
+                           const std::vector<int64_t>& dims,
+                           T init,
+                           Op op) {
+  int rank = shape.size();
+  std::vector<bool> reduced(rank, false);
+  for (auto dim : dims) {
+    reduced[dim] = true;
+  }
+  int64_t numel = 1, out_numel = 1;
+  for (int i = 0; i < rank; ++i) {
+    numel *= shape[i];
+    out_numel *= reduced[i] ? 1 : shape[i];
+  }
+  std::vector<T> out(out_numel, init);
+  for (int64_t i = 0; i < numel; ++i) {
+    int64_t rest = i, out_index = 0, out_stride = 1;
+    for (int d = rank - 1; d >= 0; --d) {
+      int64_t index = rest % shape[d];
+      rest /= shape[d];
+      if (!reduced[d]) {
+        out_index += index * out_stride;
+        out_stride *= shape[d];
+      }
+    }
+    out[out_index] = op(out[out_index], x[i]);
+  }
+  return out;
+}
+
+template <typename Functor, typename T, typename Op>
+void CompareWithNaive(const CPUContext& dev_ctx,
+                      const DenseTensor& x,
+                      const std::vector<int64_t>& dims,
+                      T init,
+                      Op op,
+                      DenseTensor* out) {
+  dev_ctx.Alloc<T>(out);
+  auto expected =
+      NaiveReduce<T>(x.data<T>(), vectorize(x.dims()), dims, init, op);
+  ASSERT_TRUE((funcs::CpuReduceIfSupported<Functor, T>(
+      dev_ctx, x.data<T>(), out->data<T>(), x.dims(), dims, false)));
+  ASSERT_EQ(out->numel(), static_cast<int64_t>(expected.size()));
+  for (int64_t i = 0; i < out->numel(); ++i) {
+    double value = static_cast<double>(out->data<T>()[i]);
+    double expected_value = static_cast<double>(expected[i]);
+    ASSERT_NEAR(
+        value, expected_value, 1e-3 * std::max(1.0, std::abs(expected_value)));
+  }
+}
+
+// the Eigen path of ReduceKernelImpl, for ranks up to 3
+template <typename Functor>
+void EigenReduce(const CPUContext& dev_ctx,
+                 const DenseTensor& x,
+                 const std::vector<int64_t>& dims,
+                 DenseTensor* out) {
+  int ndim = x.dims().size();
+  int rdim = dims.size();
+  if (ndim == rdim) {
+    auto x_flat = EigenVector<float>::Flatten(x);
+    auto out_scalar = EigenScalar<float>::From(*out);
+    auto reduce_dim = Eigen::array<int, 1>({{0}});
+    Functor()(*dev_ctx.eigen_device(), &x_flat, &out_scalar, reduce_dim);
+  } else if (ndim == 2) {
+    ReduceFunctor<CPUContext, float, 2, 1, Functor>(
+        dev_ctx, x, out, dims, true);
+  } else if (ndim == 3 && rdim == 1) {
+    ReduceFunctor<CPUContext, float, 3, 1, Functor>(
+        dev_ctx, x, out, dims, true);
+  } else {
+    ReduceFunctor<CPUContext, float, 3, 2, Functor>(
+        dev_ctx, x, out, dims, true);
+  }
+}
+
+template <typename Functor>
+void CompareWithEigen(const CPUContext& dev_ctx,
+                      const DenseTensor& x,
+                      const std::vector<int64_t>& dims,
+                      DenseTensor* expected,
+                      DenseTensor* out) {
+  dev_ctx.Alloc<float>(expected);
+  dev_ctx.Alloc<float>(out);
+  EigenReduce<Functor>(dev_ctx, x, dims, expected);
+  ASSERT_TRUE((funcs::CpuReduceIfSupported<Functor, float>(
+      dev_ctx, x.data<float>(), out->data<float>(), x.dims(), dims, false)));
+  for (int64_t i = 0; i < out->numel(); ++i) {
+    ASSERT_NEAR(out->data<float>()[i],
+                expected->data<float>()[i],
+                1e-3 * std::max(1.f, std::abs(expected->data<float>()[i])));
+  }
+}
+
+TEST(DEV_API, cpu_reduce) {
+  const auto alloc = std::make_unique<paddle::experimental::DefaultAllocator>(
+      paddle::platform::CPUPlace());
+  CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.Init();
+
+  struct Case {
+    std::vector<int64_t> shape;
+    std::vector<int64_t> dims;
+  };
+  std::vector<Case> cases = {{{37, 1000}, {1}},
+                             {{37, 1000}, {0}},
+                             {{16, 30, 70}, {1}},
+                             {{16, 30, 70}, {0, 2}},
+                             {{16, 30, 70}, {0, 1, 2}},
+                             {{1, 4096, 3}, {1}}};
+  for (auto& c : cases) {
+    auto x = MakeInput(alloc.get(), c.shape);
+    auto expected = MakeOutput(alloc.get(), x, c.dims);
+    auto out = MakeOutput(alloc.get(), x, c.dims);
+    CompareWithEigen<funcs::SumFunctor>(dev_ctx, x, c.dims, &expected, &out);
+    CompareWithEigen<funcs::MeanFunctor>(dev_ctx, x, c.dims, &expected, &out);
+    CompareWithEigen<funcs::MaxFunctor>(dev_ctx, x, c.dims, &expected, &out);
+    CompareWithEigen<funcs::MinFunctor>(dev_ctx, x, c.dims, &expected, &out);
+  }
+}
+
+TEST(DEV_API, cpu_reduce_prod_and_high_rank) {
+  const auto alloc = std::make_unique<paddle::experimental::DefaultAllocator>(
+      paddle::platform::CPUPlace());
+  CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.Init();
+
+  struct Case {
+    std::vector<int64_t> shape;
+    std::vector<int64_t> dims;
+  };
+  // the reduced dims of the rank 4+ cases are not adjacent
+  std::vector<Case> cases = {{{37, 1000}, {1}},
+                             {{16, 30, 70}, {0, 2}},
+                             {{6, 7, 8, 9}, {0, 2}},
+                             {{6, 7, 8, 9}, {1, 3}},
+                             {{5, 4, 6, 3, 8}, {0, 2, 4}},
+                             {{5, 4, 6, 3, 8}, {1, 3}},
+                             {{2, 3, 1, 4, 5, 6}, {0, 3, 5}}};
+  for (auto& c : cases) {
+    // close to 1, so that the products neither vanish nor overflow
+    auto x = MakeInput(alloc.get(), c.shape, 0.9f, 1.1f);
+    auto out = MakeOutput(alloc.get(), x, c.dims);
+    CompareWithNaive<funcs::ProdFunctor>(
+        dev_ctx, x, c.dims, 1.f, std::multiplies<float>(), &out);
+    CompareWithNaive<funcs::SumFunctor>(
+        dev_ctx, x, c.dims, 0.f, std::plus<float>(), &out);
+    CompareWithNaive<funcs::MaxFunctor>(
+        dev_ctx,
+        x,
+        c.dims,
+        -std::numeric_limits<float>::infinity(),
+        [](float a, float b) { return std::max(a, b); },
+        &out);
+  }
+}
+
+TEST(DEV_API, cpu_reduce_any_all) {
+  const auto alloc = std::make_unique<paddle::experimental::DefaultAllocator>(
+      paddle::platform::CPUPlace());
+  CPUContext dev_ctx;
+  dev_ctx.SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                           .GetAllocator(paddle::platform::CPUPlace())
+                           .get());
+  dev_ctx.Init();
+
+  struct Case {
+    std::vector<int64_t> shape;
+    std::vector<int64_t> dims;
+  };
+  std::vector<Case> cases = {{{37, 1000}, {1}},
+                             {{37, 1000}, {0}},
+                             {{16, 30, 70}, {0, 2}},
+                             {{16, 30, 70}, {0, 1, 2}},
+                             {{6, 7, 8, 9}, {1, 3}},
+                             {{5, 4, 6, 3, 8}, {0, 2, 4}}};
+  for (auto& c : cases) {
+    int64_t numel = 1;
+    for (auto dim : c.shape) {
+      numel *= dim;
+    }
+    // a few flipped elements, so that some outputs differ from the others
+    auto all_false = MakeBoolInput(alloc.get(), c.shape, false, numel / 500);
+    auto out = MakeOutput(alloc.get(), all_false, c.dims);
+    CompareWithNaive<funcs::AnyFunctor>(
+        dev_ctx, all_false, c.dims, false, std::logical_or<bool>(), &out);
+    auto all_true = MakeBoolInput(alloc.get(), c.shape, true, numel / 500);
+    CompareWithNaive<funcs::AllFunctor>(
+        dev_ctx, all_true, c.dims, true, std::logical_and<bool>(), &out);
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,212 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/argsort_kernel.h"
+#include "paddle/phi/kernels/funcs/cpu_sort.h"
+#include "paddle/phi/kernels/top_k_kernel.h"
+
+namespace phi {
+namespace tests {
+
+class CpuSortTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    alloc_ = std::make_unique<paddle::experimental::DefaultAllocator>(
+        paddle::platform::CPUPlace());
+    dev_ctx_.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    dev_ctx_.Init();
+  }
+
+  template <typename T>
+  DenseTensor MakeTensor(const std::vector<int64_t>& shape) {
+    DenseTensor t(alloc_.get(),
+                  DenseTensorMeta(paddle::experimental::CppTypeToDataType<
+                                      T>::Type(),
+                                  make_ddim(shape),
+                                  DataLayout::NCHW));
+    t.mutable_data<T>(paddle::platform::CPUPlace());
+    return t;
+  }
+
+  // values from a small range when ties, NaN in a few places for floats
+  template <typename T>
+  std::vector<T> MakeValues(int64_t n, bool ties) {
+    std::vector<T> x(n);
+    for (auto& v : x) {
+      v = ties ? static_cast<T>(static_cast<int>(rng_() % 7) - 3)
+               : static_cast<T>(static_cast<int64_t>(rng_() % 2000001) -
+                                1000000);
+    }
+    if (std::is_floating_point<T>::value) {
+      for (int64_t i = 0; i < n / 50; ++i) {
+        x[rng_() % n] = std::numeric_limits<T>::quiet_NaN();
+      }
+      x[0] = static_cast<T>(-0.0);
+      x[n - 1] = static_cast<T>(0.0);
+    }
+    return x;
+  }
+
+  std::unique_ptr<paddle::experimental::DefaultAllocator> alloc_;
+  CPUContext dev_ctx_;
+  std::mt19937 rng_{2022};
+};
+
+template <typename T>
+static bool IsNan(T v) {
+  return v != v;
+}
+
+// the indices of a row in the output order: NaN is the largest value and
+// equal values keep their order
+template <typename T>
+static std::vector<int64_t> ReferenceOrder(const T* x,
+                                           int64_t n,
+                                           bool descending) {
+  auto less = [](T a, T b) { return !IsNan(a) && (IsNan(b) || a < b); };
+  std::vector<int64_t> order(n);
+  for (int64_t i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return descending ? less(x[b], x[a]) : less(x[a], x[b]);
+  });
+  return order;
+}
+
+template <typename T>
+static void CheckRows(const CPUContext& dev_ctx,
+                      const std::vector<T>& x,
+                      int64_t rows,
+                      int64_t n,
+                      int64_t k) {
+  for (bool descending : {true, false}) {
+    std::vector<T> top(rows * k), sorted(rows * n);
+    std::vector<int64_t> top_index(rows * k), sorted_index(rows * n);
+    funcs::CpuTopK(dev_ctx,
+                   x.data(),
+                   rows,
+                   n,
+                   k,
+                   descending,
+                   true,
+                   top.data(),
+                   top_index.data());
+    funcs::CpuArgsort(dev_ctx,
+                      x.data(),
+                      rows,
+                      n,
+                      descending,
+                      sorted.data(),
+                      sorted_index.data());
+    for (int64_t r = 0; r < rows; ++r) {
+      const T* row = x.data() + r * n;
+      auto order = ReferenceOrder(row, n, descending);
+      for (int64_t j = 0; j < k; ++j) {
+        ASSERT_EQ(top_index[r * k + j], order[j]) << "top-k of row " << r;
+        T v = top[r * k + j];
+        ASSERT_TRUE(v == row[order[j]] || (IsNan(v) && IsNan(row[order[j]])));
+      }
+      for (int64_t j = 0; j < n; ++j) {
+        ASSERT_EQ(sorted_index[r * n + j], order[j]) << "argsort of row " << r;
+      }
+    }
+
+    // the unsorted top-k holds the same values in any order
+    funcs::CpuTopK(dev_ctx,
+                   x.data(),
+                   rows,
+                   n,
+                   k,
+                   descending,
+                   false,
+                   top.data(),
+                   top_index.data());
+    for (int64_t r = 0; r < rows; ++r) {
+      auto order = ReferenceOrder(x.data() + r * n, n, descending);
+      std::vector<int64_t> expected(order.begin(), order.begin() + k);
+      std::vector<int64_t> got(top_index.begin() + r * k,
+                               top_index.begin() + (r + 1) * k);
+      std::sort(expected.begin(), expected.end());
+      std::sort(got.begin(), got.end());
+      ASSERT_EQ(got, expected) << "unsorted top-k of row " << r;
+    }
+  }
+}
+
+TEST_F(CpuSortTest, compare_with_reference) {
+  for (int threads : {1, 4}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    for (bool ties : {false, true}) {
+      // the heap, the quickselect and the split rows
+      CheckRows(dev_ctx_, MakeValues<float>(7 * 1000, ties), 7, 1000, 5);
+      CheckRows(dev_ctx_, MakeValues<float>(7 * 1000, ties), 7, 1000, 300);
+      CheckRows(dev_ctx_, MakeValues<float>(2 * 200000, ties), 2, 200000, 17);
+      CheckRows(
+          dev_ctx_, MakeValues<float>(2 * 200000, ties), 2, 200000, 5000);
+      CheckRows(dev_ctx_, MakeValues<double>(3 * 700, ties), 3, 700, 10);
+      CheckRows(dev_ctx_, MakeValues<int>(5 * 1500, ties), 5, 1500, 10);
+      CheckRows(dev_ctx_, MakeValues<int64_t>(5 * 100, ties), 5, 100, 100);
+    }
+  }
+}
+
+TEST_F(CpuSortTest, kernels_on_inner_axis) {
+  const int64_t d0 = 6, d1 = 300, d2 = 5, k = 7;
+  auto x = MakeTensor<float>({d0, d1, d2});
+  auto values = MakeValues<float>(x.numel(), false);
+  std::copy(values.begin(), values.end(), x.data<float>());
+
+  auto out = MakeTensor<float>({d0, k, d2});
+  auto indices = MakeTensor<int64_t>({d0, k, d2});
+  TopkKernel<float>(dev_ctx_, x, Scalar(k), 1, true, true, &out, &indices);
+  auto sorted = MakeTensor<float>({d0, d1, d2});
+  auto sorted_indices = MakeTensor<int64_t>({d0, d1, d2});
+  ArgsortKernel<float>(dev_ctx_, x, 1, false, &sorted, &sorted_indices);
+
+  std::vector<float> column(d1);
+  for (int64_t i = 0; i < d0; ++i) {
+    for (int64_t j = 0; j < d2; ++j) {
+      for (int64_t m = 0; m < d1; ++m) {
+        column[m] = values[(i * d1 + m) * d2 + j];
+      }
+      auto largest = ReferenceOrder(column.data(), d1, true);
+      for (int64_t m = 0; m < k; ++m) {
+        ASSERT_EQ(indices.data<int64_t>()[(i * k + m) * d2 + j], largest[m]);
+      }
+      auto ascending = ReferenceOrder(column.data(), d1, false);
+      for (int64_t m = 0; m < d1; ++m) {
+        ASSERT_EQ(sorted_indices.data<int64_t>()[(i * d1 + m) * d2 + j],
+                  ascending[m]);
+      }
+    }
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
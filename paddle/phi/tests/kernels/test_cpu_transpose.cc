@@ -0,0 +1,142 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
+#include "paddle/phi/kernels/funcs/math_function.h"
+
+namespace phi {
+namespace tests {
+
+class CpuTransposeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    alloc_ = std::make_unique<paddle::experimental::DefaultAllocator>(
+        paddle::platform::CPUPlace());
+    dev_ctx_.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    dev_ctx_.Init();
+  }
+
+  template <typename T>
+  DenseTensor MakeTensor(const std::vector<int64_t>& shape) {
+    DenseTensor t(alloc_.get(),
+                  DenseTensorMeta(paddle::experimental::CppTypeToDataType<
+                                      T>::Type(),
+                                  make_ddim(shape),
+                                  DataLayout::NCHW));
+    auto* data = t.mutable_data<T>(paddle::platform::CPUPlace());
+    for (int64_t i = 0; i < t.numel(); ++i) {
+      data[i] = static_cast<T>(i % 1021);
+    }
+    return t;
+  }
+
+  template <typename T>
+  void CompareWithEigen(const std::vector<int64_t>& shape,
+                        const std::vector<int>& axis);
+
+  std::unique_ptr<paddle::experimental::DefaultAllocator> alloc_;
+  CPUContext dev_ctx_;
+};
+
+template <typename T>
+void EigenTranspose(const CPUContext& dev_ctx,
+                    const DenseTensor& x,
+                    const std::vector<int>& axis,
+                    DenseTensor* out) {
+  switch (axis.size()) {
+    case 2:
+      funcs::Transpose<CPUContext, T, 2>()(dev_ctx, x, out, axis);
+      break;
+    case 3:
+      funcs::Transpose<CPUContext, T, 3>()(dev_ctx, x, out, axis);
+      break;
+    case 4:
+      funcs::Transpose<CPUContext, T, 4>()(dev_ctx, x, out, axis);
+      break;
+    default:
+      funcs::TransposeNormal<CPUContext, T>()(dev_ctx, x, out, axis);
+  }
+}
+
+static std::vector<int64_t> OutShape(const std::vector<int64_t>& shape,
+                                     const std::vector<int>& axis) {
+  std::vector<int64_t> out_shape;
+  for (int i : axis) {
+    out_shape.push_back(shape[i]);
+  }
+  return out_shape;
+}
+
+template <typename T>
+void CpuTransposeTest::CompareWithEigen(const std::vector<int64_t>& shape,
+                                        const std::vector<int>& axis) {
+  auto x = MakeTensor<T>(shape);
+  auto expected = MakeTensor<T>(OutShape(shape, axis));
+  auto out = MakeTensor<T>(OutShape(shape, axis));
+  EigenTranspose<T>(dev_ctx_, x, axis, &expected);
+  funcs::CpuTranspose(dev_ctx_, x.data<T>(), out.data<T>(), x.dims(), axis);
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    ASSERT_EQ(out.data<T>()[i], expected.data<T>()[i]) << x.dims();
+  }
+}
+
+TEST_F(CpuTransposeTest, compare_with_eigen) {
+  struct Case {
+    std::vector<int64_t> shape;
+    std::vector<int> axis;
+  };
+  std::vector<Case> cases = {
+      {{256, 256}, {1, 0}},                             // matrix
+      {{101, 99}, {1, 0}},                              // odd matrix
+      {{2, 33, 4, 16}, {0, 2, 1, 3}},                   // split heads
+      {{2, 4, 33, 16}, {0, 1, 3, 2}},                   // key transpose
+      {{2, 16, 7, 9}, {0, 2, 3, 1}},                    // nchw to nhwc
+      {{2, 7, 9, 16}, {0, 3, 1, 2}},                    // nhwc to nchw
+      {{2, 16, 7, 7}, {0, 1, 2, 3}},                    // identity
+      {{1, 65, 1, 77}, {3, 2, 1, 0}},                   // unit dims
+      {{2, 3, 4, 5, 6, 7, 8}, {6, 0, 5, 1, 4, 2, 3}}};  // rank 7
+  for (int threads : {1, 4}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    for (auto& c : cases) {
+      CompareWithEigen<float>(c.shape, c.axis);
+      CompareWithEigen<double>(c.shape, c.axis);
+      CompareWithEigen<int64_t>(c.shape, c.axis);
+      CompareWithEigen<phi::dtype::bfloat16>(c.shape, c.axis);
+    }
+  }
+}
+
+TEST_F(CpuTransposeTest, collapse_dims) {
+  auto shape = funcs::CollapseTransposeDims(make_ddim({8, 1, 3, 4, 5}),
+                                            {0, 3, 4, 1, 2});
+  EXPECT_EQ(shape.dims, std::vector<int64_t>({8, 3, 20}));
+  EXPECT_EQ(shape.axis, std::vector<int>({0, 2, 1}));
+
+  shape = funcs::CollapseTransposeDims(make_ddim({2, 3, 4}), {0, 1, 2});
+  EXPECT_EQ(shape.dims, std::vector<int64_t>({24}));
+  EXPECT_EQ(shape.axis, std::vector<int>({0}));
+}
+
+}  // namespace tests
+}  // namespace phi
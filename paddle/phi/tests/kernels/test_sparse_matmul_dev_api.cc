@@ -0,0 +1,297 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/kernels/matmul_kernel.h"
+#include "paddle/phi/kernels/sparse/csr_matmul_grad_kernel.h"
+#include "paddle/phi/kernels/sparse/csr_matmul_kernel.h"
+#include "paddle/phi/kernels/sparse/csr_softmax_grad_kernel.h"
+#include "paddle/phi/kernels/sparse/csr_softmax_kernel.h"
+
+namespace phi {
+namespace tests {
+
+class SparseMatmulTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    alloc_ = std::make_unique<paddle::experimental::DefaultAllocator>(
+        paddle::platform::CPUPlace());
+    dev_ctx_.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    dev_ctx_.Init();
+  }
+
+  DenseTensor MakeTensor(const std::vector<int64_t>& shape,
+                         DataType dtype = DataType::FLOAT32) {
+    return DenseTensor(
+        alloc_.get(),
+        DenseTensorMeta(dtype, make_ddim(shape), DataLayout::NCHW));
+  }
+
+  DenseTensor RandomTensor(const std::vector<int64_t>& shape) {
+    auto t = MakeTensor(shape);
+    auto* data = t.mutable_data<float>(paddle::platform::CPUPlace());
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (int64_t i = 0; i < t.numel(); ++i) {
+      data[i] = dist(engine_);
+    }
+    return t;
+  }
+
+  // A random SparseCsrTensor of [batch, rows, cols] (2-D when batch is 0)
+  // and its dense copy, which has zeros at the unstored elements.
+  SparseCsrTensor RandomCsr(int64_t batch,
+                            int64_t rows,
+                            int64_t cols,
+                            double density,
+                            DenseTensor* dense) {
+    const int64_t b = std::max<int64_t>(batch, 1);
+    std::vector<int64_t> shape = {rows, cols};
+    if (batch > 0) {
+      shape.insert(shape.begin(), batch);
+    }
+    *dense = MakeTensor(shape);
+    float* dense_data =
+        dense->mutable_data<float>(paddle::platform::CPUPlace());
+    std::fill(dense_data, dense_data + dense->numel(), 0.0f);
+
+    std::bernoulli_distribution keep(density);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<int64_t> crows, cols_index;
+    std::vector<float> values;
+    for (int64_t i = 0; i < b; ++i) {
+      crows.push_back(0);
+      int64_t count = 0;
+      for (int64_t r = 0; r < rows; ++r) {
+        for (int64_t c = 0; c < cols; ++c) {
+          if (keep(engine_)) {
+            float v = dist(engine_);
+            dense_data[(i * rows + r) * cols + c] = v;
+            cols_index.push_back(c);
+            values.push_back(v);
+            ++count;
+          }
+        }
+        crows.push_back(count);
+      }
+    }
+
+    auto crows_t = MakeTensor({static_cast<int64_t>(crows.size())},
+                              DataType::INT64);
+    auto cols_t = MakeTensor({static_cast<int64_t>(cols_index.size())},
+                             DataType::INT64);
+    auto values_t = MakeTensor({static_cast<int64_t>(values.size())});
+    std::copy(crows.begin(),
+              crows.end(),
+              crows_t.mutable_data<int64_t>(paddle::platform::CPUPlace()));
+    std::copy(cols_index.begin(),
+              cols_index.end(),
+              cols_t.mutable_data<int64_t>(paddle::platform::CPUPlace()));
+    std::copy(values.begin(),
+              values.end(),
+              values_t.mutable_data<float>(paddle::platform::CPUPlace()));
+    return SparseCsrTensor(crows_t, cols_t, values_t, make_ddim(shape));
+  }
+
+  // The values of a dense [batch, rows, cols] tensor at the elements of csr.
+  std::vector<float> Gather(const SparseCsrTensor& csr,
+                            const DenseTensor& dense) {
+    const auto& dims = csr.dims();
+    const int64_t rows = dims[dims.size() - 2];
+    const int64_t cols = dims[dims.size() - 1];
+    const int64_t batch = dims.size() == 3 ? dims[0] : 1;
+    const int64_t* crows = csr.non_zero_crows().data<int64_t>();
+    const int64_t* col_index = csr.non_zero_cols().data<int64_t>();
+    std::vector<float> values;
+    for (int64_t b = 0; b < batch; ++b) {
+      const int64_t* batch_crows = crows + b * (rows + 1);
+      for (int64_t r = 0; r < rows; ++r) {
+        for (int64_t j = batch_crows[r]; j < batch_crows[r + 1]; ++j) {
+          const int64_t c = col_index[values.size()];
+          values.push_back(dense.data<float>()[(b * rows + r) * cols + c]);
+        }
+      }
+    }
+    return values;
+  }
+
+  DenseTensor DenseMatmul(const DenseTensor& x,
+                          const DenseTensor& y,
+                          bool transpose_x,
+                          bool transpose_y) {
+    auto out = MakeTensor({1});
+    MatmulKernel<float>(dev_ctx_, x, y, transpose_x, transpose_y, &out);
+    return out;
+  }
+
+  std::unique_ptr<paddle::experimental::DefaultAllocator> alloc_;
+  CPUContext dev_ctx_;
+  std::mt19937 engine_{2022};
+};
+
+static void ExpectNear(const float* actual,
+                       const float* expected,
+                       int64_t n,
+                       const char* name) {
+  for (int64_t i = 0; i < n; ++i) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-4) << name << " at " << i;
+  }
+}
+
+TEST_F(SparseMatmulTest, csr_dense_matmul) {
+  for (int threads : {1, 4}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    for (int64_t batch : {0, 3}) {
+      DenseTensor x_dense;
+      auto x = RandomCsr(batch, 37, 29, 0.1, &x_dense);
+      std::vector<int64_t> y_shape = {29, 17};
+      if (batch > 0) {
+        y_shape.insert(y_shape.begin(), batch);
+      }
+      auto y = RandomTensor(y_shape);
+      auto out = sparse::CsrDenseMatmul<float>(dev_ctx_, x, y);
+      auto expected = DenseMatmul(x_dense, y, false, false);
+      ASSERT_EQ(out.dims(), expected.dims());
+      ExpectNear(out.data<float>(),
+                 expected.data<float>(),
+                 out.numel(),
+                 "out");
+
+      auto out_grad = RandomTensor(vectorize(out.dims()));
+      SparseCsrTensor x_grad;
+      auto y_grad = MakeTensor({1});
+      sparse::CsrDenseMatmulGradKernel<float>(
+          dev_ctx_, x, y, out_grad, &x_grad, &y_grad);
+      auto x_grad_dense = DenseMatmul(out_grad, y, false, true);
+      auto x_grad_expected = Gather(x, x_grad_dense);
+      ASSERT_EQ(x_grad.non_zero_elements().numel(),
+                static_cast<int64_t>(x_grad_expected.size()));
+      ExpectNear(x_grad.non_zero_elements().data<float>(),
+                 x_grad_expected.data(),
+                 x_grad_expected.size(),
+                 "x_grad");
+      auto y_grad_expected = DenseMatmul(x_dense, out_grad, true, false);
+      ASSERT_EQ(y_grad.dims(), y.dims());
+      ExpectNear(y_grad.data<float>(),
+                 y_grad_expected.data<float>(),
+                 y_grad.numel(),
+                 "y_grad");
+    }
+  }
+}
+
+TEST_F(SparseMatmulTest, csr_masked_matmul) {
+  for (int threads : {1, 4}) {
+    dev_ctx_.SetIntraOpThreads(threads);
+    for (int64_t batch : {0, 3}) {
+      std::vector<int64_t> x_shape = {37, 21};
+      std::vector<int64_t> y_shape = {21, 29};
+      if (batch > 0) {
+        x_shape.insert(x_shape.begin(), batch);
+        y_shape.insert(y_shape.begin(), batch);
+      }
+      auto x = RandomTensor(x_shape);
+      auto y = RandomTensor(y_shape);
+      DenseTensor mask_dense;
+      auto mask = RandomCsr(batch, 37, 29, 0.1, &mask_dense);
+      auto out = sparse::CsrMaskedMatmul<float>(dev_ctx_, x, y, mask);
+      auto expected = Gather(mask, DenseMatmul(x, y, false, false));
+      ASSERT_EQ(out.non_zero_elements().numel(),
+                static_cast<int64_t>(expected.size()));
+      ExpectNear(out.non_zero_elements().data<float>(),
+                 expected.data(),
+                 expected.size(),
+                 "out");
+
+      // the random values of mask are taken as out_grad
+      auto x_grad = MakeTensor({1});
+      auto y_grad = MakeTensor({1});
+      sparse::CsrMaskedMatmulGradKernel<float>(
+          dev_ctx_, x, y, mask, &x_grad, &y_grad);
+      auto x_grad_expected = DenseMatmul(mask_dense, y, false, true);
+      ASSERT_EQ(x_grad.dims(), x.dims());
+      ExpectNear(x_grad.data<float>(),
+                 x_grad_expected.data<float>(),
+                 x_grad.numel(),
+                 "x_grad");
+      auto y_grad_expected = DenseMatmul(x, mask_dense, true, false);
+      ASSERT_EQ(y_grad.dims(), y.dims());
+      ExpectNear(y_grad.data<float>(),
+                 y_grad_expected.data<float>(),
+                 y_grad.numel(),
+                 "y_grad");
+    }
+  }
+}
+
+TEST_F(SparseMatmulTest, csr_softmax) {
+  DenseTensor x_dense;
+  auto x = RandomCsr(3, 37, 29, 0.2, &x_dense);
+  auto out = sparse::CsrSoftmax<float>(dev_ctx_, x);
+  const int64_t* crows = x.non_zero_crows().data<int64_t>();
+  const float* x_values = x.non_zero_elements().data<float>();
+  const float* out_values = out.non_zero_elements().data<float>();
+  std::vector<float> out_grad(x.non_zero_elements().numel());
+  std::iota(out_grad.begin(), out_grad.end(), 0.0f);
+  std::vector<float> expected(out_grad.size());
+  std::vector<float> x_grad_expected(out_grad.size());
+  int64_t offset = 0;
+  for (int64_t b = 0; b < 3; ++b) {
+    for (int64_t r = 0; r < 37; ++r) {
+      const int64_t begin = offset + crows[b * 38 + r];
+      const int64_t end = offset + crows[b * 38 + r + 1];
+      float sum = 0.0f, dot = 0.0f;
+      for (int64_t j = begin; j < end; ++j) {
+        sum += std::exp(x_values[j]);
+      }
+      for (int64_t j = begin; j < end; ++j) {
+        expected[j] = std::exp(x_values[j]) / sum;
+        dot += expected[j] * out_grad[j];
+      }
+      for (int64_t j = begin; j < end; ++j) {
+        x_grad_expected[j] = expected[j] * (out_grad[j] - dot);
+      }
+    }
+    offset += crows[b * 38 + 37];
+  }
+  ExpectNear(out_values, expected.data(), expected.size(), "out");
+
+  auto out_grad_values = MakeTensor({static_cast<int64_t>(out_grad.size())});
+  std::copy(out_grad.begin(),
+            out_grad.end(),
+            out_grad_values.mutable_data<float>(paddle::platform::CPUPlace()));
+  SparseCsrTensor out_grad_csr(
+      x.non_zero_crows(), x.non_zero_cols(), out_grad_values, x.dims());
+  SparseCsrTensor x_grad;
+  sparse::CsrSoftmaxGradKernel<float>(dev_ctx_, out, out_grad_csr, &x_grad);
+  ExpectNear(x_grad.non_zero_elements().data<float>(),
+             x_grad_expected.data(),
+             x_grad_expected.size(),
+             "x_grad");
+}
+
+}  // namespace tests
+}  // namespace phi
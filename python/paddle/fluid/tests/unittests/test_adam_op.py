@@ -16,7 +16,7 @@ from __future__ import print_function
 
 import unittest
 import numpy as np
-from op_test import OpTest
+from op_test import OpTest, convert_float_to_uint16, convert_uint16_to_float
 from paddle.fluid import core
 from paddle.fluid.op import Operator
 import paddle.fluid as fluid
@@ -68,6 +68,57 @@ class TestAdamOp1(OpTest):
         self.check_output()
 
 
+class TestAdamOpBF16(OpTest):
+    def setUp(self):
+        '''Test Adam Op with bfloat16 parameters and float moments
+        '''
+        self.op_type = "adam"
+        self.dtype = np.uint16
+        param = convert_float_to_uint16(
+            np.random.uniform(-1, 1, (22, 35)).astype("float32"))
+        grad = convert_float_to_uint16(
+            np.random.uniform(-1, 1, (22, 35)).astype("float32"))
+        moment1 = np.random.uniform(-1, 1, (22, 35)).astype("float32")
+        moment2 = np.random.random((22, 35)).astype("float32")
+
+        learning_rate = 0.004
+        beta1 = 0.78
+        beta2 = 0.836
+        epsilon = 1e-4
+        beta1_pow = beta1**10
+        beta2_pow = beta2**10
+
+        self.inputs = {
+            'Param': param,
+            'Grad': grad,
+            'Moment1': moment1,
+            'Moment2': moment2,
+            'LearningRate': np.array([learning_rate]).astype("float32"),
+            'Beta1Pow': np.array([beta1_pow]).astype("float32"),
+            'Beta2Pow': np.array([beta2_pow]).astype("float32")
+        }
+
+        self.attrs = {'epsilon': epsilon, 'beta1': beta1, 'beta2': beta2}
+
+        # the update is computed in float from the bfloat16 values
+        float_inputs = dict(self.inputs)
+        float_inputs['Param'] = convert_uint16_to_float(param)
+        float_inputs['Grad'] = convert_uint16_to_float(grad)
+        param_out, moment1_out, \
+            moment2_out = adam_step(float_inputs, self.attrs)
+
+        self.outputs = {
+            'Moment1Out': moment1_out,
+            'Moment2Out': moment2_out,
+            'ParamOut': convert_float_to_uint16(param_out),
+            'Beta1PowOut': np.array([beta1_pow]).astype("float32") * beta1,
+            'Beta2PowOut': np.array([beta2_pow]).astype("float32") * beta2
+        }
+
+    def test_check_output(self):
+        self.check_output_with_place(core.CPUPlace(), atol=1e-2)
+
+
 class TestAdamOp2(OpTest):
     def set_shape(self):
         self.shape = (102, 105)
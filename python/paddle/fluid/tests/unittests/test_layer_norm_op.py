@@ -401,9 +401,7 @@ class TestBF16ScaleBiasLayerNorm(unittest.TestCase):
         paddle.enable_static()
         return y_np, x_g_np, w_g_np, b_g_np
 
-    def test_main(self):
-        if (not core.is_compiled_with_cuda()) or (core.cudnn_version() < 8100):
-            return
+    def check_bf16_close_to_fp32(self):
         x_np = np.random.random([10, 20]).astype('float32')
         weight_np = np.random.random([20]).astype('float32')
         bias_np = np.random.random([20]).astype('float32')
@@ -421,6 +419,19 @@ class TestBF16ScaleBiasLayerNorm(unittest.TestCase):
         assert_equal(w_g_np_1, w_g_np_2)
         assert_equal(b_g_np_1, b_g_np_2)
 
+    def test_main(self):
+        if (not core.is_compiled_with_cuda()) or (core.cudnn_version() < 8100):
+            return
+        self.check_bf16_close_to_fp32()
+
+    def test_main_cpu(self):
+        device = paddle.get_device()
+        paddle.set_device('cpu')
+        try:
+            self.check_bf16_close_to_fp32()
+        finally:
+            paddle.set_device(device)
+
 
 class TestGetSetKeepLayerNormScaleBiasFP32Flag(unittest.TestCase):
     def test_main(self):
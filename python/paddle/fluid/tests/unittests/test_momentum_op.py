@@ -18,7 +18,7 @@ import unittest
 import numpy as np
 import paddle.fluid.core as core
 from paddle.fluid.op import Operator
-from op_test import OpTest
+from op_test import OpTest, convert_float_to_uint16, convert_uint16_to_float
 import paddle
 import paddle.fluid as fluid
 import numpy
@@ -98,6 +98,56 @@ class TestMomentumOpFp16(TestMomentumOp1):
         self.check_output(atol=1e-3)
 
 
+class TestMomentumOpBF16(OpTest):
+    def setUp(self):
+        self.op_type = "momentum"
+        self.dtype = np.uint16
+        self.use_nesterov = False
+        self.init_config()
+
+        param = convert_float_to_uint16(
+            np.random.random((23, 31)).astype(np.float32))
+        grad = convert_float_to_uint16(
+            np.random.random((23, 31)).astype(np.float32))
+        velocity = convert_float_to_uint16(
+            np.random.random((23, 31)).astype(np.float32))
+        learning_rate = np.array([0.001]).astype(np.float32)
+        mu = 0.0001
+
+        self.inputs = {
+            'Param': param,
+            'Grad': grad,
+            'Velocity': velocity,
+            'LearningRate': learning_rate
+        }
+        self.attrs = {'mu': mu, 'use_nesterov': self.use_nesterov}
+
+        # the update is computed in float from the bfloat16 values
+        param_out, velocity_out = calculate_momentum_by_numpy(
+            param=convert_uint16_to_float(param),
+            grad=convert_uint16_to_float(grad),
+            mu=mu,
+            velocity=convert_uint16_to_float(velocity),
+            use_nesterov=self.use_nesterov,
+            learning_rate=learning_rate)
+
+        self.outputs = {
+            'ParamOut': convert_float_to_uint16(param_out),
+            'VelocityOut': convert_float_to_uint16(velocity_out)
+        }
+
+    def init_config(self):
+        pass
+
+    def test_check_output(self):
+        self.check_output_with_place(core.CPUPlace(), atol=1e-2)
+
+
+class TestMomentumOpBF16Nesterov(TestMomentumOpBF16):
+    def init_config(self):
+        self.use_nesterov = True
+
+
 class TestMomentumOp2(OpTest):
     '''Test Momentum with default values for attributes
     '''
@@ -111,7 +111,7 @@ PADDLE_API {self.outputs['return_type']} {self.get_api_func_name()}({self.args_s
                     )
                 else:
                     kernel_context_code = kernel_context_code + f"""
-  kernel_context.EmplaceBackInput({param}.impl().get());"""
+  kernel_context->EmplaceBackInput({param}.impl().get());"""
 
                 continue
             if param in attr_names:
@@ -125,11 +125,11 @@ PADDLE_API {self.outputs['return_type']} {self.get_api_func_name()}({self.args_s
             else:
                 param + str(param) + ", "
             kernel_context_code = kernel_context_code + f"""
-  kernel_context.EmplaceBackAttr({param});"""
+  kernel_context->EmplaceBackAttr({param});"""
 
         for out_name in kernel_output_names:
             kernel_context_code = kernel_context_code + f"""
-  kernel_context.EmplaceBackOutput({out_name});"""
+  kernel_context->EmplaceBackOutput({out_name});"""
 
         return kernel_context_code
 
@@ -141,16 +141,17 @@ PADDLE_API {self.outputs['return_type']} {self.get_api_func_name()}({self.args_s
             kernel_output_names)
 
         return f"""
-  auto phi_kernel = phi::KernelFactory::Instance().SelectKernelOrThrowError(
-      "{self.kernel['func'][0]}", {{kernel_backend, kernel_layout, kernel_data_type}});
+  static const phi::KernelHandle kernel_handle("{self.kernel['func'][0]}");
+  const auto& phi_kernel = kernel_handle.SelectKernelOrThrowError(
+      {{kernel_backend, kernel_layout, kernel_data_type}});
   VLOG(6) << "{self.api} api sparse kernel key: [" << kernel_backend << ", " << kernel_layout << ", "<< kernel_data_type << "]";
   VLOG(6) << "{self.api} api sparse kernel: " << phi_kernel;
 
   auto* dev_ctx = GetDeviceContextByBackend(kernel_backend);
-  auto kernel_context = phi::KernelContext(dev_ctx);
+  phi::ScopedKernelContext kernel_context(dev_ctx);
 {output_create}
 {kernel_context_code}
-  phi_kernel(&kernel_context);
+  phi_kernel(kernel_context.get());
 
   return api_output;"""
 